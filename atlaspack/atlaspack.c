@@ -0,0 +1,656 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <ctype.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bcm_host.h"
+
+#include "image.h"
+#include "imageFile.h"
+#include "spriteAtlas.h"
+
+//-----------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-----------------------------------------------------------------------
+
+typedef struct
+{
+    const char *path;
+    char name[SPRITE_ATLAS_NAME_LENGTH];
+    IMAGE_T image;
+    int32_t page;
+    int32_t x;
+    int32_t y;
+} ATLAS_SPRITE_T;
+
+// The skyline is the top edge of the packed area, as a list of segments
+// from left to right. A sprite goes where its bottom edge is lowest,
+// resting on the highest segment under it.
+
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+    int32_t width;
+} SKYLINE_NODE_T;
+
+typedef struct
+{
+    SKYLINE_NODE_T *nodes;
+    int32_t count;
+    int32_t width;
+    int32_t height;
+} ATLAS_PAGE_T;
+
+//-----------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s ", program);
+    fprintf(stderr, "[-f <format>] [-o <index>] [-p <padding>] ");
+    fprintf(stderr, "[-s <size>] [-t <type>] <sprite> ...\n");
+    fprintf(stderr, "    -f - format of pages, png (default), qoi or dmx\n");
+    fprintf(stderr, "    -o - index to write (default atlas.txt)\n");
+    fprintf(stderr, "    -p - pixels between sprites (default 1)\n");
+    fprintf(stderr, "    -s - largest page width and height ");
+    fprintf(stderr, "(default 1024)\n");
+    fprintf(stderr, "    -t - type of page image (default RGBA32)\n");
+    fprintf(stderr, "         can be one of the following:");
+    printImageTypes(stderr, " ", "", IMAGE_TYPES_ALL_DIRECT_COLOUR);
+    fprintf(stderr, "\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-----------------------------------------------------------------------
+
+// Order sprites tallest first, then widest, which packs well with a
+// skyline.
+
+static int
+compareSprites(
+    const void *a,
+    const void *b)
+{
+    const ATLAS_SPRITE_T *sa = *(const ATLAS_SPRITE_T **)a;
+    const ATLAS_SPRITE_T *sb = *(const ATLAS_SPRITE_T **)b;
+
+    if (sa->image.height != sb->image.height)
+    {
+        return sb->image.height - sa->image.height;
+    }
+
+    return sb->image.width - sa->image.width;
+}
+
+//-----------------------------------------------------------------------
+
+static void
+initAtlasPage(
+    ATLAS_PAGE_T *page,
+    int32_t size)
+{
+    page->nodes = malloc((size + 1) * sizeof(SKYLINE_NODE_T));
+
+    if (page->nodes == NULL)
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    page->nodes[0].x = 0;
+    page->nodes[0].y = 0;
+    page->nodes[0].width = size;
+    page->count = 1;
+    page->width = 0;
+    page->height = 0;
+}
+
+//-----------------------------------------------------------------------
+
+// Return the y at which a rectangle starting at node 'index' would sit,
+// or -1 if it doesn't fit on the page.
+
+static int32_t
+skylineFit(
+    const ATLAS_PAGE_T *page,
+    int32_t index,
+    int32_t width,
+    int32_t height,
+    int32_t size)
+{
+    if (page->nodes[index].x + width > size)
+    {
+        return -1;
+    }
+
+    int32_t y = 0;
+    int32_t widthLeft = width;
+    int32_t i = index;
+
+    while (widthLeft > 0)
+    {
+        if (page->nodes[i].y > y)
+        {
+            y = page->nodes[i].y;
+        }
+
+        if (y + height > size)
+        {
+            return -1;
+        }
+
+        widthLeft -= page->nodes[i].width;
+        i++;
+    }
+
+    return y;
+}
+
+//-----------------------------------------------------------------------
+
+static void
+removeNode(
+    ATLAS_PAGE_T *page,
+    int32_t index)
+{
+    memmove(&(page->nodes[index]),
+            &(page->nodes[index + 1]),
+            (page->count - index - 1) * sizeof(SKYLINE_NODE_T));
+    page->count--;
+}
+
+//-----------------------------------------------------------------------
+
+static bool
+skylineInsert(
+    ATLAS_PAGE_T *page,
+    int32_t width,
+    int32_t height,
+    int32_t size,
+    int32_t *x,
+    int32_t *y)
+{
+    int32_t bestIndex = -1;
+    int32_t bestBottom = INT_MAX;
+    int32_t bestWidth = INT_MAX;
+    int32_t bestY = 0;
+
+    int32_t i;
+    for (i = 0 ; i < page->count ; i++)
+    {
+        int32_t fitY = skylineFit(page, i, width, height, size);
+
+        if (fitY < 0)
+        {
+            continue;
+        }
+
+        int32_t bottom = fitY + height;
+
+        if ((bottom < bestBottom) ||
+            ((bottom == bestBottom) && (page->nodes[i].width < bestWidth)))
+        {
+            bestIndex = i;
+            bestBottom = bottom;
+            bestWidth = page->nodes[i].width;
+            bestY = fitY;
+        }
+    }
+
+    if (bestIndex == -1)
+    {
+        return false;
+    }
+
+    *x = page->nodes[bestIndex].x;
+    *y = bestY;
+
+    //-------------------------------------------------------------------
+
+    // Add the top of the new rectangle to the skyline, then trim or
+    // remove the segments it now covers and join level neighbours.
+
+    memmove(&(page->nodes[bestIndex + 1]),
+            &(page->nodes[bestIndex]),
+            (page->count - bestIndex) * sizeof(SKYLINE_NODE_T));
+    page->count++;
+
+    page->nodes[bestIndex].x = *x;
+    page->nodes[bestIndex].y = bestY + height;
+    page->nodes[bestIndex].width = width;
+
+    i = bestIndex + 1;
+
+    while (i < page->count)
+    {
+        const SKYLINE_NODE_T *previous = &(page->nodes[i - 1]);
+        SKYLINE_NODE_T *node = &(page->nodes[i]);
+        int32_t overlap = previous->x + previous->width - node->x;
+
+        if (overlap <= 0)
+        {
+            break;
+        }
+
+        node->x += overlap;
+        node->width -= overlap;
+
+        if (node->width > 0)
+        {
+            break;
+        }
+
+        removeNode(page, i);
+    }
+
+    i = 0;
+
+    while (i < page->count - 1)
+    {
+        if (page->nodes[i].y == page->nodes[i + 1].y)
+        {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            removeNode(page, i + 1);
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+// Sprite names are their file names without the directory or extension,
+// with any white space replaced so that the index can be read back.
+
+static void
+spriteName(
+    const char *path,
+    char *name)
+{
+    const char *base = basename(path);
+    const char *dot = strrchr(base, '.');
+    int length = (dot != NULL) ? dot - base : (int)strlen(base);
+
+    if (length > SPRITE_ATLAS_NAME_LENGTH - 1)
+    {
+        length = SPRITE_ATLAS_NAME_LENGTH - 1;
+    }
+
+    memcpy(name, base, length);
+    name[length] = '\0';
+
+    int i;
+    for (i = 0 ; i < length ; i++)
+    {
+        if (isspace((unsigned char)(name[i])))
+        {
+            name[i] = '_';
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    const char *format = "png";
+    const char *indexPath = "atlas.txt";
+    const char *imageTypeName = "RGBA32";
+    int32_t padding = 1;
+    int32_t size = 1024;
+
+    program = basename(argv[0]);
+
+    //-------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "f:o:p:s:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+
+            format = optarg;
+            break;
+
+        case 'o':
+
+            indexPath = optarg;
+            break;
+
+        case 'p':
+
+            padding = strtol(optarg, NULL, 10);
+            break;
+
+        case 's':
+
+            size = strtol(optarg, NULL, 10);
+            break;
+
+        case 't':
+
+            imageTypeName = optarg;
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    if ((optind >= argc) ||
+        (padding < 0) ||
+        (size < 1) ||
+        ((strcmp(format, "png") != 0) &&
+         (strcmp(format, "qoi") != 0) &&
+         (strcmp(format, "dmx") != 0)))
+    {
+        usage();
+    }
+
+    IMAGE_TYPE_INFO_T typeInfo;
+
+    if (findImageType(&typeInfo,
+                      imageTypeName,
+                      IMAGE_TYPES_ALL_DIRECT_COLOUR) == false)
+    {
+        fprintf(stderr,
+                "%s: unsupported image type %s\n",
+                program,
+                imageTypeName);
+
+        exit(EXIT_FAILURE);
+    }
+
+    //-------------------------------------------------------------------
+
+    int32_t spriteCount = argc - optind;
+    ATLAS_SPRITE_T *sprites = calloc(spriteCount, sizeof(ATLAS_SPRITE_T));
+    ATLAS_SPRITE_T **order = calloc(spriteCount, sizeof(ATLAS_SPRITE_T *));
+
+    if ((sprites == NULL) || (order == NULL))
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    int32_t i;
+    for (i = 0 ; i < spriteCount ; i++)
+    {
+        ATLAS_SPRITE_T *sprite = &(sprites[i]);
+
+        sprite->path = argv[optind + i];
+        spriteName(sprite->path, sprite->name);
+
+        if (loadImage(&(sprite->image), NULL, sprite->path) == false)
+        {
+            fprintf(stderr, "%s: unable to load %s\n", program, sprite->path);
+            exit(EXIT_FAILURE);
+        }
+
+        int32_t j;
+        for (j = 0 ; j < i ; j++)
+        {
+            if (strcmp(sprites[j].name, sprite->name) == 0)
+            {
+                fprintf(stderr,
+                        "%s: %s and %s have the same name\n",
+                        program,
+                        sprites[j].path,
+                        sprite->path);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        order[i] = sprite;
+    }
+
+    qsort(order, spriteCount, sizeof(ATLAS_SPRITE_T *), compareSprites);
+
+    //-------------------------------------------------------------------
+
+    // Each sprite goes on the first page it fits on, and a new page is
+    // started when it fits on none of them.
+
+    ATLAS_PAGE_T *pages = NULL;
+    int32_t pageCount = 0;
+
+    for (i = 0 ; i < spriteCount ; i++)
+    {
+        ATLAS_SPRITE_T *sprite = order[i];
+        int32_t width = sprite->image.width + padding;
+        int32_t height = sprite->image.height + padding;
+
+        if ((sprite->image.width > size) || (sprite->image.height > size))
+        {
+            fprintf(stderr,
+                    "%s: %s is bigger than a page\n",
+                    program,
+                    sprite->path);
+            exit(EXIT_FAILURE);
+        }
+
+        // Padding is only needed between sprites, so a sprite that
+        // fills the page doesn't need it.
+
+        if (width > size)
+        {
+            width = size;
+        }
+
+        if (height > size)
+        {
+            height = size;
+        }
+
+        int32_t p;
+        for (p = 0 ; p < pageCount ; p++)
+        {
+            if (skylineInsert(&(pages[p]),
+                              width,
+                              height,
+                              size,
+                              &(sprite->x),
+                              &(sprite->y)))
+            {
+                break;
+            }
+        }
+
+        if (p == pageCount)
+        {
+            pages = realloc(pages, (pageCount + 1) * sizeof(ATLAS_PAGE_T));
+
+            if (pages == NULL)
+            {
+                fprintf(stderr, "%s: memory exhausted\n", program);
+                exit(EXIT_FAILURE);
+            }
+
+            initAtlasPage(&(pages[pageCount]), size);
+            pageCount++;
+
+            skylineInsert(&(pages[p]),
+                          width,
+                          height,
+                          size,
+                          &(sprite->x),
+                          &(sprite->y));
+        }
+
+        sprite->page = p;
+
+        ATLAS_PAGE_T *page = &(pages[p]);
+
+        if (sprite->x + sprite->image.width > page->width)
+        {
+            page->width = sprite->x + sprite->image.width;
+        }
+
+        if (sprite->y + sprite->image.height > page->height)
+        {
+            page->height = sprite->y + sprite->image.height;
+        }
+    }
+
+    //-------------------------------------------------------------------
+
+    // Pages are named after the index, e.g. atlas.txt has atlas_0.png.
+
+    const char *dot = strrchr(indexPath, '.');
+    const char *slash = strrchr(indexPath, '/');
+    int stemLength = strlen(indexPath);
+
+    if ((dot != NULL) && ((slash == NULL) || (dot > slash)))
+    {
+        stemLength = dot - indexPath;
+    }
+
+    FILE *index = fopen(indexPath, "w");
+
+    if (index == NULL)
+    {
+        fprintf(stderr, "%s: unable to write %s\n", program, indexPath);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(index, "atlas %d\n", SPRITE_ATLAS_VERSION);
+
+    int32_t p;
+    for (p = 0 ; p < pageCount ; p++)
+    {
+        ATLAS_PAGE_T *page = &(pages[p]);
+
+        IMAGE_T image;
+        initImage(&image, typeInfo.type, page->width, page->height, false);
+
+        RGBA8_T *row = malloc(size * sizeof(RGBA8_T));
+
+        if (row == NULL)
+        {
+            fprintf(stderr, "%s: memory exhausted\n", program);
+            exit(EXIT_FAILURE);
+        }
+
+        for (i = 0 ; i < spriteCount ; i++)
+        {
+            ATLAS_SPRITE_T *sprite = &(sprites[i]);
+
+            if (sprite->page != p)
+            {
+                continue;
+            }
+
+            int32_t j;
+            for (j = 0 ; j < sprite->image.height ; j++)
+            {
+                getSpanRGB(&(sprite->image), 0, j, sprite->image.width, row);
+
+                setSpanRGB(&image,
+                           sprite->x,
+                           sprite->y + j,
+                           sprite->image.width,
+                           row);
+            }
+        }
+
+        free(row);
+
+        char pagePath[PATH_MAX];
+        snprintf(pagePath,
+                 sizeof(pagePath),
+                 "%.*s_%d.%s",
+                 stemLength,
+                 indexPath,
+                 p,
+                 format);
+
+        if (saveImage(&image, pagePath) == false)
+        {
+            fprintf(stderr, "%s: unable to save %s\n", program, pagePath);
+            exit(EXIT_FAILURE);
+        }
+
+        fprintf(index, "page %s\n", basename(pagePath));
+        printf("%s: %dx%d\n", pagePath, page->width, page->height);
+
+        destroyImage(&image);
+        free(page->nodes);
+    }
+
+    for (i = 0 ; i < spriteCount ; i++)
+    {
+        ATLAS_SPRITE_T *sprite = &(sprites[i]);
+
+        fprintf(index,
+                "frame %d %d %d %d %d %s\n",
+                sprite->page,
+                sprite->x,
+                sprite->y,
+                sprite->image.width,
+                sprite->image.height,
+                sprite->name);
+
+        destroyImage(&(sprite->image));
+    }
+
+    if (fclose(index) != 0)
+    {
+        fprintf(stderr, "%s: unable to write %s\n", program, indexPath);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%s: %d sprites on %d pages\n", indexPath, spriteCount, pageCount);
+
+    //-------------------------------------------------------------------
+
+    free(pages);
+    free(order);
+    free(sprites);
+
+    return 0;
+}
+
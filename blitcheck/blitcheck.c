@@ -0,0 +1,720 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bcm_host.h"
+
+#include "image.h"
+#include "imageBlit.h"
+
+//-----------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-----------------------------------------------------------------------
+
+// Limits on the size of the random images, the position of the blit and
+// the source rectangle, chosen so that blits often hang off every edge.
+
+#define BLITCHECK_SRC_WIDTH 40
+#define BLITCHECK_SRC_HEIGHT 30
+#define BLITCHECK_DST_WIDTH 50
+#define BLITCHECK_DST_HEIGHT 40
+
+//-----------------------------------------------------------------------
+
+typedef struct
+{
+    const char *name;
+    VC_IMAGE_TYPE_T type;
+    bool isIndexed;
+} BLITCHECK_TYPE_T;
+
+static const BLITCHECK_TYPE_T types[] =
+{
+    { "4BPP", VC_IMAGE_4BPP, true },
+    { "8BPP", VC_IMAGE_8BPP, true },
+    { "RGB565", VC_IMAGE_RGB565, false },
+    { "RGB888", VC_IMAGE_RGB888, false },
+    { "RGBA16", VC_IMAGE_RGBA16, false },
+    { "RGBA32", VC_IMAGE_RGBA32, false }
+};
+
+#define BLITCHECK_TYPES (sizeof(types) / sizeof(types[0]))
+
+static const char *modeNames[] =
+{
+    "copy",
+    "over",
+    "add",
+    "constant alpha"
+};
+
+#define BLITCHECK_MODES (sizeof(modeNames) / sizeof(modeNames[0]))
+
+//-----------------------------------------------------------------------
+
+// The blends worked out a pixel at a time with plain integer arithmetic,
+// dividing by 255 and rounding halves up, as described in imageBlit.c.
+
+static uint8_t
+divide255(
+    uint32_t value)
+{
+    return ((value * 2) + 255) / 510;
+}
+
+//-----------------------------------------------------------------------
+
+static uint8_t
+mix(
+    uint8_t source,
+    uint8_t destination,
+    uint8_t weight)
+{
+    return divide255((source * weight) + (destination * (255 - weight)));
+}
+
+//-----------------------------------------------------------------------
+
+static uint8_t
+saturate(
+    uint32_t value)
+{
+    return (value > 255) ? 255 : value;
+}
+
+//-----------------------------------------------------------------------
+
+static void
+blendPixel(
+    const RGBA8_T *src,
+    RGBA8_T *dst,
+    IMAGE_BLIT_MODE_T mode,
+    uint8_t opacity)
+{
+    uint8_t alpha = divide255(src->alpha * opacity);
+
+    switch (mode)
+    {
+    case IMAGE_BLIT_COPY:
+
+        *dst = *src;
+        break;
+
+    case IMAGE_BLIT_OVER:
+
+        if (dst->alpha == 255)
+        {
+            dst->red = mix(src->red, dst->red, alpha);
+            dst->green = mix(src->green, dst->green, alpha);
+            dst->blue = mix(src->blue, dst->blue, alpha);
+        }
+        else
+        {
+            uint32_t under = divide255(dst->alpha * (255 - alpha));
+            uint32_t total = alpha + under;
+
+            if (total > 0)
+            {
+                dst->red = ((src->red * alpha) + (dst->red * under)
+                           + (total / 2)) / total;
+                dst->green = ((src->green * alpha) + (dst->green * under)
+                             + (total / 2)) / total;
+                dst->blue = ((src->blue * alpha) + (dst->blue * under)
+                            + (total / 2)) / total;
+                dst->alpha = total;
+            }
+        }
+
+        break;
+
+    case IMAGE_BLIT_ADD:
+
+        dst->red = saturate(dst->red + divide255(src->red * alpha));
+        dst->green = saturate(dst->green + divide255(src->green * alpha));
+        dst->blue = saturate(dst->blue + divide255(src->blue * alpha));
+        dst->alpha = saturate(dst->alpha + alpha);
+        break;
+
+    case IMAGE_BLIT_CONSTANT_ALPHA:
+
+        dst->red = mix(src->red, dst->red, opacity);
+        dst->green = mix(src->green, dst->green, opacity);
+        dst->blue = mix(src->blue, dst->blue, opacity);
+        dst->alpha = mix(src->alpha, dst->alpha, opacity);
+        break;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static void
+newImage(
+    IMAGE_T *image,
+    VC_IMAGE_TYPE_T type,
+    int32_t width,
+    int32_t height)
+{
+    if (initImage(image, type, width, height, false) == false)
+    {
+        fprintf(stderr, "%s: unable to initialize image\n", program);
+        exit(EXIT_FAILURE);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static void
+copyImage(
+    IMAGE_T *copy,
+    const IMAGE_T *image)
+{
+    newImage(copy, image->type, image->width, image->height);
+    memcpy(copy->buffer, image->buffer, image->size);
+}
+
+//-----------------------------------------------------------------------
+
+// Random pixels, a quarter of the bytes 0xFF so that there are plenty of
+// opaque pixels and saturated channels.
+
+static void
+randomImage(
+    IMAGE_T *image)
+{
+    uint8_t *bytes = image->buffer;
+
+    uint32_t i;
+    for (i = 0 ; i < image->size ; i++)
+    {
+        bytes[i] = ((rand() % 4) == 0) ? 0xFF : (rand() & 0xFF);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+// The vector over only runs on rows of opaque destination pixels, so make
+// all of them opaque.
+
+static void
+opaqueImage(
+    IMAGE_T *image)
+{
+    int32_t j;
+    for (j = 0 ; j < image->height ; j++)
+    {
+        int32_t i;
+        for (i = 0 ; i < image->width ; i++)
+        {
+            RGBA8_T rgba;
+
+            image->getPixelDirect(image, i, j, &rgba);
+            rgba.alpha = 255;
+            image->setPixelDirect(image, i, j, &rgba);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static double
+secondsNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + (now.tv_nsec / 1.0e9);
+}
+
+//-----------------------------------------------------------------------
+
+// Blit a pixel at a time from 'src', a copy of the source before the blit,
+// into 'dst', a copy of the destination. Pixels outside the source or the
+// clip rectangle are left alone.
+
+static void
+blitPixels(
+    IMAGE_T *dst,
+    int32_t x,
+    int32_t y,
+    IMAGE_T *src,
+    const VC_RECT_T *rect,
+    const VC_RECT_T *clip,
+    IMAGE_BLIT_MODE_T mode,
+    uint8_t opacity)
+{
+    bool direct = (src->getPixelDirect != NULL) &&
+                  (dst->setPixelDirect != NULL);
+
+    int32_t j;
+    for (j = 0 ; j < rect->height ; j++)
+    {
+        int32_t i;
+        for (i = 0 ; i < rect->width ; i++)
+        {
+            int32_t sx = rect->x + i;
+            int32_t sy = rect->y + j;
+            int32_t dx = x + i;
+            int32_t dy = y + j;
+
+            if ((sx < 0) || (sy < 0) ||
+                (sx >= src->width) || (sy >= src->height) ||
+                (dx < clip->x) || (dy < clip->y) ||
+                (dx >= clip->x + clip->width) ||
+                (dy >= clip->y + clip->height))
+            {
+                continue;
+            }
+
+            if (direct)
+            {
+                RGBA8_T from;
+                RGBA8_T to;
+
+                src->getPixelDirect(src, sx, sy, &from);
+                dst->getPixelDirect(dst, dx, dy, &to);
+                blendPixel(&from, &to, mode, opacity);
+                dst->setPixelDirect(dst, dx, dy, &to);
+            }
+            else
+            {
+                int8_t index;
+
+                src->getPixelIndexed(src, sx, sy, &index);
+                dst->setPixelIndexed(dst, dx, dy, index);
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+
+// One random blit: a pair of types (or an image onto itself), mode and
+// opacity, at a random position, with or without a source rectangle and a
+// clip rectangle. imageBlit() must give the same image as blitPixels(),
+// and must refuse exactly the pairs it doesn't support.
+
+static bool
+checkBlit(
+    int32_t number,
+    int32_t *unsupported)
+{
+    const BLITCHECK_TYPE_T *srcType = &(types[rand() % BLITCHECK_TYPES]);
+    const BLITCHECK_TYPE_T *dstType = &(types[rand() % BLITCHECK_TYPES]);
+    bool self = (rand() % 8) == 0;
+
+    IMAGE_BLIT_MODE_T mode = rand() % BLITCHECK_MODES;
+
+    // Indexed images can only be copied onto the same type, so mostly
+    // pick a blit that works rather than one that is refused.
+
+    if ((srcType->isIndexed || dstType->isIndexed) && (rand() % 4))
+    {
+        dstType = srcType;
+        mode = IMAGE_BLIT_COPY;
+    }
+
+    if (self)
+    {
+        dstType = srcType;
+    }
+
+    IMAGE_T src;
+    IMAGE_T other;
+    IMAGE_T *dst = &src;
+
+    newImage(&src,
+             srcType->type,
+             (rand() % BLITCHECK_SRC_WIDTH) + 1,
+             (rand() % BLITCHECK_SRC_HEIGHT) + 1);
+    randomImage(&src);
+
+    if (self == false)
+    {
+        dst = &other;
+
+        newImage(dst,
+                 dstType->type,
+                 (rand() % BLITCHECK_DST_WIDTH) + 1,
+                 (rand() % BLITCHECK_DST_HEIGHT) + 1);
+        randomImage(dst);
+
+        if ((dst->setPixelDirect != NULL) && (rand() % 2))
+        {
+            opaqueImage(dst);
+        }
+    }
+
+    uint8_t opacity = ((rand() % 4) == 0) ? 255 : (rand() & 0xFF);
+
+    int32_t x = (rand() % (BLITCHECK_DST_WIDTH + 10)) - 15;
+    int32_t y = (rand() % (BLITCHECK_DST_HEIGHT + 10)) - 15;
+
+    VC_RECT_T rect;
+    bool useRect = (rand() % 3) != 0;
+
+    if (useRect)
+    {
+        vc_dispmanx_rect_set(&rect,
+                             (rand() % (BLITCHECK_SRC_WIDTH + 10)) - 10,
+                             (rand() % (BLITCHECK_SRC_HEIGHT + 10)) - 10,
+                             rand() % (BLITCHECK_SRC_WIDTH + 10),
+                             rand() % (BLITCHECK_SRC_HEIGHT + 10));
+    }
+    else
+    {
+        vc_dispmanx_rect_set(&rect, 0, 0, src.width, src.height);
+    }
+
+    bool pushed = (rand() % 3) == 0;
+
+    if (pushed)
+    {
+        pushImageClip(dst,
+                      rand() % 30,
+                      rand() % 25,
+                      rand() % 40,
+                      rand() % 40);
+    }
+
+    VC_RECT_T clip = *getImageClip(dst);
+
+    IMAGE_T srcBefore;
+    IMAGE_T expected;
+
+    copyImage(&srcBefore, &src);
+    copyImage(&expected, dst);
+
+    bool supported = ((src.getSpanDirect != NULL) &&
+                      (dst->setSpanDirect != NULL)) ||
+                     ((mode == IMAGE_BLIT_COPY) && (src.type == dst->type));
+
+    bool blitted = imageBlit(dst,
+                             x,
+                             y,
+                             &src,
+                             (useRect) ? &rect : NULL,
+                             mode,
+                             opacity);
+
+    if (pushed)
+    {
+        popImageClip(dst);
+    }
+
+    bool result = (blitted == supported);
+
+    if (blitted)
+    {
+        blitPixels(&expected,
+                   x,
+                   y,
+                   &srcBefore,
+                   &rect,
+                   &clip,
+                   mode,
+                   opacity);
+
+        result = result &&
+                 (memcmp(expected.buffer, dst->buffer, dst->size) == 0);
+    }
+    else
+    {
+        ++(*unsupported);
+    }
+
+    if (result == false)
+    {
+        fprintf(stderr,
+                "%s: blit %d, %s onto %s%s, %s, opacity %d, at (%d, %d)"
+                " differs\n",
+                program,
+                number,
+                srcType->name,
+                dstType->name,
+                (self) ? " (itself)" : "",
+                modeNames[mode],
+                opacity,
+                x,
+                y);
+    }
+
+    destroyImage(&srcBefore);
+    destroyImage(&expected);
+    destroyImage(&src);
+
+    if (self == false)
+    {
+        destroyImage(&other);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------
+
+// Time blitting a whole frame of random RGBA32 pixels onto a frame of the
+// given type with imageBlit() and a pixel at a time, taking the best of
+// 'repeats' runs of each, and check that both give the same frame.
+
+static bool
+timeBlit(
+    IMAGE_BLIT_MODE_T mode,
+    const BLITCHECK_TYPE_T *dstType,
+    int32_t width,
+    int32_t height,
+    int32_t repeats)
+{
+    IMAGE_T src;
+    IMAGE_T background;
+    IMAGE_T blitImage;
+    IMAGE_T pixelImage;
+
+    newImage(&src, VC_IMAGE_RGBA32, width, height);
+    newImage(&background, dstType->type, width, height);
+
+    randomImage(&src);
+    randomImage(&background);
+    opaqueImage(&background);
+
+    copyImage(&blitImage, &background);
+    copyImage(&pixelImage, &background);
+
+    VC_RECT_T rect;
+    vc_dispmanx_rect_set(&rect, 0, 0, width, height);
+
+    uint8_t opacity = 200;
+    double bestBlit = 0.0;
+    double bestPixel = 0.0;
+
+    int32_t r;
+    for (r = 0 ; r < repeats ; r++)
+    {
+        memcpy(blitImage.buffer, background.buffer, background.size);
+
+        double start = secondsNow();
+        imageBlit(&blitImage, 0, 0, &src, NULL, mode, opacity);
+        double seconds = secondsNow() - start;
+
+        if ((r == 0) || (seconds < bestBlit))
+        {
+            bestBlit = seconds;
+        }
+
+        memcpy(pixelImage.buffer, background.buffer, background.size);
+
+        start = secondsNow();
+        blitPixels(&pixelImage, 0, 0, &src, &rect, &rect, mode, opacity);
+        seconds = secondsNow() - start;
+
+        if ((r == 0) || (seconds < bestPixel))
+        {
+            bestPixel = seconds;
+        }
+    }
+
+    bool same = (memcmp(blitImage.buffer,
+                        pixelImage.buffer,
+                        blitImage.size) == 0);
+
+    char name[64];
+    snprintf(name,
+             sizeof(name),
+             "%s onto %s",
+             modeNames[mode],
+             dstType->name);
+
+    printf("%-28s %9.2f %9.2f %7.1fx%s\n",
+           name,
+           bestPixel * 1000.0,
+           bestBlit * 1000.0,
+           bestPixel / bestBlit,
+           (same) ? "" : " differs");
+
+    if (same == false)
+    {
+        fprintf(stderr,
+                "%s: imageBlit and the per-pixel blit give different"
+                " frames for %s\n",
+                program,
+                name);
+    }
+
+    destroyImage(&src);
+    destroyImage(&background);
+    destroyImage(&blitImage);
+    destroyImage(&pixelImage);
+
+    return same;
+}
+
+//-----------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s ", program);
+    fprintf(stderr, "[-c] [-n <number>] [-r <number>] [-s <seed>]");
+    fprintf(stderr, " [-w <width>x<height>]\n");
+    fprintf(stderr, "    -c - check the blits only, no timing\n");
+    fprintf(stderr, "    -n - number of random blits (default 30000)\n");
+    fprintf(stderr, "    -r - times to blit each frame (default 5)\n");
+    fprintf(stderr, "    -s - seed for the random blits (default 1)\n");
+    fprintf(stderr, "    -w - size of the frame timed (default 1920x1080)\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-----------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    bool checkOnly = false;
+    int32_t blits = 30000;
+    int32_t repeats = 5;
+    unsigned int seed = 1;
+    int32_t width = 1920;
+    int32_t height = 1080;
+
+    program = basename(argv[0]);
+
+    //-------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "cn:r:s:w:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+
+            checkOnly = true;
+            break;
+
+        case 'n':
+
+            blits = strtol(optarg, NULL, 10);
+            break;
+
+        case 'r':
+
+            repeats = strtol(optarg, NULL, 10);
+            break;
+
+        case 's':
+
+            seed = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'w':
+
+            if (sscanf(optarg, "%dx%d", &width, &height) != 2)
+            {
+                usage();
+            }
+
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    if ((blits < 0) || (repeats < 1) || (width < 1) || (height < 1))
+    {
+        usage();
+    }
+
+    //-------------------------------------------------------------------
+
+    srand(seed);
+
+    printf("%s: blends built for %s\n\n", program, imageBlitPath());
+
+    int32_t unsupported = 0;
+    int32_t failed = 0;
+
+    int32_t n;
+    for (n = 0 ; n < blits ; n++)
+    {
+        if (checkBlit(n, &unsupported) == false)
+        {
+            ++failed;
+        }
+    }
+
+    printf("%d random blits, %d refused, %d differ\n",
+           blits,
+           unsupported,
+           failed);
+
+    if (failed > 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (checkOnly)
+    {
+        return 0;
+    }
+
+    printf("\nRGBA32 %dx%d frame, best of %d\n\n", width, height, repeats);
+    printf("%-28s %9s %9s %8s\n", "", "pixel ms", "blit ms", "speedup");
+
+    bool result = true;
+
+    IMAGE_BLIT_MODE_T mode;
+    for (mode = IMAGE_BLIT_OVER ; mode < BLITCHECK_MODES ; mode++)
+    {
+        size_t t;
+        for (t = 0 ; t < BLITCHECK_TYPES ; t++)
+        {
+            if (types[t].isIndexed)
+            {
+                continue;
+            }
+
+            if (timeBlit(mode, &(types[t]), width, height, repeats) == false)
+            {
+                result = false;
+            }
+        }
+    }
+
+    return (result) ? 0 : EXIT_FAILURE;
+}
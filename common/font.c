@@ -26,6 +26,11 @@
 //
 //-------------------------------------------------------------------------
 
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "bits.h"
 #include "font.h"
 
@@ -4645,93 +4650,512 @@ uint8_t font[256][FONT_HEIGHT] =
 
 //-------------------------------------------------------------------------
 
-void
-drawCharIndexed(
-    int x,
-    int y,
-    uint8_t c,
-    int8_t index,
-    IMAGE_T *image)
+// The set bits in each of the 256 possible rows of a glyph, as runs that
+// can each be stored with a single copy.
+
+typedef struct
 {
-    int j;
-    for (j = 0 ; j < FONT_HEIGHT ; j++)
+    uint8_t count;
+    uint8_t start[FONT_WIDTH / 2];
+    uint8_t length[FONT_WIDTH / 2];
+} FONT_ROW_RUNS_T;
+
+static FONT_ROW_RUNS_T fontRowRuns[256];
+static bool fontRowRunsInitialised = false;
+
+//-------------------------------------------------------------------------
+
+// The colour to draw with. When the image allows it, a row of pixels is
+// packed once so that spans are stored with memcpy().
+
+#define FONT_PEN_PIXELS 32
+
+typedef struct
+{
+    bool packed;
+    int32_t bytesPerPixel;
+    uint8_t row[FONT_PEN_PIXELS * 4];
+    const RGBA8_T *rgb;
+    int8_t index;
+} FONT_PEN_T;
+
+//-------------------------------------------------------------------------
+
+static void
+initFontRowRuns(void)
+{
+    int byte;
+    for (byte = 0 ; byte < 256 ; byte++)
     {
-        uint8_t byte = font[c][j];
+        FONT_ROW_RUNS_T *runs = &(fontRowRuns[byte]);
+        runs->count = 0;
 
-        if (byte != 0)
+        int i = 0;
+        while (i < FONT_WIDTH)
         {
-            int i;
-            for (i = 0 ; i < FONT_WIDTH ; ++i)
+            if ((byte >> (FONT_WIDTH - i - 1)) & 1)
             {
-                if ((byte >> (FONT_WIDTH - i - 1)) & 1 )
+                int start = i;
+
+                while ((i < FONT_WIDTH) &&
+                       ((byte >> (FONT_WIDTH - i - 1)) & 1))
                 {
-                    setPixelIndexed(image, x + i, y + j, index);
+                    ++i;
                 }
+
+                runs->start[runs->count] = start;
+                runs->length[runs->count] = i - start;
+                ++(runs->count);
+            }
+            else
+            {
+                ++i;
             }
         }
     }
+
+    fontRowRunsInitialised = true;
 }
 
 //-------------------------------------------------------------------------
 
-void
-drawCharRGB(
+static void
+initPen(
+    FONT_PEN_T *pen,
+    const IMAGE_T *image)
+{
+    if (fontRowRunsInitialised == false)
+    {
+        initFontRowRuns();
+    }
+
+    if (pen->packed)
+    {
+        pen->bytesPerPixel = image->bitsPerPixel / 8;
+
+        int i;
+        for (i = 1 ; i < FONT_PEN_PIXELS ; i++)
+        {
+            memcpy(pen->row + (i * pen->bytesPerPixel),
+                   pen->row,
+                   pen->bytesPerPixel);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+initPenIndexed(
+    FONT_PEN_T *pen,
+    int8_t index,
+    const IMAGE_T *image)
+{
+    pen->packed = packPixelIndexed(image, index, pen->row);
+    pen->rgb = NULL;
+    pen->index = index;
+
+    initPen(pen, image);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+initPenRGB(
+    FONT_PEN_T *pen,
+    const RGBA8_T *rgb,
+    const IMAGE_T *image)
+{
+    pen->packed = packPixelRGB(image, rgb, pen->row);
+    pen->rgb = rgb;
+    pen->index = 0;
+
+    initPen(pen, image);
+}
+
+//-------------------------------------------------------------------------
+
+// Spans inside the clip rectangle are copied from the pen without marking
+// the image dirty, the caller marks the area of the whole character or
+// string.
+
+static void
+fillPenSpan(
+    const FONT_PEN_T *pen,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    IMAGE_T *image)
+{
+    const VC_RECT_T *clip = getImageClip(image);
+
+    if (pen->packed &&
+        (x >= clip->x) && (x + length <= clip->x + clip->width) &&
+        (y >= clip->y) && (y < clip->y + clip->height))
+    {
+        uint8_t *line = (uint8_t *)(image->buffer)
+                      + (y * image->pitch)
+                      + (x * pen->bytesPerPixel);
+
+        while (length > 0)
+        {
+            int32_t pixels = length;
+
+            if (pixels > FONT_PEN_PIXELS)
+            {
+                pixels = FONT_PEN_PIXELS;
+            }
+
+            memcpy(line, pen->row, pixels * pen->bytesPerPixel);
+            line += pixels * pen->bytesPerPixel;
+            length -= pixels;
+        }
+    }
+    else if (pen->rgb != NULL)
+    {
+        fillSpanRGB(image, x, y, length, pen->rgb);
+    }
+    else
+    {
+        fillSpanIndexed(image, x, y, length, pen->index);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+drawGlyphPen(
     int x,
     int y,
     uint8_t c,
-    const RGBA8_T *rgb,
+    const FONT_PEN_T *pen,
     IMAGE_T *image)
 {
     int j;
     for (j = 0 ; j < FONT_HEIGHT ; j++)
     {
-        uint8_t byte = font[c][j];
+        const FONT_ROW_RUNS_T *runs = &(fontRowRuns[font[c][j]]);
 
-        if (byte != 0)
+        int i;
+        for (i = 0 ; i < runs->count ; i++)
         {
-            int i;
-            for (i = 0 ; i < FONT_WIDTH ; ++i)
-            {
-                if ((byte >> (FONT_WIDTH - i - 1)) & 1 )
-                {
-                    setPixelRGB(image, x + i, y + j, rgb);
-                }
-            }
+            fillPenSpan(pen,
+                        x + runs->start[i],
+                        y + j,
+                        runs->length[i],
+                        image);
         }
     }
 }
 
 //-------------------------------------------------------------------------
 
-void
-drawStringIndexed(
+static void
+drawCharPen(
     int x,
     int y,
-    const char *string,
-    int8_t index,
+    uint8_t c,
+    const FONT_PEN_T *pen,
     IMAGE_T *image)
 {
-    if (string == NULL)
+    drawGlyphPen(x, y, c, pen, image);
+    markImageDirty(image, x, y, FONT_WIDTH, FONT_HEIGHT);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+sizeString(
+    const char *string,
+    int32_t *width,
+    int32_t *height)
+{
+    *width = 0;
+    *height = 0;
+
+    const char *line = string;
+
+    while (line != NULL)
     {
-        return;
+        const char *end = strchr(line, '\n');
+        int32_t length = (end != NULL) ? (end - line) : strlen(line);
+
+        if (length * FONT_WIDTH > *width)
+        {
+            *width = length * FONT_WIDTH;
+        }
+
+        *height += FONT_HEIGHT;
+        line = (end != NULL) ? (end + 1) : NULL;
     }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+drawStringPen(
+    int x,
+    int y,
+    const char *string,
+    const FONT_PEN_T *pen,
+    IMAGE_T *image)
+{
+    int32_t width = 0;
+    int32_t height = 0;
+
+    sizeString(string, &width, &height);
 
-    int x_first = x;
+    int32_t xc = x;
+    int32_t yc = y;
 
-    while (*string != '\0')
+    for ( ; *string != '\0' ; string++)
     {
         if (*string == '\n')
         {
-            x = x_first;
-            y += FONT_HEIGHT;
+            xc = x;
+            yc += FONT_HEIGHT;
         }
         else
         {
-            drawCharIndexed(x, y, *string, index, image);
-            x += FONT_WIDTH;
+            drawGlyphPen(xc, yc, *string, pen, image);
+            xc += FONT_WIDTH;
         }
-        ++string;
     }
+
+    markImageDirty(image, x, y, width, height);
+}
+
+//-------------------------------------------------------------------------
+
+// Copy a rendered string into the image, clipped to the clip rectangle,
+// one row at a time.
+
+static void
+copyFontBlock(
+    const IMAGE_T *block,
+    int32_t x,
+    int32_t y,
+    IMAGE_T *image)
+{
+    const VC_RECT_T *clip = getImageClip(image);
+
+    int32_t left = (x > clip->x) ? x : clip->x;
+    int32_t top = (y > clip->y) ? y : clip->y;
+    int32_t right = x + block->width;
+    int32_t bottom = y + block->height;
+
+    if (right > clip->x + clip->width)
+    {
+        right = clip->x + clip->width;
+    }
+
+    if (bottom > clip->y + clip->height)
+    {
+        bottom = clip->y + clip->height;
+    }
+
+    if ((left >= right) || (top >= bottom))
+    {
+        return;
+    }
+
+    int32_t bytesPerPixel = image->bitsPerPixel / 8;
+    size_t bytes = (right - left) * bytesPerPixel;
+
+    int32_t j;
+    for (j = top ; j < bottom ; j++)
+    {
+        memcpy((uint8_t *)(image->buffer)
+               + (j * image->pitch)
+               + (left * bytesPerPixel),
+               (uint8_t *)(block->buffer)
+               + ((j - y) * block->pitch)
+               + ((left - x) * bytesPerPixel),
+               bytes);
+    }
+
+    markImageDirty(image, left, top, right - left, bottom - top);
+}
+
+//-------------------------------------------------------------------------
+
+// Find the block for a string drawn with the given pen on the given
+// background, rendering it into the least recently used entry if it is
+// not already in the cache.
+
+static const IMAGE_T *
+findFontBlock(
+    FONT_CACHE_T *cache,
+    const char *string,
+    int32_t width,
+    int32_t height,
+    const IMAGE_T *image,
+    const FONT_PEN_T *pen,
+    const FONT_PEN_T *background)
+{
+    FONT_CACHE_ENTRY_T *oldest = &(cache->entries[0]);
+
+    ++(cache->used);
+
+    int i;
+    for (i = 0 ; i < FONT_CACHE_ENTRIES ; i++)
+    {
+        FONT_CACHE_ENTRY_T *entry = &(cache->entries[i]);
+
+        if ((entry->string != NULL) &&
+            (entry->type == image->type) &&
+            (memcmp(entry->foreground,
+                    pen->row,
+                    pen->bytesPerPixel) == 0) &&
+            (memcmp(entry->background,
+                    background->row,
+                    pen->bytesPerPixel) == 0) &&
+            (strcmp(entry->string, string) == 0))
+        {
+            entry->lastUsed = cache->used;
+            return &(entry->block);
+        }
+
+        if (entry->lastUsed < oldest->lastUsed)
+        {
+            oldest = entry;
+        }
+    }
+
+    if (oldest->string != NULL)
+    {
+        free(oldest->string);
+        destroyImage(&(oldest->block));
+    }
+
+    oldest->string = strdup(string);
+
+    if ((oldest->string == NULL) ||
+        (initImage(&(oldest->block),
+                   image->type,
+                   width,
+                   height,
+                   false) == false))
+    {
+        fprintf(stderr, "font: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    oldest->type = image->type;
+    memcpy(oldest->foreground, pen->row, pen->bytesPerPixel);
+    memcpy(oldest->background, background->row, pen->bytesPerPixel);
+    oldest->lastUsed = cache->used;
+
+    IMAGE_T *block = &(oldest->block);
+
+    int32_t j;
+    for (j = 0 ; j < height ; j++)
+    {
+        fillPenSpan(background, 0, j, width, block);
+    }
+
+    drawStringPen(0, 0, string, pen, block);
+
+    return block;
+}
+
+//-------------------------------------------------------------------------
+
+static void
+drawStringCachedPen(
+    FONT_CACHE_T *cache,
+    int x,
+    int y,
+    const char *string,
+    const FONT_PEN_T *pen,
+    const FONT_PEN_T *background,
+    IMAGE_T *image)
+{
+    int32_t width = 0;
+    int32_t height = 0;
+
+    sizeString(string, &width, &height);
+
+    if (width == 0)
+    {
+        return;
+    }
+
+    if (pen->packed && background->packed)
+    {
+        const IMAGE_T *block = findFontBlock(cache,
+                                             string,
+                                             width,
+                                             height,
+                                             image,
+                                             pen,
+                                             background);
+
+        copyFontBlock(block, x, y, image);
+    }
+    else
+    {
+        int32_t j;
+        for (j = 0 ; j < height ; j++)
+        {
+            fillPenSpan(background, x, y + j, width, image);
+        }
+
+        drawStringPen(x, y, string, pen, image);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+drawCharIndexed(
+    int x,
+    int y,
+    uint8_t c,
+    int8_t index,
+    IMAGE_T *image)
+{
+    FONT_PEN_T pen;
+    initPenIndexed(&pen, index, image);
+
+    drawCharPen(x, y, c, &pen, image);
+}
+
+//-------------------------------------------------------------------------
+
+void
+drawCharRGB(
+    int x,
+    int y,
+    uint8_t c,
+    const RGBA8_T *rgb,
+    IMAGE_T *image)
+{
+    FONT_PEN_T pen;
+    initPenRGB(&pen, rgb, image);
+
+    drawCharPen(x, y, c, &pen, image);
+}
+
+//-------------------------------------------------------------------------
+
+void
+drawStringIndexed(
+    int x,
+    int y,
+    const char *string,
+    int8_t index,
+    IMAGE_T *image)
+{
+    if (string == NULL)
+    {
+        return;
+    }
+
+    FONT_PEN_T pen;
+    initPenIndexed(&pen, index, image);
+
+    drawStringPen(x, y, string, &pen, image);
 }
 
 //-------------------------------------------------------------------------
@@ -4749,21 +5173,92 @@ drawStringRGB(
         return;
     }
 
-    int x_first = x;
+    FONT_PEN_T pen;
+    initPenRGB(&pen, rgb, image);
+
+    drawStringPen(x, y, string, &pen, image);
+}
+
+
+//-------------------------------------------------------------------------
+
+void
+initFontCache(
+    FONT_CACHE_T *cache)
+{
+    memset(cache, 0, sizeof(*cache));
+}
+
+//-------------------------------------------------------------------------
 
-    while (*string != '\0')
+void
+destroyFontCache(
+    FONT_CACHE_T *cache)
+{
+    int i;
+    for (i = 0 ; i < FONT_CACHE_ENTRIES ; i++)
     {
-        if (*string == '\n')
-        {
-            x = x_first;
-            y += FONT_HEIGHT;
-        }
-        else
+        FONT_CACHE_ENTRY_T *entry = &(cache->entries[i]);
+
+        if (entry->string != NULL)
         {
-            drawCharRGB(x, y, *string, rgb, image);
-            x += FONT_WIDTH;
+            free(entry->string);
+            destroyImage(&(entry->block));
+            entry->string = NULL;
         }
-        ++string;
     }
+
+    cache->used = 0;
 }
 
+//-------------------------------------------------------------------------
+
+void
+drawStringCachedIndexed(
+    FONT_CACHE_T *cache,
+    int x,
+    int y,
+    const char *string,
+    int8_t index,
+    int8_t background,
+    IMAGE_T *image)
+{
+    if (string == NULL)
+    {
+        return;
+    }
+
+    FONT_PEN_T pen;
+    initPenIndexed(&pen, index, image);
+
+    FONT_PEN_T backgroundPen;
+    initPenIndexed(&backgroundPen, background, image);
+
+    drawStringCachedPen(cache, x, y, string, &pen, &backgroundPen, image);
+}
+
+//-------------------------------------------------------------------------
+
+void
+drawStringCachedRGB(
+    FONT_CACHE_T *cache,
+    int x,
+    int y,
+    const char *string,
+    const RGBA8_T *rgb,
+    const RGBA8_T *background,
+    IMAGE_T *image)
+{
+    if (string == NULL)
+    {
+        return;
+    }
+
+    FONT_PEN_T pen;
+    initPenRGB(&pen, rgb, image);
+
+    FONT_PEN_T backgroundPen;
+    initPenRGB(&backgroundPen, background, image);
+
+    drawStringCachedPen(cache, x, y, string, &pen, &backgroundPen, image);
+}
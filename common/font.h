@@ -38,6 +38,31 @@
 #define FONT_WIDTH 8
 #define FONT_HEIGHT 16
 
+//-------------------------------------------------------------------------
+// Labels that are redrawn often can be drawn through a font cache. Each
+// entry holds the pixels of a string rendered on its background for one
+// image type and pair of colours, so a string that is in the cache is
+// drawn with a copy per row. A cache belongs to its caller and should
+// only be used from one thread.
+
+#define FONT_CACHE_ENTRIES 16
+
+typedef struct
+{
+    char *string;
+    VC_IMAGE_TYPE_T type;
+    uint8_t foreground[4];
+    uint8_t background[4];
+    IMAGE_T block;
+    uint32_t lastUsed;
+} FONT_CACHE_ENTRY_T;
+
+typedef struct
+{
+    FONT_CACHE_ENTRY_T entries[FONT_CACHE_ENTRIES];
+    uint32_t used;
+} FONT_CACHE_T;
+
 //-------------------------------------------------------------------------
 
 void
@@ -56,6 +81,8 @@ drawCharRGB(
     const RGBA8_T *rgb,
     IMAGE_T *image);
 
+//-------------------------------------------------------------------------
+
 void
 drawStringIndexed(
     int x,
@@ -74,4 +101,38 @@ drawStringRGB(
 
 //-------------------------------------------------------------------------
 
+void
+initFontCache(
+    FONT_CACHE_T *cache);
+
+void
+destroyFontCache(
+    FONT_CACHE_T *cache);
+
+// The string is drawn over a rectangle filled with the background colour,
+// as wide as its longest line. Images that are dithered or have less than
+// a byte per pixel are drawn without the cache.
+
+void
+drawStringCachedIndexed(
+    FONT_CACHE_T *cache,
+    int x,
+    int y,
+    const char *string,
+    int8_t index,
+    int8_t background,
+    IMAGE_T *image);
+
+void
+drawStringCachedRGB(
+    FONT_CACHE_T *cache,
+    int x,
+    int y,
+    const char *string,
+    const RGBA8_T *rgb,
+    const RGBA8_T *background,
+    IMAGE_T *image);
+
+//-------------------------------------------------------------------------
+
 #endif
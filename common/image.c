@@ -30,6 +30,7 @@
 #include <string.h>
 
 #include "image.h"
+#include "imageConvert.h"
 
 //-------------------------------------------------------------------------
 
@@ -55,13 +56,35 @@ void getPixelRGB888(IMAGE_T *image, int32_t x, int32_t y, RGBA8_T *rgba);
 void getPixelRGBA16(IMAGE_T *image, int32_t x, int32_t y, RGBA8_T *rgba);
 void getPixelRGBA32(IMAGE_T *image, int32_t x, int32_t y, RGBA8_T *rgba);
 
+void fillSpan4BPP(IMAGE_T *image, int32_t x, int32_t y, int32_t length, int8_t index);
+void fillSpan8BPP(IMAGE_T *image, int32_t x, int32_t y, int32_t length, int8_t index);
+void fillSpanRGB565(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void fillSpanDitheredRGB565(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void fillSpanRGB888(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void fillSpanRGBA16(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void fillSpanDitheredRGBA16(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void fillSpanRGBA32(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+
+void setSpanRGB565(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void setSpanDitheredRGB565(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void setSpanRGB888(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void setSpanRGBA16(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void setSpanDitheredRGBA16(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+void setSpanRGBA32(IMAGE_T *image, int32_t x, int32_t y, int32_t length, const RGBA8_T *rgba);
+
+void getSpanRGB565(IMAGE_T *image, int32_t x, int32_t y, int32_t length, RGBA8_T *rgba);
+void getSpanRGB888(IMAGE_T *image, int32_t x, int32_t y, int32_t length, RGBA8_T *rgba);
+void getSpanRGBA16(IMAGE_T *image, int32_t x, int32_t y, int32_t length, RGBA8_T *rgba);
+void getSpanRGBA32(IMAGE_T *image, int32_t x, int32_t y, int32_t length, RGBA8_T *rgba);
+
 //-------------------------------------------------------------------------
 
-bool initImage(
+// Set the pixel functions for the type of image.
+
+static bool
+initImageFunctions(
     IMAGE_T *image,
     VC_IMAGE_TYPE_T type,
-    int32_t width,
-    int32_t height,
     bool dither)
 {
     switch (type)
@@ -73,6 +96,10 @@ bool initImage(
         image->getPixelDirect = NULL;
         image->setPixelIndexed = setPixel4BPP;
         image->getPixelIndexed = getPixel4BPP;
+        image->fillSpanDirect = NULL;
+        image->setSpanDirect = NULL;
+        image->getSpanDirect = NULL;
+        image->fillSpanIndexed = fillSpan4BPP;
 
         break;
 
@@ -83,6 +110,10 @@ bool initImage(
         image->getPixelDirect = NULL;
         image->setPixelIndexed = setPixel8BPP;
         image->getPixelIndexed = getPixel8BPP;
+        image->fillSpanDirect = NULL;
+        image->setSpanDirect = NULL;
+        image->getSpanDirect = NULL;
+        image->fillSpanIndexed = fillSpan8BPP;
 
         break;
 
@@ -93,14 +124,20 @@ bool initImage(
         if (dither)
         {
             image->setPixelDirect = setPixelDitheredRGB565;
+            image->fillSpanDirect = fillSpanDitheredRGB565;
+            image->setSpanDirect = setSpanDitheredRGB565;
         }
         else
         {
             image->setPixelDirect = setPixelRGB565;
+            image->fillSpanDirect = fillSpanRGB565;
+            image->setSpanDirect = setSpanRGB565;
         }
         image->getPixelDirect = getPixelRGB565;
+        image->getSpanDirect = getSpanRGB565;
         image->setPixelIndexed = NULL;
         image->getPixelIndexed = NULL;
+        image->fillSpanIndexed = NULL;
 
         break;
 
@@ -111,6 +148,10 @@ bool initImage(
         image->getPixelDirect = getPixelRGB888;
         image->setPixelIndexed = NULL;
         image->getPixelIndexed = NULL;
+        image->fillSpanDirect = fillSpanRGB888;
+        image->setSpanDirect = setSpanRGB888;
+        image->getSpanDirect = getSpanRGB888;
+        image->fillSpanIndexed = NULL;
 
         break;
 
@@ -120,14 +161,20 @@ bool initImage(
         if (dither)
         {
             image->setPixelDirect = setPixelDitheredRGBA16;
+            image->fillSpanDirect = fillSpanDitheredRGBA16;
+            image->setSpanDirect = setSpanDitheredRGBA16;
         }
         else
         {
             image->setPixelDirect = setPixelRGBA16;
+            image->fillSpanDirect = fillSpanRGBA16;
+            image->setSpanDirect = setSpanRGBA16;
         }
         image->getPixelDirect = getPixelRGBA16;
+        image->getSpanDirect = getSpanRGBA16;
         image->setPixelIndexed = NULL;
         image->getPixelIndexed = NULL;
+        image->fillSpanIndexed = NULL;
 
         break;
 
@@ -138,6 +185,10 @@ bool initImage(
         image->getPixelDirect = getPixelRGBA32;
         image->setPixelIndexed = NULL;
         image->getPixelIndexed = NULL;
+        image->fillSpanDirect = fillSpanRGBA32;
+        image->setSpanDirect = setSpanRGBA32;
+        image->getSpanDirect = getSpanRGBA32;
+        image->fillSpanIndexed = NULL;
 
         break;
 
@@ -149,6 +200,18 @@ bool initImage(
         break;
     }
 
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+static void
+initImageLayout(
+    IMAGE_T *image,
+    VC_IMAGE_TYPE_T type,
+    int32_t width,
+    int32_t height)
+{
     image->type = type;
     image->width = width;
     image->height = height;
@@ -156,7 +219,37 @@ bool initImage(
     image->alignedHeight = ALIGN_TO_16(height);
     image->size = image->pitch * image->alignedHeight;
 
+    image->clip.depth = 0;
+    vc_dispmanx_rect_set(&(image->clip.rects[0]), 0, 0, width, height);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+freeImageBuffer(
+    IMAGE_T *image)
+{
+    free(image->buffer);
+}
+
+//-------------------------------------------------------------------------
+
+bool initImage(
+    IMAGE_T *image,
+    VC_IMAGE_TYPE_T type,
+    int32_t width,
+    int32_t height,
+    bool dither)
+{
+    if (initImageFunctions(image, type, dither) == false)
+    {
+        return false;
+    }
+
+    initImageLayout(image, type, width, height);
+
     image->buffer = calloc(1, image->size);
+    image->destroyBuffer = freeImageBuffer;
 
     if (image->buffer == NULL)
     {
@@ -164,6 +257,35 @@ bool initImage(
         exit(EXIT_FAILURE);
     }
 
+    markImageAllDirty(image);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+initImageWithBuffer(
+    IMAGE_T *image,
+    VC_IMAGE_TYPE_T type,
+    int32_t width,
+    int32_t height,
+    bool dither,
+    void *buffer,
+    void (*destroyBuffer)(IMAGE_T*))
+{
+    if (initImageFunctions(image, type, dither) == false)
+    {
+        return false;
+    }
+
+    initImageLayout(image, type, width, height);
+
+    image->buffer = buffer;
+    image->destroyBuffer = destroyBuffer;
+
+    markImageAllDirty(image);
+
     return true;
 }
 
@@ -174,17 +296,15 @@ clearImageIndexed(
     IMAGE_T *image,
     int8_t index)
 {
-    if (image->setPixelIndexed != NULL)
+    if (image->fillSpanIndexed != NULL)
     {
         int j;
         for (j = 0 ; j < image->height ; j++)
         {
-            int i;
-            for (i = 0 ; i < image->width ; i++)
-            {
-                image->setPixelIndexed(image, i, j, index);
-            }
+            image->fillSpanIndexed(image, 0, j, image->width, index);
         }
+
+        markImageAllDirty(image);
     }
 }
 
@@ -195,17 +315,15 @@ clearImageRGB(
     IMAGE_T *image,
     const RGBA8_T *rgb)
 {
-    if (image->setPixelDirect != NULL)
+    if (image->fillSpanDirect != NULL)
     {
         int j;
         for (j = 0 ; j < image->height ; j++)
         {
-            int i;
-            for (i = 0 ; i < image->width ; i++)
-            {
-                image->setPixelDirect(image, i, j, rgb);
-            }
+            image->fillSpanDirect(image, 0, j, image->width, rgb);
         }
+
+        markImageAllDirty(image);
     }
 }
 
@@ -218,152 +336,880 @@ setPixelIndexed(
     int32_t y,
     int8_t index)
 {
+    const VC_RECT_T *clip = getImageClip(image);
     bool result = false;
 
     if ((image->setPixelIndexed != NULL) &&
+        (x >= clip->x) && (x < clip->x + clip->width) &&
+        (y >= clip->y) && (y < clip->y + clip->height))
+    {
+        result = true;
+        image->setPixelIndexed(image, x, y, index);
+        markImageDirty(image, x, y, 1, 1);
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+setPixelRGB(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgb)
+{
+    const VC_RECT_T *clip = getImageClip(image);
+    bool result = false;
+
+    if ((image->setPixelDirect != NULL) &&
+        (x >= clip->x) && (x < clip->x + clip->width) &&
+        (y >= clip->y) && (y < clip->y + clip->height))
+    {
+        result = true;
+        image->setPixelDirect(image, x, y, rgb);
+        markImageDirty(image, x, y, 1, 1);
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+getPixelIndexed(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int8_t *index)
+{
+    bool result = false;
+
+    if ((image->getPixelIndexed != NULL) && 
         (x >= 0) && (x < image->width) &&
         (y >= 0) && (y < image->height))
     {
         result = true;
-        image->setPixelIndexed(image, x, y, index);
+        image->getPixelIndexed(image, x, y, index);
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+getPixelRGB(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    RGBA8_T *rgb)
+{
+    bool result = false;
+
+    if ((image->getPixelDirect != NULL) &&
+        (x >= 0) && (x < image->width) &&
+        (y >= 0) && (y < image->height))
+    {
+        result = true;
+        image->getPixelDirect(image, x, y, rgb);
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+clipSpan(
+    const VC_RECT_T *rect,
+    int32_t *x,
+    int32_t y,
+    int32_t *length,
+    int32_t *skip)
+{
+    *skip = 0;
+
+    if ((y < rect->y) || (y >= rect->y + rect->height) || (*length <= 0))
+    {
+        return false;
+    }
+
+    if (*x < rect->x)
+    {
+        *skip = rect->x - *x;
+        *length -= *skip;
+        *x = rect->x;
+    }
+
+    if (*length > rect->x + rect->width - *x)
+    {
+        *length = rect->x + rect->width - *x;
+    }
+
+    return (*length > 0);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+fillSpanIndexed(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    int8_t index)
+{
+    int32_t skip = 0;
+    bool result = false;
+
+    if ((image->fillSpanIndexed != NULL) &&
+        clipSpan(getImageClip(image), &x, y, &length, &skip))
+    {
+        result = true;
+        image->fillSpanIndexed(image, x, y, length, index);
+        markImageDirty(image, x, y, length, 1);
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+fillSpanRGB(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    const RGBA8_T *rgb)
+{
+    int32_t skip = 0;
+    bool result = false;
+
+    if ((image->fillSpanDirect != NULL) &&
+        clipSpan(getImageClip(image), &x, y, &length, &skip))
+    {
+        result = true;
+        image->fillSpanDirect(image, x, y, length, rgb);
+        markImageDirty(image, x, y, length, 1);
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+setSpanRGB(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    const RGBA8_T *rgb)
+{
+    int32_t skip = 0;
+    bool result = false;
+
+    if ((image->setSpanDirect != NULL) &&
+        clipSpan(getImageClip(image), &x, y, &length, &skip))
+    {
+        result = true;
+        image->setSpanDirect(image, x, y, length, rgb + skip);
+        markImageDirty(image, x, y, length, 1);
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+getSpanRGB(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    RGBA8_T *rgb)
+{
+    VC_RECT_T whole = { 0, 0, image->width, image->height };
+    int32_t skip = 0;
+    bool result = false;
+
+    if ((image->getSpanDirect != NULL) &&
+        clipSpan(&whole, &x, y, &length, &skip))
+    {
+        result = true;
+        image->getSpanDirect(image, x, y, length, rgb + skip);
+    }
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+pushImageClip(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t width,
+    int32_t height)
+{
+    IMAGE_CLIP_T *clip = &(image->clip);
+
+    if (clip->depth >= IMAGE_CLIP_DEPTH)
+    {
+        ++(clip->depth);
+        return false;
+    }
+
+    const VC_RECT_T *current = &(clip->rects[clip->depth]);
+
+    int32_t left = (x > current->x) ? x : current->x;
+    int32_t top = (y > current->y) ? y : current->y;
+    int32_t right = x + width;
+    int32_t bottom = y + height;
+
+    if (right > current->x + current->width)
+    {
+        right = current->x + current->width;
+    }
+
+    if (bottom > current->y + current->height)
+    {
+        bottom = current->y + current->height;
+    }
+
+    if (right < left)
+    {
+        right = left;
+    }
+
+    if (bottom < top)
+    {
+        bottom = top;
+    }
+
+    ++(clip->depth);
+    vc_dispmanx_rect_set(&(clip->rects[clip->depth]),
+                         left,
+                         top,
+                         right - left,
+                         bottom - top);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+void
+popImageClip(
+    IMAGE_T *image)
+{
+    if (image->clip.depth > 0)
+    {
+        --(image->clip.depth);
     }
+}
+
+//-------------------------------------------------------------------------
+
+const VC_RECT_T *
+getImageClip(
+    const IMAGE_T *image)
+{
+    const IMAGE_CLIP_T *clip = &(image->clip);
+
+    if (clip->depth > IMAGE_CLIP_DEPTH)
+    {
+        return &(clip->rects[IMAGE_CLIP_DEPTH]);
+    }
+
+    return &(clip->rects[clip->depth]);
+}
+
+//-------------------------------------------------------------------------
+
+// Use the image's own set pixel function on a one pixel copy of the image
+// that points at 'pixel'.
+
+static void
+onePixelImage(
+    const IMAGE_T *image,
+    uint8_t *pixel,
+    IMAGE_T *copy)
+{
+    *copy = *image;
+    copy->width = 1;
+    copy->height = 1;
+    copy->pitch = image->bitsPerPixel / 8;
+    copy->alignedHeight = 1;
+    copy->size = copy->pitch;
+    copy->buffer = pixel;
+    copy->destroyBuffer = NULL;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+packPixelIndexed(
+    const IMAGE_T *image,
+    int8_t index,
+    uint8_t *pixel)
+{
+    if ((image->setPixelIndexed == NULL) || (image->bitsPerPixel < 8))
+    {
+        return false;
+    }
+
+    IMAGE_T copy;
+    onePixelImage(image, pixel, &copy);
+    copy.setPixelIndexed(&copy, 0, 0, index);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+packPixelRGB(
+    const IMAGE_T *image,
+    const RGBA8_T *rgb,
+    uint8_t *pixel)
+{
+    if ((image->setPixelDirect == NULL) ||
+        (image->bitsPerPixel < 8) ||
+        (image->setPixelDirect == setPixelDitheredRGB565) ||
+        (image->setPixelDirect == setPixelDitheredRGBA16))
+    {
+        return false;
+    }
+
+    IMAGE_T copy;
+    onePixelImage(image, pixel, &copy);
+    copy.setPixelDirect(&copy, 0, 0, rgb);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+// Grow the bounds to include dirty rectangle 'index' and remove it.
+
+static void
+absorbDirtyRect(
+    IMAGE_DIRTY_T *dirty,
+    int32_t index,
+    int32_t *left,
+    int32_t *top,
+    int32_t *right,
+    int32_t *bottom)
+{
+    const VC_RECT_T *rect = &(dirty->rects[index]);
+
+    if (rect->x < *left)
+    {
+        *left = rect->x;
+    }
+
+    if (rect->y < *top)
+    {
+        *top = rect->y;
+    }
+
+    if (rect->x + rect->width > *right)
+    {
+        *right = rect->x + rect->width;
+    }
+
+    if (rect->y + rect->height > *bottom)
+    {
+        *bottom = rect->y + rect->height;
+    }
+
+    dirty->rects[index] = dirty->rects[--(dirty->count)];
+}
+
+//-------------------------------------------------------------------------
+
+void
+markImageDirty(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t width,
+    int32_t height)
+{
+    if (x < 0)
+    {
+        width += x;
+        x = 0;
+    }
+
+    if (y < 0)
+    {
+        height += y;
+        y = 0;
+    }
+
+    if (width > image->width - x)
+    {
+        width = image->width - x;
+    }
+
+    if (height > image->height - y)
+    {
+        height = image->height - y;
+    }
+
+    if ((width <= 0) || (height <= 0))
+    {
+        return;
+    }
+
+    //---------------------------------------------------------------------
+
+    IMAGE_DIRTY_T *dirty = &(image->dirty);
+    int32_t left = x;
+    int32_t top = y;
+    int32_t right = x + width;
+    int32_t bottom = y + height;
+
+    int32_t i;
+    for (i = 0 ; i < dirty->count ; i++)
+    {
+        const VC_RECT_T *rect = &(dirty->rects[i]);
+
+        if ((left >= rect->x) &&
+            (right <= rect->x + rect->width) &&
+            (top >= rect->y) &&
+            (bottom <= rect->y + rect->height))
+        {
+            return;
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    // Absorb the rectangles that share or touch rows with the new one,
+    // until none are left. If there is still no room for it, absorb the
+    // nearest rectangle and check again.
+
+    while (true)
+    {
+        bool absorbed = false;
+        int32_t nearest = -1;
+        int32_t nearestGap = 0;
+
+        i = 0;
+        while (i < dirty->count)
+        {
+            const VC_RECT_T *rect = &(dirty->rects[i]);
+            int32_t gap = (rect->y > bottom)
+                        ? rect->y - bottom
+                        : top - (rect->y + rect->height);
+
+            if (gap <= 0)
+            {
+                absorbDirtyRect(dirty, i, &left, &top, &right, &bottom);
+                absorbed = true;
+            }
+            else
+            {
+                if ((nearest == -1) || (gap < nearestGap))
+                {
+                    nearest = i;
+                    nearestGap = gap;
+                }
+
+                i++;
+            }
+        }
+
+        if (absorbed == false)
+        {
+            if (dirty->count < IMAGE_DIRTY_RECTS)
+            {
+                break;
+            }
+
+            absorbDirtyRect(dirty, nearest, &left, &top, &right, &bottom);
+        }
+    }
+
+    vc_dispmanx_rect_set(&(dirty->rects[dirty->count]),
+                         left,
+                         top,
+                         right - left,
+                         bottom - top);
+    dirty->count++;
+}
+
+//-------------------------------------------------------------------------
+
+void
+markImageAllDirty(
+    IMAGE_T *image)
+{
+    image->dirty.count = 0;
+    markImageDirty(image, 0, 0, image->width, image->height);
+}
+
+//-------------------------------------------------------------------------
+
+void
+clearImageDirty(
+    IMAGE_T *image)
+{
+    image->dirty.count = 0;
+}
+
+//-------------------------------------------------------------------------
+
+void
+destroyImage(
+    IMAGE_T *image)
+{
+    if ((image->buffer != NULL) && (image->destroyBuffer != NULL))
+    {
+        image->destroyBuffer(image);
+    }
+
+    image->type = VC_IMAGE_MIN;
+    image->width = 0;
+    image->height = 0;
+    image->pitch = 0;
+    image->alignedHeight = 0;
+    image->bitsPerPixel = 0;
+    image->size = 0;
+    image->buffer = NULL;
+    image->destroyBuffer = NULL;
+    image->dirty.count = 0;
+    image->clip.depth = 0;
+    vc_dispmanx_rect_set(&(image->clip.rects[0]), 0, 0, 0, 0);
+    image->setPixelDirect = NULL;
+    image->getPixelDirect = NULL;
+    image->setPixelIndexed = NULL;
+    image->getPixelIndexed = NULL;
+    image->fillSpanDirect = NULL;
+    image->setSpanDirect = NULL;
+    image->getSpanDirect = NULL;
+    image->fillSpanIndexed = NULL;
+}
+
+//-----------------------------------------------------------------------
+
+void
+setPixel4BPP(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int8_t index)
+{
+    index &= 0x0F;
+
+    uint8_t *value = (uint8_t*)(image->buffer + (x/2) + (y *image->pitch));
+
+    if (x % 2)
+    {
+        *value = (*value & 0xF0) | (index);
+    }
+    else
+    {
+        *value = (*value & 0x0F) | (index << 4);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void
+setPixel8BPP(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int8_t index)
+{
+    *(uint8_t*)(image->buffer + x + (y * image->pitch)) = index;
+}
+
+//-----------------------------------------------------------------------
+
+void
+setPixelRGB565(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgba)
+{
+    uint8_t r5 = rgba->red >> 3;
+    uint8_t g6 = rgba->green >> 2;
+    uint8_t b5 = rgba->blue >> 3;
+
+    uint16_t pixel = (r5 << 11) | (g6 << 5) | b5;
+    *(uint16_t*)(image->buffer + (x * 2) + (y *image->pitch)) = pixel;
+}
+
+//-----------------------------------------------------------------------
+
+void
+setPixelDitheredRGB565(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgba)
+{
+    uint16_t *pixel = (uint16_t*)(image->buffer + (x * 2) + (y * image->pitch));
+    rgba8RowToDitheredRgb565(rgba, pixel, x, y, 1);
+}
+
+//-------------------------------------------------------------------------
+
+void
+setPixelRGB888(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgba)
+{
+    uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (3*x);
+    line[0] = rgba->red;
+    line[1] = rgba->green;
+    line[2] = rgba->blue;
+}
+
+//-----------------------------------------------------------------------
+
+void
+setPixelRGBA16(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgba)
+{
+    uint8_t r4 = rgba->red  >> 4;
+    uint8_t g4 = rgba->green >> 4;
+    uint8_t b4 = rgba->blue >> 4;
+    uint8_t a4 = rgba->alpha >> 4;
+
+    uint16_t pixel = (r4 << 12) | (g4 << 8) | (b4 << 4) | a4;
+    *(uint16_t*)(image->buffer + (x * 2) + (y *image->pitch)) = pixel;
+}
+
+//-----------------------------------------------------------------------
+
+void
+setPixelDitheredRGBA16(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgba)
+{
+    uint16_t *pixel = (uint16_t*)(image->buffer + (x * 2) + (y * image->pitch));
+    rgba8RowToDitheredRgba16(rgba, pixel, x, y, 1);
+}
+
+//-----------------------------------------------------------------------
+
+void
+setPixelRGBA32(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgba)
+{
+    uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (4*x);
+
+    line[0] = rgba->red;
+    line[1] = rgba->green;
+    line[2] = rgba->blue;
+    line[3] = rgba->alpha;
+}
+
+//-----------------------------------------------------------------------
+
+void
+getPixel4BPP(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int8_t *index)
+{
+    uint8_t *value = (uint8_t*)(image->buffer + (x/2) + (y *image->pitch));
+
+    if (x % 2)
+    {
+        *index = (*value) & 0x0F;
+    }
+    else
+    {
+        *index = (*value) >> 4;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+void
+getPixel8BPP(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int8_t *index)
+{
+    *index = *(uint8_t*)(image->buffer + x + (y * image->pitch));
+}
+
+//-----------------------------------------------------------------------
+
+void
+getPixelRGB565(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    RGBA8_T *rgba)
+{
+    uint16_t pixel = *(uint16_t*)(image->buffer + (x * 2) + (y * image->pitch));
+
+    uint8_t r5 = (pixel >> 11) & 0x1F;
+    uint8_t g6 = (pixel >> 5) & 0x3F;
+    uint8_t b5 = pixel & 0x1F;
 
-    return result;
+    rgba->red = (r5 << 3) | (r5 >> 2);
+    rgba->green = (g6 << 2) | (g6 >> 4);
+    rgba->blue = (b5 << 3) | (b5 >> 2);
+    rgba->alpha = 255;
 }
 
 //-------------------------------------------------------------------------
 
-bool
-setPixelRGB(
+void
+getPixelRGB888(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
-    const RGBA8_T *rgb)
+    RGBA8_T *rgba)
 {
-    bool result = false;
-
-    if ((image->setPixelDirect != NULL) &&
-        (x >= 0) && (x < image->width) &&
-        (y >= 0) && (y < image->height))
-    {
-        result = true;
-        image->setPixelDirect(image, x, y, rgb);
-    }
-
-    return result;
+    uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (3*x);
+    rgba->red = line[0];
+    rgba->green = line[1];
+    rgba->blue = line[2];
+    rgba->alpha = 255;
 }
 
-//-------------------------------------------------------------------------
+//-----------------------------------------------------------------------
 
-bool
-getPixelIndexed(
+void
+getPixelRGBA16(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
-    int8_t *index)
+    RGBA8_T *rgba)
 {
-    bool result = false;
-
-    if ((image->getPixelIndexed != NULL) && 
-        (x >= 0) && (x < image->width) &&
-        (y >= 0) && (y < image->height))
-    {
-        result = true;
-        image->getPixelIndexed(image, x, y, index);
-    }
+    uint16_t pixel = *(uint16_t*)(image->buffer+(x*2)+(y*image->pitch));
+    uint8_t r4 = (pixel >> 12) & 0xF;
+    uint8_t g4 = (pixel >> 8) & 0xF;
+    uint8_t b4 = (pixel >> 4) & 0xF;
+    uint8_t a4 = (pixel & 0xF);
 
-    return result;
+    rgba->red = (r4 << 4) | r4;
+    rgba->green = (g4 << 4) | g4;
+    rgba->blue = (b4 << 4) | b4;
+    rgba->alpha = (a4 << 4) | a4;
 }
 
-//-------------------------------------------------------------------------
+//-----------------------------------------------------------------------
 
-bool
-getPixelRGB(
+void
+getPixelRGBA32(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
-    RGBA8_T *rgb)
+    RGBA8_T *rgba)
 {
-    bool result = false;
-
-    if ((image->getPixelDirect != NULL) &&
-        (x >= 0) && (x < image->width) &&
-        (y >= 0) && (y < image->height))
-    {
-        result = true;
-        image->getPixelDirect(image, x, y, rgb);
-    }
+    uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (4*x);
 
-    return result;
+    rgba->red = line[0];
+    rgba->green = line[1];
+    rgba->blue = line[2];
+    rgba->alpha = line[3];
 }
 
-//-------------------------------------------------------------------------
+//-----------------------------------------------------------------------
 
-void
-destroyImage(
-    IMAGE_T *image)
+static void
+fillSpan16(
+    uint16_t *line,
+    int32_t length,
+    uint16_t pixel)
 {
-    if (image->buffer)
+    if ((pixel >> 8) == (pixel & 0xFF))
     {
-        free(image->buffer);
+        memset(line, pixel & 0xFF, length * sizeof(uint16_t));
+    }
+    else
+    {
+        int32_t i;
+        for (i = 0 ; i < length ; i++)
+        {
+            line[i] = pixel;
+        }
     }
-
-    image->type = VC_IMAGE_MIN;
-    image->width = 0;
-    image->height = 0;
-    image->pitch = 0;
-    image->alignedHeight = 0;
-    image->bitsPerPixel = 0;
-    image->size = 0;
-    image->buffer = NULL;
-    image->setPixelDirect = NULL;
-    image->getPixelDirect = NULL;
-    image->setPixelIndexed = NULL;
-    image->getPixelIndexed = NULL;
 }
 
 //-----------------------------------------------------------------------
 
 void
-setPixel4BPP(
+fillSpan4BPP(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     int8_t index)
 {
     index &= 0x0F;
 
-    uint8_t *value = (uint8_t*)(image->buffer + (x/2) + (y *image->pitch));
-
     if (x % 2)
     {
-        *value = (*value & 0xF0) | (index);
+        setPixel4BPP(image, x, y, index);
+        ++x;
+        --length;
     }
-    else
+
+    if (length % 2)
     {
-        *value = (*value & 0x0F) | (index << 4);
+        setPixel4BPP(image, x + length - 1, y, index);
+        --length;
+    }
+
+    if (length > 0)
+    {
+        uint8_t *line = (uint8_t*)(image->buffer + (x/2) + (y *image->pitch));
+        memset(line, (index << 4) | index, length / 2);
     }
 }
 
 //-----------------------------------------------------------------------
 
 void
-setPixel8BPP(
+fillSpan8BPP(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     int8_t index)
 {
-    *(uint8_t*)(image->buffer + x + (y * image->pitch)) = index;
+    memset(image->buffer + x + (y * image->pitch), (uint8_t)index, length);
 }
 
 //-----------------------------------------------------------------------
 
 void
-setPixelRGB565(
+fillSpanRGB565(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     const RGBA8_T *rgba)
 {
     uint8_t r5 = rgba->red >> 3;
@@ -371,92 +1217,84 @@ setPixelRGB565(
     uint8_t b5 = rgba->blue >> 3;
 
     uint16_t pixel = (r5 << 11) | (g6 << 5) | b5;
-    *(uint16_t*)(image->buffer + (x * 2) + (y *image->pitch)) = pixel;
+    fillSpan16((uint16_t*)(image->buffer + (x * 2) + (y * image->pitch)),
+               length,
+               pixel);
 }
 
 //-----------------------------------------------------------------------
 
 void
-setPixelDitheredRGB565(
+fillSpanDitheredRGB565(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     const RGBA8_T *rgba)
 {
-    static int16_t dither8[64] =
-    {
-        1, 6, 2, 7, 1, 6, 2, 7,
-        4, 2, 5, 4, 4, 3, 6, 4,
-        1, 7, 1, 6, 2, 7, 1, 7,
-        5, 3, 5, 3, 5, 4, 5, 3,
-        1, 6, 2, 7, 1, 6, 2, 7,
-        4, 3, 6, 4, 4, 2, 6, 4,
-        2, 7, 1, 7, 2, 7, 1, 6,
-        5, 3, 5, 3, 5, 3, 5, 3,
-    };
-
-    static int16_t dither4[64] =
-    {
-        1, 3, 1, 3, 1, 3, 1, 3,
-        2, 1, 3, 2, 2, 1, 3, 2,
-        1, 3, 1, 3, 1, 3, 1, 3,
-        2, 2, 2, 1, 3, 2, 2, 2,
-        1, 3, 1, 3, 1, 3, 1, 3,
-        2, 1, 3, 2, 2, 1, 3, 2,
-        1, 3, 1, 3, 1, 3, 1, 3,
-        3, 2, 2, 2, 2, 2, 2, 2,
-    };
-
-    int32_t index = (x & 7) | ((y & 7) << 3);
+    // the dither pattern repeats every eight pixels
 
-    int16_t r = rgba->red + dither8[index];
+    RGBA8_T colour[8];
+    uint16_t pattern[8];
 
-    if (r > 255)
+    int32_t i;
+    for (i = 0 ; i < 8 ; i++)
     {
-        r = 255;
+        colour[i] = *rgba;
     }
 
-    int16_t g = rgba->green + dither4[index];
+    rgba8RowToDitheredRgb565(colour, pattern, x, y, 8);
 
-    if (g > 255)
-    {
-        g = 255;
-    }
+    uint16_t *line = (uint16_t*)(image->buffer + (x * 2) + (y *image->pitch));
 
-    int16_t b = rgba->blue + dither8[index];
-
-    if (b > 255)
+    for (i = 0 ; i < length ; i++)
     {
-        b = 255;
+        line[i] = pattern[i & 7];
     }
-
-    RGBA8_T dithered = { r, g, b, rgba->alpha };
-
-    setPixelRGB565(image, x, y, &dithered);
 }
 
-//-------------------------------------------------------------------------
+//-----------------------------------------------------------------------
 
 void
-setPixelRGB888(
+fillSpanRGB888(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     const RGBA8_T *rgba)
 {
     uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (3*x);
+
+    if ((rgba->red == rgba->green) && (rgba->red == rgba->blue))
+    {
+        memset(line, rgba->red, 3 * length);
+        return;
+    }
+
     line[0] = rgba->red;
     line[1] = rgba->green;
     line[2] = rgba->blue;
+
+    // double the filled region each time until the span is complete
+
+    int32_t filled = 1;
+
+    while (filled < length)
+    {
+        int32_t copy = (filled < length - filled) ? filled : length - filled;
+        memcpy(line + (3 * filled), line, 3 * copy);
+        filled += copy;
+    }
 }
 
 //-----------------------------------------------------------------------
 
 void
-setPixelRGBA16(
+fillSpanRGBA16(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     const RGBA8_T *rgba)
 {
     uint8_t r4 = rgba->red  >> 4;
@@ -465,188 +1303,214 @@ setPixelRGBA16(
     uint8_t a4 = rgba->alpha >> 4;
 
     uint16_t pixel = (r4 << 12) | (g4 << 8) | (b4 << 4) | a4;
-    *(uint16_t*)(image->buffer + (x * 2) + (y *image->pitch)) = pixel;
+    fillSpan16((uint16_t*)(image->buffer + (x * 2) + (y * image->pitch)),
+               length,
+               pixel);
 }
 
 //-----------------------------------------------------------------------
 
 void
-setPixelDitheredRGBA16(
+fillSpanDitheredRGBA16(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     const RGBA8_T *rgba)
 {
-    static int16_t dither16[64] =
-    {
-         1,  12,   4,  15,   1,  13,   4,  15,
-         8,   4,  11,   7,   9,   5,  12,   8,
-         3,  14,   2,  13,   3,  15,   2,  14,
-        10,   6,   9,   5,  11,   7,  10,   6,
-         1,  12,   4,  15,   1,  12,   4,  15,
-         9,   5,  12,   8,   8,   5,  11,   8,
-         3,  14,   2,  13,   3,  14,   2,  13,
-        11,   7,  10,   6,  10,   7,   9,   6,
-    };
-
-    int32_t index = (x & 7) | ((y & 7) << 3);
+    // the dither pattern repeats every eight pixels
 
-    int16_t r = rgba->red + dither16[index];
+    RGBA8_T colour[8];
+    uint16_t pattern[8];
 
-    if (r > 255)
+    int32_t i;
+    for (i = 0 ; i < 8 ; i++)
     {
-        r = 255;
+        colour[i] = *rgba;
     }
 
-    int16_t g = rgba->green + dither16[index];
+    rgba8RowToDitheredRgba16(colour, pattern, x, y, 8);
 
-    if (g > 255)
+    uint16_t *line = (uint16_t*)(image->buffer + (x * 2) + (y *image->pitch));
+
+    for (i = 0 ; i < length ; i++)
     {
-        g = 255;
+        line[i] = pattern[i & 7];
     }
+}
 
-    int16_t b = rgba->blue + dither16[index];
+//-----------------------------------------------------------------------
+
+void
+fillSpanRGBA32(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    const RGBA8_T *rgba)
+{
+    uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (4*x);
 
-    if (b > 255)
+    if ((rgba->red == rgba->green) &&
+        (rgba->red == rgba->blue) &&
+        (rgba->red == rgba->alpha))
     {
-        b = 255;
+        memset(line, rgba->red, 4 * length);
+        return;
     }
 
-    int16_t a = rgba->alpha + dither16[index];
+    uint32_t pixel;
+    memcpy(&pixel, rgba, sizeof(pixel));
+
+    uint32_t *pixels = (uint32_t *)line;
 
-    if (b > 255)
+    int32_t i;
+    for (i = 0 ; i < length ; i++)
     {
-        b = 255;
+        pixels[i] = pixel;
     }
+}
 
-    RGBA8_T dithered = { r, g, b, a };
+//-----------------------------------------------------------------------
 
-    setPixelRGBA16(image, x, y, &dithered);
+void
+setSpanRGB565(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    const RGBA8_T *rgba)
+{
+    uint16_t *line = (uint16_t*)(image->buffer + (x * 2) + (y *image->pitch));
+    rgba8RowToRgb565(rgba, line, length);
 }
 
 //-----------------------------------------------------------------------
 
 void
-setPixelRGBA32(
+setSpanDitheredRGB565(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     const RGBA8_T *rgba)
 {
-    uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (4*x);
-
-    line[0] = rgba->red;
-    line[1] = rgba->green;
-    line[2] = rgba->blue;
-    line[3] = rgba->alpha;
+    uint16_t *line = (uint16_t*)(image->buffer + (x * 2) + (y *image->pitch));
+    rgba8RowToDitheredRgb565(rgba, line, x, y, length);
 }
 
 //-----------------------------------------------------------------------
 
 void
-getPixel4BPP(
+setSpanRGB888(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
-    int8_t *index)
+    int32_t length,
+    const RGBA8_T *rgba)
 {
-    uint8_t *value = (uint8_t*)(image->buffer + (x/2) + (y *image->pitch));
+    uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (3*x);
+    rgba8RowToRgb888(rgba, line, length);
+}
 
-    if (x % 2)
-    {
-        *index = (*value) & 0x0F;
-    }
-    else
-    {
-        *index = (*value) >> 4;
-    }
+//-----------------------------------------------------------------------
+
+void
+setSpanRGBA16(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    const RGBA8_T *rgba)
+{
+    uint16_t *line = (uint16_t*)(image->buffer + (x * 2) + (y *image->pitch));
+    rgba8RowToRgba16(rgba, line, length);
 }
 
 //-----------------------------------------------------------------------
 
 void
-getPixel8BPP(
+setSpanDitheredRGBA16(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
-    int8_t *index)
+    int32_t length,
+    const RGBA8_T *rgba)
 {
-    *index = *(uint8_t*)(image->buffer + x + (y * image->pitch));
+    uint16_t *line = (uint16_t*)(image->buffer + (x * 2) + (y *image->pitch));
+    rgba8RowToDitheredRgba16(rgba, line, x, y, length);
 }
 
 //-----------------------------------------------------------------------
 
 void
-getPixelRGB565(
+setSpanRGBA32(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
-    RGBA8_T *rgba)
+    int32_t length,
+    const RGBA8_T *rgba)
 {
-    uint16_t pixel = *(uint16_t*)(image->buffer + (x * 2) + (y * image->pitch));
+    // RGBA8_T has the same byte layout as a VC_IMAGE_RGBA32 pixel
 
-    uint8_t r5 = (pixel >> 11) & 0x1F;
-    uint8_t g6 = (pixel >> 5) & 0x3F;
-    uint8_t b5 = pixel & 0x1F;
+    uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (4*x);
+    memcpy(line, rgba, length * sizeof(RGBA8_T));
+}
 
-    rgba->red = (r5 << 3) | (r5 >> 2);
-    rgba->green = (g6 << 2) | (g6 >> 4);
-    rgba->blue = (b5 << 3) | (b5 >> 2);
-    rgba->alpha = 255;
+//-----------------------------------------------------------------------
+
+void
+getSpanRGB565(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    RGBA8_T *rgba)
+{
+    uint16_t *line = (uint16_t*)(image->buffer + (x * 2) + (y *image->pitch));
+    rgb565RowToRgba8(line, rgba, length);
 }
 
-//-------------------------------------------------------------------------
+//-----------------------------------------------------------------------
 
 void
-getPixelRGB888(
+getSpanRGB888(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     RGBA8_T *rgba)
 {
     uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (3*x);
-    rgba->red = line[0];
-    rgba->green = line[1];
-    rgba->blue = line[2];
-    rgba->alpha = 255;
+    rgb888RowToRgba8(line, rgba, length);
 }
 
 //-----------------------------------------------------------------------
 
 void
-getPixelRGBA16(
+getSpanRGBA16(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     RGBA8_T *rgba)
 {
-    uint16_t pixel = *(uint16_t*)(image->buffer+(x*2)+(y*image->pitch));
-    uint8_t r4 = (pixel >> 12) & 0xF;
-    uint8_t g4 = (pixel >> 8) & 0xF;
-    uint8_t b4 = (pixel >> 4) & 0xF;
-    uint8_t a4 = (pixel & 0xF);
-
-    rgba->red = (r4 << 4) | r4;
-    rgba->green = (g4 << 4) | g4;
-    rgba->blue = (b4 << 4) | b4;
-    rgba->alpha = (a4 << 4) | a4;
+    uint16_t *line = (uint16_t*)(image->buffer + (x * 2) + (y *image->pitch));
+    rgba16RowToRgba8(line, rgba, length);
 }
 
 //-----------------------------------------------------------------------
 
 void
-getPixelRGBA32(
+getSpanRGBA32(
     IMAGE_T *image,
     int32_t x,
     int32_t y,
+    int32_t length,
     RGBA8_T *rgba)
 {
     uint8_t *line = (uint8_t *)(image->buffer) + (y*image->pitch) + (4*x);
-
-    rgba->red = line[0];
-    rgba->green = line[1];
-    rgba->blue = line[2];
-    rgba->alpha = line[3];
+    memcpy(rgba, line, length * sizeof(RGBA8_T));
 }
 
 //-----------------------------------------------------------------------
@@ -782,20 +1646,33 @@ setImageAlphaRelative(
     IMAGE_T *image,
     uint8_t alpha)
 {
-    if (image->setPixelDirect != NULL)
+    if ((image->getSpanDirect != NULL) && (image->setSpanDirect != NULL))
     {
-        RGBA8_T rgba;
+        RGBA8_T *row = malloc(image->width * sizeof(RGBA8_T));
+
+        if (row == NULL)
+        {
+            fprintf(stderr, "image: memory exhausted\n");
+            exit(EXIT_FAILURE);
+        }
+
         int j;
         for (j = 0 ; j < image->height ; j++)
         {
+            image->getSpanDirect(image, 0, j, image->width, row);
+
             int i;
             for (i = 0 ; i < image->width ; i++)
             {
-                getPixelRGB(image, i, j, &rgba);
-                rgba.alpha = (uint8_t)(rgba.alpha * (uint16_t)alpha / 255);
-                setPixelRGB(image, i, j, &rgba);
+                row[i].alpha = (uint8_t)(row[i].alpha * (uint16_t)alpha / 255);
             }
+
+            image->setSpanDirect(image, 0, j, image->width, row);
         }
+
+        free(row);
+
+        markImageAllDirty(image);
     }
 }
 
@@ -809,21 +1686,34 @@ setImageRGB (
     uint8_t green,
     uint8_t blue)
 {
-    if (image->setPixelDirect != NULL)
+    if ((image->getSpanDirect != NULL) && (image->setSpanDirect != NULL))
     {
-        RGBA8_T rgba;
+        RGBA8_T *row = malloc(image->width * sizeof(RGBA8_T));
+
+        if (row == NULL)
+        {
+            fprintf(stderr, "image: memory exhausted\n");
+            exit(EXIT_FAILURE);
+        }
+
         int j;
         for (j = 0 ; j < image->height ; j++)
         {
+            image->getSpanDirect(image, 0, j, image->width, row);
+
             int i;
             for (i = 0 ; i < image->width ; i++)
             {
-                getPixelRGB(image, i, j, &rgba);
-                rgba.red = red;
-                rgba.green = green;
-                rgba.blue = blue;
-                setPixelRGB(image, i, j, &rgba);
+                row[i].red = red;
+                row[i].green = green;
+                row[i].blue = blue;
             }
+
+            image->setSpanDirect(image, 0, j, image->width, row);
         }
+
+        free(row);
+
+        markImageAllDirty(image);
     }
 }
\ No newline at end of file
@@ -48,6 +48,34 @@ typedef struct
 
 //-------------------------------------------------------------------------
 
+// Regions of an image that have changed since it was last copied to a
+// resource. Resource writes always copy whole rows, so the rectangles are
+// kept apart in rows and merged when they touch or when there are too
+// many.
+
+#define IMAGE_DIRTY_RECTS 4
+
+typedef struct
+{
+    int32_t count;
+    VC_RECT_T rects[IMAGE_DIRTY_RECTS];
+} IMAGE_DIRTY_T;
+
+//-------------------------------------------------------------------------
+
+// Drawing is limited to a clip rectangle, the last one pushed or the whole
+// image. Each rectangle pushed is intersected with the one before it.
+
+#define IMAGE_CLIP_DEPTH 8
+
+typedef struct
+{
+    int32_t depth;
+    VC_RECT_T rects[IMAGE_CLIP_DEPTH + 1];
+} IMAGE_CLIP_T;
+
+//-------------------------------------------------------------------------
+
 typedef struct IMAGE_T_ IMAGE_T;
 
 struct IMAGE_T_
@@ -60,10 +88,17 @@ struct IMAGE_T_
     uint16_t bitsPerPixel;
     uint32_t size;
     void *buffer;
+    void (*destroyBuffer)(IMAGE_T*);
+    IMAGE_DIRTY_T dirty;
+    IMAGE_CLIP_T clip;
     void (*setPixelDirect)(IMAGE_T*, int32_t, int32_t, const RGBA8_T*);
     void (*getPixelDirect)(IMAGE_T*, int32_t, int32_t, RGBA8_T*);
     void (*setPixelIndexed)(IMAGE_T*, int32_t, int32_t, int8_t);
     void (*getPixelIndexed)(IMAGE_T*, int32_t, int32_t, int8_t*);
+    void (*fillSpanDirect)(IMAGE_T*, int32_t, int32_t, int32_t, const RGBA8_T*);
+    void (*setSpanDirect)(IMAGE_T*, int32_t, int32_t, int32_t, const RGBA8_T*);
+    void (*getSpanDirect)(IMAGE_T*, int32_t, int32_t, int32_t, RGBA8_T*);
+    void (*fillSpanIndexed)(IMAGE_T*, int32_t, int32_t, int32_t, int8_t);
 };
 
 //-------------------------------------------------------------------------
@@ -104,6 +139,21 @@ initImage(
     int32_t height,
     bool dither);
 
+// Initialise an image around a buffer the caller already has, such as a
+// mapped file. The buffer must be at least pitch * alignedHeight bytes, as
+// initImage would allocate. destroyImage calls destroyBuffer (if not NULL)
+// to release it.
+
+bool
+initImageWithBuffer(
+    IMAGE_T *image,
+    VC_IMAGE_TYPE_T type,
+    int32_t width,
+    int32_t height,
+    bool dither,
+    void *buffer,
+    void (*destroyBuffer)(IMAGE_T*));
+
 void
 clearImageIndexed(
     IMAGE_T *image,
@@ -142,6 +192,105 @@ getPixelRGB(
     int32_t y,
     RGBA8_T *rgb);
 
+//-------------------------------------------------------------------------
+// Span functions operate on 'length' pixels of row 'y' starting at 'x'.
+// The span is clipped, to the clip rectangle when setting or filling and to
+// the image when getting. False is returned if nothing is left.
+
+bool
+fillSpanIndexed(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    int8_t index);
+
+bool
+fillSpanRGB(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    const RGBA8_T *rgb);
+
+bool
+setSpanRGB(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    const RGBA8_T *rgb);
+
+bool
+getSpanRGB(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    RGBA8_T *rgb);
+
+//-------------------------------------------------------------------------
+// The set, fill and draw functions only change pixels inside the clip
+// rectangle. Clearing the image and reading pixels ignore it. If the stack
+// is full the clip is left as it is and false is returned, popImageClip()
+// must still be called.
+
+bool
+pushImageClip(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t width,
+    int32_t height);
+
+void
+popImageClip(
+    IMAGE_T *image);
+
+const VC_RECT_T *
+getImageClip(
+    const IMAGE_T *image);
+
+//-------------------------------------------------------------------------
+// Store the bytes of one pixel of the given colour in 'pixel', which must
+// hold at least four bytes. False is returned if the image has no fixed
+// bytes for the colour, i.e. it has less than a byte per pixel or is
+// dithered.
+
+bool
+packPixelIndexed(
+    const IMAGE_T *image,
+    int8_t index,
+    uint8_t *pixel);
+
+bool
+packPixelRGB(
+    const IMAGE_T *image,
+    const RGBA8_T *rgb,
+    uint8_t *pixel);
+
+//-------------------------------------------------------------------------
+// The drawing functions above record the area they change. Code that
+// writes to the buffer directly should call markImageDirty().
+
+void
+markImageDirty(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t width,
+    int32_t height);
+
+void
+markImageAllDirty(
+    IMAGE_T *image);
+
+void
+clearImageDirty(
+    IMAGE_T *image);
+
+//-------------------------------------------------------------------------
+
 void
 destroyImage(
     IMAGE_T *image);
@@ -0,0 +1,647 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(RASPIDMX_NO_SIMD)
+// plain C only
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGE_BLIT_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGE_BLIT_SSE2
+#endif
+
+#include "imageBlit.h"
+
+//-------------------------------------------------------------------------
+// All of the blends work on rows of RGBA8_T. Each channel is mixed as
+//
+//     (source * weight + destination * (255 - weight)) / 255
+//
+// rounded, which the NEON, SSE2 and C versions compute identically. For
+// over and add the source alpha is treated as 255 so that the destination
+// alpha comes out as the Porter-Duff alpha.
+
+static uint8_t
+div255(
+    uint32_t value)
+{
+    value += 128;
+    return (value + (value >> 8)) >> 8;
+}
+
+//-------------------------------------------------------------------------
+
+static uint8_t
+mix255(
+    uint8_t source,
+    uint8_t destination,
+    uint8_t weight)
+{
+    return div255((source * weight) + (destination * (255 - weight)));
+}
+
+//-------------------------------------------------------------------------
+
+static uint8_t
+addSaturate(
+    uint8_t a,
+    uint8_t b)
+{
+    uint32_t sum = a + b;
+    return (sum > 255) ? 255 : sum;
+}
+
+//-------------------------------------------------------------------------
+
+#if defined(IMAGE_BLIT_NEON)
+
+static uint8x8_t
+div255Neon(
+    uint16x8_t value)
+{
+    return vraddhn_u16(value, vrshrq_n_u16(value, 8));
+}
+
+//-------------------------------------------------------------------------
+
+static uint8x8_t
+mix255Neon(
+    uint8x8_t source,
+    uint8x8_t destination,
+    uint8x8_t weight)
+{
+    uint16x8_t sum = vmull_u8(source, weight);
+    sum = vmlal_u8(sum, destination, vmvn_u8(weight));
+
+    return div255Neon(sum);
+}
+
+#elif defined(IMAGE_BLIT_SSE2)
+
+// Each 128 bit register holds two pixels, one channel in each 16 bits.
+
+static __m128i
+div255Sse2(
+    __m128i value)
+{
+    value = _mm_add_epi16(value, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(value, _mm_srli_epi16(value, 8)), 8);
+}
+
+//-------------------------------------------------------------------------
+
+static __m128i
+mix255Sse2(
+    __m128i source,
+    __m128i destination,
+    __m128i weight)
+{
+    __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), weight);
+
+    return div255Sse2(_mm_add_epi16(_mm_mullo_epi16(source, weight),
+                                    _mm_mullo_epi16(destination, inverse)));
+}
+
+//-------------------------------------------------------------------------
+
+// Copy the alpha of each of the two pixels into all four of its channels.
+
+static __m128i
+broadcastAlphaSse2(
+    __m128i pixels)
+{
+    pixels = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_shufflehi_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+//-------------------------------------------------------------------------
+
+// The source alpha of each of the two pixels, scaled by opacity.
+
+static __m128i
+sourceAlphaSse2(
+    __m128i pixels,
+    __m128i opacity)
+{
+    return div255Sse2(_mm_mullo_epi16(broadcastAlphaSse2(pixels), opacity));
+}
+
+#endif
+
+//-------------------------------------------------------------------------
+
+static void
+blendPixelOver(
+    const RGBA8_T *src,
+    RGBA8_T *dst,
+    uint8_t opacity)
+{
+    uint8_t alpha = div255(src->alpha * opacity);
+
+    if (dst->alpha == 255)
+    {
+        dst->red = mix255(src->red, dst->red, alpha);
+        dst->green = mix255(src->green, dst->green, alpha);
+        dst->blue = mix255(src->blue, dst->blue, alpha);
+    }
+    else
+    {
+        // The destination shows through, so the colours are weighted by
+        // how much of each is left.
+
+        uint32_t under = div255(dst->alpha * (255 - alpha));
+        uint32_t total = alpha + under;
+
+        if (total > 0)
+        {
+            dst->red = ((src->red * alpha) + (dst->red * under)
+                       + (total / 2)) / total;
+            dst->green = ((src->green * alpha) + (dst->green * under)
+                         + (total / 2)) / total;
+            dst->blue = ((src->blue * alpha) + (dst->blue * under)
+                        + (total / 2)) / total;
+            dst->alpha = total;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+blendRowOver(
+    const RGBA8_T *src,
+    RGBA8_T *dst,
+    int32_t length,
+    uint8_t opacity)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_BLIT_NEON)
+
+    uint8x8_t o = vdup_n_u8(opacity);
+    uint8x8_t opaque = vdup_n_u8(255);
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t *)(dst + i));
+
+        // Only use the vector mix when every destination pixel is opaque
+
+        if (vget_lane_u64(vreinterpret_u64_u8(vmvn_u8(d.val[3])), 0) != 0)
+        {
+            int32_t j;
+            for (j = i ; j < i + 8 ; j++)
+            {
+                blendPixelOver(src + j, dst + j, opacity);
+            }
+
+            continue;
+        }
+
+        uint8x8_t alpha = div255Neon(vmull_u8(s.val[3], o));
+
+        d.val[0] = mix255Neon(s.val[0], d.val[0], alpha);
+        d.val[1] = mix255Neon(s.val[1], d.val[1], alpha);
+        d.val[2] = mix255Neon(s.val[2], d.val[2], alpha);
+        d.val[3] = mix255Neon(opaque, d.val[3], alpha);
+
+        vst4_u8((uint8_t *)(dst + i), d);
+    }
+
+#elif defined(IMAGE_BLIT_SSE2)
+
+    __m128i zero = _mm_setzero_si128();
+    __m128i o = _mm_set1_epi16(opacity);
+    __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+
+    for ( ; i + 4 <= length ; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+
+        // Only use the vector mix when every destination pixel is opaque
+
+        __m128i opaque = _mm_cmpeq_epi32(_mm_and_si128(d, alphaMask),
+                                         alphaMask);
+
+        if (_mm_movemask_epi8(opaque) != 0xFFFF)
+        {
+            int32_t j;
+            for (j = i ; j < i + 4 ; j++)
+            {
+                blendPixelOver(src + j, dst + j, opacity);
+            }
+
+            continue;
+        }
+
+        __m128i sLo = _mm_unpacklo_epi8(s, zero);
+        __m128i sHi = _mm_unpackhi_epi8(s, zero);
+        __m128i alphaLo = sourceAlphaSse2(sLo, o);
+        __m128i alphaHi = sourceAlphaSse2(sHi, o);
+
+        s = _mm_or_si128(s, alphaMask);
+
+        __m128i lo = mix255Sse2(_mm_unpacklo_epi8(s, zero),
+                                _mm_unpacklo_epi8(d, zero),
+                                alphaLo);
+        __m128i hi = mix255Sse2(_mm_unpackhi_epi8(s, zero),
+                                _mm_unpackhi_epi8(d, zero),
+                                alphaHi);
+
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        blendPixelOver(src + i, dst + i, opacity);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+blendRowAdd(
+    const RGBA8_T *src,
+    RGBA8_T *dst,
+    int32_t length,
+    uint8_t opacity)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_BLIT_NEON)
+
+    uint8x8_t o = vdup_n_u8(opacity);
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t *)(dst + i));
+
+        uint8x8_t alpha = div255Neon(vmull_u8(s.val[3], o));
+
+        d.val[0] = vqadd_u8(d.val[0], div255Neon(vmull_u8(s.val[0], alpha)));
+        d.val[1] = vqadd_u8(d.val[1], div255Neon(vmull_u8(s.val[1], alpha)));
+        d.val[2] = vqadd_u8(d.val[2], div255Neon(vmull_u8(s.val[2], alpha)));
+        d.val[3] = vqadd_u8(d.val[3], alpha);
+
+        vst4_u8((uint8_t *)(dst + i), d);
+    }
+
+#elif defined(IMAGE_BLIT_SSE2)
+
+    __m128i zero = _mm_setzero_si128();
+    __m128i o = _mm_set1_epi16(opacity);
+    __m128i alphaMask = _mm_set1_epi32(0xFF000000);
+
+    for ( ; i + 4 <= length ; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+
+        __m128i sLo = _mm_unpacklo_epi8(s, zero);
+        __m128i sHi = _mm_unpackhi_epi8(s, zero);
+        __m128i alphaLo = sourceAlphaSse2(sLo, o);
+        __m128i alphaHi = sourceAlphaSse2(sHi, o);
+
+        s = _mm_or_si128(s, alphaMask);
+
+        __m128i lo = div255Sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero),
+                                                alphaLo));
+        __m128i hi = div255Sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero),
+                                                alphaHi));
+
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_adds_epu8(d, _mm_packus_epi16(lo, hi)));
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        uint8_t alpha = div255(src[i].alpha * opacity);
+
+        dst[i].red = addSaturate(dst[i].red, div255(src[i].red * alpha));
+        dst[i].green = addSaturate(dst[i].green, div255(src[i].green * alpha));
+        dst[i].blue = addSaturate(dst[i].blue, div255(src[i].blue * alpha));
+        dst[i].alpha = addSaturate(dst[i].alpha, alpha);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+blendRowConstantAlpha(
+    const RGBA8_T *src,
+    RGBA8_T *dst,
+    int32_t length,
+    uint8_t opacity)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_BLIT_NEON)
+
+    uint8x8_t o = vdup_n_u8(opacity);
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint8x8x4_t s = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t *)(dst + i));
+
+        d.val[0] = mix255Neon(s.val[0], d.val[0], o);
+        d.val[1] = mix255Neon(s.val[1], d.val[1], o);
+        d.val[2] = mix255Neon(s.val[2], d.val[2], o);
+        d.val[3] = mix255Neon(s.val[3], d.val[3], o);
+
+        vst4_u8((uint8_t *)(dst + i), d);
+    }
+
+#elif defined(IMAGE_BLIT_SSE2)
+
+    __m128i zero = _mm_setzero_si128();
+    __m128i o = _mm_set1_epi16(opacity);
+
+    for ( ; i + 4 <= length ; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+
+        __m128i lo = mix255Sse2(_mm_unpacklo_epi8(s, zero),
+                                _mm_unpacklo_epi8(d, zero),
+                                o);
+        __m128i hi = mix255Sse2(_mm_unpackhi_epi8(s, zero),
+                                _mm_unpackhi_epi8(d, zero),
+                                o);
+
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        dst[i].red = mix255(src[i].red, dst[i].red, opacity);
+        dst[i].green = mix255(src[i].green, dst[i].green, opacity);
+        dst[i].blue = mix255(src[i].blue, dst[i].blue, opacity);
+        dst[i].alpha = mix255(src[i].alpha, dst[i].alpha, opacity);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Limit the blit to the source image and the destination clip rectangle.
+// False is returned if nothing is left.
+
+static bool
+clipBlit(
+    const IMAGE_T *dst,
+    const IMAGE_T *src,
+    int32_t *x,
+    int32_t *y,
+    VC_RECT_T *rect)
+{
+    const VC_RECT_T *clip = getImageClip(dst);
+
+    if (rect->x < 0)
+    {
+        *x -= rect->x;
+        rect->width += rect->x;
+        rect->x = 0;
+    }
+
+    if (rect->y < 0)
+    {
+        *y -= rect->y;
+        rect->height += rect->y;
+        rect->y = 0;
+    }
+
+    if (rect->x + rect->width > src->width)
+    {
+        rect->width = src->width - rect->x;
+    }
+
+    if (rect->y + rect->height > src->height)
+    {
+        rect->height = src->height - rect->y;
+    }
+
+    if (*x < clip->x)
+    {
+        rect->x += clip->x - *x;
+        rect->width -= clip->x - *x;
+        *x = clip->x;
+    }
+
+    if (*y < clip->y)
+    {
+        rect->y += clip->y - *y;
+        rect->height -= clip->y - *y;
+        *y = clip->y;
+    }
+
+    if (*x + rect->width > clip->x + clip->width)
+    {
+        rect->width = clip->x + clip->width - *x;
+    }
+
+    if (*y + rect->height > clip->y + clip->height)
+    {
+        rect->height = clip->y + clip->height - *y;
+    }
+
+    return (rect->width > 0) && (rect->height > 0);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+imageBlit(
+    IMAGE_T *dst,
+    int32_t x,
+    int32_t y,
+    IMAGE_T *src,
+    const VC_RECT_T *srcRect,
+    IMAGE_BLIT_MODE_T mode,
+    uint8_t opacity)
+{
+    bool direct = (src->getSpanDirect != NULL) &&
+                  (dst->setSpanDirect != NULL);
+
+    bool copy = (mode == IMAGE_BLIT_COPY) && (src->type == dst->type);
+
+    if ((direct == false) && (copy == false))
+    {
+        return false;
+    }
+
+    VC_RECT_T rect;
+
+    if (srcRect != NULL)
+    {
+        rect = *srcRect;
+    }
+    else
+    {
+        vc_dispmanx_rect_set(&rect, 0, 0, src->width, src->height);
+    }
+
+    if (clipBlit(dst, src, &x, &y, &rect) == false)
+    {
+        return true;
+    }
+
+    //---------------------------------------------------------------------
+
+    // Copying an image onto itself has to go from the bottom up when the
+    // destination is lower, so that rows aren't overwritten before use.
+
+    int32_t first = 0;
+    int32_t last = rect.height;
+    int32_t step = 1;
+
+    if ((src == dst) && (y > rect.y))
+    {
+        first = rect.height - 1;
+        last = -1;
+        step = -1;
+    }
+
+    int32_t j;
+
+    if (copy && (src->bitsPerPixel >= 8))
+    {
+        int32_t bytes = src->bitsPerPixel / 8;
+
+        for (j = first ; j != last ; j += step)
+        {
+            const uint8_t *from = (uint8_t *)(src->buffer)
+                                + ((rect.y + j) * src->pitch)
+                                + (rect.x * bytes);
+            uint8_t *to = (uint8_t *)(dst->buffer)
+                        + ((y + j) * dst->pitch)
+                        + (x * bytes);
+
+            memmove(to, from, rect.width * bytes);
+        }
+    }
+    else if (copy && (direct == false))
+    {
+        // Indexed pixels smaller than a byte
+
+        int32_t i;
+        for (j = first ; j != last ; j += step)
+        {
+            for (i = 0 ; i < rect.width ; i++)
+            {
+                int32_t column = (x > rect.x) ? (rect.width - 1 - i) : i;
+                int8_t index;
+
+                src->getPixelIndexed(src,
+                                     rect.x + column,
+                                     rect.y + j,
+                                     &index);
+                dst->setPixelIndexed(dst, x + column, y + j, index);
+            }
+        }
+    }
+    else
+    {
+        RGBA8_T *srcRow = malloc(rect.width * sizeof(RGBA8_T));
+        RGBA8_T *dstRow = malloc(rect.width * sizeof(RGBA8_T));
+
+        if ((srcRow == NULL) || (dstRow == NULL))
+        {
+            fprintf(stderr, "imageBlit: memory exhausted\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (j = first ; j != last ; j += step)
+        {
+            src->getSpanDirect(src, rect.x, rect.y + j, rect.width, srcRow);
+
+            if (mode == IMAGE_BLIT_COPY)
+            {
+                dst->setSpanDirect(dst, x, y + j, rect.width, srcRow);
+                continue;
+            }
+
+            dst->getSpanDirect(dst, x, y + j, rect.width, dstRow);
+
+            switch (mode)
+            {
+            case IMAGE_BLIT_OVER:
+
+                blendRowOver(srcRow, dstRow, rect.width, opacity);
+                break;
+
+            case IMAGE_BLIT_ADD:
+
+                blendRowAdd(srcRow, dstRow, rect.width, opacity);
+                break;
+
+            default:
+
+                blendRowConstantAlpha(srcRow, dstRow, rect.width, opacity);
+                break;
+            }
+
+            dst->setSpanDirect(dst, x, y + j, rect.width, dstRow);
+        }
+
+        free(srcRow);
+        free(dstRow);
+    }
+
+    markImageDirty(dst, x, y, rect.width, rect.height);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+const char *
+imageBlitPath(void)
+{
+#if defined(IMAGE_BLIT_NEON)
+    return "NEON";
+#elif defined(IMAGE_BLIT_SSE2)
+    return "SSE2";
+#else
+    return "C";
+#endif
+}
@@ -0,0 +1,82 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef IMAGE_BLIT_H
+#define IMAGE_BLIT_H
+
+//-------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "image.h"
+
+//-------------------------------------------------------------------------
+
+// How each source pixel is combined with the destination pixel. Opacity
+// scales the source alpha for over and add, and is the mix of source and
+// destination for constant alpha.
+//
+//     IMAGE_BLIT_COPY           destination = source
+//     IMAGE_BLIT_OVER           Porter-Duff source over destination
+//     IMAGE_BLIT_ADD            destination + source * source alpha
+//     IMAGE_BLIT_CONSTANT_ALPHA source and destination mixed by opacity
+
+typedef enum
+{
+    IMAGE_BLIT_COPY,
+    IMAGE_BLIT_OVER,
+    IMAGE_BLIT_ADD,
+    IMAGE_BLIT_CONSTANT_ALPHA
+} IMAGE_BLIT_MODE_T;
+
+//-------------------------------------------------------------------------
+
+// Combine the 'srcRect' part of 'src' (all of it if NULL) with 'dst' at
+// (x, y). The destination is clipped to its clip rectangle. Any two direct
+// colour types can be mixed. Indexed images can only be copied onto an
+// image of the same type. False is returned if the types can't be used.
+
+bool
+imageBlit(
+    IMAGE_T *dst,
+    int32_t x,
+    int32_t y,
+    IMAGE_T *src,
+    const VC_RECT_T *srcRect,
+    IMAGE_BLIT_MODE_T mode,
+    uint8_t opacity);
+
+// The code path the blends were built with: "NEON", "SSE2" or "C".
+
+const char *
+imageBlitPath(void);
+
+//-------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,720 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <stdint.h>
+
+#if defined(RASPIDMX_NO_SIMD)
+// plain C only
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGE_CONVERT_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGE_CONVERT_SSE2
+#endif
+
+#include "imageConvert.h"
+
+//-------------------------------------------------------------------------
+
+static const uint8_t dither8[64] =
+{
+    1, 6, 2, 7, 1, 6, 2, 7,
+    4, 2, 5, 4, 4, 3, 6, 4,
+    1, 7, 1, 6, 2, 7, 1, 7,
+    5, 3, 5, 3, 5, 4, 5, 3,
+    1, 6, 2, 7, 1, 6, 2, 7,
+    4, 3, 6, 4, 4, 2, 6, 4,
+    2, 7, 1, 7, 2, 7, 1, 6,
+    5, 3, 5, 3, 5, 3, 5, 3,
+};
+
+static const uint8_t dither4[64] =
+{
+    1, 3, 1, 3, 1, 3, 1, 3,
+    2, 1, 3, 2, 2, 1, 3, 2,
+    1, 3, 1, 3, 1, 3, 1, 3,
+    2, 2, 2, 1, 3, 2, 2, 2,
+    1, 3, 1, 3, 1, 3, 1, 3,
+    2, 1, 3, 2, 2, 1, 3, 2,
+    1, 3, 1, 3, 1, 3, 1, 3,
+    3, 2, 2, 2, 2, 2, 2, 2,
+};
+
+static const uint8_t dither16[64] =
+{
+     1,  12,   4,  15,   1,  13,   4,  15,
+     8,   4,  11,   7,   9,   5,  12,   8,
+     3,  14,   2,  13,   3,  15,   2,  14,
+    10,   6,   9,   5,  11,   7,  10,   6,
+     1,  12,   4,  15,   1,  12,   4,  15,
+     9,   5,  12,   8,   8,   5,  11,   8,
+     3,  14,   2,  13,   3,  14,   2,  13,
+    11,   7,  10,   6,  10,   7,   9,   6,
+};
+
+//-------------------------------------------------------------------------
+// Fill in the dither thresholds for up to eight consecutive pixels of
+// row 'y' starting at column 'x'. The pattern repeats every eight pixels,
+// so threshold[i & 7] applies to pixel 'x + i' for the whole row.
+
+static void
+ditherThresholdsRgb565(
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    RGBA8_T *thresholds)
+{
+    const uint8_t *row8 = dither8 + ((y & 7) << 3);
+    const uint8_t *row4 = dither4 + ((y & 7) << 3);
+
+    int32_t i;
+    for (i = 0 ; (i < 8) && (i < length) ; i++)
+    {
+        int32_t column = (x + i) & 7;
+
+        thresholds[i].red = row8[column];
+        thresholds[i].green = row4[column];
+        thresholds[i].blue = row8[column];
+        thresholds[i].alpha = 0;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+ditherThresholdsRgba16(
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    RGBA8_T *thresholds)
+{
+    const uint8_t *row16 = dither16 + ((y & 7) << 3);
+
+    int32_t i;
+    for (i = 0 ; (i < 8) && (i < length) ; i++)
+    {
+        uint8_t threshold = row16[(x + i) & 7];
+
+        thresholds[i].red = threshold;
+        thresholds[i].green = threshold;
+        thresholds[i].blue = threshold;
+        thresholds[i].alpha = threshold;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint8_t
+addSaturate(
+    uint8_t value,
+    uint8_t threshold)
+{
+    uint16_t sum = value + threshold;
+
+    return (sum > 255) ? 255 : sum;
+}
+
+//-------------------------------------------------------------------------
+
+#ifdef IMAGE_CONVERT_SSE2
+
+// Pack the low 16 bits of each 32 bit lane of two registers into a single
+// register of eight 16 bit values. The values are sign extended first so
+// that the saturating pack leaves them unchanged.
+
+static inline __m128i
+packLow16(
+    __m128i lo,
+    __m128i hi)
+{
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+
+    return _mm_packs_epi32(lo, hi);
+}
+
+//-------------------------------------------------------------------------
+
+static inline __m128i
+rgba8ToRgb565Sse2(
+    __m128i p)
+{
+    __m128i r = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF8)), 8);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x07E0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(p, 19), _mm_set1_epi32(0x1F));
+
+    return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+//-------------------------------------------------------------------------
+
+static inline __m128i
+rgb565ToRgba8Sse2(
+    __m128i p)
+{
+    __m128i r = _mm_or_si128(
+                    _mm_and_si128(_mm_srli_epi32(p, 8), _mm_set1_epi32(0xF8)),
+                    _mm_and_si128(_mm_srli_epi32(p, 13), _mm_set1_epi32(0x07)));
+
+    __m128i g = _mm_or_si128(
+                    _mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0xFC)),
+                    _mm_and_si128(_mm_srli_epi32(p, 9), _mm_set1_epi32(0x03)));
+
+    __m128i b = _mm_or_si128(
+                    _mm_and_si128(_mm_slli_epi32(p, 3), _mm_set1_epi32(0xF8)),
+                    _mm_and_si128(_mm_srli_epi32(p, 2), _mm_set1_epi32(0x07)));
+
+    __m128i a = _mm_set1_epi32(0xFF000000);
+
+    return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+                        _mm_or_si128(_mm_slli_epi32(b, 16), a));
+}
+
+//-------------------------------------------------------------------------
+
+static inline __m128i
+rgba8ToRgba16Sse2(
+    __m128i p)
+{
+    __m128i r = _mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0xF0)), 8);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(p, 4), _mm_set1_epi32(0x0F00));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(p, 16), _mm_set1_epi32(0xF0));
+    __m128i a = _mm_srli_epi32(p, 28);
+
+    return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+//-------------------------------------------------------------------------
+
+static inline __m128i
+rgba16ToRgba8Sse2(
+    __m128i p)
+{
+    __m128i hi = _mm_set1_epi32(0xF0);
+    __m128i lo = _mm_set1_epi32(0x0F);
+
+    __m128i r = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 8), hi),
+                             _mm_and_si128(_mm_srli_epi32(p, 12), lo));
+
+    __m128i g = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 4), hi),
+                             _mm_and_si128(_mm_srli_epi32(p, 8), lo));
+
+    __m128i b = _mm_or_si128(_mm_and_si128(p, hi),
+                             _mm_and_si128(_mm_srli_epi32(p, 4), lo));
+
+    __m128i a = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(p, 4), hi),
+                             _mm_and_si128(p, lo));
+
+    return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+                        _mm_or_si128(_mm_slli_epi32(b, 16),
+                                     _mm_slli_epi32(a, 24)));
+}
+
+#endif
+
+//-------------------------------------------------------------------------
+
+void
+rgba8RowToRgb565(
+    const RGBA8_T *src,
+    uint16_t *dst,
+    int32_t length)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_CONVERT_NEON)
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint8x8x4_t p = vld4_u8((const uint8_t *)(src + i));
+
+        uint16x8_t pixel = vshll_n_u8(p.val[0], 8);
+        pixel = vsriq_n_u16(pixel, vshll_n_u8(p.val[1], 8), 5);
+        pixel = vsriq_n_u16(pixel, vshll_n_u8(p.val[2], 8), 11);
+
+        vst1q_u16(dst + i, pixel);
+    }
+
+#elif defined(IMAGE_CONVERT_SSE2)
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(src + i + 4));
+
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         packLow16(rgba8ToRgb565Sse2(lo),
+                                   rgba8ToRgb565Sse2(hi)));
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        dst[i] = ((src[i].red >> 3) << 11)
+               | ((src[i].green >> 2) << 5)
+               | (src[i].blue >> 3);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+rgb565RowToRgba8(
+    const uint16_t *src,
+    RGBA8_T *dst,
+    int32_t length)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_CONVERT_NEON)
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint16x8_t p = vld1q_u16(src + i);
+        uint8x8x4_t rgba;
+
+        rgba.val[0] = vshrn_n_u16(p, 8);
+        rgba.val[0] = vsri_n_u8(rgba.val[0], rgba.val[0], 5);
+        rgba.val[1] = vshrn_n_u16(p, 3);
+        rgba.val[1] = vsri_n_u8(rgba.val[1], rgba.val[1], 6);
+        rgba.val[2] = vmovn_u16(vshlq_n_u16(p, 3));
+        rgba.val[2] = vsri_n_u8(rgba.val[2], rgba.val[2], 5);
+        rgba.val[3] = vdup_n_u8(255);
+
+        vst4_u8((uint8_t *)(dst + i), rgba);
+    }
+
+#elif defined(IMAGE_CONVERT_SSE2)
+
+    __m128i zero = _mm_setzero_si128();
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         rgb565ToRgba8Sse2(_mm_unpacklo_epi16(p, zero)));
+        _mm_storeu_si128((__m128i *)(dst + i + 4),
+                         rgb565ToRgba8Sse2(_mm_unpackhi_epi16(p, zero)));
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        uint16_t pixel = src[i];
+
+        uint8_t r5 = (pixel >> 11) & 0x1F;
+        uint8_t g6 = (pixel >> 5) & 0x3F;
+        uint8_t b5 = pixel & 0x1F;
+
+        dst[i].red = (r5 << 3) | (r5 >> 2);
+        dst[i].green = (g6 << 2) | (g6 >> 4);
+        dst[i].blue = (b5 << 3) | (b5 >> 2);
+        dst[i].alpha = 255;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+rgb565RowToRgb888(
+    const uint16_t *src,
+    uint8_t *dst,
+    int32_t length)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_CONVERT_NEON)
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint16x8_t p = vld1q_u16(src + i);
+        uint8x8x3_t rgb;
+
+        rgb.val[0] = vshrn_n_u16(p, 8);
+        rgb.val[0] = vsri_n_u8(rgb.val[0], rgb.val[0], 5);
+        rgb.val[1] = vshrn_n_u16(p, 3);
+        rgb.val[1] = vsri_n_u8(rgb.val[1], rgb.val[1], 6);
+        rgb.val[2] = vmovn_u16(vshlq_n_u16(p, 3));
+        rgb.val[2] = vsri_n_u8(rgb.val[2], rgb.val[2], 5);
+
+        vst3_u8(dst + (3 * i), rgb);
+    }
+
+#elif defined(IMAGE_CONVERT_SSE2)
+
+    // SSE2 has no byte shuffle, so expand eight pixels at a time to RGBA
+    // and then drop the alpha bytes.
+
+    RGBA8_T block[8];
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        rgb565RowToRgba8(src + i, block, 8);
+        rgba8RowToRgb888(block, dst + (3 * i), 8);
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        uint16_t pixel = src[i];
+
+        uint8_t r5 = (pixel >> 11) & 0x1F;
+        uint8_t g6 = (pixel >> 5) & 0x3F;
+        uint8_t b5 = pixel & 0x1F;
+
+        dst[(3 * i)] = (r5 << 3) | (r5 >> 2);
+        dst[(3 * i) + 1] = (g6 << 2) | (g6 >> 4);
+        dst[(3 * i) + 2] = (b5 << 3) | (b5 >> 2);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+rgba8RowToDitheredRgb565(
+    const RGBA8_T *src,
+    uint16_t *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    RGBA8_T thresholds[8];
+    ditherThresholdsRgb565(x, y, length, thresholds);
+
+    int32_t i = 0;
+
+#if defined(IMAGE_CONVERT_NEON)
+
+    uint8x8x4_t t = vld4_u8((const uint8_t *)thresholds);
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint8x8x4_t p = vld4_u8((const uint8_t *)(src + i));
+
+        uint8x8_t r = vqadd_u8(p.val[0], t.val[0]);
+        uint8x8_t g = vqadd_u8(p.val[1], t.val[1]);
+        uint8x8_t b = vqadd_u8(p.val[2], t.val[2]);
+
+        uint16x8_t pixel = vshll_n_u8(r, 8);
+        pixel = vsriq_n_u16(pixel, vshll_n_u8(g, 8), 5);
+        pixel = vsriq_n_u16(pixel, vshll_n_u8(b, 8), 11);
+
+        vst1q_u16(dst + i, pixel);
+    }
+
+#elif defined(IMAGE_CONVERT_SSE2)
+
+    __m128i tlo = _mm_loadu_si128((const __m128i *)thresholds);
+    __m128i thi = _mm_loadu_si128((const __m128i *)(thresholds + 4));
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(src + i + 4));
+
+        lo = _mm_adds_epu8(lo, tlo);
+        hi = _mm_adds_epu8(hi, thi);
+
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         packLow16(rgba8ToRgb565Sse2(lo),
+                                   rgba8ToRgb565Sse2(hi)));
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        const RGBA8_T *t = &(thresholds[i & 7]);
+
+        uint8_t r = addSaturate(src[i].red, t->red);
+        uint8_t g = addSaturate(src[i].green, t->green);
+        uint8_t b = addSaturate(src[i].blue, t->blue);
+
+        dst[i] = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+rgba8RowToRgba16(
+    const RGBA8_T *src,
+    uint16_t *dst,
+    int32_t length)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_CONVERT_NEON)
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint8x8x4_t p = vld4_u8((const uint8_t *)(src + i));
+
+        uint16x8_t pixel = vshll_n_u8(p.val[0], 8);
+        pixel = vsriq_n_u16(pixel, vshll_n_u8(p.val[1], 8), 4);
+        pixel = vsriq_n_u16(pixel, vshll_n_u8(p.val[2], 8), 8);
+        pixel = vsriq_n_u16(pixel, vshll_n_u8(p.val[3], 8), 12);
+
+        vst1q_u16(dst + i, pixel);
+    }
+
+#elif defined(IMAGE_CONVERT_SSE2)
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(src + i + 4));
+
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         packLow16(rgba8ToRgba16Sse2(lo),
+                                   rgba8ToRgba16Sse2(hi)));
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        dst[i] = ((src[i].red >> 4) << 12)
+               | ((src[i].green >> 4) << 8)
+               | ((src[i].blue >> 4) << 4)
+               | (src[i].alpha >> 4);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+rgba8RowToDitheredRgba16(
+    const RGBA8_T *src,
+    uint16_t *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    RGBA8_T thresholds[8];
+    ditherThresholdsRgba16(x, y, length, thresholds);
+
+    int32_t i = 0;
+
+#if defined(IMAGE_CONVERT_NEON)
+
+    uint8x8x4_t t = vld4_u8((const uint8_t *)thresholds);
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint8x8x4_t p = vld4_u8((const uint8_t *)(src + i));
+
+        uint16x8_t pixel = vshll_n_u8(vqadd_u8(p.val[0], t.val[0]), 8);
+        pixel = vsriq_n_u16(pixel,
+                            vshll_n_u8(vqadd_u8(p.val[1], t.val[1]), 8),
+                            4);
+        pixel = vsriq_n_u16(pixel,
+                            vshll_n_u8(vqadd_u8(p.val[2], t.val[2]), 8),
+                            8);
+        pixel = vsriq_n_u16(pixel,
+                            vshll_n_u8(vqadd_u8(p.val[3], t.val[3]), 8),
+                            12);
+
+        vst1q_u16(dst + i, pixel);
+    }
+
+#elif defined(IMAGE_CONVERT_SSE2)
+
+    __m128i tlo = _mm_loadu_si128((const __m128i *)thresholds);
+    __m128i thi = _mm_loadu_si128((const __m128i *)(thresholds + 4));
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        __m128i lo = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(src + i + 4));
+
+        lo = _mm_adds_epu8(lo, tlo);
+        hi = _mm_adds_epu8(hi, thi);
+
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         packLow16(rgba8ToRgba16Sse2(lo),
+                                   rgba8ToRgba16Sse2(hi)));
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        uint8_t t = thresholds[i & 7].red;
+
+        uint8_t r = addSaturate(src[i].red, t);
+        uint8_t g = addSaturate(src[i].green, t);
+        uint8_t b = addSaturate(src[i].blue, t);
+        uint8_t a = addSaturate(src[i].alpha, t);
+
+        dst[i] = ((r >> 4) << 12)
+               | ((g >> 4) << 8)
+               | ((b >> 4) << 4)
+               | (a >> 4);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+rgba16RowToRgba8(
+    const uint16_t *src,
+    RGBA8_T *dst,
+    int32_t length)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_CONVERT_NEON)
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint16x8_t p = vld1q_u16(src + i);
+        uint8x8_t rg = vshrn_n_u16(p, 8);
+        uint8x8_t ba = vmovn_u16(p);
+        uint8x8x4_t rgba;
+
+        rgba.val[0] = vsri_n_u8(rg, rg, 4);
+        rgba.val[1] = vsli_n_u8(rg, rg, 4);
+        rgba.val[2] = vsri_n_u8(ba, ba, 4);
+        rgba.val[3] = vsli_n_u8(ba, ba, 4);
+
+        vst4_u8((uint8_t *)(dst + i), rgba);
+    }
+
+#elif defined(IMAGE_CONVERT_SSE2)
+
+    __m128i zero = _mm_setzero_si128();
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         rgba16ToRgba8Sse2(_mm_unpacklo_epi16(p, zero)));
+        _mm_storeu_si128((__m128i *)(dst + i + 4),
+                         rgba16ToRgba8Sse2(_mm_unpackhi_epi16(p, zero)));
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        uint16_t pixel = src[i];
+
+        uint8_t r4 = (pixel >> 12) & 0xF;
+        uint8_t g4 = (pixel >> 8) & 0xF;
+        uint8_t b4 = (pixel >> 4) & 0xF;
+        uint8_t a4 = (pixel & 0xF);
+
+        dst[i].red = (r4 << 4) | r4;
+        dst[i].green = (g4 << 4) | g4;
+        dst[i].blue = (b4 << 4) | b4;
+        dst[i].alpha = (a4 << 4) | a4;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+rgba8RowToRgb888(
+    const RGBA8_T *src,
+    uint8_t *dst,
+    int32_t length)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_CONVERT_NEON)
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint8x8x4_t p = vld4_u8((const uint8_t *)(src + i));
+        uint8x8x3_t rgb = {{ p.val[0], p.val[1], p.val[2] }};
+
+        vst3_u8(dst + (3 * i), rgb);
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        dst[(3 * i)] = src[i].red;
+        dst[(3 * i) + 1] = src[i].green;
+        dst[(3 * i) + 2] = src[i].blue;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+rgb888RowToRgba8(
+    const uint8_t *src,
+    RGBA8_T *dst,
+    int32_t length)
+{
+    int32_t i = 0;
+
+#if defined(IMAGE_CONVERT_NEON)
+
+    for ( ; i + 8 <= length ; i += 8)
+    {
+        uint8x8x3_t p = vld3_u8(src + (3 * i));
+        uint8x8x4_t rgba = {{ p.val[0], p.val[1], p.val[2], vdup_n_u8(255) }};
+
+        vst4_u8((uint8_t *)(dst + i), rgba);
+    }
+
+#endif
+
+    for ( ; i < length ; i++)
+    {
+        dst[i].red = src[(3 * i)];
+        dst[i].green = src[(3 * i) + 1];
+        dst[i].blue = src[(3 * i) + 2];
+        dst[i].alpha = 255;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+const char *
+imageConvertPath(void)
+{
+#if defined(IMAGE_CONVERT_NEON)
+    return "NEON";
+#elif defined(IMAGE_CONVERT_SSE2)
+    return "SSE2";
+#else
+    return "C";
+#endif
+}
+
@@ -0,0 +1,112 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef IMAGE_CONVERT_H
+#define IMAGE_CONVERT_H
+
+//-------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include "image.h"
+
+//-------------------------------------------------------------------------
+// Convert whole rows of pixels between RGBA8_T and the packed formats used
+// by IMAGE_T. NEON is used on ARM and SSE2 on x86 when the compiler
+// supports them, otherwise a plain C loop is used. Defining
+// RASPIDMX_NO_SIMD forces the plain C loop.
+
+void
+rgba8RowToRgb565(
+    const RGBA8_T *src,
+    uint16_t *dst,
+    int32_t length);
+
+void
+rgb565RowToRgba8(
+    const uint16_t *src,
+    RGBA8_T *dst,
+    int32_t length);
+
+void
+rgb565RowToRgb888(
+    const uint16_t *src,
+    uint8_t *dst,
+    int32_t length);
+
+// Ordered dither a row of RGBA8_T into RGB565. 'x' and 'y' are the image
+// coordinates of the first pixel, they select the dither thresholds.
+
+void
+rgba8RowToDitheredRgb565(
+    const RGBA8_T *src,
+    uint16_t *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length);
+
+void
+rgba8RowToRgba16(
+    const RGBA8_T *src,
+    uint16_t *dst,
+    int32_t length);
+
+void
+rgba8RowToDitheredRgba16(
+    const RGBA8_T *src,
+    uint16_t *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length);
+
+void
+rgba16RowToRgba8(
+    const uint16_t *src,
+    RGBA8_T *dst,
+    int32_t length);
+
+void
+rgba8RowToRgb888(
+    const RGBA8_T *src,
+    uint8_t *dst,
+    int32_t length);
+
+void
+rgb888RowToRgba8(
+    const uint8_t *src,
+    RGBA8_T *dst,
+    int32_t length);
+
+// The code path the converters were built with: "NEON", "SSE2" or "C".
+
+const char *
+imageConvertPath(void);
+
+//-------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,140 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "image.h"
+#include "imageFile.h"
+#include "imagePalette.h"
+#include "loadpng.h"
+#include "mappedImage.h"
+#include "qoi.h"
+#include "savepng.h"
+
+//-------------------------------------------------------------------------
+
+static bool
+hasExtension(
+    const char *path,
+    const char *extension)
+{
+    size_t pathLength = strlen(path);
+    size_t extensionLength = strlen(extension);
+
+    return (pathLength > extensionLength) &&
+           (strcasecmp(path + pathLength - extensionLength, extension) == 0);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadImage(
+    IMAGE_T *image,
+    IMAGE_PALETTE32_T *palette,
+    const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "imageFile: can't open file for reading\n");
+        return false;
+    }
+
+    char magic[4];
+
+    if ((fread(magic, sizeof(magic), 1, file) == 1) &&
+        (memcmp(magic, MAPPED_IMAGE_MAGIC, sizeof(magic)) == 0))
+    {
+        fclose(file);
+        return loadMappedImage(image, palette, path);
+    }
+
+    rewind(file);
+
+    bool result = loadImageFile(image, palette, file);
+
+    fclose(file);
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+// Only one character can be pushed back onto a stream, but the first one
+// is enough to tell a QOI file ('q') from a PNG (0x89).
+
+bool
+loadImageFile(
+    IMAGE_T *image,
+    IMAGE_PALETTE32_T *palette,
+    FILE *file)
+{
+    int c = getc(file);
+
+    if ((c == EOF) || (ungetc(c, file) == EOF))
+    {
+        return false;
+    }
+
+    if (c == QOI_MAGIC[0])
+    {
+        if (palette != NULL)
+        {
+            palette->palette = NULL;
+            palette->length = 0;
+        }
+
+        return loadQoiFile(image, file);
+    }
+
+    return loadPngFilePalette(image, palette, file);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+saveImage(
+    const IMAGE_T *image,
+    const char *path)
+{
+    if (hasExtension(path, ".qoi"))
+    {
+        return saveQoi(image, path);
+    }
+    else if (hasExtension(path, ".dmx"))
+    {
+        return saveMappedImage(image, NULL, path);
+    }
+
+    return savePng(image, path);
+}
+
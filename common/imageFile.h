@@ -0,0 +1,69 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef IMAGE_FILE_H
+#define IMAGE_FILE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "image.h"
+#include "imagePalette.h"
+
+//-------------------------------------------------------------------------
+// Load a PNG, QOI or mapped image (see png2dmx) file, telling them apart
+// by the first bytes of the file rather than its name. PNGs and QOI files
+// load as RGBA32 if they have alpha and RGB888 if they don't, a mapped
+// image as whatever type it was saved as. Palette PNGs load as in
+// loadPngPalette, and mapped images with a palette fill it too, otherwise
+// the palette is left empty. It may be NULL.
+
+bool
+loadImage(
+    IMAGE_T *image,
+    IMAGE_PALETTE32_T *palette,
+    const char *path);
+
+// A stream can't be mapped, so this only loads PNG and QOI.
+
+bool
+loadImageFile(
+    IMAGE_T *image,
+    IMAGE_PALETTE32_T *palette,
+    FILE *file);
+
+//-------------------------------------------------------------------------
+// Save as QOI if the name ends in .qoi, as a mapped image if it ends in
+// .dmx and as a PNG otherwise.
+
+bool saveImage(const IMAGE_T *image, const char *path);
+
+//-------------------------------------------------------------------------
+
+#endif
+
@@ -25,6 +25,7 @@
 //
 //-------------------------------------------------------------------------
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 #include "image.h"
@@ -32,6 +33,58 @@
 
 //-------------------------------------------------------------------------
 
+// Intersect the box with corners (x1, y1) and (x2, y2) with the clip
+// rectangle. False is returned if nothing is left.
+
+static bool
+clipBox(
+    const IMAGE_T *image,
+    int32_t x1,
+    int32_t y1,
+    int32_t x2,
+    int32_t y2,
+    int32_t *left,
+    int32_t *top,
+    int32_t *width,
+    int32_t *height)
+{
+    const VC_RECT_T *clip = getImageClip(image);
+
+    int64_t l = (x1 < x2) ? x1 : x2;
+    int64_t t = (y1 < y2) ? y1 : y2;
+    int64_t r = ((x1 < x2) ? x2 : x1) + (int64_t)1;
+    int64_t b = ((y1 < y2) ? y2 : y1) + (int64_t)1;
+
+    if (l < clip->x)
+    {
+        l = clip->x;
+    }
+
+    if (t < clip->y)
+    {
+        t = clip->y;
+    }
+
+    if (r > clip->x + clip->width)
+    {
+        r = clip->x + clip->width;
+    }
+
+    if (b > clip->y + clip->height)
+    {
+        b = clip->y + clip->height;
+    }
+
+    *left = l;
+    *top = t;
+    *width = r - l;
+    *height = b - t;
+
+    return (*width > 0) && (*height > 0);
+}
+
+//-------------------------------------------------------------------------
+
 void
 imageBoxIndexed(
     IMAGE_T *image,
@@ -75,18 +128,29 @@ imageBoxFilledIndexed(
     int32_t y2,
     int8_t index)
 {
-    int32_t sign_y = (y1 <= y2) ? 1 : -1;
-    int32_t y = y1;
+    if (image->fillSpanIndexed == NULL)
+    {
+        return;
+    }
 
-    imageHorizontalLineIndexed(image, x1, x2, y, index);
+    int32_t left;
+    int32_t top;
+    int32_t width;
+    int32_t height;
 
-    while (y != y2)
+    if (clipBox(image, x1, y1, x2, y2, &left, &top, &width, &height))
     {
-        y += sign_y;
-        imageHorizontalLineIndexed(image, x1, x2, y, index);
+        int32_t y;
+        for (y = top ; y < top + height ; y++)
+        {
+            image->fillSpanIndexed(image, left, y, width, index);
+        }
+
+        markImageDirty(image, left, top, width, height);
     }
 }
 
+
 //-------------------------------------------------------------------------
 
 void
@@ -98,97 +162,341 @@ imageBoxFilledRGB(
     int32_t y2,
     const RGBA8_T *rgb)
 {
-    int32_t sign_y = (y1 <= y2) ? 1 : -1;
-    int32_t y = y1;
+    if (image->fillSpanDirect == NULL)
+    {
+        return;
+    }
 
-    imageHorizontalLineRGB(image, x1, x2, y, rgb);
+    int32_t left;
+    int32_t top;
+    int32_t width;
+    int32_t height;
 
-    while (y != y2)
+    if (clipBox(image, x1, y1, x2, y2, &left, &top, &width, &height))
     {
-        y += sign_y;
-        imageHorizontalLineRGB(image, x1, x2, y, rgb);
+        int32_t y;
+        for (y = top ; y < top + height ; y++)
+        {
+            image->fillSpanDirect(image, left, y, width, rgb);
+        }
+
+        markImageDirty(image, left, top, width, height);
     }
 }
 
+
 //-------------------------------------------------------------------------
 
-void
-imageLineIndexed(
+// A line is stepped along its major axis, the axis it changes most along.
+// Step k is at offset k along the major axis and at offset
+//
+//     floor((2 * k * minor + major - 1) / (2 * major))
+//
+// along the minor axis, which is where Bresenham's algorithm puts it. This
+// lets a line be clipped to the image before it is drawn.
+
+typedef struct
+{
+    const RGBA8_T *rgb;
+    int8_t index;
+} LINE_PEN_T;
+
+//-------------------------------------------------------------------------
+
+static int64_t
+lineMinorOffset(
+    int64_t k,
+    int64_t major,
+    int64_t minor)
+{
+    return ((2 * k * minor) + major - 1) / (2 * major);
+}
+
+//-------------------------------------------------------------------------
+
+// Limit the steps [first, last] to those where 'start + sign * offset' is
+// in [from, to), where offset is the step itself.
+
+static void
+clipLineMajor(
+    int32_t start,
+    int32_t sign,
+    int32_t from,
+    int32_t to,
+    int64_t *first,
+    int64_t *last)
+{
+    int64_t low = (sign > 0) ? (int64_t)from - start
+                             : (int64_t)start - (to - 1);
+    int64_t high = (sign > 0) ? (int64_t)(to - 1) - start
+                              : (int64_t)start - from;
+
+    if (low > *first)
+    {
+        *first = low;
+    }
+
+    if (high < *last)
+    {
+        *last = high;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Limit the steps [first, last] to those where 'start + sign * offset' is
+// in [from, to), where offset is lineMinorOffset() of the step.
+
+static void
+clipLineMinor(
+    int32_t start,
+    int32_t sign,
+    int32_t from,
+    int32_t to,
+    int64_t major,
+    int64_t minor,
+    int64_t *first,
+    int64_t *last)
+{
+    int64_t low = (sign > 0) ? (int64_t)from - start
+                             : (int64_t)start - (to - 1);
+    int64_t high = (sign > 0) ? (int64_t)(to - 1) - start
+                              : (int64_t)start - from;
+
+    if ((high < 0) || (low > minor))
+    {
+        *first = 1;
+        *last = 0;
+        return;
+    }
+
+    if (low > 0)
+    {
+        int64_t step = ((2 * low * major) - major + 2 * minor)
+                     / (2 * minor);
+
+        if (step > *first)
+        {
+            *first = step;
+        }
+    }
+
+    if (high < minor)
+    {
+        int64_t step = ((2 * (high + 1) * major) - major + 2 * minor)
+                     / (2 * minor) - 1;
+
+        if (step < *last)
+        {
+            *last = step;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// The span is already inside the clip rectangle, so it is drawn without
+// clipping.
+
+static void
+fillLineSpan(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    int32_t length,
+    const LINE_PEN_T *pen)
+{
+    if (pen->rgb != NULL)
+    {
+        image->fillSpanDirect(image, x, y, length, pen->rgb);
+    }
+    else
+    {
+        image->fillSpanIndexed(image, x, y, length, pen->index);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+drawLine(
     IMAGE_T *image,
     int32_t x1,
     int32_t y1,
     int32_t x2,
     int32_t y2,
-    int8_t index)
+    const LINE_PEN_T *pen)
 {
-    if (y1 == y2)
+    if (((pen->rgb != NULL) && (image->fillSpanDirect == NULL)) ||
+        ((pen->rgb == NULL) && (image->fillSpanIndexed == NULL)))
     {
-        imageHorizontalLineIndexed(image, x1, x2, y1, index);
+        return;
     }
-    else if (x1 == x2)
+
+    int64_t dx = llabs((int64_t)x2 - x1);
+    int64_t dy = llabs((int64_t)y2 - y1);
+
+    int32_t sign_x = (x1 <= x2) ? 1 : -1;
+    int32_t sign_y = (y1 <= y2) ? 1 : -1;
+
+    bool xMajor = (dx > dy);
+    int64_t major = (xMajor) ? dx : dy;
+    int64_t minor = (xMajor) ? dy : dx;
+
+    const VC_RECT_T *clip = getImageClip(image);
+    int32_t right = clip->x + clip->width;
+    int32_t bottom = clip->y + clip->height;
+
+    int64_t first = 0;
+    int64_t last = major;
+
+    if (xMajor)
     {
-        imageVerticalLineIndexed(image, x1, y1, y2, index);
+        clipLineMajor(x1, sign_x, clip->x, right, &first, &last);
+        clipLineMinor(y1,
+                      sign_y,
+                      clip->y,
+                      bottom,
+                      major,
+                      minor,
+                      &first,
+                      &last);
     }
     else
     {
-        int32_t dx = abs(x2 - x1);
-        int32_t dy = abs(y2 - y1);
+        clipLineMajor(y1, sign_y, clip->y, bottom, &first, &last);
+        clipLineMinor(x1,
+                      sign_x,
+                      clip->x,
+                      right,
+                      major,
+                      minor,
+                      &first,
+                      &last);
+    }
 
-        int32_t sign_x = (x1 <= x2) ? 1 : -1;
-        int32_t sign_y = (y1 <= y2) ? 1 : -1;
+    if (first > last)
+    {
+        return;
+    }
+
+    //---------------------------------------------------------------------
+
+    int64_t offset = lineMinorOffset(first, major, minor);
+    int64_t d = (2 * minor) - major
+              + (2 * first * minor) - (2 * offset * major);
+    int64_t incrE = 2 * minor;
+    int64_t incrNE = 2 * (minor - major);
+
+    int32_t x;
+    int32_t y;
+
+    if (xMajor)
+    {
+        x = x1 + sign_x * first;
+        y = y1 + sign_y * offset;
+    }
+    else
+    {
+        x = x1 + sign_x * offset;
+        y = y1 + sign_y * first;
+    }
 
-        int32_t x = x1;
-        int32_t y = y1;
+    int32_t xFirst = x;
+    int32_t yFirst = y;
 
-        setPixelIndexed(image, x, y, index);
+    int64_t k = first;
 
-        if (dx > dy)
+    if (xMajor)
+    {
+        // Each row is one span. While d <= 0 the line steps along the row,
+        // so the length of the span can be worked out directly.
+
+        while (k <= last)
         {
-            int32_t d = 2 * dy - dx;
-            int32_t incrE = 2 * dy;
-            int32_t incrNE = 2 * (dy - dx);
+            int64_t steps = (d <= 0) ? (-d / incrE) + 1 : 0;
+            int32_t length = ((steps < last - k) ? steps : last - k) + 1;
 
-            while (x != x2)
+            if (sign_x > 0)
             {
-                x += sign_x;
-
-                if (d <= 0)
-                {
-                    d += incrE;
-                }
-                else
-                {
-                    d += incrNE;
-                    y += sign_y;
-                }
-
-                setPixelIndexed(image, x, y, index);
+                fillLineSpan(image, x, y, length, pen);
             }
+            else
+            {
+                fillLineSpan(image, x - length + 1, y, length, pen);
+            }
+
+            k += steps + 1;
+            d += (steps * incrE) + incrNE;
+            x += sign_x * (steps + 1);
+            y += sign_y;
         }
-        else
+
+        x -= sign_x * (k - last);
+        y -= sign_y;
+    }
+    else
+    {
+        while (true)
         {
-            int32_t d = 2 * dx - dy;
-            int32_t incrN = 2 * dx;
-            int32_t incrNE = 2 * (dx - dy);
+            fillLineSpan(image, x, y, 1, pen);
 
-            while (y != y2)
+            if (k == last)
+            {
+                break;
+            }
+
+            ++k;
+            y += sign_y;
+
+            if (d <= 0)
+            {
+                d += incrE;
+            }
+            else
             {
-                y += sign_y;
-
-                if (d <= 0)
-                {
-                    d += incrN;
-                }
-                else
-                {
-                    d += incrNE;
-                    x += sign_x;
-                }
-
-                setPixelIndexed(image, x, y, index);
+                d += incrNE;
+                x += sign_x;
             }
         }
     }
+
+    //---------------------------------------------------------------------
+
+    int32_t left = (x < xFirst) ? x : xFirst;
+    int32_t top = (y < yFirst) ? y : yFirst;
+
+    markImageDirty(image,
+                   left,
+                   top,
+                   abs(x - xFirst) + 1,
+                   abs(y - yFirst) + 1);
+}
+
+//-------------------------------------------------------------------------
+
+void
+imageLineIndexed(
+    IMAGE_T *image,
+    int32_t x1,
+    int32_t y1,
+    int32_t x2,
+    int32_t y2,
+    int8_t index)
+{
+    if (y1 == y2)
+    {
+        imageHorizontalLineIndexed(image, x1, x2, y1, index);
+    }
+    else if (x1 == x2)
+    {
+        imageVerticalLineIndexed(image, x1, y1, y2, index);
+    }
+    else
+    {
+        LINE_PEN_T pen = { NULL, index };
+        drawLine(image, x1, y1, x2, y2, &pen);
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -212,64 +520,269 @@ imageLineRGB(
     }
     else
     {
-        int32_t dx = abs(x2 - x1);
-        int32_t dy = abs(y2 - y1);
+        LINE_PEN_T pen = { rgb, 0 };
+        drawLine(image, x1, y1, x2, y2, &pen);
+    }
+}
 
-        int32_t sign_x = (x1 <= x2) ? 1 : -1;
-        int32_t sign_y = (y1 <= y2) ? 1 : -1;
+//-------------------------------------------------------------------------
 
-        int32_t x = x1;
-        int32_t y = y1;
+// Composite 'rgb' over 'pixel' with a weight from 0 to 256. Opaque pixels,
+// the usual case, are a simple mix.
 
-        setPixelRGB(image, x, y, rgb);
+static void
+blendLineRGBA(
+    RGBA8_T *pixel,
+    const RGBA8_T *rgb,
+    int32_t weight)
+{
+    if (pixel->alpha == 255)
+    {
+        pixel->red += ((rgb->red - pixel->red) * weight) >> 8;
+        pixel->green += ((rgb->green - pixel->green) * weight) >> 8;
+        pixel->blue += ((rgb->blue - pixel->blue) * weight) >> 8;
+    }
+    else
+    {
+        int32_t alpha = (weight * 255) >> 8;
+        int32_t under = (pixel->alpha * (255 - alpha)) / 255;
+        int32_t total = alpha + under;
 
-        if (dx > dy)
+        if (total > 0)
         {
-            int32_t d = 2 * dy - dx;
-            int32_t incrE = 2 * dy;
-            int32_t incrNE = 2 * (dy - dx);
+            pixel->red = ((rgb->red * alpha) + (pixel->red * under)) / total;
+            pixel->green = ((rgb->green * alpha) + (pixel->green * under))
+                         / total;
+            pixel->blue = ((rgb->blue * alpha) + (pixel->blue * under))
+                        / total;
+            pixel->alpha = total;
+        }
+    }
+}
 
-            while (x != x2)
-            {
-                x += sign_x;
+//-------------------------------------------------------------------------
 
-                if (d <= 0)
-                {
-                    d += incrE;
-                }
-                else
-                {
-                    d += incrNE;
-                    y += sign_y;
-                }
-
-                setPixelRGB(image, x, y, rgb);
-            }
+// Mix 'rgb' into the pixel at (x, y) with a weight from 0 to 256. RGBA32
+// and RGB565 pixels are blended in place, other direct colour types go
+// through the get and set pixel functions.
+
+static void
+blendLinePixel(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgb,
+    int32_t weight)
+{
+    const VC_RECT_T *clip = getImageClip(image);
+
+    if ((weight <= 0) ||
+        (x < clip->x) || (x >= clip->x + clip->width) ||
+        (y < clip->y) || (y >= clip->y + clip->height))
+    {
+        return;
+    }
+
+    weight = (weight * (rgb->alpha + 1)) >> 8;
+
+    uint8_t *line = (uint8_t *)(image->buffer) + (y * image->pitch);
+
+    if (image->type == VC_IMAGE_RGBA32)
+    {
+        uint8_t *pixel = line + (4 * x);
+        RGBA8_T rgba = { pixel[0], pixel[1], pixel[2], pixel[3] };
+
+        blendLineRGBA(&rgba, rgb, weight);
+
+        pixel[0] = rgba.red;
+        pixel[1] = rgba.green;
+        pixel[2] = rgba.blue;
+        pixel[3] = rgba.alpha;
+    }
+    else if (image->type == VC_IMAGE_RGB565)
+    {
+        uint16_t *pixel = (uint16_t *)line + x;
+
+        int32_t r5 = (*pixel >> 11) & 0x1F;
+        int32_t g6 = (*pixel >> 5) & 0x3F;
+        int32_t b5 = *pixel & 0x1F;
+
+        r5 += (((rgb->red >> 3) - r5) * weight) >> 8;
+        g6 += (((rgb->green >> 2) - g6) * weight) >> 8;
+        b5 += (((rgb->blue >> 3) - b5) * weight) >> 8;
+
+        *pixel = (r5 << 11) | (g6 << 5) | b5;
+    }
+    else if (image->getPixelDirect != NULL)
+    {
+        RGBA8_T pixel;
+        image->getPixelDirect(image, x, y, &pixel);
+
+        blendLineRGBA(&pixel, rgb, weight);
+
+        image->setPixelDirect(image, x, y, &pixel);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Xiaolin Wu's line. Each step along the major axis covers two pixels of
+// the minor axis, weighted by how close the line passes to each.
+
+void
+imageLineAntiAliasedRGB(
+    IMAGE_T *image,
+    int32_t x1,
+    int32_t y1,
+    int32_t x2,
+    int32_t y2,
+    const RGBA8_T *rgb)
+{
+    if (image->getPixelDirect == NULL)
+    {
+        return;
+    }
+
+    int64_t dx = (int64_t)x2 - x1;
+    int64_t dy = (int64_t)y2 - y1;
+
+    bool xMajor = (llabs(dx) >= llabs(dy));
+    int64_t major = (xMajor) ? llabs(dx) : llabs(dy);
+    int32_t majorStart = (xMajor) ? x1 : y1;
+    int32_t majorSign = (((xMajor) ? dx : dy) >= 0) ? 1 : -1;
+    int32_t minorStart = (xMajor) ? y1 : x1;
+
+    const VC_RECT_T *clip = getImageClip(image);
+    int32_t majorFrom = (xMajor) ? clip->x : clip->y;
+    int32_t majorTo = majorFrom + ((xMajor) ? clip->width : clip->height);
+    int32_t minorFrom = (xMajor) ? clip->y : clip->x;
+    int32_t minorTo = minorFrom + ((xMajor) ? clip->height : clip->width);
+
+    // 16.16 fixed point change in the minor axis for each step
+
+    int64_t gradient = 0;
+
+    if (major != 0)
+    {
+        gradient = (((xMajor) ? dy : dx) * 65536) / major;
+    }
+
+    int64_t first = 0;
+    int64_t last = major;
+
+    clipLineMajor(majorStart, majorSign, majorFrom, majorTo, &first, &last);
+
+    // Skip the steps that are wholly outside the clip rectangle in the
+    // minor axis, give or take a step.
+
+    if (gradient != 0)
+    {
+        int64_t low = (((int64_t)minorFrom - 1 - minorStart) * 65536)
+                    / gradient;
+        int64_t high = (((int64_t)minorTo - minorStart) * 65536)
+                     / gradient;
+
+        if (low > high)
+        {
+            int64_t swap = low;
+            low = high;
+            high = swap;
         }
-        else
+
+        if (low - 1 > first)
         {
-            int32_t d = 2 * dx - dy;
-            int32_t incrN = 2 * dx;
-            int32_t incrNE = 2 * (dx - dy);
+            first = low - 1;
+        }
 
-            while (y != y2)
-            {
-                y += sign_y;
-
-                if (d <= 0)
-                {
-                    d += incrN;
-                }
-                else
-                {
-                    d += incrNE;
-                    x += sign_x;
-                }
-
-                setPixelRGB(image, x, y, rgb);
-            }
+        if (high + 1 < last)
+        {
+            last = high + 1;
         }
     }
+    else if ((minorStart < minorFrom) || (minorStart >= minorTo))
+    {
+        return;
+    }
+
+    if (first > last)
+    {
+        return;
+    }
+
+    //---------------------------------------------------------------------
+
+    int64_t k;
+    for (k = first ; k <= last ; k++)
+    {
+        int64_t minor = ((int64_t)minorStart * 65536) + (gradient * k);
+        int32_t whole = (int32_t)(minor >> 16);
+        int32_t fraction = (int32_t)((minor & 0xFFFF) >> 8);
+        int32_t position = majorStart + (majorSign * k);
+
+        if (xMajor)
+        {
+            blendLinePixel(image, position, whole, rgb, 256 - fraction);
+            blendLinePixel(image, position, whole + 1, rgb, fraction);
+        }
+        else
+        {
+            blendLinePixel(image, whole, position, rgb, 256 - fraction);
+            blendLinePixel(image, whole + 1, position, rgb, fraction);
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    // The minor position only moves one way, so the steps actually plotted
+    // cover the minor positions between the first and last step (plus the
+    // pixel below the last), limited to the clip rectangle.
+
+    int64_t minorFirst = (((int64_t)minorStart * 65536) + (gradient * first))
+                       >> 16;
+    int64_t minorLast = (((int64_t)minorStart * 65536) + (gradient * last))
+                      >> 16;
+
+    int64_t minorLow = (minorFirst < minorLast) ? minorFirst : minorLast;
+    int64_t minorHigh = ((minorFirst > minorLast) ? minorFirst : minorLast)
+                      + 1;
+
+    if (minorLow < minorFrom)
+    {
+        minorLow = minorFrom;
+    }
+
+    if (minorHigh > minorTo - 1)
+    {
+        minorHigh = minorTo - 1;
+    }
+
+    if (minorLow > minorHigh)
+    {
+        return;
+    }
+
+    int32_t majorFirst = majorStart + (majorSign * first);
+    int32_t majorLast = majorStart + (majorSign * last);
+    int32_t majorLow = (majorFirst < majorLast) ? majorFirst : majorLast;
+    int32_t majorLength = abs(majorLast - majorFirst) + 1;
+    int32_t minorLength = (int32_t)(minorHigh - minorLow) + 1;
+
+    if (xMajor)
+    {
+        markImageDirty(image,
+                       majorLow,
+                       (int32_t)minorLow,
+                       majorLength,
+                       minorLength);
+    }
+    else
+    {
+        markImageDirty(image,
+                       (int32_t)minorLow,
+                       majorLow,
+                       minorLength,
+                       majorLength);
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -282,16 +795,7 @@ imageHorizontalLineIndexed(
     int32_t y,
     int8_t index)
 {
-    int32_t sign_x = (x1 <= x2) ? 1 : -1;
-    int32_t x = x1;
-
-    setPixelIndexed(image, x, y, index);
-
-    while (x != x2)
-    {
-        x += sign_x;
-        setPixelIndexed(image, x, y, index);
-    }
+    imageBoxFilledIndexed(image, x1, y, x2, y, index);
 }
 
 //-------------------------------------------------------------------------
@@ -304,16 +808,7 @@ imageHorizontalLineRGB(
     int32_t y,
     const RGBA8_T *rgb)
 {
-    int32_t sign_x = (x1 <= x2) ? 1 : -1;
-    int32_t x = x1;
-
-    setPixelRGB(image, x, y, rgb);
-
-    while (x != x2)
-    {
-        x += sign_x;
-        setPixelRGB(image, x, y, rgb);
-    }
+    imageBoxFilledRGB(image, x1, y, x2, y, rgb);
 }
 
 //-------------------------------------------------------------------------
@@ -326,16 +821,7 @@ imageVerticalLineIndexed(
     int32_t y2,
     int8_t index)
 {
-    int32_t sign_y = (y1 <= y2) ? 1 : -1;
-    int32_t y = y1;
-
-    setPixelIndexed(image, x, y, index);
-
-    while (y != y2)
-    {
-        y += sign_y;
-        setPixelIndexed(image, x, y, index);
-    }
+    imageBoxFilledIndexed(image, x, y1, x, y2, index);
 }
 
 //-------------------------------------------------------------------------
@@ -348,15 +834,6 @@ imageVerticalLineRGB(
     int32_t y2,
     const RGBA8_T *rgb)
 {
-    int32_t sign_y = (y1 <= y2) ? 1 : -1;
-    int32_t y = y1;
-
-    setPixelRGB(image, x, y, rgb);
-
-    while (y != y2)
-    {
-        y += sign_y;
-        setPixelRGB(image, x, y, rgb);
-    }
+    imageBoxFilledRGB(image, x, y1, x, y2, rgb);
 }
 
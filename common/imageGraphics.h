@@ -86,6 +86,18 @@ imageLineRGB(
     int32_t y2,
     const RGBA8_T *rgb);
 
+// Anti-aliased line, blended into the image using the alpha of 'rgb'. Only
+// direct colour images are drawn on.
+
+void
+imageLineAntiAliasedRGB(
+    IMAGE_T *image,
+    int32_t x1,
+    int32_t y1,
+    int32_t x2,
+    int32_t y2,
+    const RGBA8_T *rgb);
+
 void
 imageHorizontalLineIndexed(
     IMAGE_T *image,
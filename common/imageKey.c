@@ -45,6 +45,7 @@
 KEY_DIMENSIONS_T
 drawKey(
     IMAGE_LAYER_T *imageLayer,
+    FONT_CACHE_T *fontCache,
     int32_t x,
     int32_t y,
     const char *text,
@@ -77,17 +78,21 @@ drawKey(
 
     imageBoxRGB(image, x, y, x + width, y + height, &borderColour);
 
-    drawStringRGB(x + KEY_BORDER_WIDTH + KEY_LEFT_PADDING,
-                  y + KEY_BORDER_WIDTH + KEY_TOP_PADDING,
-                  text,
-                  &textColour,
-                  image);
-
-    drawStringRGB(x + width + KEY_RIGHT_PADDING,
-                  y + KEY_BORDER_WIDTH + KEY_TOP_PADDING,
-                  description,
-                  &textColour,
-                  image);
+    drawStringCachedRGB(fontCache,
+                        x + KEY_BORDER_WIDTH + KEY_LEFT_PADDING,
+                        y + KEY_BORDER_WIDTH + KEY_TOP_PADDING,
+                        text,
+                        &textColour,
+                        &backgroundColour,
+                        image);
+
+    drawStringCachedRGB(fontCache,
+                        x + width + KEY_RIGHT_PADDING,
+                        y + KEY_BORDER_WIDTH + KEY_TOP_PADDING,
+                        description,
+                        &textColour,
+                        &backgroundColour,
+                        image);
 
     KEY_DIMENSIONS_T dimensions = { width, height };
 
@@ -30,6 +30,7 @@
 
 #include <stdint.h>
 
+#include "font.h"
 #include "imageLayer.h"
 
 //-------------------------------------------------------------------------
@@ -41,10 +42,13 @@ typedef struct
 } KEY_DIMENSIONS_T;
 
 //-------------------------------------------------------------------------
+// The key and its description are drawn on a white background, the text
+// through the caller's font cache.
 
 KEY_DIMENSIONS_T
 drawKey(
     IMAGE_LAYER_T *imageLayer,
+    FONT_CACHE_T *fontCache,
     int32_t x,
     int32_t y,
     const char *text,
@@ -42,6 +42,9 @@ initImageLayer(
     VC_IMAGE_TYPE_T type)
 {
     initImage(&(il->image), type, width, height, false);
+
+    il->palette.palette = NULL;
+    il->palette.length = 0;
 }
 
 //-------------------------------------------------------------------------
@@ -64,6 +67,16 @@ createResourceImageLayer(
             &vc_image_ptr);
     assert(il->resource != 0);
 
+    if (il->palette.length > 0)
+    {
+        bool set = setResourcePalette32(&(il->palette),
+                                        0,
+                                        il->resource,
+                                        0,
+                                        il->palette.length);
+        assert(set);
+    }
+
     //---------------------------------------------------------------------
 
     vc_dispmanx_rect_set(&(il->bmpRect),
@@ -78,6 +91,8 @@ createResourceImageLayer(
                                              il->image.buffer,
                                              &(il->bmpRect));
     assert(result == 0);
+
+    clearImageDirty(&(il->image));
 }
 
 //-------------------------------------------------------------------------
@@ -160,21 +175,42 @@ addElementImageLayer(
 
 //-------------------------------------------------------------------------
 
+// Only the rows that have changed since the last write are copied to the
+// resource.
+
+static void
+writeDirtyImageLayer(
+    IMAGE_LAYER_T *il)
+{
+    IMAGE_T *image = &(il->image);
+
+    int32_t i;
+    for (i = 0 ; i < image->dirty.count ; i++)
+    {
+        int result =
+            vc_dispmanx_resource_write_data(il->resource,
+                                            image->type,
+                                            image->pitch,
+                                            image->buffer,
+                                            &(image->dirty.rects[i]));
+        assert(result == 0);
+    }
+
+    clearImageDirty(image);
+}
+
+//-------------------------------------------------------------------------
+
 void
 changeSourceImageLayer(
     IMAGE_LAYER_T *il,
     DISPMANX_UPDATE_HANDLE_T update)
 {
-    int result = vc_dispmanx_resource_write_data(il->resource,
-                                                 il->image.type,
-                                                 il->image.pitch,
-                                                 il->image.buffer,
-                                                 &(il->bmpRect));
-    assert(result == 0);
+    writeDirtyImageLayer(il);
 
-    result = vc_dispmanx_element_change_source(update,
-                                               il->element,
-                                               il->resource);
+    int result = vc_dispmanx_element_change_source(update,
+                                                   il->element,
+                                                   il->resource);
     assert(result == 0);
 
 }
@@ -185,19 +221,14 @@ void
 changeSourceAndUpdateImageLayer(
     IMAGE_LAYER_T *il)
 {
-    int result = vc_dispmanx_resource_write_data(il->resource,
-                                                 il->image.type,
-                                                 il->image.pitch,
-                                                 il->image.buffer,
-                                                 &(il->bmpRect));
-    assert(result == 0);
+    writeDirtyImageLayer(il);
 
     DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
     assert(update != 0);
 
-    result = vc_dispmanx_element_change_source(update,
-                                               il->element,
-                                               il->resource);
+    int result = vc_dispmanx_element_change_source(update,
+                                                   il->element,
+                                                   il->resource);
     assert(result == 0);
 
     result = vc_dispmanx_update_submit_sync(update);
@@ -256,5 +287,6 @@ destroyImageLayer(
     //---------------------------------------------------------------------
 
     destroyImage(&(il->image));
+    destroyImagePalette32(&(il->palette));
 }
 
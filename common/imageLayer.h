@@ -29,14 +29,19 @@
 #define IMAGE_LAYER_H
 
 #include "image.h"
+#include "imagePalette.h"
 
 #include "bcm_host.h"
 
 //-------------------------------------------------------------------------
+// An indexed image's palette is uploaded to the resource when it is
+// created. initImageLayer, loadPngPalette and loadImage all set the
+// palette, so one of them must be used to fill in the layer.
 
 typedef struct
 {
     IMAGE_T image;
+    IMAGE_PALETTE32_T palette;
     VC_RECT_T bmpRect;
     VC_RECT_T srcRect;
     VC_RECT_T dstRect;
@@ -131,7 +131,7 @@ setResourcePalette16(
 {
     bool result = false;
 
-    if ((first >= 0) && (last + offset < palette->length))
+    if ((first >= 0) && (last + offset <= palette->length))
     {
         int status =
             vc_dispmanx_resource_set_palette(resource,
@@ -235,7 +235,7 @@ uint32_t
 rgbaToPalette32Entry(
     const RGBA8_T *rgba)
 {
-    return (rgba->alpha << 24) |
+    return ((uint32_t)(rgba->alpha) << 24) |
            (rgba->red << 16) |
            (rgba->green << 8) |
            rgba->blue;
@@ -253,7 +253,7 @@ setResourcePalette32(
 {
     bool result = false;
 
-    if ((first >= 0) && (last + offset < palette->length))
+    if ((first >= 0) && (last + offset <= palette->length))
     {
         int status =
             vc_dispmanx_resource_set_palette(resource,
@@ -268,6 +268,47 @@ setResourcePalette32(
 
 //-------------------------------------------------------------------------
 
+// Palette equivalents of setImageAlphaRelative and setImageRGB, for
+// indexed images.
+
+void
+setPalette32AlphaRelative(
+    IMAGE_PALETTE32_T *palette,
+    uint8_t alpha)
+{
+    int16_t i;
+    for (i = 0 ; i < palette->length ; i++)
+    {
+        RGBA8_T rgba;
+        palette32EntryToRgba(palette->palette[i], &rgba);
+        rgba.alpha = (uint8_t)(rgba.alpha * (uint16_t)alpha / 255);
+        palette->palette[i] = rgbaToPalette32Entry(&rgba);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+setPalette32Rgb(
+    IMAGE_PALETTE32_T *palette,
+    uint8_t red,
+    uint8_t green,
+    uint8_t blue)
+{
+    int16_t i;
+    for (i = 0 ; i < palette->length ; i++)
+    {
+        RGBA8_T rgba;
+        palette32EntryToRgba(palette->palette[i], &rgba);
+        rgba.red = red;
+        rgba.green = green;
+        rgba.blue = blue;
+        palette->palette[i] = rgbaToPalette32Entry(&rgba);
+    }
+}
+
+//-------------------------------------------------------------------------
+
 void
 destroyImagePalette32(
     IMAGE_PALETTE32_T *palette)
@@ -127,6 +127,18 @@ setResourcePalette32(
     int16_t first,
     int16_t last);
 
+void
+setPalette32AlphaRelative(
+    IMAGE_PALETTE32_T *palette,
+    uint8_t alpha);
+
+void
+setPalette32Rgb(
+    IMAGE_PALETTE32_T *palette,
+    uint8_t red,
+    uint8_t green,
+    uint8_t blue);
+
 void
 destroyImagePalette32(
     IMAGE_PALETTE32_T *palette);
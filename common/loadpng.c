@@ -60,11 +60,69 @@ loadPng(
     return result;
 }
 
-bool
-loadPngFile(
+//-------------------------------------------------------------------------
+
+// Copy the PNG palette, with any tRNS alpha, into a full 256 entry palette
+// made by the caller. Unused entries are left transparent.
+
+static void
+readPngPalette(
+    png_structp png_ptr,
+    png_infop info_ptr,
+    IMAGE_PALETTE32_T *palette)
+{
+    png_colorp colours = NULL;
+    int numColours = 0;
+    png_bytep alphas = NULL;
+    int numAlphas = 0;
+
+    png_get_PLTE(png_ptr, info_ptr, &colours, &numColours);
+
+    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+    {
+        png_get_tRNS(png_ptr, info_ptr, &alphas, &numAlphas, NULL);
+    }
+
+    int i = 0;
+    for (i = 0 ; (i < numColours) && (i < palette->length) ; i++)
+    {
+        RGBA8_T rgba =
+        {
+            colours[i].red,
+            colours[i].green,
+            colours[i].blue,
+            (i < numAlphas) ? alphas[i] : 255
+        };
+
+        setPalette32EntryRgba(palette, i, &rgba);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Load the PNG as 'alphaType' if it has an alpha channel or transparent
+// colour, and as 'opaqueType' if it doesn't. RGBA32 and RGB888 are read
+// straight into the image. Other types are read a row at a time as RGBA
+// and converted, so only one extra row of memory is needed, except for
+// interlaced images, which are read whole first. If 'palette' isn't NULL,
+// palette images are read as 8BPP and their palette is returned in it. For
+// other images it is left empty.
+
+static bool
+loadPngFileTypes(
     IMAGE_T* image,
-    FILE *file)
+    IMAGE_PALETTE32_T *palette,
+    FILE *file,
+    VC_IMAGE_TYPE_T alphaType,
+    VC_IMAGE_TYPE_T opaqueType,
+    bool dither)
 {
+    if (palette != NULL)
+    {
+        palette->palette = NULL;
+        palette->length = 0;
+    }
+
     png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING,
                                                  NULL,
                                                  NULL,
@@ -100,18 +158,99 @@ loadPngFile(
     png_byte colour_type = png_get_color_type(png_ptr, info_ptr);
     png_byte bit_depth = png_get_bit_depth(png_ptr, info_ptr);
 
-    VC_IMAGE_TYPE_T type = VC_IMAGE_RGB888;
+    bool hasAlpha = (colour_type & PNG_COLOR_MASK_ALPHA) ||
+                    png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS);
+
+    bool indexed = (palette != NULL) &&
+                   (colour_type == PNG_COLOR_TYPE_PALETTE);
+
+    VC_IMAGE_TYPE_T type = (hasAlpha) ? alphaType : opaqueType;
+
+    if (indexed)
+    {
+        type = VC_IMAGE_8BPP;
+    }
+
+    // Rows that libpng can't produce in the image's own format are read as
+    // RGBA and converted.
+
+    bool convert = (hasAlpha) ? (type != VC_IMAGE_RGBA32)
+                              : (type != VC_IMAGE_RGB888);
+
+    if (indexed)
+    {
+        convert = false;
+    }
+
+    if (initImage(image,
+                  type,
+                  png_get_image_width(png_ptr, info_ptr),
+                  png_get_image_height(png_ptr, info_ptr),
+                  dither) == false)
+    {
+        png_destroy_read_struct(&png_ptr, &info_ptr, 0);
+        return false;
+    }
+
+    if (convert && (image->setSpanDirect == NULL))
+    {
+        fprintf(stderr, "loadpng: can't load as an indexed image\n");
+        destroyImage(image);
+        png_destroy_read_struct(&png_ptr, &info_ptr, 0);
+        return false;
+    }
+
+    //---------------------------------------------------------------------
+
+    // Everything that has to be freed if libpng fails is allocated before
+    // the error handler is set up, so that none of it changes after the
+    // setjmp. A converted image is read a row at a time, except that
+    // interlaced rows arrive a pass at a time, so then it is read whole
+    // as RGBA first.
+
+    bool interlaced =
+        (png_get_interlace_type(png_ptr, info_ptr) != PNG_INTERLACE_NONE);
 
-    if (colour_type & PNG_COLOR_MASK_ALPHA)
+    RGBA8_T *pixels = NULL;
+    png_bytepp row_pointers = NULL;
+
+    if (convert)
     {
-        type = VC_IMAGE_RGBA32;
+        int32_t rows = (interlaced) ? image->height : 1;
+        pixels = malloc(image->width * rows * sizeof(RGBA8_T));
     }
 
-    initImage(image,
-              type,
-              png_get_image_width(png_ptr, info_ptr),
-              png_get_image_height(png_ptr, info_ptr),
-              false);
+    if ((convert == false) || interlaced)
+    {
+        row_pointers = malloc(image->height * sizeof(png_bytep));
+    }
+
+    if ((convert && (pixels == NULL)) ||
+        (((convert == false) || interlaced) && (row_pointers == NULL)))
+    {
+        fprintf(stderr, "loadpng: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (indexed)
+    {
+        initImagePalette32(palette, 256);
+    }
+
+    if (setjmp(png_jmpbuf(png_ptr)))
+    {
+        free(row_pointers);
+        free(pixels);
+        destroyImage(image);
+
+        if (indexed)
+        {
+            destroyImagePalette32(palette);
+        }
+
+        png_destroy_read_struct(&png_ptr, &info_ptr, 0);
+        return false;
+    }
 
     //---------------------------------------------------------------------
 
@@ -124,7 +263,14 @@ loadPngFile(
 
     //---------------------------------------------------------------------
 
-    if (colour_type == PNG_COLOR_TYPE_PALETTE) 
+    if (indexed)
+    {
+        if (bit_depth < 8)
+        {
+            png_set_packing(png_ptr);
+        }
+    }
+    else if (colour_type == PNG_COLOR_TYPE_PALETTE) 
     {
         png_set_palette_to_rgb(png_ptr);
     }
@@ -134,7 +280,7 @@ loadPngFile(
         png_set_expand_gray_1_2_4_to_8(png_ptr);
     }
 
-    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS))
+    if (png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS) && (indexed == false))
     {
         png_set_tRNS_to_alpha(png_ptr);
     }
@@ -154,30 +300,176 @@ loadPngFile(
         png_set_gray_to_rgb(png_ptr);
     }
 
-    //---------------------------------------------------------------------
+    if (convert && (hasAlpha == false))
+    {
+        png_set_add_alpha(png_ptr, 0xFF, PNG_FILLER_AFTER);
+    }
 
-    png_read_update_info(png_ptr, info_ptr);
+    if (interlaced)
+    {
+        png_set_interlace_handling(png_ptr);
+    }
 
     //---------------------------------------------------------------------
 
-    png_bytepp row_pointers = malloc(image->height * sizeof(png_bytep));
+    png_read_update_info(png_ptr, info_ptr);
 
-    png_uint_32 j = 0;
-    for (j = 0 ; j < image->height ; ++j)
+    if (indexed)
     {
-        row_pointers[j] = image->buffer + (j * image->pitch);
+        readPngPalette(png_ptr, info_ptr, palette);
     }
 
     //---------------------------------------------------------------------
 
-    png_read_image(png_ptr, row_pointers);
+    int32_t j = 0;
+
+    if (convert && (interlaced == false))
+    {
+        for (j = 0 ; j < image->height ; ++j)
+        {
+            png_read_row(png_ptr, (png_bytep)pixels, NULL);
+            image->setSpanDirect(image, 0, j, image->width, pixels);
+        }
+    }
+    else
+    {
+        png_bytep buffer = image->buffer;
+        size_t pitch = image->pitch;
+
+        if (convert)
+        {
+            buffer = (png_bytep)pixels;
+            pitch = image->width * sizeof(RGBA8_T);
+        }
+
+        for (j = 0 ; j < image->height ; ++j)
+        {
+            row_pointers[j] = buffer + (j * pitch);
+        }
+
+        png_read_image(png_ptr, row_pointers);
+
+        if (convert)
+        {
+            for (j = 0 ; j < image->height ; ++j)
+            {
+                image->setSpanDirect(image,
+                                     0,
+                                     j,
+                                     image->width,
+                                     pixels + (j * image->width));
+            }
+        }
+    }
+
+    png_read_end(png_ptr, NULL);
 
     //---------------------------------------------------------------------
 
     free(row_pointers);
-
+    free(pixels);
     png_destroy_read_struct(&png_ptr, &info_ptr, 0);
 
     return true;
 }
 
+//-------------------------------------------------------------------------
+
+bool
+loadPngFile(
+    IMAGE_T* image,
+    FILE *file)
+{
+    return loadPngFileTypes(image,
+                            NULL,
+                            file,
+                            VC_IMAGE_RGBA32,
+                            VC_IMAGE_RGB888,
+                            false);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadPngAs(
+    IMAGE_T* image,
+    const char *path,
+    VC_IMAGE_TYPE_T type,
+    bool dither)
+{
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "loadpng: can't open file for reading\n");
+        return false;
+    }
+
+    bool result = loadPngFileAs(image, file, type, dither);
+
+    fclose(file);
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadPngFileAs(
+    IMAGE_T* image,
+    FILE *file,
+    VC_IMAGE_TYPE_T type,
+    bool dither)
+{
+    if (type == LOADPNG_TYPE_AUTO)
+    {
+        return loadPngFileTypes(image,
+                                NULL,
+                                file,
+                                VC_IMAGE_RGBA32,
+                                VC_IMAGE_RGB565,
+                                dither);
+    }
+
+    return loadPngFileTypes(image, NULL, file, type, type, dither);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadPngPalette(
+    IMAGE_T* image,
+    IMAGE_PALETTE32_T *palette,
+    const char *path)
+{
+    FILE* file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "loadpng: can't open file for reading\n");
+        return false;
+    }
+
+    bool result = loadPngFilePalette(image, palette, file);
+
+    fclose(file);
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadPngFilePalette(
+    IMAGE_T* image,
+    IMAGE_PALETTE32_T *palette,
+    FILE *file)
+{
+    return loadPngFileTypes(image,
+                            palette,
+                            file,
+                            VC_IMAGE_RGBA32,
+                            VC_IMAGE_RGB888,
+                            false);
+}
+
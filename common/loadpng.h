@@ -32,12 +32,52 @@
 #include <stdio.h>
 
 #include "image.h"
+#include "imagePalette.h"
 
 //-------------------------------------------------------------------------
 
 bool loadPng(IMAGE_T *image, const char *path);
 bool loadPngFile(IMAGE_T* image, FILE *file);
 
+//-------------------------------------------------------------------------
+// Load a PNG as an image of the given direct colour type, converting it a
+// row at a time. LOADPNG_TYPE_AUTO loads images with transparency as
+// RGBA32 and those without as RGB565.
+
+#define LOADPNG_TYPE_AUTO VC_IMAGE_MIN
+
+bool
+loadPngAs(
+    IMAGE_T *image,
+    const char *path,
+    VC_IMAGE_TYPE_T type,
+    bool dither);
+
+bool
+loadPngFileAs(
+    IMAGE_T *image,
+    FILE *file,
+    VC_IMAGE_TYPE_T type,
+    bool dither);
+
+//-------------------------------------------------------------------------
+// Load a palette PNG as an 8BPP image and a 256 entry palette, with any
+// tRNS transparency in the palette alpha. Other PNGs load as they do with
+// loadPng and the palette is left empty (length 0). Either way the palette
+// should be freed with destroyImagePalette32.
+
+bool
+loadPngPalette(
+    IMAGE_T *image,
+    IMAGE_PALETTE32_T *palette,
+    const char *path);
+
+bool
+loadPngFilePalette(
+    IMAGE_T *image,
+    IMAGE_PALETTE32_T *palette,
+    FILE *file);
+
 //-------------------------------------------------------------------------
 
 #endif
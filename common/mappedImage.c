@@ -0,0 +1,290 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "image.h"
+#include "imagePalette.h"
+#include "mappedImage.h"
+
+//-------------------------------------------------------------------------
+
+#define MAPPED_IMAGE_PALETTE_OFFSET 64
+#define MAPPED_IMAGE_DATA_OFFSET 4096
+#define MAPPED_IMAGE_PALETTE_MAX 256
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t type;
+    int32_t width;
+    int32_t height;
+    int32_t pitch;
+    int32_t alignedHeight;
+    uint32_t bitsPerPixel;
+    uint32_t paletteLength;
+    uint32_t paletteOffset;
+    uint32_t dataOffset;
+    uint32_t dataSize;
+    uint32_t reserved[4];
+} MAPPED_IMAGE_HEADER_T;
+
+//-------------------------------------------------------------------------
+
+static bool
+readMappedImageHeader(
+    int fd,
+    MAPPED_IMAGE_HEADER_T *header)
+{
+    ssize_t length = pread(fd, header, sizeof(*header), 0);
+
+    if (length != sizeof(*header))
+    {
+        return false;
+    }
+
+    return (memcmp(header->magic, MAPPED_IMAGE_MAGIC, 4) == 0) &&
+           (header->version == MAPPED_IMAGE_VERSION);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+isMappedImage(
+    const char *path)
+{
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    MAPPED_IMAGE_HEADER_T header;
+    bool result = readMappedImageHeader(fd, &header);
+
+    close(fd);
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+saveMappedImage(
+    const IMAGE_T *image,
+    const IMAGE_PALETTE32_T *palette,
+    const char *path)
+{
+    uint32_t paletteLength = 0;
+
+    if ((palette != NULL) && (palette->palette != NULL))
+    {
+        paletteLength = palette->length;
+    }
+
+    if (paletteLength > MAPPED_IMAGE_PALETTE_MAX)
+    {
+        return false;
+    }
+
+    MAPPED_IMAGE_HEADER_T header;
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, MAPPED_IMAGE_MAGIC, 4);
+    header.version = MAPPED_IMAGE_VERSION;
+    header.type = image->type;
+    header.width = image->width;
+    header.height = image->height;
+    header.pitch = image->pitch;
+    header.alignedHeight = image->alignedHeight;
+    header.bitsPerPixel = image->bitsPerPixel;
+    header.paletteLength = paletteLength;
+    header.paletteOffset = MAPPED_IMAGE_PALETTE_OFFSET;
+    header.dataOffset = MAPPED_IMAGE_DATA_OFFSET;
+    header.dataSize = image->size;
+
+    //---------------------------------------------------------------------
+
+    uint8_t *start = calloc(1, MAPPED_IMAGE_DATA_OFFSET);
+
+    if (start == NULL)
+    {
+        fprintf(stderr, "mappedImage: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memcpy(start, &header, sizeof(header));
+
+    if (paletteLength > 0)
+    {
+        memcpy(start + MAPPED_IMAGE_PALETTE_OFFSET,
+               palette->palette,
+               paletteLength * sizeof(uint32_t));
+    }
+
+    //---------------------------------------------------------------------
+
+    FILE *file = fopen(path, "wb");
+    bool result = false;
+
+    if (file != NULL)
+    {
+        result =
+            (fwrite(start, MAPPED_IMAGE_DATA_OFFSET, 1, file) == 1) &&
+            (fwrite(image->buffer, image->size, 1, file) == 1);
+
+        if (fclose(file) != 0)
+        {
+            result = false;
+        }
+    }
+
+    free(start);
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+static void
+unmapImageBuffer(
+    IMAGE_T *image)
+{
+    munmap((uint8_t *)(image->buffer) - MAPPED_IMAGE_DATA_OFFSET,
+           MAPPED_IMAGE_DATA_OFFSET + image->size);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadMappedImage(
+    IMAGE_T *image,
+    IMAGE_PALETTE32_T *palette,
+    const char *path)
+{
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    MAPPED_IMAGE_HEADER_T header;
+    struct stat st;
+
+    if ((readMappedImageHeader(fd, &header) == false) ||
+        (fstat(fd, &st) == -1) ||
+        (header.dataOffset != MAPPED_IMAGE_DATA_OFFSET) ||
+        (header.paletteLength > MAPPED_IMAGE_PALETTE_MAX) ||
+        (header.paletteOffset < sizeof(header)) ||
+        (header.paletteOffset + header.paletteLength * sizeof(uint32_t) >
+         header.dataOffset) ||
+        ((uint64_t)(header.dataOffset) + header.dataSize > st.st_size))
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t length = header.dataOffset + header.dataSize;
+
+    uint8_t *start = mmap(NULL,
+                          length,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE,
+                          fd,
+                          0);
+    close(fd);
+
+    if (start == MAP_FAILED)
+    {
+        return false;
+    }
+
+    //---------------------------------------------------------------------
+
+    // The layout must be the one initImage would give this image, so that
+    // everything that walks the buffer agrees with the file.
+
+    if ((header.width <= 0) ||
+        (header.width > INT16_MAX) ||
+        (header.height <= 0) ||
+        (header.height > INT16_MAX) ||
+        (initImageWithBuffer(image,
+                             header.type,
+                             header.width,
+                             header.height,
+                             false,
+                             start + header.dataOffset,
+                             unmapImageBuffer) == false))
+    {
+        munmap(start, length);
+        return false;
+    }
+
+    if ((image->pitch != header.pitch) ||
+        (image->alignedHeight != header.alignedHeight) ||
+        (image->bitsPerPixel != header.bitsPerPixel) ||
+        (image->size != header.dataSize))
+    {
+        image->destroyBuffer = NULL;
+        destroyImage(image);
+        munmap(start, length);
+        return false;
+    }
+
+    //---------------------------------------------------------------------
+
+    if (palette != NULL)
+    {
+        palette->palette = NULL;
+        palette->length = 0;
+
+        if (header.paletteLength > 0)
+        {
+            initImagePalette32(palette, header.paletteLength);
+            memcpy(palette->palette,
+                   start + header.paletteOffset,
+                   header.paletteLength * sizeof(uint32_t));
+        }
+    }
+
+    return true;
+}
+
@@ -0,0 +1,78 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef MAPPED_IMAGE_H
+#define MAPPED_IMAGE_H
+
+#include <stdbool.h>
+
+#include "image.h"
+#include "imagePalette.h"
+
+//-------------------------------------------------------------------------
+// A mapped image file holds an IMAGE_T exactly as it is in memory: a small
+// header, an optional 32 bit palette and then the pixels, pitch aligned, at
+// a page aligned offset. Loading it maps the file and the image buffer
+// points straight at the mapped pages, so there is no decode and no copy
+// before the pixels are written to a resource. The file is in the byte
+// order of the machine that wrote it.
+
+#define MAPPED_IMAGE_MAGIC "RDMX"
+#define MAPPED_IMAGE_VERSION 1
+
+//-------------------------------------------------------------------------
+
+bool
+isMappedImage(
+    const char *path);
+
+// The palette may be NULL if there isn't one. Indexed images are saved with
+// their palette so that they can be shown without the original PNG.
+
+bool
+saveMappedImage(
+    const IMAGE_T *image,
+    const IMAGE_PALETTE32_T *palette,
+    const char *path);
+
+// The mapping is private, so drawing on the image works as it would on any
+// other image (without dithering) and doesn't change the file.
+// destroyImage unmaps it. If the
+// palette is not NULL it is filled from the file (length 0 if the file has
+// no palette) and should be freed with destroyImagePalette32.
+
+bool
+loadMappedImage(
+    IMAGE_T *image,
+    IMAGE_PALETTE32_T *palette,
+    const char *path);
+
+//-------------------------------------------------------------------------
+
+#endif
+
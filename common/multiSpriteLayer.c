@@ -0,0 +1,405 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "element_change.h"
+#include "multiSpriteLayer.h"
+#include "spriteAtlas.h"
+
+//-------------------------------------------------------------------------
+
+// Alongside the ELEMENT_CHANGE_ flags, a sprite whose frame has moved to
+// another page needs its source resource changed.
+
+#define MULTI_SPRITE_CHANGE_SOURCE (1 << 16)
+
+//-------------------------------------------------------------------------
+
+static void
+frameRects(
+    const SPRITE_ATLAS_FRAME_T *frame,
+    int32_t x,
+    int32_t y,
+    VC_RECT_T *srcRect,
+    VC_RECT_T *dstRect)
+{
+    vc_dispmanx_rect_set(srcRect,
+                         frame->x << 16,
+                         frame->y << 16,
+                         frame->width << 16,
+                         frame->height << 16);
+
+    vc_dispmanx_rect_set(dstRect, x, y, frame->width, frame->height);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+markChanged(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    uint32_t changes)
+{
+    SPRITE_INSTANCE_T *s = &(ms->instances[instance]);
+
+    if ((s->changes == 0) && (changes != 0))
+    {
+        ms->changed[ms->changedCount++] = instance;
+    }
+
+    s->changes |= changes;
+}
+
+//-------------------------------------------------------------------------
+
+static SPRITE_INSTANCE_T *
+usedInstance(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance)
+{
+    assert((instance >= 0) && (instance < ms->count));
+    assert(ms->instances[instance].used);
+
+    return &(ms->instances[instance]);
+}
+
+//-------------------------------------------------------------------------
+
+void
+initMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    const SPRITE_ATLAS_T *atlas,
+    int32_t maxInstances,
+    int32_t layer)
+{
+    ms->atlas = atlas;
+    ms->layer = layer;
+    ms->count = 0;
+    ms->maxInstances = maxInstances;
+    ms->instances = calloc(maxInstances, sizeof(SPRITE_INSTANCE_T));
+    ms->changedCount = 0;
+    ms->changed = calloc(maxInstances, sizeof(int32_t));
+    ms->unusedCount = 0;
+    ms->unused = calloc(maxInstances, sizeof(int32_t));
+
+    if ((ms->instances == NULL) ||
+        (ms->changed == NULL) ||
+        (ms->unused == NULL))
+    {
+        fprintf(stderr, "multiSprite: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+int32_t
+addInstanceMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t frame,
+    int32_t x,
+    int32_t y,
+    DISPMANX_DISPLAY_HANDLE_T display,
+    DISPMANX_UPDATE_HANDLE_T update)
+{
+    assert((frame >= 0) && (frame < ms->atlas->frameCount));
+
+    if (ms->unusedCount > 0)
+    {
+        int32_t instance = ms->unused[--(ms->unusedCount)];
+        ms->instances[instance].used = true;
+
+        setInstanceMultiSpriteLayer(ms, instance, frame, x, y);
+        setOpacityMultiSpriteLayer(ms, instance, 255);
+        setLayerMultiSpriteLayer(ms, instance, ms->layer);
+
+        return instance;
+    }
+
+    if (ms->count >= ms->maxInstances)
+    {
+        return -1;
+    }
+
+    const SPRITE_ATLAS_FRAME_T *f = &(ms->atlas->frames[frame]);
+    SPRITE_INSTANCE_T *instance = &(ms->instances[ms->count]);
+
+    instance->frame = frame;
+    instance->x = x;
+    instance->y = y;
+    instance->layer = ms->layer;
+    instance->opacity = 255;
+    instance->used = true;
+    instance->changes = 0;
+
+    VC_RECT_T srcRect;
+    VC_RECT_T dstRect;
+    frameRects(f, x, y, &srcRect, &dstRect);
+
+    // Mix in the element opacity, so that sprites can be faded and hidden.
+
+    VC_DISPMANX_ALPHA_T alpha =
+    {
+        DISPMANX_FLAGS_ALPHA_FROM_SOURCE | DISPMANX_FLAGS_ALPHA_MIX,
+        255, /*alpha 0->255*/
+        0
+    };
+
+    instance->element =
+        vc_dispmanx_element_add(update,
+                                display,
+                                ms->layer,
+                                &dstRect,
+                                ms->atlas->pages[f->page].resource,
+                                &srcRect,
+                                DISPMANX_PROTECTION_NONE,
+                                &alpha,
+                                NULL, // clamp
+                                DISPMANX_NO_ROTATE);
+    assert(instance->element != 0);
+
+    return ms->count++;
+}
+
+//-------------------------------------------------------------------------
+
+void
+removeInstanceMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance)
+{
+    setOpacityMultiSpriteLayer(ms, instance, 0);
+
+    ms->instances[instance].used = false;
+    ms->unused[ms->unusedCount++] = instance;
+}
+
+//-------------------------------------------------------------------------
+
+void
+setFrameMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    int32_t frame)
+{
+    assert((frame >= 0) && (frame < ms->atlas->frameCount));
+
+    SPRITE_INSTANCE_T *s = usedInstance(ms, instance);
+
+    if (frame == s->frame)
+    {
+        return;
+    }
+
+    const SPRITE_ATLAS_FRAME_T *f = &(ms->atlas->frames[frame]);
+    const SPRITE_ATLAS_FRAME_T *old = &(ms->atlas->frames[s->frame]);
+    uint32_t changes = 0;
+
+    if (f->page != old->page)
+    {
+        changes |= MULTI_SPRITE_CHANGE_SOURCE;
+    }
+
+    if ((f->x != old->x) ||
+        (f->y != old->y) ||
+        (f->width != old->width) ||
+        (f->height != old->height))
+    {
+        changes |= ELEMENT_CHANGE_SRC_RECT;
+    }
+
+    if ((f->width != old->width) || (f->height != old->height))
+    {
+        changes |= ELEMENT_CHANGE_DEST_RECT;
+    }
+
+    s->frame = frame;
+    markChanged(ms, instance, changes);
+}
+
+//-------------------------------------------------------------------------
+
+void
+setPositionMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    int32_t x,
+    int32_t y)
+{
+    SPRITE_INSTANCE_T *s = usedInstance(ms, instance);
+
+    if ((x != s->x) || (y != s->y))
+    {
+        s->x = x;
+        s->y = y;
+        markChanged(ms, instance, ELEMENT_CHANGE_DEST_RECT);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+setOpacityMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    uint8_t opacity)
+{
+    SPRITE_INSTANCE_T *s = usedInstance(ms, instance);
+
+    if (opacity != s->opacity)
+    {
+        s->opacity = opacity;
+        markChanged(ms, instance, ELEMENT_CHANGE_OPACITY);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+setLayerMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    int32_t layer)
+{
+    SPRITE_INSTANCE_T *s = usedInstance(ms, instance);
+
+    if (layer != s->layer)
+    {
+        s->layer = layer;
+        markChanged(ms, instance, ELEMENT_CHANGE_LAYER);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+setInstanceMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    int32_t frame,
+    int32_t x,
+    int32_t y)
+{
+    setFrameMultiSpriteLayer(ms, instance, frame);
+    setPositionMultiSpriteLayer(ms, instance, x, y);
+}
+
+//-------------------------------------------------------------------------
+
+int32_t
+updateMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    DISPMANX_UPDATE_HANDLE_T update)
+{
+    int result = 0;
+
+    int32_t i;
+    for (i = 0 ; i < ms->changedCount ; i++)
+    {
+        SPRITE_INSTANCE_T *s = &(ms->instances[ms->changed[i]]);
+        const SPRITE_ATLAS_FRAME_T *f = &(ms->atlas->frames[s->frame]);
+
+        if (s->changes & MULTI_SPRITE_CHANGE_SOURCE)
+        {
+            result =
+                vc_dispmanx_element_change_source(
+                    update,
+                    s->element,
+                    ms->atlas->pages[f->page].resource);
+            assert(result == 0);
+        }
+
+        uint32_t changes = s->changes & ~MULTI_SPRITE_CHANGE_SOURCE;
+
+        if (changes != 0)
+        {
+            VC_RECT_T srcRect;
+            VC_RECT_T dstRect;
+            frameRects(f, s->x, s->y, &srcRect, &dstRect);
+
+            result =
+            vc_dispmanx_element_change_attributes(update,
+                                                  s->element,
+                                                  changes,
+                                                  s->layer,
+                                                  s->opacity,
+                                                  &dstRect,
+                                                  &srcRect,
+                                                  0,
+                                                  DISPMANX_NO_ROTATE);
+            assert(result == 0);
+        }
+
+        s->changes = 0;
+    }
+
+    int32_t changed = ms->changedCount;
+    ms->changedCount = 0;
+
+    return changed;
+}
+
+//-------------------------------------------------------------------------
+
+void
+destroyMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms)
+{
+    int result = 0;
+
+    DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
+    assert(update != 0);
+
+    int32_t i;
+    for (i = 0 ; i < ms->count ; i++)
+    {
+        result = vc_dispmanx_element_remove(update, ms->instances[i].element);
+        assert(result == 0);
+    }
+
+    result = vc_dispmanx_update_submit_sync(update);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    free(ms->instances);
+    ms->instances = NULL;
+    free(ms->changed);
+    ms->changed = NULL;
+    free(ms->unused);
+    ms->unused = NULL;
+    ms->count = 0;
+    ms->maxInstances = 0;
+    ms->changedCount = 0;
+    ms->unusedCount = 0;
+}
+
@@ -0,0 +1,156 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef MULTI_SPRITE_LAYER_H
+#define MULTI_SPRITE_LAYER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "spriteAtlas.h"
+
+#include "bcm_host.h"
+
+//-------------------------------------------------------------------------
+// Many independent sprites shown from the resources of a sprite atlas.
+// Each sprite instance is a DispmanX element whose source rectangle is
+// one frame of the atlas, so changing a sprite's frame or position is an
+// attribute change and no pixels are written. The atlas is shared, and
+// must outlive the layer.
+//
+// The set functions only record what is different about a sprite.
+// updateMultiSpriteLayer() then makes one attribute change for each
+// sprite that changed, with just the attributes that changed, so a frame
+// in which few sprites move costs few calls. Removed sprites are hidden
+// and their elements are kept for the next sprite added.
+
+typedef struct
+{
+    int32_t frame;
+    int32_t x;
+    int32_t y;
+    int32_t layer;
+    uint8_t opacity;
+    bool used;
+    uint32_t changes;
+    DISPMANX_ELEMENT_HANDLE_T element;
+} SPRITE_INSTANCE_T;
+
+typedef struct
+{
+    const SPRITE_ATLAS_T *atlas;
+    int32_t layer;
+    int32_t count;
+    int32_t maxInstances;
+    SPRITE_INSTANCE_T *instances;
+    int32_t changedCount;
+    int32_t *changed;
+    int32_t unusedCount;
+    int32_t *unused;
+} MULTI_SPRITE_LAYER_T;
+
+//-------------------------------------------------------------------------
+
+void
+initMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    const SPRITE_ATLAS_T *atlas,
+    int32_t maxInstances,
+    int32_t layer);
+
+// Add a sprite showing 'frame' with its top left corner at (x, y).
+// Returns the instance number, or -1 if the layer is full. A new element
+// is added in 'update', a sprite that reuses the element of a removed one
+// is shown by the next updateMultiSpriteLayer().
+
+int32_t
+addInstanceMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t frame,
+    int32_t x,
+    int32_t y,
+    DISPMANX_DISPLAY_HANDLE_T display,
+    DISPMANX_UPDATE_HANDLE_T update);
+
+void
+removeInstanceMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance);
+
+// If the new frame is on another page of the atlas, the element's source
+// resource is changed too.
+
+void
+setFrameMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    int32_t frame);
+
+void
+setPositionMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    int32_t x,
+    int32_t y);
+
+void
+setOpacityMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    uint8_t opacity);
+
+void
+setLayerMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    int32_t layer);
+
+// Change both the frame and the position of a sprite.
+
+void
+setInstanceMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    int32_t instance,
+    int32_t frame,
+    int32_t x,
+    int32_t y);
+
+// Make the changes recorded since the last call in 'update'. Returns the
+// number of sprites changed.
+
+int32_t
+updateMultiSpriteLayer(
+    MULTI_SPRITE_LAYER_T *ms,
+    DISPMANX_UPDATE_HANDLE_T update);
+
+void destroyMultiSpriteLayer(MULTI_SPRITE_LAYER_T *ms);
+
+//-------------------------------------------------------------------------
+
+#endif
+
@@ -0,0 +1,842 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image.h"
+#include "imageConvert.h"
+#include "qoi.h"
+
+//-------------------------------------------------------------------------
+
+#define QOI_HEADER_SIZE 14
+#define QOI_END_SIZE 8
+#define QOI_INDEX_SIZE 64
+#define QOI_MAX_PIXELS 400000000
+#define QOI_MAX_RUN 62
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+#define QOI_OP_MASK 0xC0
+
+// Bytes buffered before writing, on top of room for one coded row.
+
+#define QOI_WRITE_BUFFER 65536
+
+// Files are read in blocks that double in size, so that a stream like
+// stdin can be read without knowing its length.
+
+#define QOI_READ_BLOCK 65536
+
+//-------------------------------------------------------------------------
+
+static const uint8_t qoiEnd[QOI_END_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    const uint8_t *data;
+    size_t position;
+    size_t end;
+    RGBA8_T pixel;
+    RGBA8_T index[QOI_INDEX_SIZE];
+    int32_t run;
+    bool overrun;
+} QOI_DECODER_T;
+
+typedef struct
+{
+    FILE *file;
+    uint8_t *buffer;
+    size_t used;
+    bool failed;
+    RGBA8_T pixel;
+    RGBA8_T index[QOI_INDEX_SIZE];
+    int32_t run;
+} QOI_ENCODER_T;
+
+//-------------------------------------------------------------------------
+
+static inline int32_t
+qoiHash(
+    RGBA8_T pixel)
+{
+    return (pixel.red * 3 +
+            pixel.green * 5 +
+            pixel.blue * 7 +
+            pixel.alpha * 11) % QOI_INDEX_SIZE;
+}
+
+//-------------------------------------------------------------------------
+
+static inline bool
+samePixel(
+    RGBA8_T a,
+    RGBA8_T b)
+{
+    return (a.red == b.red) &&
+           (a.green == b.green) &&
+           (a.blue == b.blue) &&
+           (a.alpha == b.alpha);
+}
+
+//-------------------------------------------------------------------------
+
+static uint32_t
+getUint32(
+    const uint8_t *bytes)
+{
+    return ((uint32_t)(bytes[0]) << 24) |
+           ((uint32_t)(bytes[1]) << 16) |
+           ((uint32_t)(bytes[2]) << 8) |
+           bytes[3];
+}
+
+//-------------------------------------------------------------------------
+
+static void
+putUint32(
+    uint8_t *bytes,
+    uint32_t value)
+{
+    bytes[0] = value >> 24;
+    bytes[1] = value >> 16;
+    bytes[2] = value >> 8;
+    bytes[3] = value;
+}
+
+//-------------------------------------------------------------------------
+
+// Decode 'length' pixels into 'out', which has 3 (RGB) or 4 (RGBA) bytes
+// per pixel. This is inlined with a constant 'channels' so that each
+// output format gets its own loop. A stream that ends early sets
+// 'overrun'.
+
+static inline __attribute__((always_inline)) void
+decodePixels(
+    QOI_DECODER_T *decoder,
+    uint8_t *out,
+    int32_t length,
+    const int channels)
+{
+    const uint8_t *data = decoder->data;
+    size_t position = decoder->position;
+    size_t end = decoder->end;
+    RGBA8_T pixel = decoder->pixel;
+    int32_t run = decoder->run;
+
+    int32_t i;
+    for (i = 0 ; i < length ; i++)
+    {
+        if (run > 0)
+        {
+            run--;
+        }
+        else if (position < end)
+        {
+            uint8_t op = data[position++];
+
+            if (op == QOI_OP_RGB)
+            {
+                if (position + 3 > end)
+                {
+                    decoder->overrun = true;
+                    break;
+                }
+
+                pixel.red = data[position];
+                pixel.green = data[position + 1];
+                pixel.blue = data[position + 2];
+                position += 3;
+            }
+            else if (op == QOI_OP_RGBA)
+            {
+                if (position + 4 > end)
+                {
+                    decoder->overrun = true;
+                    break;
+                }
+
+                pixel.red = data[position];
+                pixel.green = data[position + 1];
+                pixel.blue = data[position + 2];
+                pixel.alpha = data[position + 3];
+                position += 4;
+            }
+            else
+            {
+                switch (op & QOI_OP_MASK)
+                {
+                case QOI_OP_INDEX:
+
+                    pixel = decoder->index[op];
+                    break;
+
+                case QOI_OP_DIFF:
+
+                    pixel.red += ((op >> 4) & 0x03) - 2;
+                    pixel.green += ((op >> 2) & 0x03) - 2;
+                    pixel.blue += (op & 0x03) - 2;
+                    break;
+
+                case QOI_OP_LUMA:
+                {
+                    if (position + 1 > end)
+                    {
+                        decoder->overrun = true;
+                        break;
+                    }
+
+                    uint8_t next = data[position++];
+                    int dg = (op & 0x3F) - 32;
+
+                    pixel.red += dg - 8 + ((next >> 4) & 0x0F);
+                    pixel.green += dg;
+                    pixel.blue += dg - 8 + (next & 0x0F);
+                    break;
+                }
+                case QOI_OP_RUN:
+
+                    run = op & 0x3F;
+                    break;
+                }
+
+                if (decoder->overrun)
+                {
+                    break;
+                }
+            }
+
+            decoder->index[qoiHash(pixel)] = pixel;
+        }
+        else
+        {
+            decoder->overrun = true;
+            break;
+        }
+
+        out[0] = pixel.red;
+        out[1] = pixel.green;
+        out[2] = pixel.blue;
+
+        if (channels == 4)
+        {
+            out[3] = pixel.alpha;
+        }
+
+        out += channels;
+    }
+
+    decoder->position = position;
+    decoder->pixel = pixel;
+    decoder->run = run;
+}
+
+//-------------------------------------------------------------------------
+
+static void
+decodeRgb(
+    QOI_DECODER_T *decoder,
+    uint8_t *out,
+    int32_t length)
+{
+    decodePixels(decoder, out, length, 3);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+decodeRgba(
+    QOI_DECODER_T *decoder,
+    uint8_t *out,
+    int32_t length)
+{
+    decodePixels(decoder, out, length, 4);
+}
+
+//-------------------------------------------------------------------------
+
+// Decode into an image of 'alphaType' if there are four channels and of
+// 'opaqueType' if there are three. RGBA32 and RGB888 rows are decoded in
+// place, other types through one row of RGBA.
+
+static bool
+decodeQoi(
+    IMAGE_T *image,
+    const uint8_t *data,
+    size_t size,
+    VC_IMAGE_TYPE_T alphaType,
+    VC_IMAGE_TYPE_T opaqueType,
+    bool dither)
+{
+    if ((size < QOI_HEADER_SIZE + QOI_END_SIZE) ||
+        (memcmp(data, QOI_MAGIC, 4) != 0))
+    {
+        return false;
+    }
+
+    uint32_t width = getUint32(data + 4);
+    uint32_t height = getUint32(data + 8);
+    uint8_t channels = data[12];
+
+    if ((width == 0) ||
+        (height == 0) ||
+        (width > INT16_MAX) ||
+        (height > INT16_MAX) ||
+        ((uint64_t)(width) * height > QOI_MAX_PIXELS) ||
+        ((channels != 3) && (channels != 4)))
+    {
+        return false;
+    }
+
+    VC_IMAGE_TYPE_T type = (channels == 4) ? alphaType : opaqueType;
+
+    if (initImage(image, type, width, height, dither) == false)
+    {
+        return false;
+    }
+
+    bool convert = (type != VC_IMAGE_RGBA32) && (type != VC_IMAGE_RGB888);
+
+    if (convert && (image->setSpanDirect == NULL))
+    {
+        fprintf(stderr, "qoi: can't load as an indexed image\n");
+        destroyImage(image);
+        return false;
+    }
+
+    RGBA8_T *pixels = NULL;
+
+    if (convert)
+    {
+        pixels = malloc(image->width * sizeof(RGBA8_T));
+
+        if (pixels == NULL)
+        {
+            fprintf(stderr, "qoi: memory exhausted\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    QOI_DECODER_T decoder;
+    memset(&decoder, 0, sizeof(decoder));
+
+    decoder.data = data;
+    decoder.position = QOI_HEADER_SIZE;
+    decoder.end = size - QOI_END_SIZE;
+    decoder.pixel.alpha = 255;
+
+    int32_t j;
+    for (j = 0 ; (j < image->height) && (decoder.overrun == false) ; j++)
+    {
+        uint8_t *row = (uint8_t *)(image->buffer) + (j * image->pitch);
+
+        if (convert)
+        {
+            decodeRgba(&decoder, (uint8_t *)pixels, image->width);
+            image->setSpanDirect(image, 0, j, image->width, pixels);
+        }
+        else if (type == VC_IMAGE_RGBA32)
+        {
+            decodeRgba(&decoder, row, image->width);
+        }
+        else
+        {
+            decodeRgb(&decoder, row, image->width);
+        }
+    }
+
+    free(pixels);
+
+    if (decoder.overrun)
+    {
+        destroyImage(image);
+        return false;
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+static uint8_t *
+readQoiFile(
+    FILE *file,
+    size_t *size)
+{
+    size_t capacity = QOI_READ_BLOCK;
+    size_t used = 0;
+    uint8_t *data = malloc(capacity);
+
+    if (data == NULL)
+    {
+        fprintf(stderr, "qoi: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t length = 0;
+
+    while ((length = fread(data + used, 1, capacity - used, file)) > 0)
+    {
+        used += length;
+
+        if (used == capacity)
+        {
+            capacity *= 2;
+            data = realloc(data, capacity);
+
+            if (data == NULL)
+            {
+                fprintf(stderr, "qoi: memory exhausted\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    if (ferror(file))
+    {
+        free(data);
+        return NULL;
+    }
+
+    *size = used;
+
+    return data;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+loadQoiFileTypes(
+    IMAGE_T *image,
+    FILE *file,
+    VC_IMAGE_TYPE_T alphaType,
+    VC_IMAGE_TYPE_T opaqueType,
+    bool dither)
+{
+    size_t size = 0;
+    uint8_t *data = readQoiFile(file, &size);
+
+    if (data == NULL)
+    {
+        return false;
+    }
+
+    bool result = decodeQoi(image,
+                            data,
+                            size,
+                            alphaType,
+                            opaqueType,
+                            dither);
+
+    free(data);
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadQoi(
+    IMAGE_T *image,
+    const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "qoi: can't open file for reading\n");
+        return false;
+    }
+
+    bool result = loadQoiFile(image, file);
+
+    fclose(file);
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadQoiFile(
+    IMAGE_T *image,
+    FILE *file)
+{
+    return loadQoiFileTypes(image,
+                            file,
+                            VC_IMAGE_RGBA32,
+                            VC_IMAGE_RGB888,
+                            false);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadQoiAs(
+    IMAGE_T *image,
+    const char *path,
+    VC_IMAGE_TYPE_T type,
+    bool dither)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "qoi: can't open file for reading\n");
+        return false;
+    }
+
+    bool result = loadQoiFileAs(image, file, type, dither);
+
+    fclose(file);
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadQoiFileAs(
+    IMAGE_T *image,
+    FILE *file,
+    VC_IMAGE_TYPE_T type,
+    bool dither)
+{
+    if (type == LOADQOI_TYPE_AUTO)
+    {
+        return loadQoiFileTypes(image,
+                                file,
+                                VC_IMAGE_RGBA32,
+                                VC_IMAGE_RGB565,
+                                dither);
+    }
+
+    return loadQoiFileTypes(image, file, type, type, dither);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+flushQoi(
+    QOI_ENCODER_T *encoder)
+{
+    if ((encoder->used > 0) &&
+        (fwrite(encoder->buffer, encoder->used, 1, encoder->file) != 1))
+    {
+        encoder->failed = true;
+    }
+
+    encoder->used = 0;
+}
+
+//-------------------------------------------------------------------------
+
+// Encode 'length' pixels of 3 (RGB) or 4 (RGBA) bytes each. Like
+// decodePixels this is inlined with a constant 'channels'. The buffer is
+// flushed first if a row coded entirely as literals might not fit.
+
+static inline __attribute__((always_inline)) void
+encodePixels(
+    QOI_ENCODER_T *encoder,
+    const uint8_t *in,
+    int32_t length,
+    const int channels)
+{
+    if (encoder->used > QOI_WRITE_BUFFER)
+    {
+        flushQoi(encoder);
+    }
+
+    uint8_t *out = encoder->buffer + encoder->used;
+    RGBA8_T previous = encoder->pixel;
+    int32_t run = encoder->run;
+
+    int32_t i;
+    for (i = 0 ; i < length ; i++)
+    {
+        RGBA8_T pixel;
+        pixel.red = in[0];
+        pixel.green = in[1];
+        pixel.blue = in[2];
+        pixel.alpha = (channels == 4) ? in[3] : previous.alpha;
+        in += channels;
+
+        if (samePixel(pixel, previous))
+        {
+            run++;
+
+            if (run == QOI_MAX_RUN)
+            {
+                *out++ = QOI_OP_RUN | (run - 1);
+                run = 0;
+            }
+
+            continue;
+        }
+
+        if (run > 0)
+        {
+            *out++ = QOI_OP_RUN | (run - 1);
+            run = 0;
+        }
+
+        int32_t hash = qoiHash(pixel);
+
+        if (samePixel(encoder->index[hash], pixel))
+        {
+            *out++ = QOI_OP_INDEX | hash;
+        }
+        else
+        {
+            encoder->index[hash] = pixel;
+
+            if (pixel.alpha == previous.alpha)
+            {
+                int8_t dr = pixel.red - previous.red;
+                int8_t dg = pixel.green - previous.green;
+                int8_t db = pixel.blue - previous.blue;
+                int8_t dgr = dr - dg;
+                int8_t dgb = db - dg;
+
+                if ((dr > -3) && (dr < 2) &&
+                    (dg > -3) && (dg < 2) &&
+                    (db > -3) && (db < 2))
+                {
+                    *out++ = QOI_OP_DIFF |
+                             ((dr + 2) << 4) |
+                             ((dg + 2) << 2) |
+                             (db + 2);
+                }
+                else if ((dgr > -9) && (dgr < 8) &&
+                         (dg > -33) && (dg < 32) &&
+                         (dgb > -9) && (dgb < 8))
+                {
+                    *out++ = QOI_OP_LUMA | (dg + 32);
+                    *out++ = ((dgr + 8) << 4) | (dgb + 8);
+                }
+                else
+                {
+                    *out++ = QOI_OP_RGB;
+                    *out++ = pixel.red;
+                    *out++ = pixel.green;
+                    *out++ = pixel.blue;
+                }
+            }
+            else
+            {
+                *out++ = QOI_OP_RGBA;
+                *out++ = pixel.red;
+                *out++ = pixel.green;
+                *out++ = pixel.blue;
+                *out++ = pixel.alpha;
+            }
+        }
+
+        previous = pixel;
+    }
+
+    encoder->used = out - encoder->buffer;
+    encoder->pixel = previous;
+    encoder->run = run;
+}
+
+//-------------------------------------------------------------------------
+
+static void
+encodeRgb(
+    QOI_ENCODER_T *encoder,
+    const uint8_t *in,
+    int32_t length)
+{
+    encodePixels(encoder, in, length, 3);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+encodeRgba(
+    QOI_ENCODER_T *encoder,
+    const uint8_t *in,
+    int32_t length)
+{
+    encodePixels(encoder, in, length, 4);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+saveQoi(
+    const IMAGE_T *image,
+    const char *path)
+{
+    int channels = 0;
+
+    switch (image->type)
+    {
+    case VC_IMAGE_RGB565:
+    case VC_IMAGE_RGB888:
+
+        channels = 3;
+        break;
+
+    case VC_IMAGE_RGBA16:
+    case VC_IMAGE_RGBA32:
+
+        channels = 4;
+        break;
+
+    default:
+
+        fprintf(stderr, "qoi: unsupported image type\n");
+        return false;
+    }
+
+    if ((image->width <= 0) || (image->height <= 0))
+    {
+        return false;
+    }
+
+    //---------------------------------------------------------------------
+
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    // A pixel codes to at most 5 bytes, and a run held over from the
+    // previous row adds one more. The last row is followed by a run and
+    // the end marker.
+
+    size_t rowSpace = (image->width * 5) + 1;
+
+    QOI_ENCODER_T encoder;
+    memset(&encoder, 0, sizeof(encoder));
+
+    encoder.file = file;
+    encoder.buffer = malloc(QOI_WRITE_BUFFER + rowSpace + 1 + QOI_END_SIZE);
+    encoder.pixel.alpha = 255;
+
+    uint8_t *scratch = NULL;
+
+    if ((image->type == VC_IMAGE_RGB565) || (image->type == VC_IMAGE_RGBA16))
+    {
+        scratch = malloc(image->width * sizeof(RGBA8_T));
+    }
+
+    if ((encoder.buffer == NULL) ||
+        ((scratch == NULL) &&
+         ((image->type == VC_IMAGE_RGB565) ||
+          (image->type == VC_IMAGE_RGBA16))))
+    {
+        fprintf(stderr, "qoi: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    //---------------------------------------------------------------------
+
+    uint8_t *header = encoder.buffer;
+
+    memcpy(header, QOI_MAGIC, 4);
+    putUint32(header + 4, image->width);
+    putUint32(header + 8, image->height);
+    header[12] = channels;
+    header[13] = 0;
+    encoder.used = QOI_HEADER_SIZE;
+
+    int32_t j;
+    for (j = 0 ; j < image->height ; j++)
+    {
+        const uint8_t *row = (uint8_t *)(image->buffer) + (j * image->pitch);
+
+        switch (image->type)
+        {
+        case VC_IMAGE_RGB565:
+
+            rgb565RowToRgb888((const uint16_t *)row, scratch, image->width);
+            encodeRgb(&encoder, scratch, image->width);
+            break;
+
+        case VC_IMAGE_RGBA16:
+
+            rgba16RowToRgba8((const uint16_t *)row,
+                             (RGBA8_T *)scratch,
+                             image->width);
+            encodeRgba(&encoder, scratch, image->width);
+            break;
+
+        case VC_IMAGE_RGBA32:
+
+            encodeRgba(&encoder, row, image->width);
+            break;
+
+        default:
+
+            encodeRgb(&encoder, row, image->width);
+            break;
+        }
+    }
+
+    if (encoder.run > 0)
+    {
+        encoder.buffer[encoder.used++] = QOI_OP_RUN | (encoder.run - 1);
+    }
+
+    memcpy(encoder.buffer + encoder.used, qoiEnd, QOI_END_SIZE);
+    encoder.used += QOI_END_SIZE;
+
+    flushQoi(&encoder);
+
+    //---------------------------------------------------------------------
+
+    bool result = (encoder.failed == false);
+
+    if (fclose(file) != 0)
+    {
+        result = false;
+    }
+
+    free(scratch);
+    free(encoder.buffer);
+
+    return result;
+}
+
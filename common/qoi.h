@@ -0,0 +1,82 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef QOI_H
+#define QOI_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "image.h"
+
+//-------------------------------------------------------------------------
+// A codec for the QOI ("Quite OK Image") format. Each pixel is coded as a
+// run, a reference into a table of recently seen colours, a small
+// difference from the previous pixel or a literal, so encoding and
+// decoding are a single pass with no entropy coder. It is lossless and
+// typically several times faster than PNG, for somewhat larger files.
+
+#define QOI_MAGIC "qoif"
+
+//-------------------------------------------------------------------------
+// Load a QOI image as RGBA32 if it has four channels and RGB888 if it has
+// three. These two are decoded straight into the image.
+
+bool loadQoi(IMAGE_T *image, const char *path);
+bool loadQoiFile(IMAGE_T *image, FILE *file);
+
+// Load a QOI image as the given direct colour type, converting a row at a
+// time. LOADQOI_TYPE_AUTO loads four channel images as RGBA32 and three
+// channel images as RGB565.
+
+#define LOADQOI_TYPE_AUTO VC_IMAGE_MIN
+
+bool
+loadQoiAs(
+    IMAGE_T *image,
+    const char *path,
+    VC_IMAGE_TYPE_T type,
+    bool dither);
+
+bool
+loadQoiFileAs(
+    IMAGE_T *image,
+    FILE *file,
+    VC_IMAGE_TYPE_T type,
+    bool dither);
+
+//-------------------------------------------------------------------------
+// RGB565 and RGB888 images are saved with three channels, RGBA16 and
+// RGBA32 with four.
+
+bool saveQoi(const IMAGE_T *image, const char *path);
+
+//-------------------------------------------------------------------------
+
+#endif
+
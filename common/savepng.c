@@ -25,243 +25,791 @@
 //
 //-------------------------------------------------------------------------
 
+
 #define _GNU_SOURCE
 
-#include <png.h>
+#include <errno.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <zlib.h>
 
 #include "image.h"
+#include "imageConvert.h"
+#include "savepng.h"
 
 //-----------------------------------------------------------------------
 
-bool
-pngWriteImageRGB565(
-    const IMAGE_T *image,
-    png_structp pngPtr,
-    png_infop infoPtr)
+// The filtered image is cut into strips of about this many bytes. The
+// strips are deflated independently, each one primed with the 32K of data
+// before it, and joined with full flushes into one zlib stream. The strip
+// size doesn't depend on the number of threads, so neither does the file.
+
+#define SAVEPNG_STRIP_BYTES (256 * 1024)
+#define SAVEPNG_WINDOW_BYTES (32 * 1024)
+#define SAVEPNG_MAX_THREADS 16
+
+//-----------------------------------------------------------------------
+
+typedef struct
+{
+    size_t offset;
+    size_t length;
+    uLong adler;
+    uint8_t *data;
+    size_t dataLength;
+} SAVEPNG_STRIP_T;
+
+typedef struct
 {
-    int32_t rowLength = 3 * image->width;
-    uint8_t *imageRow = malloc(rowLength);
+    const IMAGE_T *image;
+    const SAVEPNG_OPTIONS_T *options;
+    int32_t channels;
+    size_t pixelBytes;
+    size_t rowBytes;
+    uint8_t *filtered;
+    int32_t stripRows;
+    int32_t strips;
+    SAVEPNG_STRIP_T *strip;
+    int32_t next;
+    bool ok;
+    pthread_mutex_t mutex;
+} SAVEPNG_ENCODER_T;
+
+typedef void (*SAVEPNG_JOB_T)(SAVEPNG_ENCODER_T *encoder, int32_t strip);
+
+typedef struct
+{
+    SAVEPNG_ENCODER_T *encoder;
+    SAVEPNG_JOB_T job;
+} SAVEPNG_WORKER_T;
 
-    if (imageRow == NULL)
+//-----------------------------------------------------------------------
+
+void
+setSavePngPreset(
+    SAVEPNG_OPTIONS_T *options,
+    SAVEPNG_PRESET_T preset)
+{
+    options->threads = 0;
+
+    switch (preset)
     {
-        fprintf(stderr, "savepng: unable to allocated row buffer\n");
-        return false;
+    case SAVEPNG_PRESET_UNCOMPRESSED:
+
+        options->filter = SAVEPNG_FILTER_NONE;
+        options->level = Z_NO_COMPRESSION;
+        options->strategy = Z_DEFAULT_STRATEGY;
+        break;
+
+    case SAVEPNG_PRESET_FAST:
+
+        options->filter = SAVEPNG_FILTER_SUB;
+        options->level = Z_BEST_SPEED;
+        options->strategy = Z_RLE;
+        break;
+
+    case SAVEPNG_PRESET_SMALL:
+
+        options->filter = SAVEPNG_FILTER_ADAPTIVE;
+        options->level = Z_BEST_COMPRESSION;
+        options->strategy = Z_FILTERED;
+        break;
+
+    case SAVEPNG_PRESET_DEFAULT:
+    default:
+
+        options->filter = SAVEPNG_FILTER_ADAPTIVE;
+        options->level = Z_DEFAULT_COMPRESSION;
+        options->strategy = Z_FILTERED;
+        break;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static uint8_t
+paethPredictor(
+    uint8_t a,
+    uint8_t b,
+    uint8_t c)
+{
+    int16_t p = a + b - c;
+    int16_t pa = abs(p - a);
+    int16_t pb = abs(p - b);
+    int16_t pc = abs(p - c);
+
+    if ((pa <= pb) && (pa <= pc))
+    {
+        return a;
+    }
+    else if (pb <= pc)
+    {
+        return b;
+    }
+
+    return c;
+}
+
+//-----------------------------------------------------------------------
+
+// Filter one row of 'length' bytes into 'out', which starts with the
+// filter type byte. The row above the first row is 'prior', all zeros.
+
+static void
+filterRow(
+    SAVEPNG_FILTER_T filter,
+    const uint8_t *row,
+    const uint8_t *prior,
+    size_t length,
+    size_t bpp,
+    uint8_t *out)
+{
+    *(out++) = filter;
+
+    size_t i;
+
+    switch (filter)
+    {
+    case SAVEPNG_FILTER_SUB:
+
+        memcpy(out, row, bpp);
+
+        for (i = bpp ; i < length ; i++)
+        {
+            out[i] = row[i] - row[i - bpp];
+        }
+
+        break;
+
+    case SAVEPNG_FILTER_UP:
+
+        for (i = 0 ; i < length ; i++)
+        {
+            out[i] = row[i] - prior[i];
+        }
+
+        break;
+
+    case SAVEPNG_FILTER_AVERAGE:
+
+        for (i = 0 ; i < bpp ; i++)
+        {
+            out[i] = row[i] - (prior[i] >> 1);
+        }
+
+        for (i = bpp ; i < length ; i++)
+        {
+            out[i] = row[i] - ((row[i - bpp] + prior[i]) >> 1);
+        }
+
+        break;
+
+    case SAVEPNG_FILTER_PAETH:
+
+        for (i = 0 ; i < bpp ; i++)
+        {
+            out[i] = row[i] - prior[i];
+        }
+
+        for (i = bpp ; i < length ; i++)
+        {
+            out[i] = row[i] - paethPredictor(row[i - bpp],
+                                             prior[i],
+                                             prior[i - bpp]);
+        }
+
+        break;
+
+    case SAVEPNG_FILTER_NONE:
+    default:
+
+        memcpy(out, row, length);
+        break;
     }
+}
+
+//-----------------------------------------------------------------------
+
+// The usual heuristic: use the filter whose output, taken as signed
+// bytes, has the smallest sum of magnitudes. 'scratch' holds one filtered
+// row.
+
+static void
+filterRowAdaptive(
+    const uint8_t *row,
+    const uint8_t *prior,
+    size_t length,
+    size_t bpp,
+    uint8_t *out,
+    uint8_t *scratch)
+{
+    uint32_t bestSum = UINT32_MAX;
 
-    int32_t y = 0;
-    for (y = 0; y < image->height; y++)
+    SAVEPNG_FILTER_T filter;
+    for (filter = SAVEPNG_FILTER_NONE ;
+         filter <= SAVEPNG_FILTER_PAETH ;
+         filter++)
     {
-        int32_t x = 0;
-        for (x = 0; x < image->width; x++)
+        filterRow(filter, row, prior, length, bpp, scratch);
+
+        uint32_t sum = 0;
+
+        size_t i;
+        for (i = 1 ; (i <= length) && (sum < bestSum) ; i++)
         {
-            uint16_t pixels = *(uint16_t*)(image->buffer +
-                                          (y * image->pitch) +
-                                          ((x * image->bitsPerPixel) / 8));
-            int32_t index = x * 3;
-
-            uint8_t r5 = (pixels >> 11) & 0x1F;
-            uint8_t g6 = (pixels >> 5) & 0x3F;
-            uint8_t b5 = (pixels) & 0x1F;
-
-            imageRow[index] =  (r5 << 3) | (r5 >> 2);
-            imageRow[index + 1] =  (g6 << 2) | (g6 >> 4);
-            imageRow[index + 2] =  (b5 << 3) | (b5 >> 2);
+            sum += abs((int8_t)scratch[i]);
         }
-        png_write_row(pngPtr, imageRow);
 
+        if (sum < bestSum)
+        {
+            bestSum = sum;
+            memcpy(out, scratch, length + 1);
+        }
     }
+}
 
-    free(imageRow);
+//-----------------------------------------------------------------------
+
+// Return row 'y' as 8 bit RGB or RGBA, converting it into 'scratch' if
+// the image isn't already in that format.
+
+static const uint8_t *
+pngRow(
+    const SAVEPNG_ENCODER_T *encoder,
+    int32_t y,
+    uint8_t *scratch)
+{
+    const IMAGE_T *image = encoder->image;
+    const uint8_t *row = (uint8_t *)(image->buffer) + (y * image->pitch);
 
-    return true;
+    switch (image->type)
+    {
+    case VC_IMAGE_RGB565:
+
+        rgb565RowToRgb888((const uint16_t *)row, scratch, image->width);
+        return scratch;
+
+    case VC_IMAGE_RGBA16:
+
+        rgba16RowToRgba8((const uint16_t *)row,
+                         (RGBA8_T *)scratch,
+                         image->width);
+        return scratch;
+
+    default:
+
+        return row;
+    }
 }
 
 //-----------------------------------------------------------------------
 
-bool
-pngWriteImageRGB888(
-    const IMAGE_T *image,
-    png_structp pngPtr,
-    png_infop infoPtr)
+static void
+filterStrip(
+    SAVEPNG_ENCODER_T *encoder,
+    int32_t strip)
 {
-    int32_t y = 0;
-    for (y = 0; y < image->height; y++)
+    size_t length = encoder->rowBytes - 1;
+    uint8_t *scratch = malloc(3 * encoder->rowBytes);
+
+    if (scratch == NULL)
     {
-        png_write_row(pngPtr, image->buffer + (image->pitch * y));
+        fprintf(stderr, "savepng: memory exhausted\n");
+        exit(EXIT_FAILURE);
     }
 
-    return true;
+    uint8_t *priorScratch = scratch;
+    uint8_t *rowScratch = scratch + encoder->rowBytes;
+    uint8_t *filterScratch = rowScratch + encoder->rowBytes;
+
+    int32_t first = strip * encoder->stripRows;
+    int32_t last = first + encoder->stripRows;
+
+    if (last > encoder->image->height)
+    {
+        last = encoder->image->height;
+    }
+
+    const uint8_t *prior = priorScratch;
+
+    if (first > 0)
+    {
+        prior = pngRow(encoder, first - 1, priorScratch);
+    }
+    else
+    {
+        memset(priorScratch, 0, length);
+    }
+
+    int32_t y;
+    for (y = first ; y < last ; y++)
+    {
+        const uint8_t *row = pngRow(encoder, y, rowScratch);
+        uint8_t *out = encoder->filtered + (y * encoder->rowBytes);
+
+        if (encoder->options->filter == SAVEPNG_FILTER_ADAPTIVE)
+        {
+            filterRowAdaptive(row,
+                              prior,
+                              length,
+                              encoder->pixelBytes,
+                              out,
+                              filterScratch);
+        }
+        else
+        {
+            filterRow(encoder->options->filter,
+                      row,
+                      prior,
+                      length,
+                      encoder->pixelBytes,
+                      out);
+        }
+
+        // A converted row has to move out of the way of the next one.
+
+        if (row == rowScratch)
+        {
+            uint8_t *tmp = priorScratch;
+            priorScratch = rowScratch;
+            rowScratch = tmp;
+        }
+
+        prior = row;
+    }
+
+    free(scratch);
 }
 
 //-----------------------------------------------------------------------
 
-bool
-pngWriteImageRGBA16(
-    const IMAGE_T *image,
-    png_structp pngPtr,
-    png_infop infoPtr)
+static void
+deflateStrip(
+    SAVEPNG_ENCODER_T *encoder,
+    int32_t strip)
 {
-    int32_t rowLength = 4 * image->width;
-    uint8_t *imageRow = malloc(rowLength);
+    SAVEPNG_STRIP_T *s = &(encoder->strip[strip]);
+    bool lastStrip = (strip == (encoder->strips - 1));
+    const uint8_t *input = encoder->filtered + s->offset;
+
+    s->adler = adler32(adler32(0L, Z_NULL, 0), input, s->length);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    bool ok = (deflateInit2(&stream,
+                            encoder->options->level,
+                            Z_DEFLATED,
+                            -MAX_WBITS,
+                            8,
+                            encoder->options->strategy) == Z_OK);
 
-    if (imageRow == NULL)
+    if (ok == false)
     {
-        fprintf(stderr, "savepng: unable to allocated row buffer\n");
-        return false;
+        pthread_mutex_lock(&(encoder->mutex));
+        encoder->ok = false;
+        pthread_mutex_unlock(&(encoder->mutex));
+        return;
+    }
+
+    // The first strip has room for the zlib header before it and the last
+    // for the checksum after it. Flushing can add a few bytes more than
+    // deflateBound allows for.
+
+    size_t size = deflateBound(&stream, s->length) + 16 + 6;
+    s->data = malloc(size);
+
+    if (s->data == NULL)
+    {
+        fprintf(stderr, "savepng: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t start = (strip == 0) ? 2 : 0;
+
+    if ((s->offset > 0) && (encoder->options->level != Z_NO_COMPRESSION))
+    {
+        size_t window = (s->offset < SAVEPNG_WINDOW_BYTES)
+                      ? s->offset
+                      : SAVEPNG_WINDOW_BYTES;
+
+        deflateSetDictionary(&stream, input - window, window);
+    }
+
+    stream.next_in = (Bytef *)input;
+    stream.avail_in = s->length;
+    stream.next_out = s->data + start;
+    stream.avail_out = size - start - 4;
+
+    int status = deflate(&stream, (lastStrip) ? Z_FINISH : Z_FULL_FLUSH);
+
+    // A flush that fills the output exactly may not have finished, so the
+    // slack above must leave some of the output unused.
+
+    ok = (stream.avail_in == 0) &&
+         ((status == Z_STREAM_END) ||
+          ((status == Z_OK) && !lastStrip && (stream.avail_out > 0)));
+
+    s->dataLength = start + stream.total_out;
+
+    deflateEnd(&stream);
+
+    if (ok == false)
+    {
+        pthread_mutex_lock(&(encoder->mutex));
+        encoder->ok = false;
+        pthread_mutex_unlock(&(encoder->mutex));
     }
+}
+
+//-----------------------------------------------------------------------
+
+static void *
+savePngWorker(
+    void *arg)
+{
+    SAVEPNG_WORKER_T *worker = arg;
+    SAVEPNG_ENCODER_T *encoder = worker->encoder;
 
-    int32_t y = 0;
-    for (y = 0; y < image->height; y++)
+    while (true)
     {
-        int32_t x = 0;
-        for (x = 0; x < image->width; x++)
+        pthread_mutex_lock(&(encoder->mutex));
+        int32_t strip = encoder->next++;
+        pthread_mutex_unlock(&(encoder->mutex));
+
+        if (strip >= encoder->strips)
         {
-            uint16_t pixels = *(uint16_t*)(image->buffer +
-                                           (y * image->pitch) +
-                                           ((x * image->bitsPerPixel) / 8));
-            int32_t index = x * 4;
-
-            uint8_t r4 = (pixels >> 12) & 0xF;
-            uint8_t g4 = (pixels >> 8) & 0xF;
-            uint8_t b4 = (pixels >> 4) & 0xF;
-            uint8_t a4 = pixels & 0xF;
-
-            imageRow[index] = (r4 << 4) | r4;
-            imageRow[index + 1] = (g4 << 4) | g4;
-            imageRow[index + 2] = (b4 << 4) | b4;
-            imageRow[index + 3] = (a4 << 4) | a4;
+            break;
         }
-        png_write_row(pngPtr, imageRow);
 
+        worker->job(encoder, strip);
     }
 
-    free(imageRow);
+    return NULL;
+}
+
+//-----------------------------------------------------------------------
+
+// Run 'job' on every strip, sharing the strips between 'threads' threads
+// including the calling one.
+
+static void
+runSavePngJob(
+    SAVEPNG_ENCODER_T *encoder,
+    SAVEPNG_JOB_T job,
+    int32_t threads)
+{
+    SAVEPNG_WORKER_T worker = { encoder, job };
+    pthread_t thread[SAVEPNG_MAX_THREADS];
+    int32_t started = 0;
+
+    encoder->next = 0;
 
-    return true;
+    int32_t i;
+    for (i = 1 ; i < threads ; i++)
+    {
+        if (pthread_create(&(thread[started]),
+                           NULL,
+                           savePngWorker,
+                           &worker) == 0)
+        {
+            started++;
+        }
+    }
+
+    savePngWorker(&worker);
+
+    for (i = 0 ; i < started ; i++)
+    {
+        pthread_join(thread[i], NULL);
+    }
 }
 
 //-----------------------------------------------------------------------
 
-bool
-pngWriteImageRGBA32(
-    const IMAGE_T *image,
-    png_structp pngPtr,
-    png_infop infoPtr)
+static void
+putUint32(
+    uint8_t *buffer,
+    uint32_t value)
 {
-    int32_t y = 0;
-    for (y = 0; y < image->height; y++)
+    buffer[0] = value >> 24;
+    buffer[1] = value >> 16;
+    buffer[2] = value >> 8;
+    buffer[3] = value;
+}
+
+//-----------------------------------------------------------------------
+
+static bool
+writeChunk(
+    FILE *file,
+    const char *type,
+    const uint8_t *data,
+    size_t length)
+{
+    uint8_t header[8];
+    putUint32(header, length);
+    memcpy(header + 4, type, 4);
+
+    // crc32 restarts when given a NULL buffer, so an empty chunk's data
+    // is left out.
+
+    uLong chunkCrc = crc32(crc32(0L, Z_NULL, 0), header + 4, 4);
+
+    if (length > 0)
     {
-        png_write_row(pngPtr, image->buffer + (image->pitch * y));
+        chunkCrc = crc32(chunkCrc, data, length);
     }
 
-    return true;
+    uint8_t crc[4];
+    putUint32(crc, chunkCrc);
+
+    return (fwrite(header, sizeof(header), 1, file) == 1) &&
+           ((length == 0) || (fwrite(data, length, 1, file) == 1)) &&
+           (fwrite(crc, sizeof(crc), 1, file) == 1);
+}
+
+//-----------------------------------------------------------------------
+
+static bool
+writePngFile(
+    SAVEPNG_ENCODER_T *encoder,
+    FILE *file)
+{
+    static const uint8_t signature[8] =
+    {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'
+    };
+
+    uint8_t ihdr[13];
+    putUint32(ihdr, encoder->image->width);
+    putUint32(ihdr + 4, encoder->image->height);
+    ihdr[8] = 8;
+    ihdr[9] = (encoder->channels == 4) ? 6 : 2;
+    ihdr[10] = 0;
+    ihdr[11] = 0;
+    ihdr[12] = 0;
+
+    bool result = (fwrite(signature, sizeof(signature), 1, file) == 1) &&
+                  writeChunk(file, "IHDR", ihdr, sizeof(ihdr));
+
+    int32_t i;
+    for (i = 0 ; (i < encoder->strips) && result ; i++)
+    {
+        SAVEPNG_STRIP_T *s = &(encoder->strip[i]);
+        result = writeChunk(file, "IDAT", s->data, s->dataLength);
+    }
+
+    return result && writeChunk(file, "IEND", NULL, 0);
 }
 
 //-----------------------------------------------------------------------
 
-bool savePng(const IMAGE_T* image, const char *file)
+// Add the zlib header to the first strip and the checksum of the whole
+// stream to the last.
+
+static void
+wrapZlibStream(
+    SAVEPNG_ENCODER_T *encoder)
 {
-    png_structp pngPtr = png_create_write_struct(PNG_LIBPNG_VER_STRING,
-                                                 NULL,
-                                                 NULL,
-                                                 NULL);
+    int level = encoder->options->level;
+    int compressionLevel = 2;
 
-    if (pngPtr == NULL)
+    if ((level >= 0) && (level < 2))
+    {
+        compressionLevel = 0;
+    }
+    else if ((level >= 2) && (level < 6))
+    {
+        compressionLevel = 1;
+    }
+    else if (level > 6)
     {
-        fprintf(stderr,
-                "savepng: unable to allocated PNG write structure\n");
+        compressionLevel = 3;
+    }
 
-        return false;
+    uint16_t header = (0x78 << 8) | (compressionLevel << 6);
+    header += 31 - (header % 31);
+
+    encoder->strip[0].data[0] = header >> 8;
+    encoder->strip[0].data[1] = header & 0xFF;
+
+    uLong adler = adler32(0L, Z_NULL, 0);
+
+    int32_t i;
+    for (i = 0 ; i < encoder->strips ; i++)
+    {
+        adler = adler32_combine(adler,
+                                encoder->strip[i].adler,
+                                encoder->strip[i].length);
     }
 
-    png_infop infoPtr = png_create_info_struct(pngPtr);
+    SAVEPNG_STRIP_T *last = &(encoder->strip[encoder->strips - 1]);
+    putUint32(last->data + last->dataLength, adler);
+    last->dataLength += 4;
+}
+
+//-----------------------------------------------------------------------
 
-    if (infoPtr == NULL)
+bool
+savePngWithOptions(
+    const IMAGE_T* image,
+    const char *file,
+    const SAVEPNG_OPTIONS_T *options)
+{
+    SAVEPNG_ENCODER_T encoder;
+    memset(&encoder, 0, sizeof(encoder));
+
+    encoder.image = image;
+    encoder.options = options;
+
+    switch (image->type)
     {
-        fprintf(stderr,
-                "savepng: unable to allocated PNG info structure\n");
+    case VC_IMAGE_RGB565:
+    case VC_IMAGE_RGB888:
+
+        encoder.channels = 3;
+        break;
 
+    case VC_IMAGE_RGBA16:
+    case VC_IMAGE_RGBA32:
+
+        encoder.channels = 4;
+        break;
+
+    default:
+
+        fprintf(stderr, "savepng: unsupported image type\n");
         return false;
     }
 
-    if (setjmp(png_jmpbuf(pngPtr)))
+    if ((image->width <= 0) || (image->height <= 0))
     {
-        fprintf(stderr, "savepng: unable to create PNG\n");
         return false;
     }
 
-    FILE *pngfp = fopen(file, "wb");
+    encoder.pixelBytes = encoder.channels;
+    encoder.rowBytes = 1 + (image->width * encoder.channels);
+    encoder.stripRows = SAVEPNG_STRIP_BYTES / encoder.rowBytes;
 
-    if (pngfp == NULL)
+    if (encoder.stripRows < 1)
     {
-        fprintf(stderr,
-                "savepng: unable to create %s - %s\n",
-                file,
-                strerror(errno));
+        encoder.stripRows = 1;
+    }
+
+    encoder.strips = (image->height + encoder.stripRows - 1)
+                   / encoder.stripRows;
+    encoder.ok = true;
 
+    encoder.filtered = malloc(image->height * encoder.rowBytes);
+    encoder.strip = calloc(encoder.strips, sizeof(SAVEPNG_STRIP_T));
+
+    if ((encoder.filtered == NULL) || (encoder.strip == NULL))
+    {
+        fprintf(stderr, "savepng: memory exhausted\n");
         exit(EXIT_FAILURE);
     }
 
-    png_init_io(pngPtr, pngfp);
+    int32_t i;
+    for (i = 0 ; i < encoder.strips ; i++)
+    {
+        SAVEPNG_STRIP_T *s = &(encoder.strip[i]);
+        int32_t rows = encoder.stripRows;
 
-    int png_color_type = PNG_COLOR_TYPE_RGB;
+        if (i == (encoder.strips - 1))
+        {
+            rows = image->height - (i * encoder.stripRows);
+        }
 
-    if ((image->type == VC_IMAGE_RGBA16) ||
-        (image->type == VC_IMAGE_RGBA32))
-    {
-        png_color_type = PNG_COLOR_TYPE_RGBA;
+        s->offset = i * encoder.stripRows * encoder.rowBytes;
+        s->length = rows * encoder.rowBytes;
     }
 
-    png_set_IHDR(
-        pngPtr,
-        infoPtr,
-        image->width,
-        image->height,
-        8,
-        png_color_type,
-        PNG_INTERLACE_NONE,
-        PNG_COMPRESSION_TYPE_BASE,
-        PNG_FILTER_TYPE_BASE);
+    //-------------------------------------------------------------------
 
-    png_write_info(pngPtr, infoPtr);
+    int32_t threads = options->threads;
+
+    if (threads <= 0)
+    {
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
 
-    bool result = false;
+    if (threads > SAVEPNG_MAX_THREADS)
+    {
+        threads = SAVEPNG_MAX_THREADS;
+    }
 
-    switch(image->type)
+    if (threads > encoder.strips)
     {
-    case VC_IMAGE_RGB565:
+        threads = encoder.strips;
+    }
 
-        result = pngWriteImageRGB565(image, pngPtr, infoPtr);
-        break;
+    pthread_mutex_init(&(encoder.mutex), NULL);
 
-    case VC_IMAGE_RGB888:
+    runSavePngJob(&encoder, filterStrip, threads);
+    runSavePngJob(&encoder, deflateStrip, threads);
 
-        result = pngWriteImageRGB888(image, pngPtr, infoPtr);
-        break;
+    pthread_mutex_destroy(&(encoder.mutex));
 
-    case VC_IMAGE_RGBA16:
+    //-------------------------------------------------------------------
 
-        result = pngWriteImageRGBA16(image, pngPtr, infoPtr);
-        break;
+    bool result = encoder.ok;
 
-    case VC_IMAGE_RGBA32:
+    if (result)
+    {
+        wrapZlibStream(&encoder);
 
-        result = pngWriteImageRGBA32(image, pngPtr, infoPtr);
-        break;
+        FILE *pngfp = fopen(file, "wb");
 
-    default:
+        if (pngfp == NULL)
+        {
+            fprintf(stderr,
+                    "savepng: unable to create %s - %s\n",
+                    file,
+                    strerror(errno));
 
-        break;
+            result = false;
+        }
+        else
+        {
+            result = writePngFile(&encoder, pngfp);
+
+            if (fclose(pngfp) != 0)
+            {
+                result = false;
+            }
+        }
+    }
+    else
+    {
+        fprintf(stderr, "savepng: unable to compress image\n");
+    }
+
+    for (i = 0 ; i < encoder.strips ; i++)
+    {
+        free(encoder.strip[i].data);
     }
 
-    png_write_end(pngPtr, NULL);
-    png_destroy_write_struct(&pngPtr, &infoPtr);
-    fclose(pngfp);
+    free(encoder.strip);
+    free(encoder.filtered);
 
     return result;
 }
+
+//-----------------------------------------------------------------------
+
+bool
+savePng(
+    const IMAGE_T* image,
+    const char *file)
+{
+    SAVEPNG_OPTIONS_T options;
+    setSavePngPreset(&options, SAVEPNG_PRESET_DEFAULT);
+
+    return savePngWithOptions(image, file, &options);
+}
+
@@ -33,6 +33,55 @@
 #include "image.h"
 
 //-------------------------------------------------------------------------
+// PNGs are written as 8 bit RGB or RGBA from RGB565, RGB888, RGBA16 and
+// RGBA32 images. The image is filtered and deflated in strips spread over
+// several threads, and the result is the same whatever the number of
+// threads.
+
+typedef enum
+{
+    SAVEPNG_FILTER_NONE = 0,
+    SAVEPNG_FILTER_SUB = 1,
+    SAVEPNG_FILTER_UP = 2,
+    SAVEPNG_FILTER_AVERAGE = 3,
+    SAVEPNG_FILTER_PAETH = 4,
+    SAVEPNG_FILTER_ADAPTIVE = 5
+} SAVEPNG_FILTER_T;
+
+typedef enum
+{
+    SAVEPNG_PRESET_UNCOMPRESSED,
+    SAVEPNG_PRESET_FAST,
+    SAVEPNG_PRESET_DEFAULT,
+    SAVEPNG_PRESET_SMALL
+} SAVEPNG_PRESET_T;
+
+// 'level' and 'strategy' are the zlib ones. 'threads' of zero or less uses
+// one thread per core.
+
+typedef struct
+{
+    SAVEPNG_FILTER_T filter;
+    int level;
+    int strategy;
+    int threads;
+} SAVEPNG_OPTIONS_T;
+
+//-------------------------------------------------------------------------
+
+void
+setSavePngPreset(
+    SAVEPNG_OPTIONS_T *options,
+    SAVEPNG_PRESET_T preset);
+
+// False is returned if the image can't be encoded or the file can't be
+// created or written.
+
+bool
+savePngWithOptions(
+    const IMAGE_T* image,
+    const char *file,
+    const SAVEPNG_OPTIONS_T *options);
 
 bool savePng(const IMAGE_T* image, const char *file);
 
@@ -29,8 +29,8 @@
 #include <ctype.h>
 #include <stdbool.h>
 
-#include "element_change.h"
 #include "image.h"
+#include "imageFile.h"
 #include "loadpng.h"
 #include "scrollingLayer.h"
 
@@ -43,10 +43,10 @@ initScrollingLayer(SCROLLING_LAYER_T *sl,
     const char* file,
     int32_t layer)
 {
-    int result = 0;
+    IMAGE_T texture;
+    IMAGE_PALETTE32_T palette;
 
-    //---------------------------------------------------------------------
-    if (loadScrollingLayerPng(&sl->image, file, true, true) == false)
+    if (loadImage(&texture, &palette, file) == false)
     {
         fprintf(stderr, "scrollingBgLayer: unable to load %s\n", file);
         exit(EXIT_FAILURE);
@@ -75,47 +75,20 @@ initScrollingLayer(SCROLLING_LAYER_T *sl,
 
     //---------------------------------------------------------------------
 
-    uint32_t vc_image_ptr;
-
-    sl->layer = layer;
-
-    sl->frontResource =
-        vc_dispmanx_resource_create(
-            sl->image.type,
-            sl->image.width | (sl->image.pitch << 16),
-            sl->image.height | (sl->image.alignedHeight << 16),
-            &vc_image_ptr);
-    assert(sl->frontResource != 0);
-
-    sl->backResource =
-        vc_dispmanx_resource_create(
-            sl->image.type,
-            sl->image.width | (sl->image.pitch << 16),
-            sl->image.height | (sl->image.alignedHeight << 16),
-            &vc_image_ptr);
-    assert(sl->backResource != 0);
+    sl->textureWidth = texture.width;
+    sl->textureHeight = texture.height;
 
-    //---------------------------------------------------------------------
+    initTiledLayer(&(sl->tiles),
+                   &texture,
+                   &palette,
+                   texture.width,
+                   texture.height,
+                   1,
+                   1,
+                   layer);
 
-    vc_dispmanx_rect_set(&(sl->bmpRect),
-                         0,
-                         0,
-                         sl->image.width,
-                         sl->image.height);
-
-    result = vc_dispmanx_resource_write_data(sl->frontResource,
-                                             sl->image.type,
-                                             sl->image.pitch,
-                                             sl->image.buffer,
-                                             &(sl->bmpRect));
-    assert(result == 0);
-
-    result = vc_dispmanx_resource_write_data(sl->backResource,
-                                             sl->image.type,
-                                             sl->image.pitch,
-                                             sl->image.buffer,
-                                             &(sl->bmpRect));
-    assert(result == 0);
+    destroyImage(&texture);
+    destroyImagePalette32(&palette);
 }
 
 //-------------------------------------------------------------------------
@@ -127,14 +100,11 @@ addElementScrollingLayerCentered(
     DISPMANX_DISPLAY_HANDLE_T display,
     DISPMANX_UPDATE_HANDLE_T update)
 {
-    sl->viewWidth = sl->image.width / 2;
-    sl->viewHeight = sl->image.height / 2;
-
-    sl->xOffsetMax = sl->viewWidth - 1;
-    sl->xOffset = sl->xOffsetMax / 2;
+    sl->viewWidth = sl->textureWidth;
+    sl->viewHeight = sl->textureHeight;
 
-    sl->yOffsetMax = sl->viewHeight - 1;
-    sl->yOffset = sl->yOffsetMax / 2;
+    sl->xOffset = (sl->textureWidth - 1) / 2;
+    sl->yOffset = (sl->textureHeight - 1) / 2;
 
     if (sl->viewWidth > info->width)
     {
@@ -146,12 +116,6 @@ addElementScrollingLayerCentered(
         sl->viewHeight = info->height;
     }
 
-    vc_dispmanx_rect_set(&sl->srcRect,
-                         sl->xOffset << 16,
-                         sl->yOffset << 16,
-                         sl->viewWidth << 16,
-                         sl->viewHeight << 16);
-
     vc_dispmanx_rect_set(&(sl->dstRect),
                          (info->width - sl->viewWidth) / 2,
                          (info->height - sl->viewHeight) / 2,
@@ -169,24 +133,8 @@ addElementScrollingLayer(
     DISPMANX_DISPLAY_HANDLE_T display,
     DISPMANX_UPDATE_HANDLE_T update)
 {
-    VC_DISPMANX_ALPHA_T alpha =
-    {
-        DISPMANX_FLAGS_ALPHA_FROM_SOURCE, 
-        255,
-        0
-    };
-
-    sl->element = vc_dispmanx_element_add(update,
-                                          display,
-                                          sl->layer,
-                                          &(sl->dstRect),
-                                          sl->frontResource,
-                                          &(sl->srcRect),
-                                          DISPMANX_PROTECTION_NONE,
-                                          &alpha,
-                                          NULL,
-                                          DISPMANX_NO_ROTATE);
-    assert(sl->element != 0);
+    setPositionTiledLayer(&(sl->tiles), sl->xOffset, sl->yOffset);
+    addElementTiledLayer(&(sl->tiles), &(sl->dstRect), display, update);
 }
 
 //-------------------------------------------------------------------------
@@ -236,62 +184,17 @@ updatePositionScrollingLayer(
     SCROLLING_LAYER_T *sl,
     DISPMANX_UPDATE_HANDLE_T update)
 {
-    int result = 0;
-
-    //---------------------------------------------------------------------
-
     sl->xOffset += sl->xDirections[sl->direction];
-
-    if (sl->xOffset < 0)
-    {
-        sl->xOffset = sl->xOffsetMax;
-    }
-    else if (sl->xOffset > sl->xOffsetMax)
-    {
-        sl->xOffset = 0;
-    }
-
     sl->yOffset -= sl->yDirections[sl->direction];
 
-    if (sl->yOffset < 0)
-    {
-        sl->yOffset = sl->yOffsetMax;
-    }
-    else if (sl->yOffset > sl->yOffsetMax)
-    {
-        sl->yOffset = 0;
-    }
-
-    //---------------------------------------------------------------------
+    // The tiled layer wraps the position around the texture.
 
-    result = vc_dispmanx_element_change_source(update,
-                                               sl->element,
-                                               sl->backResource);
-    assert(result == 0);
-
-    vc_dispmanx_rect_set(&(sl->srcRect),
-                         sl->xOffset << 16,
-                         sl->yOffset << 16,
-                         sl->viewWidth << 16,
-                         sl->viewHeight << 16);
-
-    result = 
-    vc_dispmanx_element_change_attributes(update,
-                                          sl->element,
-                                          ELEMENT_CHANGE_SRC_RECT,
-                                          0,
-                                          255,
-                                          &(sl->dstRect),
-                                          &(sl->srcRect),
-                                          0,
-                                          DISPMANX_NO_ROTATE);
-    assert(result == 0);
+    setPositionTiledLayer(&(sl->tiles), sl->xOffset, sl->yOffset);
 
-    //---------------------------------------------------------------------
+    sl->xOffset = sl->tiles.x;
+    sl->yOffset = sl->tiles.y;
 
-    DISPMANX_RESOURCE_HANDLE_T tmp = sl->frontResource;
-    sl->frontResource = sl->backResource;
-    sl->backResource = tmp;
+    updateTiledLayer(&(sl->tiles), update);
 }
 
 //-------------------------------------------------------------------------
@@ -300,25 +203,7 @@ void
 destroyScrollingLayer(
     SCROLLING_LAYER_T *sl)
 {
-    int result = 0;
-
-    DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
-    assert(update != 0);
-    result = vc_dispmanx_element_remove(update, sl->element);
-    assert(result == 0);
-    result = vc_dispmanx_update_submit_sync(update);
-    assert(result == 0);
-
-    //---------------------------------------------------------------------
-
-    result = vc_dispmanx_resource_delete(sl->frontResource);
-    assert(result == 0);
-    result = vc_dispmanx_resource_delete(sl->backResource);
-    assert(result == 0);
-
-    //---------------------------------------------------------------------
-
-    destroyImage(&(sl->image));
+    destroyTiledLayer(&(sl->tiles));
 }
 
 //-------------------------------------------------------------------------
@@ -348,7 +233,7 @@ loadScrollingLayerPng(
             int32_t offset = 0;
 
             int32_t y = 0;
-            for (y = 0 ; y < baseImage.width ; y++)
+            for (y = 0 ; y < baseImage.height ; y++)
             {
                 baseOffset = y * baseImage.pitch;
                 offset = y * image->pitch;
@@ -373,6 +258,8 @@ loadScrollingLayerPng(
 
             memcpy(image->buffer + size, image->buffer, size);
         }
+
+        destroyImage(&baseImage);
     }
 
     return loaded;
@@ -31,31 +31,29 @@
 #include <stdbool.h>
 
 #include "image.h"
+#include "tiledLayer.h"
 
 #include "bcm_host.h"
 
 //-------------------------------------------------------------------------
+// A seamless texture scrolled in one of eight directions. The texture is
+// a tiled layer with a single tile and a map one tile in size, so it is
+// kept in one resource of its own size and wraps around as it scrolls.
 
 typedef struct
 {
-    IMAGE_T image;
+    TILED_LAYER_T tiles;
+    int32_t textureWidth;
+    int32_t textureHeight;
     int32_t viewWidth;
     int32_t viewHeight;
-    int32_t xOffsetMax;
     int32_t xOffset;
-    int32_t yOffsetMax;
     int32_t yOffset;
     int16_t direction;
     int16_t directionMax;
     int32_t xDirections[8];
     int32_t yDirections[8];
-    VC_RECT_T bmpRect;
-    VC_RECT_T srcRect;
     VC_RECT_T dstRect;
-    int32_t layer;
-    DISPMANX_RESOURCE_HANDLE_T frontResource;
-    DISPMANX_RESOURCE_HANDLE_T backResource;
-    DISPMANX_ELEMENT_HANDLE_T element;
 } SCROLLING_LAYER_T;
 
 //-------------------------------------------------------------------------
@@ -87,6 +85,9 @@ updatePositionScrollingLayer(
 
 void destroyScrollingLayer(SCROLLING_LAYER_T *sl);
 
+// Load a PNG, repeated once to the right if extendX and once below if
+// extendY.
+
 bool
 loadScrollingLayerPng(
     IMAGE_T* image,
@@ -0,0 +1,334 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "image.h"
+#include "imageFile.h"
+#include "imagePalette.h"
+#include "spriteAtlas.h"
+
+//-------------------------------------------------------------------------
+
+#define SPRITE_ATLAS_LINE_LENGTH 512
+
+// The %s width in the frame format must be SPRITE_ATLAS_NAME_LENGTH - 1.
+
+#define SPRITE_ATLAS_FRAME_FORMAT "frame %d %d %d %d %d %63s"
+
+//-------------------------------------------------------------------------
+
+static void *
+growArray(
+    void *array,
+    int32_t count,
+    int32_t *capacity,
+    size_t size)
+{
+    if (count < *capacity)
+    {
+        return array;
+    }
+
+    *capacity = (*capacity == 0) ? 16 : *capacity * 2;
+    array = realloc(array, *capacity * size);
+
+    if (array == NULL)
+    {
+        fprintf(stderr, "spriteAtlas: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return array;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+createSpriteAtlasPage(
+    SPRITE_ATLAS_PAGE_T *page,
+    const char *path)
+{
+    IMAGE_T image;
+    IMAGE_PALETTE32_T palette;
+
+    if (loadImage(&image, &palette, path) == false)
+    {
+        fprintf(stderr, "spriteAtlas: unable to load %s\n", path);
+        return false;
+    }
+
+    page->type = image.type;
+    page->width = image.width;
+    page->height = image.height;
+
+    //---------------------------------------------------------------------
+
+    uint32_t vc_image_ptr;
+
+    page->resource =
+        vc_dispmanx_resource_create(
+            image.type,
+            image.width | (image.pitch << 16),
+            image.height | (image.alignedHeight << 16),
+            &vc_image_ptr);
+    assert(page->resource != 0);
+
+    if (palette.length > 0)
+    {
+        bool set = setResourcePalette32(&palette,
+                                        0,
+                                        page->resource,
+                                        0,
+                                        palette.length);
+        assert(set);
+    }
+
+    VC_RECT_T bmpRect;
+    vc_dispmanx_rect_set(&bmpRect, 0, 0, image.width, image.height);
+
+    int result = vc_dispmanx_resource_write_data(page->resource,
+                                                 image.type,
+                                                 image.pitch,
+                                                 image.buffer,
+                                                 &bmpRect);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    destroyImagePalette32(&palette);
+    destroyImage(&image);
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+addSpriteAtlasPage(
+    SPRITE_ATLAS_T *atlas,
+    int32_t *capacity,
+    const char *indexPath,
+    const char *file)
+{
+    // Page files are relative to the directory holding the index.
+
+    const char *slash = strrchr(indexPath, '/');
+    int directoryLength = (slash != NULL) ? (slash - indexPath) + 1 : 0;
+
+    if (file[0] == '/')
+    {
+        directoryLength = 0;
+    }
+
+    char path[SPRITE_ATLAS_LINE_LENGTH * 2];
+    snprintf(path, sizeof(path), "%.*s%s", directoryLength, indexPath, file);
+
+    atlas->pages = growArray(atlas->pages,
+                             atlas->pageCount,
+                             capacity,
+                             sizeof(SPRITE_ATLAS_PAGE_T));
+
+    if (createSpriteAtlasPage(&(atlas->pages[atlas->pageCount]), path))
+    {
+        atlas->pageCount++;
+        return true;
+    }
+
+    return false;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+addSpriteAtlasFrame(
+    SPRITE_ATLAS_T *atlas,
+    int32_t *capacity,
+    const SPRITE_ATLAS_FRAME_T *frame)
+{
+    if ((frame->page < 0) || (frame->page >= atlas->pageCount))
+    {
+        return false;
+    }
+
+    const SPRITE_ATLAS_PAGE_T *page = &(atlas->pages[frame->page]);
+
+    if ((frame->x < 0) ||
+        (frame->y < 0) ||
+        (frame->width <= 0) ||
+        (frame->height <= 0) ||
+        (frame->x + frame->width > page->width) ||
+        (frame->y + frame->height > page->height))
+    {
+        return false;
+    }
+
+    atlas->frames = growArray(atlas->frames,
+                              atlas->frameCount,
+                              capacity,
+                              sizeof(SPRITE_ATLAS_FRAME_T));
+
+    atlas->frames[atlas->frameCount++] = *frame;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+loadSpriteAtlas(
+    SPRITE_ATLAS_T *atlas,
+    const char *path)
+{
+    memset(atlas, 0, sizeof(*atlas));
+
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "spriteAtlas: can't open %s\n", path);
+        return false;
+    }
+
+    int32_t pageCapacity = 0;
+    int32_t frameCapacity = 0;
+    int32_t lineNumber = 0;
+    bool versionRead = false;
+    bool ok = true;
+
+    char line[SPRITE_ATLAS_LINE_LENGTH];
+
+    while (ok && (fgets(line, sizeof(line), file) != NULL))
+    {
+        lineNumber++;
+
+        char *text = line + strspn(line, " \t");
+        text[strcspn(text, "\r\n")] = '\0';
+
+        if ((text[0] == '\0') || (text[0] == '#'))
+        {
+            continue;
+        }
+
+        int version = 0;
+        SPRITE_ATLAS_FRAME_T frame;
+
+        if (versionRead == false)
+        {
+            ok = (sscanf(text, "atlas %d", &version) == 1) &&
+                 (version == SPRITE_ATLAS_VERSION);
+            versionRead = true;
+        }
+        else if (strncmp(text, "page ", 5) == 0)
+        {
+            const char *pageFile = text + 5 + strspn(text + 5, " \t");
+            ok = addSpriteAtlasPage(atlas, &pageCapacity, path, pageFile);
+        }
+        else if (sscanf(text,
+                        SPRITE_ATLAS_FRAME_FORMAT,
+                        &(frame.page),
+                        &(frame.x),
+                        &(frame.y),
+                        &(frame.width),
+                        &(frame.height),
+                        frame.name) == 6)
+        {
+            ok = addSpriteAtlasFrame(atlas, &frameCapacity, &frame);
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (ok == false)
+        {
+            fprintf(stderr,
+                    "spriteAtlas: bad line %d in %s\n",
+                    lineNumber,
+                    path);
+        }
+    }
+
+    fclose(file);
+
+    if (ok && (versionRead == false))
+    {
+        fprintf(stderr, "spriteAtlas: %s is empty\n", path);
+        ok = false;
+    }
+
+    if (ok == false)
+    {
+        destroySpriteAtlas(atlas);
+    }
+
+    return ok;
+}
+
+//-------------------------------------------------------------------------
+
+int32_t
+findSpriteAtlasFrame(
+    const SPRITE_ATLAS_T *atlas,
+    const char *name)
+{
+    int32_t i;
+    for (i = 0 ; i < atlas->frameCount ; i++)
+    {
+        if (strcmp(atlas->frames[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//-------------------------------------------------------------------------
+
+void
+destroySpriteAtlas(
+    SPRITE_ATLAS_T *atlas)
+{
+    int32_t i;
+    for (i = 0 ; i < atlas->pageCount ; i++)
+    {
+        int result = vc_dispmanx_resource_delete(atlas->pages[i].resource);
+        assert(result == 0);
+    }
+
+    free(atlas->pages);
+    free(atlas->frames);
+
+    memset(atlas, 0, sizeof(*atlas));
+}
+
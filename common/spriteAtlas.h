@@ -0,0 +1,105 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bcm_host.h"
+
+//-------------------------------------------------------------------------
+// A sprite atlas is a few large images (pages), each holding many sprite
+// frames of any size, and an index giving where each frame is. It is made
+// by atlaspack. Each page is written to one DispmanX resource that any
+// number of elements can show parts of, so hundreds of sprites need only
+// a handful of resources.
+//
+// The index is a text file. Blank lines and lines starting with '#' are
+// ignored. Pages are numbered from 0 in the order they are listed, and
+// their image files (PNG, QOI or mapped) are relative to the index.
+//
+//     atlas 1
+//     page <file>
+//     frame <page> <x> <y> <width> <height> <name>
+
+#define SPRITE_ATLAS_VERSION 1
+#define SPRITE_ATLAS_NAME_LENGTH 64
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    char name[SPRITE_ATLAS_NAME_LENGTH];
+    int32_t page;
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+} SPRITE_ATLAS_FRAME_T;
+
+typedef struct
+{
+    VC_IMAGE_TYPE_T type;
+    int32_t width;
+    int32_t height;
+    DISPMANX_RESOURCE_HANDLE_T resource;
+} SPRITE_ATLAS_PAGE_T;
+
+typedef struct
+{
+    int32_t pageCount;
+    SPRITE_ATLAS_PAGE_T *pages;
+    int32_t frameCount;
+    SPRITE_ATLAS_FRAME_T *frames;
+} SPRITE_ATLAS_T;
+
+//-------------------------------------------------------------------------
+
+// Read the index and create a resource for each page. The page images are
+// freed once they have been written to their resources.
+
+bool
+loadSpriteAtlas(
+    SPRITE_ATLAS_T *atlas,
+    const char *path);
+
+// Return the index of the named frame, or -1 if there isn't one.
+
+int32_t
+findSpriteAtlasFrame(
+    const SPRITE_ATLAS_T *atlas,
+    const char *name);
+
+void destroySpriteAtlas(SPRITE_ATLAS_T *atlas);
+
+//-------------------------------------------------------------------------
+
+#endif
+
@@ -30,7 +30,7 @@
 
 #include "element_change.h"
 #include "image.h"
-#include "loadpng.h"
+#include "imageFile.h"
 #include "spriteLayer.h"
 
 //-------------------------------------------------------------------------
@@ -44,7 +44,7 @@ void initSpriteLayer(
 {
     int result = 0;
 
-    bool loaded = loadPng(&(s->image), file);
+    bool loaded = loadImage(&(s->image), &(s->palette), file);
 
     if (loaded == false)
     {
@@ -83,6 +83,23 @@ void initSpriteLayer(
             &vc_image_ptr);
     assert(s->backResource != 0);
 
+    if (s->palette.length > 0)
+    {
+        bool set = setResourcePalette32(&(s->palette),
+                                        0,
+                                        s->frontResource,
+                                        0,
+                                        s->palette.length);
+        assert(set);
+
+        set = setResourcePalette32(&(s->palette),
+                                   0,
+                                   s->backResource,
+                                   0,
+                                   s->palette.length);
+        assert(set);
+    }
+
     //---------------------------------------------------------------------
 
     vc_dispmanx_rect_set(&(s->bmpRect),
@@ -262,5 +279,6 @@ destroySpriteLayer(
     //---------------------------------------------------------------------
 
     destroyImage(&(s->image));
+    destroyImagePalette32(&(s->palette));
 }
 
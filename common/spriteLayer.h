@@ -29,6 +29,7 @@
 #define SPRITE_LAYER_H
 
 #include "image.h"
+#include "imagePalette.h"
 
 #include "bcm_host.h"
 
@@ -37,6 +38,7 @@
 typedef struct
 {
     IMAGE_T image;
+    IMAGE_PALETTE32_T palette;
     int width;
     int height;
     int columns;
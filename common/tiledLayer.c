@@ -0,0 +1,433 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "element_change.h"
+#include "image.h"
+#include "imagePalette.h"
+#include "tiledLayer.h"
+
+//-------------------------------------------------------------------------
+
+static int32_t
+wrap(
+    int32_t value,
+    int32_t size)
+{
+    value %= size;
+
+    return (value < 0) ? value + size : value;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+sameRect(
+    const VC_RECT_T *a,
+    const VC_RECT_T *b)
+{
+    return (a->x == b->x) &&
+           (a->y == b->y) &&
+           (a->width == b->width) &&
+           (a->height == b->height);
+}
+
+//-------------------------------------------------------------------------
+
+// Work out which tile a cell of the grid shows and where, clipped to the
+// view. Cell column c always shows a map column that is c modulo the
+// number of columns, so a cell only changes tile as it wraps around from
+// one side of the view to the other (and likewise for rows). A cell that
+// falls entirely outside the view is not visible, and its rectangles are
+// left as they were.
+
+static void
+findCell(
+    const TILED_LAYER_T *tl,
+    int32_t column,
+    int32_t row,
+    TILED_LAYER_CELL_T *cell)
+{
+    int32_t firstColumn = tl->x / tl->tileWidth;
+    int32_t firstRow = tl->y / tl->tileHeight;
+
+    int32_t tileX = firstColumn + wrap(column - firstColumn, tl->columns);
+    int32_t tileY = firstRow + wrap(row - firstRow, tl->rows);
+
+    int32_t screenX = tl->viewRect.x + (tileX * tl->tileWidth) - tl->x;
+    int32_t screenY = tl->viewRect.y + (tileY * tl->tileHeight) - tl->y;
+
+    int32_t left = screenX;
+    int32_t top = screenY;
+    int32_t right = screenX + tl->tileWidth;
+    int32_t bottom = screenY + tl->tileHeight;
+
+    if (left < tl->viewRect.x)
+    {
+        left = tl->viewRect.x;
+    }
+
+    if (top < tl->viewRect.y)
+    {
+        top = tl->viewRect.y;
+    }
+
+    if (right > tl->viewRect.x + tl->viewRect.width)
+    {
+        right = tl->viewRect.x + tl->viewRect.width;
+    }
+
+    if (bottom > tl->viewRect.y + tl->viewRect.height)
+    {
+        bottom = tl->viewRect.y + tl->viewRect.height;
+    }
+
+    cell->visible = (left < right) && (top < bottom);
+
+    if (cell->visible == false)
+    {
+        return;
+    }
+
+    cell->tile = getTileTiledLayer(tl,
+                                   tileX % tl->mapWidth,
+                                   tileY % tl->mapHeight);
+
+    int32_t tileSetX = (cell->tile % tl->tileColumns) * tl->tileWidth;
+    int32_t tileSetY = (cell->tile / tl->tileColumns) * tl->tileHeight;
+
+    vc_dispmanx_rect_set(&(cell->srcRect),
+                         (tileSetX + left - screenX) << 16,
+                         (tileSetY + top - screenY) << 16,
+                         (right - left) << 16,
+                         (bottom - top) << 16);
+
+    vc_dispmanx_rect_set(&(cell->dstRect),
+                         left,
+                         top,
+                         right - left,
+                         bottom - top);
+}
+
+//-------------------------------------------------------------------------
+
+void
+initTiledLayer(
+    TILED_LAYER_T *tl,
+    const IMAGE_T *tileSet,
+    const IMAGE_PALETTE32_T *palette,
+    int32_t tileWidth,
+    int32_t tileHeight,
+    int32_t mapWidth,
+    int32_t mapHeight,
+    int32_t layer)
+{
+    assert((tileWidth > 0) && (tileHeight > 0));
+    assert((mapWidth > 0) && (mapHeight > 0));
+
+    tl->tileWidth = tileWidth;
+    tl->tileHeight = tileHeight;
+    tl->tileColumns = tileSet->width / tileWidth;
+    tl->tileCount = tl->tileColumns * (tileSet->height / tileHeight);
+    assert(tl->tileCount > 0);
+
+    tl->mapWidth = mapWidth;
+    tl->mapHeight = mapHeight;
+    tl->map = calloc((size_t)mapWidth * mapHeight, sizeof(uint16_t));
+
+    if (tl->map == NULL)
+    {
+        fprintf(stderr, "tiledLayer: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    tl->x = 0;
+    tl->y = 0;
+    tl->columns = 0;
+    tl->rows = 0;
+    tl->cells = NULL;
+    tl->layer = layer;
+
+    //---------------------------------------------------------------------
+
+    uint32_t vc_image_ptr;
+
+    tl->resource =
+        vc_dispmanx_resource_create(
+            tileSet->type,
+            tileSet->width | (tileSet->pitch << 16),
+            tileSet->height | (tileSet->alignedHeight << 16),
+            &vc_image_ptr);
+    assert(tl->resource != 0);
+
+    if ((palette != NULL) && (palette->length > 0))
+    {
+        bool set = setResourcePalette32(palette,
+                                        0,
+                                        tl->resource,
+                                        0,
+                                        palette->length);
+        assert(set);
+    }
+
+    VC_RECT_T bmpRect;
+    vc_dispmanx_rect_set(&bmpRect, 0, 0, tileSet->width, tileSet->height);
+
+    int result = vc_dispmanx_resource_write_data(tl->resource,
+                                                 tileSet->type,
+                                                 tileSet->pitch,
+                                                 tileSet->buffer,
+                                                 &bmpRect);
+    assert(result == 0);
+}
+
+//-------------------------------------------------------------------------
+
+void
+setTileTiledLayer(
+    TILED_LAYER_T *tl,
+    int32_t column,
+    int32_t row,
+    uint16_t tile)
+{
+    assert((column >= 0) && (column < tl->mapWidth));
+    assert((row >= 0) && (row < tl->mapHeight));
+    assert(tile < tl->tileCount);
+
+    tl->map[(row * tl->mapWidth) + column] = tile;
+}
+
+//-------------------------------------------------------------------------
+
+uint16_t
+getTileTiledLayer(
+    const TILED_LAYER_T *tl,
+    int32_t column,
+    int32_t row)
+{
+    assert((column >= 0) && (column < tl->mapWidth));
+    assert((row >= 0) && (row < tl->mapHeight));
+
+    return tl->map[(row * tl->mapWidth) + column];
+}
+
+//-------------------------------------------------------------------------
+
+void
+addElementTiledLayer(
+    TILED_LAYER_T *tl,
+    const VC_RECT_T *viewRect,
+    DISPMANX_DISPLAY_HANDLE_T display,
+    DISPMANX_UPDATE_HANDLE_T update)
+{
+    tl->viewRect = *viewRect;
+    tl->columns = ((viewRect->width + tl->tileWidth - 1) / tl->tileWidth) + 1;
+    tl->rows = ((viewRect->height + tl->tileHeight - 1) / tl->tileHeight) + 1;
+    tl->cells = calloc(tl->columns * tl->rows, sizeof(TILED_LAYER_CELL_T));
+
+    if (tl->cells == NULL)
+    {
+        fprintf(stderr, "tiledLayer: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    //---------------------------------------------------------------------
+
+    int32_t row;
+    for (row = 0 ; row < tl->rows ; row++)
+    {
+        int32_t column;
+        for (column = 0 ; column < tl->columns ; column++)
+        {
+            TILED_LAYER_CELL_T *cell =
+                &(tl->cells[(row * tl->columns) + column]);
+
+            // A cell that starts out of view needs some rectangles to
+            // begin with.
+
+            vc_dispmanx_rect_set(&(cell->srcRect),
+                                 0,
+                                 0,
+                                 tl->tileWidth << 16,
+                                 tl->tileHeight << 16);
+
+            vc_dispmanx_rect_set(&(cell->dstRect),
+                                 tl->viewRect.x,
+                                 tl->viewRect.y,
+                                 tl->tileWidth,
+                                 tl->tileHeight);
+
+            findCell(tl, column, row, cell);
+
+            // The opacity is mixed in so that cells out of view can be
+            // hidden.
+
+            VC_DISPMANX_ALPHA_T alpha =
+            {
+                DISPMANX_FLAGS_ALPHA_FROM_SOURCE | DISPMANX_FLAGS_ALPHA_MIX,
+                (cell->visible) ? 255 : 0,
+                0
+            };
+
+            cell->element =
+                vc_dispmanx_element_add(update,
+                                        display,
+                                        tl->layer,
+                                        &(cell->dstRect),
+                                        tl->resource,
+                                        &(cell->srcRect),
+                                        DISPMANX_PROTECTION_NONE,
+                                        &alpha,
+                                        NULL, // clamp
+                                        DISPMANX_NO_ROTATE);
+            assert(cell->element != 0);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+setPositionTiledLayer(
+    TILED_LAYER_T *tl,
+    int32_t x,
+    int32_t y)
+{
+    tl->x = wrap(x, tl->mapWidth * tl->tileWidth);
+    tl->y = wrap(y, tl->mapHeight * tl->tileHeight);
+}
+
+//-------------------------------------------------------------------------
+
+int32_t
+updateTiledLayer(
+    TILED_LAYER_T *tl,
+    DISPMANX_UPDATE_HANDLE_T update)
+{
+    int32_t changed = 0;
+
+    int32_t row;
+    for (row = 0 ; row < tl->rows ; row++)
+    {
+        int32_t column;
+        for (column = 0 ; column < tl->columns ; column++)
+        {
+            TILED_LAYER_CELL_T *cell =
+                &(tl->cells[(row * tl->columns) + column]);
+
+            TILED_LAYER_CELL_T next = *cell;
+            findCell(tl, column, row, &next);
+
+            uint32_t changes = 0;
+
+            if (next.visible != cell->visible)
+            {
+                changes |= ELEMENT_CHANGE_OPACITY;
+            }
+
+            if (next.visible)
+            {
+                if (sameRect(&(next.srcRect), &(cell->srcRect)) == false)
+                {
+                    changes |= ELEMENT_CHANGE_SRC_RECT;
+                }
+
+                if (sameRect(&(next.dstRect), &(cell->dstRect)) == false)
+                {
+                    changes |= ELEMENT_CHANGE_DEST_RECT;
+                }
+            }
+
+            if (changes == 0)
+            {
+                continue;
+            }
+
+            *cell = next;
+
+            int result =
+            vc_dispmanx_element_change_attributes(update,
+                                                  cell->element,
+                                                  changes,
+                                                  0,
+                                                  (cell->visible) ? 255 : 0,
+                                                  &(cell->dstRect),
+                                                  &(cell->srcRect),
+                                                  0,
+                                                  DISPMANX_NO_ROTATE);
+            assert(result == 0);
+
+            ++changed;
+        }
+    }
+
+    return changed;
+}
+
+//-------------------------------------------------------------------------
+
+void
+destroyTiledLayer(
+    TILED_LAYER_T *tl)
+{
+    int result = 0;
+
+    if (tl->cells != NULL)
+    {
+        DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
+        assert(update != 0);
+
+        int32_t i;
+        for (i = 0 ; i < tl->columns * tl->rows ; i++)
+        {
+            result = vc_dispmanx_element_remove(update,
+                                                tl->cells[i].element);
+            assert(result == 0);
+        }
+
+        result = vc_dispmanx_update_submit_sync(update);
+        assert(result == 0);
+    }
+
+    //---------------------------------------------------------------------
+
+    result = vc_dispmanx_resource_delete(tl->resource);
+    assert(result == 0);
+
+    free(tl->cells);
+    tl->cells = NULL;
+    free(tl->map);
+    tl->map = NULL;
+    tl->columns = 0;
+    tl->rows = 0;
+}
+
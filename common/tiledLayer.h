@@ -0,0 +1,144 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef TILED_LAYER_H
+#define TILED_LAYER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "image.h"
+#include "imagePalette.h"
+
+#include "bcm_host.h"
+
+//-------------------------------------------------------------------------
+// A scrolling view of a tile map. The tile set is one image of equally
+// sized tiles, numbered from 0 left to right and then top to bottom, that
+// is written to a single resource. The map is an array of tile numbers,
+// one per tile, held in ordinary memory and wrapping around at its edges.
+//
+// The view is covered by a grid of elements, one more column and one more
+// row than it takes to fill it, each showing a single tile of the tile
+// set. Scrolling moves the elements, and as a column or row of tiles
+// leaves one side of the view its elements are moved to the other side
+// to show the tiles coming into view. No pixels are written after the tile
+// set, so however large the map, the only resource is the tile set. The
+// elements at the edges of the view are clipped to it.
+
+typedef struct
+{
+    int32_t tile;
+    bool visible;
+    VC_RECT_T srcRect;
+    VC_RECT_T dstRect;
+    DISPMANX_ELEMENT_HANDLE_T element;
+} TILED_LAYER_CELL_T;
+
+typedef struct
+{
+    int32_t tileWidth;
+    int32_t tileHeight;
+    int32_t tileColumns;
+    int32_t tileCount;
+    int32_t mapWidth;
+    int32_t mapHeight;
+    uint16_t *map;
+    int32_t x;
+    int32_t y;
+    VC_RECT_T viewRect;
+    int32_t columns;
+    int32_t rows;
+    TILED_LAYER_CELL_T *cells;
+    int32_t layer;
+    DISPMANX_RESOURCE_HANDLE_T resource;
+} TILED_LAYER_T;
+
+//-------------------------------------------------------------------------
+
+// Write the tile set to a resource and make a map of mapWidth by mapHeight
+// tiles, all of them tile 0. The palette may be NULL. The tile set image
+// is not kept.
+
+void
+initTiledLayer(
+    TILED_LAYER_T *tl,
+    const IMAGE_T *tileSet,
+    const IMAGE_PALETTE32_T *palette,
+    int32_t tileWidth,
+    int32_t tileHeight,
+    int32_t mapWidth,
+    int32_t mapHeight,
+    int32_t layer);
+
+void
+setTileTiledLayer(
+    TILED_LAYER_T *tl,
+    int32_t column,
+    int32_t row,
+    uint16_t tile);
+
+uint16_t
+getTileTiledLayer(
+    const TILED_LAYER_T *tl,
+    int32_t column,
+    int32_t row);
+
+// Show the layer in viewRect on the display. Every tile of the grid is an
+// element, so on a Raspberry Pi the tiles should be large compared to the
+// view.
+
+void
+addElementTiledLayer(
+    TILED_LAYER_T *tl,
+    const VC_RECT_T *viewRect,
+    DISPMANX_DISPLAY_HANDLE_T display,
+    DISPMANX_UPDATE_HANDLE_T update);
+
+// Set the point of the map, in pixels, at the top left of the view.
+
+void
+setPositionTiledLayer(
+    TILED_LAYER_T *tl,
+    int32_t x,
+    int32_t y);
+
+// Bring the elements up to date with the position and the map, changing
+// only those that are different. Returns the number of elements changed.
+
+int32_t
+updateTiledLayer(
+    TILED_LAYER_T *tl,
+    DISPMANX_UPDATE_HANDLE_T update);
+
+void destroyTiledLayer(TILED_LAYER_T *tl);
+
+//-------------------------------------------------------------------------
+
+#endif
+
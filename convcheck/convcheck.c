@@ -0,0 +1,907 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bcm_host.h"
+
+#include "image.h"
+#include "imageConvert.h"
+
+//-----------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-----------------------------------------------------------------------
+
+// Longest row checked, plus room for the start offsets and for guard
+// pixels either side of each row.
+
+#define CONVCHECK_MAX_LENGTH 1031
+#define CONVCHECK_MAX_START 8
+#define CONVCHECK_GUARD 8
+#define CONVCHECK_ROW (CONVCHECK_MAX_START \
+                       + CONVCHECK_MAX_LENGTH \
+                       + CONVCHECK_GUARD)
+#define CONVCHECK_ROWS 8
+
+#define CONVCHECK_GUARD_BYTE 0xA5
+
+//-----------------------------------------------------------------------
+
+// A row converter either packs RGBA8_T pixels into the format of an image
+// (checked against its setPixelDirect, or against setPixel if given) or
+// unpacks them from it (checked against its getPixelDirect). Unpacking to
+// RGB888 keeps only the first three bytes of each RGBA8_T.
+
+typedef enum
+{
+    CONVCHECK_PACK,
+    CONVCHECK_UNPACK
+} CONVCHECK_KIND_T;
+
+typedef struct
+{
+    const char *name;
+    const char *reference;
+    CONVCHECK_KIND_T kind;
+    VC_IMAGE_TYPE_T type;
+    int32_t bytesPerPixel;
+    int32_t rowBytesPerPixel;
+    void (*convert)(const void *src,
+                    void *dst,
+                    int32_t x,
+                    int32_t y,
+                    int32_t length);
+    void (*setPixel)(IMAGE_T*, int32_t, int32_t, const RGBA8_T*);
+} CONVCHECK_CONVERTER_T;
+
+//-----------------------------------------------------------------------
+
+// The per-pixel ordered dither as it was before the row converters, so
+// that they can be checked against it. It used to clamp blue twice rather
+// than alpha, letting RGBA16 alpha wrap around, which the row converters
+// fixed. Here alpha is clamped like the other channels.
+
+static const int16_t dither8[64] =
+{
+    1, 6, 2, 7, 1, 6, 2, 7,
+    4, 2, 5, 4, 4, 3, 6, 4,
+    1, 7, 1, 6, 2, 7, 1, 7,
+    5, 3, 5, 3, 5, 4, 5, 3,
+    1, 6, 2, 7, 1, 6, 2, 7,
+    4, 3, 6, 4, 4, 2, 6, 4,
+    2, 7, 1, 7, 2, 7, 1, 6,
+    5, 3, 5, 3, 5, 3, 5, 3,
+};
+
+static const int16_t dither4[64] =
+{
+    1, 3, 1, 3, 1, 3, 1, 3,
+    2, 1, 3, 2, 2, 1, 3, 2,
+    1, 3, 1, 3, 1, 3, 1, 3,
+    2, 2, 2, 1, 3, 2, 2, 2,
+    1, 3, 1, 3, 1, 3, 1, 3,
+    2, 1, 3, 2, 2, 1, 3, 2,
+    1, 3, 1, 3, 1, 3, 1, 3,
+    3, 2, 2, 2, 2, 2, 2, 2,
+};
+
+static const int16_t dither16[64] =
+{
+     1,  12,   4,  15,   1,  13,   4,  15,
+     8,   4,  11,   7,   9,   5,  12,   8,
+     3,  14,   2,  13,   3,  15,   2,  14,
+    10,   6,   9,   5,  11,   7,  10,   6,
+     1,  12,   4,  15,   1,  12,   4,  15,
+     9,   5,  12,   8,   8,   5,  11,   8,
+     3,  14,   2,  13,   3,  14,   2,  13,
+    11,   7,  10,   6,  10,   7,   9,   6,
+};
+
+//-----------------------------------------------------------------------
+
+static uint8_t
+clamp255(
+    int16_t value)
+{
+    return (value > 255) ? 255 : value;
+}
+
+//-----------------------------------------------------------------------
+
+// 'image' is not dithered, so its setPixelDirect is setPixelRGB565.
+
+static void
+setPixelDitheredRGB565(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgba)
+{
+    int32_t index = (x & 7) | ((y & 7) << 3);
+
+    RGBA8_T dithered =
+    {
+        clamp255(rgba->red + dither8[index]),
+        clamp255(rgba->green + dither4[index]),
+        clamp255(rgba->blue + dither8[index]),
+        rgba->alpha
+    };
+
+    image->setPixelDirect(image, x, y, &dithered);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+setPixelDitheredRGBA16(
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgba)
+{
+    int32_t index = (x & 7) | ((y & 7) << 3);
+
+    RGBA8_T dithered =
+    {
+        clamp255(rgba->red + dither16[index]),
+        clamp255(rgba->green + dither16[index]),
+        clamp255(rgba->blue + dither16[index]),
+        clamp255(rgba->alpha + dither16[index])
+    };
+
+    image->setPixelDirect(image, x, y, &dithered);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+convertRgba8ToRgb565(
+    const void *src,
+    void *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    rgba8RowToRgb565(src, dst, length);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+convertRgb565ToRgba8(
+    const void *src,
+    void *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    rgb565RowToRgba8(src, dst, length);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+convertRgb565ToRgb888(
+    const void *src,
+    void *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    rgb565RowToRgb888(src, dst, length);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+convertRgba8ToDitheredRgb565(
+    const void *src,
+    void *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    rgba8RowToDitheredRgb565(src, dst, x, y, length);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+convertRgba8ToRgba16(
+    const void *src,
+    void *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    rgba8RowToRgba16(src, dst, length);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+convertRgba8ToDitheredRgba16(
+    const void *src,
+    void *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    rgba8RowToDitheredRgba16(src, dst, x, y, length);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+convertRgba16ToRgba8(
+    const void *src,
+    void *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    rgba16RowToRgba8(src, dst, length);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+convertRgba8ToRgb888(
+    const void *src,
+    void *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    rgba8RowToRgb888(src, dst, length);
+}
+
+//-----------------------------------------------------------------------
+
+static void
+convertRgb888ToRgba8(
+    const void *src,
+    void *dst,
+    int32_t x,
+    int32_t y,
+    int32_t length)
+{
+    rgb888RowToRgba8(src, dst, length);
+}
+
+//-----------------------------------------------------------------------
+
+static const CONVCHECK_CONVERTER_T converters[] =
+{
+    {
+        "rgba8RowToRgb565",
+        "setPixelRGB565",
+        CONVCHECK_PACK,
+        VC_IMAGE_RGB565,
+        2,
+        4,
+        convertRgba8ToRgb565,
+        NULL
+    },
+    {
+        "rgb565RowToRgba8",
+        "getPixelRGB565",
+        CONVCHECK_UNPACK,
+        VC_IMAGE_RGB565,
+        2,
+        4,
+        convertRgb565ToRgba8,
+        NULL
+    },
+    {
+        "rgb565RowToRgb888",
+        "getPixelRGB565",
+        CONVCHECK_UNPACK,
+        VC_IMAGE_RGB565,
+        2,
+        3,
+        convertRgb565ToRgb888,
+        NULL
+    },
+    {
+        "rgba8RowToDitheredRgb565",
+        "setPixelDitheredRGB565",
+        CONVCHECK_PACK,
+        VC_IMAGE_RGB565,
+        2,
+        4,
+        convertRgba8ToDitheredRgb565,
+        setPixelDitheredRGB565
+    },
+    {
+        "rgba8RowToRgba16",
+        "setPixelRGBA16",
+        CONVCHECK_PACK,
+        VC_IMAGE_RGBA16,
+        2,
+        4,
+        convertRgba8ToRgba16,
+        NULL
+    },
+    {
+        "rgba8RowToDitheredRgba16",
+        "setPixelDitheredRGBA16",
+        CONVCHECK_PACK,
+        VC_IMAGE_RGBA16,
+        2,
+        4,
+        convertRgba8ToDitheredRgba16,
+        setPixelDitheredRGBA16
+    },
+    {
+        "rgba16RowToRgba8",
+        "getPixelRGBA16",
+        CONVCHECK_UNPACK,
+        VC_IMAGE_RGBA16,
+        2,
+        4,
+        convertRgba16ToRgba8,
+        NULL
+    },
+    {
+        "rgba8RowToRgb888",
+        "setPixelRGB888",
+        CONVCHECK_PACK,
+        VC_IMAGE_RGB888,
+        3,
+        4,
+        convertRgba8ToRgb888,
+        NULL
+    },
+    {
+        "rgb888RowToRgba8",
+        "getPixelRGB888",
+        CONVCHECK_UNPACK,
+        VC_IMAGE_RGB888,
+        3,
+        4,
+        convertRgb888ToRgba8,
+        NULL
+    }
+};
+
+#define CONVCHECK_CONVERTERS (sizeof(converters) / sizeof(converters[0]))
+
+//-----------------------------------------------------------------------
+
+static void *
+allocate(
+    size_t size)
+{
+    void *memory = malloc(size);
+
+    if (memory == NULL)
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    return memory;
+}
+
+//-----------------------------------------------------------------------
+
+static void
+randomBytes(
+    uint8_t *bytes,
+    size_t length)
+{
+    size_t i;
+    for (i = 0 ; i < length ; i++)
+    {
+        bytes[i] = rand() & 0xFF;
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static void
+setPixel(
+    const CONVCHECK_CONVERTER_T *converter,
+    IMAGE_T *image,
+    int32_t x,
+    int32_t y,
+    const RGBA8_T *rgba)
+{
+    if (converter->setPixel)
+    {
+        converter->setPixel(image, x, y, rgba);
+    }
+    else
+    {
+        image->setPixelDirect(image, x, y, rgba);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static double
+secondsNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + (now.tv_nsec / 1.0e9);
+}
+
+//-----------------------------------------------------------------------
+
+// The bytes of pixels 'first' to 'last' - 1 of a row, in the source or
+// destination format of the converter.
+
+static bool
+sameBytes(
+    const uint8_t *a,
+    const uint8_t *b,
+    int32_t bytesPerPixel,
+    int32_t first,
+    int32_t last)
+{
+    return memcmp(a + (first * bytesPerPixel),
+                  b + (first * bytesPerPixel),
+                  (last - first) * bytesPerPixel) == 0;
+}
+
+//-----------------------------------------------------------------------
+
+static bool
+untouched(
+    const uint8_t *bytes,
+    int32_t bytesPerPixel,
+    int32_t first,
+    int32_t last)
+{
+    int32_t i;
+    for (i = first * bytesPerPixel ; i < last * bytesPerPixel ; i++)
+    {
+        if (bytes[i] != CONVCHECK_GUARD_BYTE)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------
+
+// Convert 'length' pixels of row 'y' starting at pixel 'start' and compare
+// them with the per-pixel function. The pixels either side of the row must
+// be left alone.
+
+static bool
+checkRow(
+    const CONVCHECK_CONVERTER_T *converter,
+    IMAGE_T *image,
+    int32_t y,
+    int32_t start,
+    int32_t length)
+{
+    int32_t imageBpp = converter->bytesPerPixel;
+    int32_t rowBpp = converter->rowBytesPerPixel;
+
+    uint8_t *line = (uint8_t *)(image->buffer) + (y * image->pitch);
+
+    uint8_t rgba[CONVCHECK_ROW * sizeof(RGBA8_T)];
+    uint8_t expected[CONVCHECK_ROW * sizeof(RGBA8_T)];
+    uint8_t actual[CONVCHECK_ROW * sizeof(RGBA8_T)];
+
+    memset(expected, CONVCHECK_GUARD_BYTE, sizeof(expected));
+    memset(actual, CONVCHECK_GUARD_BYTE, sizeof(actual));
+
+    int32_t end = start + length;
+    int32_t i;
+
+    if (converter->kind == CONVCHECK_PACK)
+    {
+        randomBytes(rgba, sizeof(rgba));
+
+        memset(line, CONVCHECK_GUARD_BYTE, image->pitch);
+
+        for (i = start ; i < end ; i++)
+        {
+            setPixel(converter, image, i, y, (RGBA8_T *)rgba + i);
+        }
+
+        memcpy(expected, line, CONVCHECK_ROW * imageBpp);
+
+        converter->convert((RGBA8_T *)rgba + start,
+                           actual + (start * imageBpp),
+                           start,
+                           y,
+                           length);
+
+        rowBpp = imageBpp;
+    }
+    else
+    {
+        randomBytes(line, image->pitch);
+
+        for (i = start ; i < end ; i++)
+        {
+            image->getPixelDirect(image, i, y, (RGBA8_T *)rgba);
+            memcpy(expected + (i * rowBpp), rgba, rowBpp);
+        }
+
+        converter->convert(line + (start * imageBpp),
+                           actual + (start * rowBpp),
+                           start,
+                           y,
+                           length);
+    }
+
+    return sameBytes(expected, actual, rowBpp, start, end) &&
+           untouched(actual, rowBpp, 0, start) &&
+           untouched(actual, rowBpp, end, CONVCHECK_ROW);
+}
+
+//-----------------------------------------------------------------------
+
+// Every row length up to 64 and some longer odd ones, from each start
+// offset in the first eight pixels, on each of the eight rows (which only
+// matter to the dithered converters).
+
+static const int32_t longLengths[] = { 67, 99, 127, 255, 257, 1031 };
+
+#define CONVCHECK_LONG_LENGTHS (sizeof(longLengths) / sizeof(longLengths[0]))
+
+static bool
+checkConverter(
+    const CONVCHECK_CONVERTER_T *converter)
+{
+    IMAGE_T image;
+
+    if (initImage(&image,
+                  converter->type,
+                  CONVCHECK_ROW,
+                  CONVCHECK_ROWS,
+                  false) == false)
+    {
+        fprintf(stderr, "%s: unable to initialize image\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    int32_t lengths = 65 + CONVCHECK_LONG_LENGTHS;
+    int32_t rows = 0;
+    bool result = true;
+
+    int32_t y;
+    for (y = 0 ; (y < CONVCHECK_ROWS) && result ; y++)
+    {
+        int32_t start;
+        for (start = 0 ; (start < CONVCHECK_MAX_START) && result ; start++)
+        {
+            int32_t l;
+            for (l = 0 ; (l < lengths) && result ; l++)
+            {
+                int32_t length = (l < 65)
+                               ? l
+                               : longLengths[l - 65];
+
+                result = checkRow(converter, &image, y, start, length);
+                ++rows;
+
+                if (result == false)
+                {
+                    fprintf(stderr,
+                            "%s: %s differs from %s for %d pixels"
+                            " from (%d, %d)\n",
+                            program,
+                            converter->name,
+                            converter->reference,
+                            length,
+                            start,
+                            y);
+                }
+            }
+        }
+    }
+
+    destroyImage(&image);
+
+    if (result)
+    {
+        printf("%-28s matches %-24s %6d rows\n",
+               converter->name,
+               converter->reference,
+               rows);
+    }
+
+    return result;
+}
+
+//-----------------------------------------------------------------------
+
+// Time converting a whole frame a row at a time and a pixel at a time,
+// taking the best of 'repeats' runs of each, and check that both give the
+// same frame.
+
+static void
+timeConverter(
+    const CONVCHECK_CONVERTER_T *converter,
+    int32_t width,
+    int32_t height,
+    int32_t repeats)
+{
+    IMAGE_T rowImage;
+    IMAGE_T pixelImage;
+
+    if ((initImage(&rowImage, converter->type, width, height, false) ==
+         false) ||
+        (initImage(&pixelImage, converter->type, width, height, false) ==
+         false))
+    {
+        fprintf(stderr, "%s: unable to initialize image\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t rgbaBytes = (size_t)width * height * sizeof(RGBA8_T);
+    int32_t rowBpp = converter->rowBytesPerPixel;
+
+    uint8_t *rowPixels = allocate(rgbaBytes);
+    uint8_t *pixelPixels = allocate(rgbaBytes);
+
+    memset(rowPixels, 0, rgbaBytes);
+    memset(pixelPixels, 0, rgbaBytes);
+
+    if (converter->kind == CONVCHECK_PACK)
+    {
+        randomBytes(rowPixels, rgbaBytes);
+        memcpy(pixelPixels, rowPixels, rgbaBytes);
+    }
+    else
+    {
+        randomBytes(rowImage.buffer, rowImage.size);
+        memcpy(pixelImage.buffer, rowImage.buffer, rowImage.size);
+    }
+
+    double bestRow = 0.0;
+    double bestPixel = 0.0;
+
+    int32_t r;
+    for (r = 0 ; r < repeats ; r++)
+    {
+        double start = secondsNow();
+
+        int32_t j;
+        for (j = 0 ; j < height ; j++)
+        {
+            uint8_t *line = (uint8_t *)(rowImage.buffer)
+                          + (j * rowImage.pitch);
+            uint8_t *pixels = rowPixels + ((size_t)j * width * rowBpp);
+
+            if (converter->kind == CONVCHECK_PACK)
+            {
+                converter->convert(pixels, line, 0, j, width);
+            }
+            else
+            {
+                converter->convert(line, pixels, 0, j, width);
+            }
+        }
+
+        double seconds = secondsNow() - start;
+
+        if ((r == 0) || (seconds < bestRow))
+        {
+            bestRow = seconds;
+        }
+
+        start = secondsNow();
+
+        for (j = 0 ; j < height ; j++)
+        {
+            RGBA8_T *pixels = (RGBA8_T *)pixelPixels + ((size_t)j * width);
+            RGBA8_T rgba;
+
+            int32_t i;
+            for (i = 0 ; i < width ; i++)
+            {
+                if (converter->kind == CONVCHECK_PACK)
+                {
+                    setPixel(converter, &pixelImage, i, j, pixels + i);
+                }
+                else
+                {
+                    pixelImage.getPixelDirect(&pixelImage, i, j, &rgba);
+                    memcpy(pixelPixels + ((((size_t)j * width) + i) * rowBpp),
+                           &rgba,
+                           rowBpp);
+                }
+            }
+        }
+
+        seconds = secondsNow() - start;
+
+        if ((r == 0) || (seconds < bestPixel))
+        {
+            bestPixel = seconds;
+        }
+    }
+
+    bool same = (memcmp(rowImage.buffer, pixelImage.buffer, rowImage.size)
+                 == 0) &&
+                (memcmp(rowPixels, pixelPixels, rgbaBytes) == 0);
+
+    printf("%-28s %9.2f %9.1f %9.2f %9.1f %7.1fx%s\n",
+           converter->name,
+           bestPixel * 1000.0,
+           rgbaBytes / bestPixel / 1.0e6,
+           bestRow * 1000.0,
+           rgbaBytes / bestRow / 1.0e6,
+           bestPixel / bestRow,
+           (same) ? "" : " differs");
+
+    if (same == false)
+    {
+        fprintf(stderr,
+                "%s: %s and %s give different frames\n",
+                program,
+                converter->name,
+                converter->reference);
+        exit(EXIT_FAILURE);
+    }
+
+    free(rowPixels);
+    free(pixelPixels);
+
+    destroyImage(&rowImage);
+    destroyImage(&pixelImage);
+}
+
+//-----------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s ", program);
+    fprintf(stderr, "[-c] [-r <number>] [-s <seed>] [-w <width>x<height>]\n");
+    fprintf(stderr, "    -c - check the converters only, no timing\n");
+    fprintf(stderr, "    -r - times to convert each frame (default 5)\n");
+    fprintf(stderr, "    -s - seed for the random pixels (default 1)\n");
+    fprintf(stderr, "    -w - size of the frame timed (default 1920x1080)\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-----------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    bool checkOnly = false;
+    int32_t repeats = 5;
+    unsigned int seed = 1;
+    int32_t width = 1920;
+    int32_t height = 1080;
+
+    program = basename(argv[0]);
+
+    //-------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "cr:s:w:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'c':
+
+            checkOnly = true;
+            break;
+
+        case 'r':
+
+            repeats = strtol(optarg, NULL, 10);
+            break;
+
+        case 's':
+
+            seed = strtoul(optarg, NULL, 10);
+            break;
+
+        case 'w':
+
+            if (sscanf(optarg, "%dx%d", &width, &height) != 2)
+            {
+                usage();
+            }
+
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    if ((repeats < 1) || (width < 1) || (height < 1))
+    {
+        usage();
+    }
+
+    //-------------------------------------------------------------------
+
+    srand(seed);
+
+    printf("%s: converters built for %s\n\n", program, imageConvertPath());
+
+    bool result = true;
+
+    size_t c;
+    for (c = 0 ; c < CONVCHECK_CONVERTERS ; c++)
+    {
+        if (checkConverter(&(converters[c])) == false)
+        {
+            result = false;
+        }
+    }
+
+    if (result == false)
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    if (checkOnly)
+    {
+        return 0;
+    }
+
+    printf("\n%dx%d frame, best of %d, MB/s of RGBA8_T pixels\n\n",
+           width,
+           height,
+           repeats);
+    printf("%-28s %9s %9s %9s %9s %8s\n",
+           "",
+           "pixel ms",
+           "MB/s",
+           "row ms",
+           "MB/s",
+           "speedup");
+
+    for (c = 0 ; c < CONVCHECK_CONVERTERS ; c++)
+    {
+        timeConverter(&(converters[c]), width, height, repeats);
+    }
+
+    return 0;
+}
+
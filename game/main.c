@@ -37,8 +37,8 @@
 #include "backgroundLayer.h"
 #include "element_change.h"
 #include "image.h"
+#include "imageFile.h"
 #include "imageLayer.h"
-#include "loadpng.h"
 #include "key.h"
 #include "scrollingLayer.h"
 #include "spriteLayer.h"
@@ -51,6 +51,27 @@
 
 //-------------------------------------------------------------------------
 
+// Each image is loaded from a mapped image file (see png2dmx) if there is
+// one, otherwise from the PNG.
+
+static const char *
+assetPath(
+    const char *name,
+    char *path,
+    size_t size)
+{
+    snprintf(path, size, "%s.dmx", name);
+
+    if (access(path, R_OK) != 0)
+    {
+        snprintf(path, size, "%s.png", name);
+    }
+
+    return path;
+}
+
+//-------------------------------------------------------------------------
+
 int main(int argc, char *argv[])
 {
     uint32_t displayNumber = 0;
@@ -86,12 +107,16 @@ int main(int argc, char *argv[])
     BACKGROUND_LAYER_T bg;
     initBackgroundLayer(&bg, 0x000F, 0);
 
+    char path[64];
+
     SCROLLING_LAYER_T sl;
-    initScrollingLayer(&sl, "texture.png", 1);
+    initScrollingLayer(&sl, assetPath("texture", path, sizeof(path)), 1);
 
     IMAGE_LAYER_T spotlight;
 
-    if (loadPng(&(spotlight.image), "spotlight.png") == false)
+    if (loadImage(&(spotlight.image),
+                  &(spotlight.palette),
+                  assetPath("spotlight", path, sizeof(path))) == false)
     {
         fprintf(stderr, "unable to load spotlight\n");
         exit(EXIT_FAILURE);
@@ -100,7 +125,11 @@ int main(int argc, char *argv[])
     createResourceImageLayer(&spotlight, 2);
 
     SPRITE_LAYER_T sprite;
-    initSpriteLayer(&sprite, 12, 1, "sprite.png", 3);
+    initSpriteLayer(&sprite,
+                    12,
+                    1,
+                    assetPath("sprite", path, sizeof(path)),
+                    3);
 
     //---------------------------------------------------------------------
 
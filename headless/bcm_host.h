@@ -0,0 +1,295 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+// A software stand in for the part of bcm_host.h and vc_dispmanx.h used
+// by these programs. Build against this directory instead of /opt/vc to
+// run the programs on a Linux machine that is not a Raspberry Pi. The
+// values of the constants match the Raspberry Pi firmware headers.
+//
+//-------------------------------------------------------------------------
+
+#ifndef BCM_HOST_H
+#define BCM_HOST_H
+
+// The firmware headers pull these in through vcos, and some of the
+// programs rely on that.
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//-------------------------------------------------------------------------
+
+typedef enum
+{
+    VC_IMAGE_MIN = 0,
+    VC_IMAGE_RGB565 = 1,
+    VC_IMAGE_1BPP,
+    VC_IMAGE_YUV420,
+    VC_IMAGE_48BPP,
+    VC_IMAGE_RGB888,
+    VC_IMAGE_8BPP,
+    VC_IMAGE_4BPP,
+    VC_IMAGE_3D32,
+    VC_IMAGE_3D32B,
+    VC_IMAGE_3D32MAT,
+    VC_IMAGE_RGB2X9,
+    VC_IMAGE_RGB666,
+    VC_IMAGE_PAL4_OBSOLETE,
+    VC_IMAGE_PAL8_OBSOLETE,
+    VC_IMAGE_RGBA32,
+    VC_IMAGE_YUV422,
+    VC_IMAGE_RGBA565,
+    VC_IMAGE_RGBA16,
+    VC_IMAGE_MAX
+} VC_IMAGE_TYPE_T;
+
+//-------------------------------------------------------------------------
+
+typedef uint32_t DISPMANX_DISPLAY_HANDLE_T;
+typedef uint32_t DISPMANX_UPDATE_HANDLE_T;
+typedef uint32_t DISPMANX_ELEMENT_HANDLE_T;
+typedef uint32_t DISPMANX_RESOURCE_HANDLE_T;
+
+typedef uint32_t DISPMANX_PROTECTION_T;
+
+#define DISPMANX_NO_HANDLE 0
+
+#define DISPMANX_PROTECTION_MAX 0x0f
+#define DISPMANX_PROTECTION_NONE 0
+#define DISPMANX_PROTECTION_HDCP 11
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+} VC_RECT_T;
+
+//-------------------------------------------------------------------------
+
+typedef enum
+{
+    DISPMANX_NO_ROTATE = 0,
+    DISPMANX_ROTATE_90 = 1,
+    DISPMANX_ROTATE_180 = 2,
+    DISPMANX_ROTATE_270 = 3,
+
+    DISPMANX_FLIP_HRIZ = 1 << 16,
+    DISPMANX_FLIP_VERT = 1 << 17
+} DISPMANX_TRANSFORM_T;
+
+//-------------------------------------------------------------------------
+
+typedef enum
+{
+    DISPMANX_FLAGS_ALPHA_FROM_SOURCE = 0,
+    DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS = 1,
+    DISPMANX_FLAGS_ALPHA_FIXED_NON_ZERO = 2,
+    DISPMANX_FLAGS_ALPHA_FIXED_EXCEED_0X07 = 3,
+
+    DISPMANX_FLAGS_ALPHA_PREMULT = 1 << 16,
+    DISPMANX_FLAGS_ALPHA_MIX = 1 << 17
+} DISPMANX_FLAGS_ALPHA_T;
+
+typedef struct
+{
+    DISPMANX_FLAGS_ALPHA_T flags;
+    uint32_t opacity;
+    DISPMANX_RESOURCE_HANDLE_T mask;
+} VC_DISPMANX_ALPHA_T;
+
+//-------------------------------------------------------------------------
+
+typedef struct DISPMANX_CLAMP_T DISPMANX_CLAMP_T;
+
+//-------------------------------------------------------------------------
+
+typedef enum
+{
+    VCOS_DISPLAY_INPUT_FORMAT_INVALID = 0,
+    VCOS_DISPLAY_INPUT_FORMAT_RGB888,
+    VCOS_DISPLAY_INPUT_FORMAT_RGB565
+} DISPLAY_INPUT_FORMAT_T;
+
+typedef struct
+{
+    int32_t width;
+    int32_t height;
+    DISPMANX_TRANSFORM_T transform;
+    DISPLAY_INPUT_FORMAT_T input_format;
+    uint32_t display_num;
+} DISPMANX_MODEINFO_T;
+
+//-------------------------------------------------------------------------
+
+#define ELEMENT_CHANGE_LAYER (1<<0)
+#define ELEMENT_CHANGE_OPACITY (1<<1)
+#define ELEMENT_CHANGE_DEST_RECT (1<<2)
+#define ELEMENT_CHANGE_SRC_RECT (1<<3)
+#define ELEMENT_CHANGE_MASK_RESOURCE (1<<4)
+#define ELEMENT_CHANGE_TRANSFORM (1<<5)
+
+//-------------------------------------------------------------------------
+
+void
+bcm_host_init(void);
+
+void
+bcm_host_deinit(void);
+
+int32_t
+graphics_get_display_size(
+    const uint16_t display_number,
+    uint32_t *width,
+    uint32_t *height);
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_rect_set(
+    VC_RECT_T *rect,
+    uint32_t x_offset,
+    uint32_t y_offset,
+    uint32_t width,
+    uint32_t height);
+
+//-------------------------------------------------------------------------
+
+DISPMANX_RESOURCE_HANDLE_T
+vc_dispmanx_resource_create(
+    VC_IMAGE_TYPE_T type,
+    uint32_t width,
+    uint32_t height,
+    uint32_t *native_image_handle);
+
+int
+vc_dispmanx_resource_write_data(
+    DISPMANX_RESOURCE_HANDLE_T handle,
+    VC_IMAGE_TYPE_T src_type,
+    int src_pitch,
+    void *src_address,
+    const VC_RECT_T *rect);
+
+int
+vc_dispmanx_resource_read_data(
+    DISPMANX_RESOURCE_HANDLE_T handle,
+    const VC_RECT_T *p_rect,
+    void *dst_address,
+    uint32_t dst_pitch);
+
+int
+vc_dispmanx_resource_set_palette(
+    DISPMANX_RESOURCE_HANDLE_T handle,
+    void *src_address,
+    int offset,
+    int size);
+
+int
+vc_dispmanx_resource_delete(
+    DISPMANX_RESOURCE_HANDLE_T res);
+
+//-------------------------------------------------------------------------
+
+DISPMANX_DISPLAY_HANDLE_T
+vc_dispmanx_display_open(
+    uint32_t device);
+
+DISPMANX_DISPLAY_HANDLE_T
+vc_dispmanx_display_open_offscreen(
+    DISPMANX_RESOURCE_HANDLE_T dest,
+    DISPMANX_TRANSFORM_T orientation);
+
+int
+vc_dispmanx_display_get_info(
+    DISPMANX_DISPLAY_HANDLE_T display,
+    DISPMANX_MODEINFO_T *pinfo);
+
+int
+vc_dispmanx_display_close(
+    DISPMANX_DISPLAY_HANDLE_T display);
+
+//-------------------------------------------------------------------------
+
+DISPMANX_UPDATE_HANDLE_T
+vc_dispmanx_update_start(
+    int32_t priority);
+
+int
+vc_dispmanx_update_submit_sync(
+    DISPMANX_UPDATE_HANDLE_T update);
+
+//-------------------------------------------------------------------------
+
+DISPMANX_ELEMENT_HANDLE_T
+vc_dispmanx_element_add(
+    DISPMANX_UPDATE_HANDLE_T update,
+    DISPMANX_DISPLAY_HANDLE_T display,
+    int32_t layer,
+    const VC_RECT_T *dest_rect,
+    DISPMANX_RESOURCE_HANDLE_T src,
+    const VC_RECT_T *src_rect,
+    DISPMANX_PROTECTION_T protection,
+    VC_DISPMANX_ALPHA_T *alpha,
+    DISPMANX_CLAMP_T *clamp,
+    DISPMANX_TRANSFORM_T transform);
+
+int
+vc_dispmanx_element_change_source(
+    DISPMANX_UPDATE_HANDLE_T update,
+    DISPMANX_ELEMENT_HANDLE_T element,
+    DISPMANX_RESOURCE_HANDLE_T src);
+
+int
+vc_dispmanx_element_change_attributes(
+    DISPMANX_UPDATE_HANDLE_T update,
+    DISPMANX_ELEMENT_HANDLE_T element,
+    uint32_t change_flags,
+    int32_t layer,
+    uint8_t opacity,
+    const VC_RECT_T *dest_rect,
+    const VC_RECT_T *src_rect,
+    DISPMANX_RESOURCE_HANDLE_T mask,
+    DISPMANX_TRANSFORM_T transform);
+
+int
+vc_dispmanx_element_remove(
+    DISPMANX_UPDATE_HANDLE_T update,
+    DISPMANX_ELEMENT_HANDLE_T element);
+
+//-------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,1642 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+// Software DispmanX. Resources live in ordinary memory and the elements of
+// a display are composited into an RGBA framebuffer. Changes to elements
+// take effect straight away rather than when the update is submitted,
+// which none of the programs can tell apart. Offscreen displays are
+// composited into their resource when an update is submitted, other
+// displays only when their pixels are asked for.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "bcm_host.h"
+#include "headless.h"
+#include "headlessPng.h"
+
+//-------------------------------------------------------------------------
+
+#define HEADLESS_MAX_RESOURCES 1024
+#define HEADLESS_MAX_ELEMENTS 4096
+#define HEADLESS_MAX_DISPLAYS 8
+
+#define HEADLESS_DEFAULT_WIDTH 1920
+#define HEADLESS_DEFAULT_HEIGHT 1080
+
+// Enough for 256 entries of 32 bits
+
+#define HEADLESS_PALETTE_BYTES 1024
+
+#ifndef ALIGN_TO_16
+#define ALIGN_TO_16(x)  ((x + 15) & ~15)
+#endif
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    bool used;
+    VC_IMAGE_TYPE_T type;
+    int32_t width;
+    int32_t height;
+    int32_t pitch;
+    uint8_t *buffer;
+    uint8_t palette[HEADLESS_PALETTE_BYTES];
+    int32_t paletteEnd;
+} HEADLESS_RESOURCE_T;
+
+typedef struct
+{
+    bool used;
+    uint32_t device;
+    int32_t width;
+    int32_t height;
+    DISPMANX_RESOURCE_HANDLE_T resource;
+    uint8_t *rgba;
+} HEADLESS_DISPLAY_T;
+
+typedef struct
+{
+    bool used;
+    uint32_t order;
+    DISPMANX_DISPLAY_HANDLE_T display;
+    int32_t layer;
+    VC_RECT_T destRect;
+    VC_RECT_T srcRect;
+    DISPMANX_RESOURCE_HANDLE_T resource;
+    VC_DISPMANX_ALPHA_T alpha;
+    DISPMANX_TRANSFORM_T transform;
+} HEADLESS_ELEMENT_T;
+
+//-------------------------------------------------------------------------
+
+static HEADLESS_RESOURCE_T resources[HEADLESS_MAX_RESOURCES];
+static HEADLESS_DISPLAY_T displays[HEADLESS_MAX_DISPLAYS];
+static HEADLESS_ELEMENT_T elements[HEADLESS_MAX_ELEMENTS];
+
+static pthread_mutex_t headlessMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t headlessOnce = PTHREAD_ONCE_INIT;
+
+static int32_t screenWidth = HEADLESS_DEFAULT_WIDTH;
+static int32_t screenHeight = HEADLESS_DEFAULT_HEIGHT;
+
+static uint32_t elementOrder = 0;
+static uint32_t updatesStarted = 0;
+static uint32_t updatesSubmitted = 0;
+static uint32_t updateLimit = 0;
+static uint32_t secondsLimit = 0;
+static const char *pngFile = NULL;
+static HEADLESS_CALLS_T callCounts;
+
+static bool terminalSaved = false;
+static struct termios terminal;
+
+// time between submitted updates
+
+static struct timeval lastSubmit;
+static double minimumMilliseconds = 0.0;
+static double maximumMilliseconds = 0.0;
+static double totalMilliseconds = 0.0;
+
+static void finishHeadless(void);
+
+//-------------------------------------------------------------------------
+
+static void *
+secondsLimitThread(
+    void *arg)
+{
+    sleep(secondsLimit);
+
+    pthread_mutex_lock(&headlessMutex);
+    finishHeadless();
+
+    return NULL;
+}
+
+//-------------------------------------------------------------------------
+
+static void
+initHeadless(void)
+{
+    const char *size = getenv("RASPIDMX_HEADLESS_SIZE");
+
+    if (size != NULL)
+    {
+        int width = 0;
+        int height = 0;
+
+        if ((sscanf(size, "%dx%d", &width, &height) == 2) &&
+            (width > 0) &&
+            (height > 0))
+        {
+            screenWidth = width;
+            screenHeight = height;
+        }
+        else
+        {
+            fprintf(stderr,
+                    "headless: ignoring RASPIDMX_HEADLESS_SIZE=%s\n",
+                    size);
+        }
+    }
+
+    const char *updates = getenv("RASPIDMX_HEADLESS_UPDATES");
+
+    if (updates != NULL)
+    {
+        updateLimit = strtoul(updates, NULL, 10);
+    }
+
+    const char *seconds = getenv("RASPIDMX_HEADLESS_SECONDS");
+
+    if (seconds != NULL)
+    {
+        secondsLimit = strtoul(seconds, NULL, 10);
+    }
+
+    if (secondsLimit > 0)
+    {
+        pthread_t thread;
+
+        if (pthread_create(&thread, NULL, secondsLimitThread, NULL) == 0)
+        {
+            pthread_detach(thread);
+        }
+    }
+
+    pngFile = getenv("RASPIDMX_HEADLESS_PNG");
+
+    // The programs put the terminal into non canonical mode and would
+    // normally restore it as they exit. Remember it, so that it can be put
+    // back when the update limit ends a program.
+
+    if (isatty(STDIN_FILENO) && (tcgetattr(STDIN_FILENO, &terminal) == 0))
+    {
+        terminalSaved = true;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+lockHeadless(void)
+{
+    pthread_once(&headlessOnce, initHeadless);
+    pthread_mutex_lock(&headlessMutex);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+unlockHeadless(void)
+{
+    pthread_mutex_unlock(&headlessMutex);
+}
+
+//-------------------------------------------------------------------------
+
+static HEADLESS_RESOURCE_T *
+findResource(
+    DISPMANX_RESOURCE_HANDLE_T handle)
+{
+    if ((handle == 0) ||
+        (handle > HEADLESS_MAX_RESOURCES) ||
+        (resources[handle - 1].used == false))
+    {
+        return NULL;
+    }
+
+    return &(resources[handle - 1]);
+}
+
+//-------------------------------------------------------------------------
+
+static HEADLESS_DISPLAY_T *
+findDisplay(
+    DISPMANX_DISPLAY_HANDLE_T handle)
+{
+    if ((handle == 0) ||
+        (handle > HEADLESS_MAX_DISPLAYS) ||
+        (displays[handle - 1].used == false))
+    {
+        return NULL;
+    }
+
+    return &(displays[handle - 1]);
+}
+
+//-------------------------------------------------------------------------
+
+static HEADLESS_ELEMENT_T *
+findElement(
+    DISPMANX_ELEMENT_HANDLE_T handle)
+{
+    if ((handle == 0) ||
+        (handle > HEADLESS_MAX_ELEMENTS) ||
+        (elements[handle - 1].used == false))
+    {
+        return NULL;
+    }
+
+    return &(elements[handle - 1]);
+}
+
+//-------------------------------------------------------------------------
+
+static int32_t
+bitsPerPixel(
+    VC_IMAGE_TYPE_T type)
+{
+    switch (type)
+    {
+    case VC_IMAGE_4BPP:
+
+        return 4;
+
+    case VC_IMAGE_8BPP:
+
+        return 8;
+
+    case VC_IMAGE_RGB565:
+    case VC_IMAGE_RGBA16:
+
+        return 16;
+
+    case VC_IMAGE_RGB888:
+
+        return 24;
+
+    case VC_IMAGE_RGBA32:
+
+        return 32;
+
+    default:
+
+        return 0;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// The palette calls don't say how big an entry is. A palette that has
+// been written past the end of a 16 bit palette (allowing for the programs
+// that start at entry one) is taken to have 32 bit ARGB entries, otherwise
+// the entries are RGB565. Without a palette, 8BPP images use an RGB332
+// palette and 4BPP images a grey scale.
+
+static void
+paletteEntryToRgba(
+    const HEADLESS_RESOURCE_T *resource,
+    uint8_t index,
+    uint8_t *rgba)
+{
+    int32_t entries = (resource->type == VC_IMAGE_4BPP) ? 16 : 256;
+
+    if (resource->paletteEnd == 0)
+    {
+        if (entries == 16)
+        {
+            rgba[0] = rgba[1] = rgba[2] = index * 17;
+        }
+        else
+        {
+            rgba[0] = ((index >> 5) * 255) / 7;
+            rgba[1] = (((index >> 2) & 0x07) * 255) / 7;
+            rgba[2] = ((index & 0x03) * 255) / 3;
+        }
+
+        rgba[3] = 255;
+    }
+    else if (resource->paletteEnd > (2 * (entries + 1)))
+    {
+        uint32_t entry = 0;
+        memcpy(&entry, resource->palette + (4 * index), sizeof(entry));
+
+        rgba[0] = (entry >> 16) & 0xFF;
+        rgba[1] = (entry >> 8) & 0xFF;
+        rgba[2] = entry & 0xFF;
+        rgba[3] = (entry >> 24) & 0xFF;
+    }
+    else
+    {
+        uint16_t entry = 0;
+        memcpy(&entry, resource->palette + (2 * index), sizeof(entry));
+
+        uint8_t r5 = (entry >> 11) & 0x1F;
+        uint8_t g6 = (entry >> 5) & 0x3F;
+        uint8_t b5 = entry & 0x1F;
+
+        rgba[0] = (r5 << 3) | (r5 >> 2);
+        rgba[1] = (g6 << 2) | (g6 >> 4);
+        rgba[2] = (b5 << 3) | (b5 >> 2);
+        rgba[3] = 255;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+resourceRowToRgba(
+    const HEADLESS_RESOURCE_T *resource,
+    int32_t y,
+    uint8_t *rgba)
+{
+    const uint8_t *line = resource->buffer + (y * resource->pitch);
+
+    int32_t x;
+    for (x = 0 ; x < resource->width ; x++, rgba += 4)
+    {
+        switch (resource->type)
+        {
+        case VC_IMAGE_4BPP:
+        {
+            uint8_t index = (x % 2) ? (line[x / 2] & 0x0F)
+                                    : (line[x / 2] >> 4);
+            paletteEntryToRgba(resource, index, rgba);
+
+            break;
+        }
+        case VC_IMAGE_8BPP:
+
+            paletteEntryToRgba(resource, line[x], rgba);
+
+            break;
+
+        case VC_IMAGE_RGB565:
+        {
+            uint16_t pixel = ((const uint16_t *)line)[x];
+
+            uint8_t r5 = (pixel >> 11) & 0x1F;
+            uint8_t g6 = (pixel >> 5) & 0x3F;
+            uint8_t b5 = pixel & 0x1F;
+
+            rgba[0] = (r5 << 3) | (r5 >> 2);
+            rgba[1] = (g6 << 2) | (g6 >> 4);
+            rgba[2] = (b5 << 3) | (b5 >> 2);
+            rgba[3] = 255;
+
+            break;
+        }
+        case VC_IMAGE_RGBA16:
+        {
+            uint16_t pixel = ((const uint16_t *)line)[x];
+
+            rgba[0] = ((pixel >> 12) & 0xF) * 17;
+            rgba[1] = ((pixel >> 8) & 0xF) * 17;
+            rgba[2] = ((pixel >> 4) & 0xF) * 17;
+            rgba[3] = (pixel & 0xF) * 17;
+
+            break;
+        }
+        case VC_IMAGE_RGB888:
+
+            rgba[0] = line[(3 * x)];
+            rgba[1] = line[(3 * x) + 1];
+            rgba[2] = line[(3 * x) + 2];
+            rgba[3] = 255;
+
+            break;
+
+        case VC_IMAGE_RGBA32:
+
+            memcpy(rgba, line + (4 * x), 4);
+
+            break;
+
+        default:
+
+            memset(rgba, 0, 4);
+
+            break;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+rgbaToResourceRow(
+    HEADLESS_RESOURCE_T *resource,
+    int32_t y,
+    const uint8_t *rgba)
+{
+    uint8_t *line = resource->buffer + (y * resource->pitch);
+
+    int32_t x;
+    for (x = 0 ; x < resource->width ; x++, rgba += 4)
+    {
+        switch (resource->type)
+        {
+        case VC_IMAGE_RGB565:
+
+            ((uint16_t *)line)[x] = ((rgba[0] >> 3) << 11) |
+                                    ((rgba[1] >> 2) << 5) |
+                                    (rgba[2] >> 3);
+
+            break;
+
+        case VC_IMAGE_RGBA16:
+
+            ((uint16_t *)line)[x] = ((rgba[0] >> 4) << 12) |
+                                    ((rgba[1] >> 4) << 8) |
+                                    ((rgba[2] >> 4) << 4) |
+                                    (rgba[3] >> 4);
+
+            break;
+
+        case VC_IMAGE_RGB888:
+
+            memcpy(line + (3 * x), rgba, 3);
+
+            break;
+
+        case VC_IMAGE_RGBA32:
+
+            memcpy(line + (4 * x), rgba, 4);
+
+            break;
+
+        default:
+
+            // compositing into an indexed image isn't supported
+
+            return;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+blendElementRow(
+    const HEADLESS_ELEMENT_T *element,
+    const uint8_t *src,
+    const int32_t *columns,
+    int32_t length,
+    uint8_t *dst)
+{
+    uint32_t flags = element->alpha.flags;
+    uint32_t mode = flags & 0xFFFF;
+    uint32_t opacity = (element->alpha.opacity > 255)
+                     ? 255
+                     : element->alpha.opacity;
+    bool premultiplied = (flags & DISPMANX_FLAGS_ALPHA_PREMULT) != 0;
+    bool mix = (flags & DISPMANX_FLAGS_ALPHA_MIX) != 0;
+
+    int32_t i;
+    for (i = 0 ; i < length ; i++, dst += 4)
+    {
+        const uint8_t *pixel = src + (4 * columns[i]);
+        uint32_t alpha = pixel[3];
+
+        switch (mode)
+        {
+        case DISPMANX_FLAGS_ALPHA_FIXED_ALL_PIXELS:
+
+            alpha = opacity;
+
+            break;
+
+        case DISPMANX_FLAGS_ALPHA_FIXED_NON_ZERO:
+
+            alpha = (alpha != 0) ? opacity : 0;
+
+            break;
+
+        case DISPMANX_FLAGS_ALPHA_FIXED_EXCEED_0X07:
+
+            alpha = (alpha > 0x07) ? opacity : 0;
+
+            break;
+
+        default:
+
+            if (mix)
+            {
+                alpha = (alpha * opacity) / 255;
+            }
+
+            break;
+        }
+
+        uint32_t inverse = 255 - alpha;
+
+        int32_t c;
+        for (c = 0 ; c < 3 ; c++)
+        {
+            uint32_t colour = (premultiplied)
+                            ? (pixel[c] * 255)
+                            : (pixel[c] * alpha);
+
+            dst[c] = (colour + (dst[c] * inverse) + 127) / 255;
+        }
+
+        dst[3] = alpha + ((dst[3] * inverse) + 127) / 255;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+compositeElement(
+    const HEADLESS_ELEMENT_T *element,
+    uint8_t *rgba,
+    int32_t width,
+    int32_t height)
+{
+    const HEADLESS_RESOURCE_T *resource = findResource(element->resource);
+
+    if (resource == NULL)
+    {
+        return;
+    }
+
+    // An element with no opacity, where opacity applies, shows nothing.
+
+    uint32_t mode = element->alpha.flags & 0xFFFF;
+
+    if ((element->alpha.opacity == 0) &&
+        ((mode != DISPMANX_FLAGS_ALPHA_FROM_SOURCE) ||
+         (element->alpha.flags & DISPMANX_FLAGS_ALPHA_MIX)))
+    {
+        return;
+    }
+
+    const VC_RECT_T *dest = &(element->destRect);
+    const VC_RECT_T *src = &(element->srcRect);
+
+    if ((dest->width <= 0) ||
+        (dest->height <= 0) ||
+        (src->width <= 0) ||
+        (src->height <= 0))
+    {
+        return;
+    }
+
+    int32_t left = (dest->x < 0) ? 0 : dest->x;
+    int32_t top = (dest->y < 0) ? 0 : dest->y;
+    int32_t right = dest->x + dest->width;
+    int32_t bottom = dest->y + dest->height;
+
+    if (right > width)
+    {
+        right = width;
+    }
+
+    if (bottom > height)
+    {
+        bottom = height;
+    }
+
+    if ((left >= right) || (top >= bottom))
+    {
+        return;
+    }
+
+    bool flipX = (element->transform & DISPMANX_FLIP_HRIZ) != 0;
+    bool flipY = (element->transform & DISPMANX_FLIP_VERT) != 0;
+
+    if ((element->transform & 0x3) == DISPMANX_ROTATE_180)
+    {
+        flipX = !flipX;
+        flipY = !flipY;
+    }
+
+    //---------------------------------------------------------------------
+
+    // Nearest neighbour scaling. The source rectangle is 16.16 fixed
+    // point, sample the centre of each destination pixel.
+
+    int32_t length = right - left;
+    int32_t *columns = malloc(length * sizeof(int32_t));
+    uint8_t *row = malloc(4 * resource->width);
+
+    if ((columns == NULL) || (row == NULL))
+    {
+        fprintf(stderr, "headless: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int32_t i;
+    for (i = 0 ; i < length ; i++)
+    {
+        int64_t u = left + i - dest->x;
+
+        if (flipX)
+        {
+            u = dest->width - 1 - u;
+        }
+
+        int64_t x = (src->x + ((2 * u + 1) * src->width) / (2 * dest->width))
+                  >> 16;
+
+        if (x < 0)
+        {
+            x = 0;
+        }
+        else if (x >= resource->width)
+        {
+            x = resource->width - 1;
+        }
+
+        columns[i] = x;
+    }
+
+    int32_t lastRow = -1;
+
+    int32_t y;
+    for (y = top ; y < bottom ; y++)
+    {
+        int64_t v = y - dest->y;
+
+        if (flipY)
+        {
+            v = dest->height - 1 - v;
+        }
+
+        int64_t sy = (src->y + ((2*v + 1) * src->height) / (2 * dest->height))
+                   >> 16;
+
+        if (sy < 0)
+        {
+            sy = 0;
+        }
+        else if (sy >= resource->height)
+        {
+            sy = resource->height - 1;
+        }
+
+        if (sy != lastRow)
+        {
+            resourceRowToRgba(resource, sy, row);
+            lastRow = sy;
+        }
+
+        blendElementRow(element,
+                        row,
+                        columns,
+                        length,
+                        rgba + (4 * ((y * width) + left)));
+    }
+
+    free(row);
+    free(columns);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+compositeDisplay(
+    HEADLESS_DISPLAY_T *display)
+{
+    DISPMANX_DISPLAY_HANDLE_T handle = (display - displays) + 1;
+    size_t size = 4 * (size_t)(display->width) * display->height;
+
+    if (display->rgba == NULL)
+    {
+        display->rgba = malloc(size);
+
+        if (display->rgba == NULL)
+        {
+            fprintf(stderr, "headless: memory exhausted\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // A screen is black where there is nothing to show, an offscreen
+    // display is transparent.
+
+    uint8_t background[4] = { 0, 0, 0, (display->resource) ? 0 : 255 };
+
+    size_t i;
+    for (i = 0 ; i < size ; i += 4)
+    {
+        memcpy(display->rgba + i, background, 4);
+    }
+
+    //---------------------------------------------------------------------
+
+    // Elements in layer order, then in the order they were added
+
+    HEADLESS_ELEMENT_T *order[HEADLESS_MAX_ELEMENTS];
+    int32_t count = 0;
+
+    int32_t e;
+    for (e = 0 ; e < HEADLESS_MAX_ELEMENTS ; e++)
+    {
+        HEADLESS_ELEMENT_T *element = &(elements[e]);
+
+        if (element->used && (element->display == handle))
+        {
+            int32_t j = count++;
+
+            while ((j > 0) &&
+                   ((order[j - 1]->layer > element->layer) ||
+                    ((order[j - 1]->layer == element->layer) &&
+                     (order[j - 1]->order > element->order))))
+            {
+                order[j] = order[j - 1];
+                --j;
+            }
+
+            order[j] = element;
+        }
+    }
+
+    for (e = 0 ; e < count ; e++)
+    {
+        compositeElement(order[e],
+                         display->rgba,
+                         display->width,
+                         display->height);
+    }
+
+    //---------------------------------------------------------------------
+
+    HEADLESS_RESOURCE_T *resource = findResource(display->resource);
+
+    if (resource != NULL)
+    {
+        int32_t y;
+        for (y = 0 ; y < display->height ; y++)
+        {
+            rgbaToResourceRow(resource,
+                              y,
+                              display->rgba + (4 * y * display->width));
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static HEADLESS_DISPLAY_T *
+firstScreen(void)
+{
+    int32_t d;
+    for (d = 0 ; d < HEADLESS_MAX_DISPLAYS ; d++)
+    {
+        if (displays[d].used && (displays[d].resource == 0))
+        {
+            return &(displays[d]);
+        }
+    }
+
+    return NULL;
+}
+
+//-------------------------------------------------------------------------
+
+// Called with the lock held once the update or time limit is reached.
+// Saves the first screen if asked to, reports the time between updates
+// and ends the program.
+
+static void
+finishHeadless(void)
+{
+    HEADLESS_DISPLAY_T *display = firstScreen();
+
+    if ((pngFile != NULL) && (display != NULL))
+    {
+        compositeDisplay(display);
+
+        if (writeRgbaPng(pngFile,
+                         display->rgba,
+                         display->width,
+                         display->height) == false)
+        {
+            fprintf(stderr, "headless: unable to write %s\n", pngFile);
+        }
+    }
+
+    if (updatesSubmitted > 1)
+    {
+        fprintf(stderr,
+                "headless: %u updates, %.3f ms mean, %.3f ms min, "
+                "%.3f ms max between updates\n",
+                updatesSubmitted,
+                totalMilliseconds / (updatesSubmitted - 1),
+                minimumMilliseconds,
+                maximumMilliseconds);
+    }
+
+    if (callCounts.updates > 0)
+    {
+        fprintf(stderr,
+                "headless: %.1f element changes and %.1f source changes "
+                "per update\n",
+                (double)(callCounts.elementChanges) / callCounts.updates,
+                (double)(callCounts.sourceChanges) / callCounts.updates);
+    }
+
+    if (terminalSaved)
+    {
+        tcsetattr(STDIN_FILENO, TCSANOW, &terminal);
+    }
+
+    unlockHeadless();
+    exit(EXIT_SUCCESS);
+}
+
+//-------------------------------------------------------------------------
+
+void
+bcm_host_init(void)
+{
+    pthread_once(&headlessOnce, initHeadless);
+}
+
+//-------------------------------------------------------------------------
+
+void
+bcm_host_deinit(void)
+{
+}
+
+//-------------------------------------------------------------------------
+
+int32_t
+graphics_get_display_size(
+    const uint16_t display_number,
+    uint32_t *width,
+    uint32_t *height)
+{
+    pthread_once(&headlessOnce, initHeadless);
+
+    *width = screenWidth;
+    *height = screenHeight;
+
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_rect_set(
+    VC_RECT_T *rect,
+    uint32_t x_offset,
+    uint32_t y_offset,
+    uint32_t width,
+    uint32_t height)
+{
+    rect->x = x_offset;
+    rect->y = y_offset;
+    rect->width = width;
+    rect->height = height;
+
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+
+// As with the firmware, the upper 16 bits of width and height may hold
+// the pitch (in bytes) and the aligned height of the image.
+
+DISPMANX_RESOURCE_HANDLE_T
+vc_dispmanx_resource_create(
+    VC_IMAGE_TYPE_T type,
+    uint32_t width,
+    uint32_t height,
+    uint32_t *native_image_handle)
+{
+    int32_t bits = bitsPerPixel(type);
+    int32_t w = width & 0xFFFF;
+    int32_t h = height & 0xFFFF;
+    int32_t pitch = width >> 16;
+    int32_t alignedHeight = height >> 16;
+
+    if ((bits == 0) || (w == 0) || (h == 0))
+    {
+        return 0;
+    }
+
+    if (pitch < ((w * bits) + 7) / 8)
+    {
+        pitch = (ALIGN_TO_16(w) * bits) / 8;
+    }
+
+    if (alignedHeight < h)
+    {
+        alignedHeight = h;
+    }
+
+    DISPMANX_RESOURCE_HANDLE_T handle = 0;
+
+    lockHeadless();
+
+    int32_t r;
+    for (r = 0 ; r < HEADLESS_MAX_RESOURCES ; r++)
+    {
+        if (resources[r].used == false)
+        {
+            HEADLESS_RESOURCE_T *resource = &(resources[r]);
+            memset(resource, 0, sizeof(*resource));
+
+            resource->buffer = calloc(1, pitch * alignedHeight);
+
+            if (resource->buffer == NULL)
+            {
+                fprintf(stderr, "headless: memory exhausted\n");
+                exit(EXIT_FAILURE);
+            }
+
+            resource->used = true;
+            resource->type = type;
+            resource->width = w;
+            resource->height = h;
+            resource->pitch = pitch;
+
+            handle = r + 1;
+            break;
+        }
+    }
+
+    unlockHeadless();
+
+    if (native_image_handle != NULL)
+    {
+        *native_image_handle = handle;
+    }
+
+    return handle;
+}
+
+//-------------------------------------------------------------------------
+
+// Like the firmware, whole rows are copied, starting from rect->y rows
+// into the source. The data is copied as is, whatever src_type says.
+
+int
+vc_dispmanx_resource_write_data(
+    DISPMANX_RESOURCE_HANDLE_T handle,
+    VC_IMAGE_TYPE_T src_type,
+    int src_pitch,
+    void *src_address,
+    const VC_RECT_T *rect)
+{
+    int result = -1;
+
+    lockHeadless();
+
+    ++(callCounts.resourceWrites);
+
+    HEADLESS_RESOURCE_T *resource = findResource(handle);
+
+    if ((resource != NULL) && (src_address != NULL) && (rect != NULL))
+    {
+        int32_t top = (rect->y < 0) ? 0 : rect->y;
+        int32_t bottom = rect->y + rect->height;
+
+        if (bottom > resource->height)
+        {
+            bottom = resource->height;
+        }
+
+        int32_t length = resource->pitch;
+
+        if (abs(src_pitch) < length)
+        {
+            length = abs(src_pitch);
+        }
+
+        int32_t y;
+        for (y = top ; y < bottom ; y++)
+        {
+            memcpy(resource->buffer + (y * resource->pitch),
+                   (uint8_t *)src_address + (y * src_pitch),
+                   length);
+        }
+
+        result = 0;
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_resource_read_data(
+    DISPMANX_RESOURCE_HANDLE_T handle,
+    const VC_RECT_T *p_rect,
+    void *dst_address,
+    uint32_t dst_pitch)
+{
+    int result = -1;
+
+    lockHeadless();
+
+    HEADLESS_RESOURCE_T *resource = findResource(handle);
+
+    if ((resource != NULL) && (dst_address != NULL) && (p_rect != NULL))
+    {
+        int32_t top = (p_rect->y < 0) ? 0 : p_rect->y;
+        int32_t bottom = p_rect->y + p_rect->height;
+
+        if (bottom > resource->height)
+        {
+            bottom = resource->height;
+        }
+
+        int32_t length = resource->pitch;
+
+        if (dst_pitch < (uint32_t)length)
+        {
+            length = dst_pitch;
+        }
+
+        int32_t y;
+        for (y = top ; y < bottom ; y++)
+        {
+            memcpy((uint8_t *)dst_address + (y * dst_pitch),
+                   resource->buffer + (y * resource->pitch),
+                   length);
+        }
+
+        result = 0;
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_resource_set_palette(
+    DISPMANX_RESOURCE_HANDLE_T handle,
+    void *src_address,
+    int offset,
+    int size)
+{
+    int result = -1;
+
+    lockHeadless();
+
+    HEADLESS_RESOURCE_T *resource = findResource(handle);
+
+    if ((resource != NULL) &&
+        (src_address != NULL) &&
+        (offset >= 0) &&
+        (size >= 0) &&
+        ((resource->type == VC_IMAGE_4BPP) ||
+         (resource->type == VC_IMAGE_8BPP)))
+    {
+        int32_t end = offset + size;
+
+        if (end > resource->paletteEnd)
+        {
+            resource->paletteEnd = end;
+        }
+
+        if (end > HEADLESS_PALETTE_BYTES)
+        {
+            end = HEADLESS_PALETTE_BYTES;
+        }
+
+        if (end > offset)
+        {
+            memcpy(resource->palette + offset, src_address, end - offset);
+        }
+
+        result = 0;
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_resource_delete(
+    DISPMANX_RESOURCE_HANDLE_T res)
+{
+    int result = -1;
+
+    lockHeadless();
+
+    HEADLESS_RESOURCE_T *resource = findResource(res);
+
+    if (resource != NULL)
+    {
+        free(resource->buffer);
+        resource->buffer = NULL;
+        resource->used = false;
+
+        result = 0;
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+static DISPMANX_DISPLAY_HANDLE_T
+openDisplay(
+    uint32_t device,
+    DISPMANX_RESOURCE_HANDLE_T dest)
+{
+    DISPMANX_DISPLAY_HANDLE_T handle = 0;
+    int32_t width = screenWidth;
+    int32_t height = screenHeight;
+
+    if (dest != 0)
+    {
+        HEADLESS_RESOURCE_T *resource = findResource(dest);
+
+        if (resource == NULL)
+        {
+            return 0;
+        }
+
+        width = resource->width;
+        height = resource->height;
+    }
+
+    int32_t d;
+    for (d = 0 ; d < HEADLESS_MAX_DISPLAYS ; d++)
+    {
+        if (displays[d].used == false)
+        {
+            HEADLESS_DISPLAY_T *display = &(displays[d]);
+
+            display->used = true;
+            display->device = device;
+            display->width = width;
+            display->height = height;
+            display->resource = dest;
+            display->rgba = NULL;
+
+            handle = d + 1;
+            break;
+        }
+    }
+
+    return handle;
+}
+
+//-------------------------------------------------------------------------
+
+DISPMANX_DISPLAY_HANDLE_T
+vc_dispmanx_display_open(
+    uint32_t device)
+{
+    lockHeadless();
+    DISPMANX_DISPLAY_HANDLE_T handle = openDisplay(device, 0);
+    unlockHeadless();
+
+    return handle;
+}
+
+//-------------------------------------------------------------------------
+
+DISPMANX_DISPLAY_HANDLE_T
+vc_dispmanx_display_open_offscreen(
+    DISPMANX_RESOURCE_HANDLE_T dest,
+    DISPMANX_TRANSFORM_T orientation)
+{
+    lockHeadless();
+    DISPMANX_DISPLAY_HANDLE_T handle = (dest != 0) ? openDisplay(0, dest) : 0;
+    unlockHeadless();
+
+    return handle;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_display_get_info(
+    DISPMANX_DISPLAY_HANDLE_T display,
+    DISPMANX_MODEINFO_T *pinfo)
+{
+    int result = -1;
+
+    lockHeadless();
+
+    HEADLESS_DISPLAY_T *d = findDisplay(display);
+
+    if ((d != NULL) && (pinfo != NULL))
+    {
+        pinfo->width = d->width;
+        pinfo->height = d->height;
+        pinfo->transform = DISPMANX_NO_ROTATE;
+        pinfo->input_format = VCOS_DISPLAY_INPUT_FORMAT_RGB888;
+        pinfo->display_num = d->device;
+
+        result = 0;
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_display_close(
+    DISPMANX_DISPLAY_HANDLE_T display)
+{
+    int result = -1;
+
+    lockHeadless();
+
+    HEADLESS_DISPLAY_T *d = findDisplay(display);
+
+    if (d != NULL)
+    {
+        int32_t e;
+        for (e = 0 ; e < HEADLESS_MAX_ELEMENTS ; e++)
+        {
+            if (elements[e].used && (elements[e].display == display))
+            {
+                elements[e].used = false;
+            }
+        }
+
+        free(d->rgba);
+        d->rgba = NULL;
+        d->used = false;
+
+        result = 0;
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+DISPMANX_UPDATE_HANDLE_T
+vc_dispmanx_update_start(
+    int32_t priority)
+{
+    lockHeadless();
+
+    if (++updatesStarted == 0)
+    {
+        ++updatesStarted;
+    }
+
+    DISPMANX_UPDATE_HANDLE_T handle = updatesStarted;
+
+    unlockHeadless();
+
+    return handle;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_update_submit_sync(
+    DISPMANX_UPDATE_HANDLE_T update)
+{
+    if (update == 0)
+    {
+        return -1;
+    }
+
+    lockHeadless();
+
+    ++(callCounts.updates);
+
+    int32_t d;
+    for (d = 0 ; d < HEADLESS_MAX_DISPLAYS ; d++)
+    {
+        if (displays[d].used && (displays[d].resource != 0))
+        {
+            compositeDisplay(&(displays[d]));
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    if (updatesSubmitted > 0)
+    {
+        double milliseconds = ((now.tv_sec - lastSubmit.tv_sec) * 1000.0)
+                            + ((now.tv_usec - lastSubmit.tv_usec) / 1000.0);
+
+        if ((updatesSubmitted == 1) || (milliseconds < minimumMilliseconds))
+        {
+            minimumMilliseconds = milliseconds;
+        }
+
+        if (milliseconds > maximumMilliseconds)
+        {
+            maximumMilliseconds = milliseconds;
+        }
+
+        totalMilliseconds += milliseconds;
+    }
+
+    lastSubmit = now;
+    ++updatesSubmitted;
+
+    if ((updateLimit > 0) && (updatesSubmitted >= updateLimit))
+    {
+        finishHeadless();
+    }
+
+    unlockHeadless();
+
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+
+DISPMANX_ELEMENT_HANDLE_T
+vc_dispmanx_element_add(
+    DISPMANX_UPDATE_HANDLE_T update,
+    DISPMANX_DISPLAY_HANDLE_T display,
+    int32_t layer,
+    const VC_RECT_T *dest_rect,
+    DISPMANX_RESOURCE_HANDLE_T src,
+    const VC_RECT_T *src_rect,
+    DISPMANX_PROTECTION_T protection,
+    VC_DISPMANX_ALPHA_T *alpha,
+    DISPMANX_CLAMP_T *clamp,
+    DISPMANX_TRANSFORM_T transform)
+{
+    DISPMANX_ELEMENT_HANDLE_T handle = 0;
+
+    lockHeadless();
+
+    ++(callCounts.elementAdds);
+
+    if ((update != 0) &&
+        (findDisplay(display) != NULL) &&
+        (dest_rect != NULL) &&
+        (src_rect != NULL))
+    {
+        int32_t e;
+        for (e = 0 ; e < HEADLESS_MAX_ELEMENTS ; e++)
+        {
+            if (elements[e].used == false)
+            {
+                HEADLESS_ELEMENT_T *element = &(elements[e]);
+
+                element->used = true;
+                element->order = elementOrder++;
+                element->display = display;
+                element->layer = layer;
+                element->destRect = *dest_rect;
+                element->srcRect = *src_rect;
+                element->resource = src;
+                element->transform = transform;
+
+                if (alpha != NULL)
+                {
+                    element->alpha = *alpha;
+                }
+                else
+                {
+                    element->alpha.flags = DISPMANX_FLAGS_ALPHA_FROM_SOURCE;
+                    element->alpha.opacity = 255;
+                    element->alpha.mask = 0;
+                }
+
+                handle = e + 1;
+                break;
+            }
+        }
+    }
+
+    unlockHeadless();
+
+    return handle;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_element_change_source(
+    DISPMANX_UPDATE_HANDLE_T update,
+    DISPMANX_ELEMENT_HANDLE_T element,
+    DISPMANX_RESOURCE_HANDLE_T src)
+{
+    int result = -1;
+
+    lockHeadless();
+
+    ++(callCounts.sourceChanges);
+
+    HEADLESS_ELEMENT_T *e = findElement(element);
+
+    if ((update != 0) && (e != NULL))
+    {
+        e->resource = src;
+        result = 0;
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_element_change_attributes(
+    DISPMANX_UPDATE_HANDLE_T update,
+    DISPMANX_ELEMENT_HANDLE_T element,
+    uint32_t change_flags,
+    int32_t layer,
+    uint8_t opacity,
+    const VC_RECT_T *dest_rect,
+    const VC_RECT_T *src_rect,
+    DISPMANX_RESOURCE_HANDLE_T mask,
+    DISPMANX_TRANSFORM_T transform)
+{
+    int result = -1;
+
+    lockHeadless();
+
+    ++(callCounts.elementChanges);
+
+    HEADLESS_ELEMENT_T *e = findElement(element);
+
+    if ((update != 0) && (e != NULL))
+    {
+        if (change_flags & ELEMENT_CHANGE_LAYER)
+        {
+            e->layer = layer;
+        }
+
+        if (change_flags & ELEMENT_CHANGE_OPACITY)
+        {
+            e->alpha.opacity = opacity;
+        }
+
+        if ((change_flags & ELEMENT_CHANGE_DEST_RECT) && (dest_rect != NULL))
+        {
+            e->destRect = *dest_rect;
+        }
+
+        if ((change_flags & ELEMENT_CHANGE_SRC_RECT) && (src_rect != NULL))
+        {
+            e->srcRect = *src_rect;
+        }
+
+        if (change_flags & ELEMENT_CHANGE_MASK_RESOURCE)
+        {
+            e->alpha.mask = mask;
+        }
+
+        if (change_flags & ELEMENT_CHANGE_TRANSFORM)
+        {
+            e->transform = transform;
+        }
+
+        result = 0;
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+int
+vc_dispmanx_element_remove(
+    DISPMANX_UPDATE_HANDLE_T update,
+    DISPMANX_ELEMENT_HANDLE_T element)
+{
+    int result = -1;
+
+    lockHeadless();
+
+    ++(callCounts.elementRemoves);
+
+    HEADLESS_ELEMENT_T *e = findElement(element);
+
+    if ((update != 0) && (e != NULL))
+    {
+        e->used = false;
+        result = 0;
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+const uint8_t *
+headlessDisplayRgba(
+    DISPMANX_DISPLAY_HANDLE_T display,
+    int32_t *width,
+    int32_t *height)
+{
+    const uint8_t *rgba = NULL;
+
+    lockHeadless();
+
+    HEADLESS_DISPLAY_T *d = findDisplay(display);
+
+    if (d != NULL)
+    {
+        compositeDisplay(d);
+
+        rgba = d->rgba;
+        *width = d->width;
+        *height = d->height;
+    }
+
+    unlockHeadless();
+
+    return rgba;
+}
+
+//-------------------------------------------------------------------------
+
+bool
+headlessSavePng(
+    DISPMANX_DISPLAY_HANDLE_T display,
+    const char *file)
+{
+    bool result = false;
+
+    lockHeadless();
+
+    HEADLESS_DISPLAY_T *d = findDisplay(display);
+
+    if (d != NULL)
+    {
+        compositeDisplay(d);
+        result = writeRgbaPng(file, d->rgba, d->width, d->height);
+    }
+
+    unlockHeadless();
+
+    return result;
+}
+
+//-------------------------------------------------------------------------
+
+uint32_t
+headlessUpdates(void)
+{
+    lockHeadless();
+    uint32_t updates = updatesSubmitted;
+    unlockHeadless();
+
+    return updates;
+}
+
+//-------------------------------------------------------------------------
+
+void
+headlessCalls(
+    HEADLESS_CALLS_T *calls)
+{
+    lockHeadless();
+    *calls = callCounts;
+    unlockHeadless();
+}
+
@@ -0,0 +1,82 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bcm_host.h"
+
+//-------------------------------------------------------------------------
+
+// Functions only found in the software DispmanX. The environment
+// variables read by bcm_host_init() are described in README.md.
+
+//-------------------------------------------------------------------------
+
+// Composite the elements of a display and return a pointer to the result,
+// four bytes (red, green, blue and alpha) per pixel and a pitch of four
+// times the width. The pixels remain valid until the next call.
+
+const uint8_t *
+headlessDisplayRgba(
+    DISPMANX_DISPLAY_HANDLE_T display,
+    int32_t *width,
+    int32_t *height);
+
+bool
+headlessSavePng(
+    DISPMANX_DISPLAY_HANDLE_T display,
+    const char *file);
+
+uint32_t
+headlessUpdates(void);
+
+// The number of calls made to the DispmanX functions that send work to
+// the compositor, since the program started. Differences between two
+// calls give the cost of whatever was done in between.
+
+typedef struct
+{
+    uint32_t updates;
+    uint32_t elementAdds;
+    uint32_t elementChanges;
+    uint32_t sourceChanges;
+    uint32_t elementRemoves;
+    uint32_t resourceWrites;
+} HEADLESS_CALLS_T;
+
+void
+headlessCalls(
+    HEADLESS_CALLS_T *calls);
+
+//-------------------------------------------------------------------------
+
+#endif
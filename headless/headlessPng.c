@@ -0,0 +1,247 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+// A PNG writer with no dependencies. The image data is stored without
+// compression, which is quick to write and fine for test images.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "headlessPng.h"
+
+//-------------------------------------------------------------------------
+
+// Largest block that deflate can store uncompressed.
+
+#define STORED_BLOCK_SIZE 65535
+
+//-------------------------------------------------------------------------
+
+static uint32_t crcTable[256];
+
+//-------------------------------------------------------------------------
+
+static void
+initCrcTable(void)
+{
+    uint32_t n;
+    for (n = 0 ; n < 256 ; n++)
+    {
+        uint32_t c = n;
+
+        int k;
+        for (k = 0 ; k < 8 ; k++)
+        {
+            c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+        }
+
+        crcTable[n] = c;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static uint32_t
+crc(
+    uint32_t crc,
+    const uint8_t *data,
+    size_t length)
+{
+    size_t i;
+    for (i = 0 ; i < length ; i++)
+    {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+//-------------------------------------------------------------------------
+
+static void
+putBigEndian(
+    uint8_t *bytes,
+    uint32_t value)
+{
+    bytes[0] = value >> 24;
+    bytes[1] = value >> 16;
+    bytes[2] = value >> 8;
+    bytes[3] = value;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+writeChunk(
+    FILE *fp,
+    const char *type,
+    const uint8_t *data,
+    uint32_t length)
+{
+    uint8_t header[8];
+    putBigEndian(header, length);
+    memcpy(header + 4, type, 4);
+
+    uint32_t c = crc(0xFFFFFFFF, header + 4, 4);
+    c = crc(c, data, length) ^ 0xFFFFFFFF;
+
+    uint8_t trailer[4];
+    putBigEndian(trailer, c);
+
+    return (fwrite(header, sizeof(header), 1, fp) == 1) &&
+           ((length == 0) || (fwrite(data, length, 1, fp) == 1)) &&
+           (fwrite(trailer, sizeof(trailer), 1, fp) == 1);
+}
+
+//-------------------------------------------------------------------------
+
+bool
+writeRgbaPng(
+    const char *file,
+    const uint8_t *rgba,
+    int32_t width,
+    int32_t height)
+{
+    if (crcTable[1] == 0)
+    {
+        initCrcTable();
+    }
+
+    //---------------------------------------------------------------------
+
+    // Each row is a filter type byte (none) followed by the pixels
+
+    size_t rowLength = 1 + (4 * (size_t)width);
+    size_t rawLength = rowLength * height;
+    size_t blocks = (rawLength + STORED_BLOCK_SIZE - 1) / STORED_BLOCK_SIZE;
+
+    if (blocks == 0)
+    {
+        blocks = 1;
+    }
+
+    size_t idatLength = 2 + (5 * blocks) + rawLength + 4;
+    uint8_t *idat = malloc(idatLength);
+
+    if (idat == NULL)
+    {
+        fprintf(stderr, "headlessPng: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint8_t *out = idat;
+
+    // zlib header: deflate, 32K window, no dictionary, fastest
+
+    *out++ = 0x78;
+    *out++ = 0x01;
+
+    uint32_t s1 = 1;
+    uint32_t s2 = 0;
+    size_t offset = 0;
+    size_t column = 0;
+    const uint8_t *row = rgba;
+
+    do
+    {
+        size_t size = rawLength - offset;
+
+        if (size > STORED_BLOCK_SIZE)
+        {
+            size = STORED_BLOCK_SIZE;
+        }
+
+        *out++ = (offset + size == rawLength) ? 1 : 0;
+        *out++ = size & 0xFF;
+        *out++ = size >> 8;
+        *out++ = ~size & 0xFF;
+        *out++ = (~size >> 8) & 0xFF;
+
+        size_t i;
+        for (i = 0 ; i < size ; i++)
+        {
+            uint8_t byte = (column == 0) ? 0 : row[column - 1];
+
+            if (++column == rowLength)
+            {
+                column = 0;
+                row += 4 * width;
+            }
+
+            *out++ = byte;
+
+            s1 = (s1 + byte) % 65521;
+            s2 = (s2 + s1) % 65521;
+        }
+
+        offset += size;
+    }
+    while (offset < rawLength);
+
+    putBigEndian(out, (s2 << 16) | s1);
+    out += 4;
+
+    //---------------------------------------------------------------------
+
+    uint8_t ihdr[13];
+    putBigEndian(ihdr, width);
+    putBigEndian(ihdr + 4, height);
+    ihdr[8] = 8;    // bit depth
+    ihdr[9] = 6;    // RGBA
+    ihdr[10] = 0;   // deflate
+    ihdr[11] = 0;   // adaptive filtering
+    ihdr[12] = 0;   // not interlaced
+
+    static const uint8_t signature[8] =
+    {
+        0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'
+    };
+
+    bool result = false;
+    FILE *fp = fopen(file, "wb");
+
+    if (fp != NULL)
+    {
+        result = (fwrite(signature, sizeof(signature), 1, fp) == 1) &&
+                 writeChunk(fp, "IHDR", ihdr, sizeof(ihdr)) &&
+                 writeChunk(fp, "IDAT", idat, out - idat) &&
+                 writeChunk(fp, "IEND", NULL, 0);
+
+        if (fclose(fp) != 0)
+        {
+            result = false;
+        }
+    }
+
+    free(idat);
+
+    return result;
+}
+
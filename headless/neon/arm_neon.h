@@ -0,0 +1,653 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef HEADLESS_ARM_NEON_H
+#define HEADLESS_ARM_NEON_H
+
+//-------------------------------------------------------------------------
+// Plain C versions of the NEON intrinsics used by raspidmx, so that the
+// NEON code paths can be compiled and checked on a machine without NEON.
+// Build with -I../headless/neon -D__ARM_NEON (and -U__SSE2__ on x86), and
+// -D__ARM_64BIT_STATE as well for the AArch64 only intrinsics.
+// Each intrinsic follows the ARM definition, one lane at a time. Nothing
+// here is fast, it only has to give the same answers.
+
+#include <stdint.h>
+#include <string.h>
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    uint8_t lane[8];
+} uint8x8_t;
+
+typedef struct
+{
+    uint16_t lane[8];
+} uint16x8_t;
+
+typedef struct
+{
+    uint64_t lane[1];
+} uint64x1_t;
+
+typedef struct
+{
+    uint64_t lane[2];
+} uint64x2_t;
+
+typedef struct
+{
+    double lane[2];
+} float64x2_t;
+
+typedef struct
+{
+    uint8x8_t val[3];
+} uint8x8x3_t;
+
+typedef struct
+{
+    uint8x8_t val[4];
+} uint8x8x4_t;
+
+//-------------------------------------------------------------------------
+
+static inline uint8x8x3_t
+vld3_u8(
+    const uint8_t *p)
+{
+    uint8x8x3_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.val[0].lane[i] = p[(3 * i)];
+        r.val[1].lane[i] = p[(3 * i) + 1];
+        r.val[2].lane[i] = p[(3 * i) + 2];
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint8x8x4_t
+vld4_u8(
+    const uint8_t *p)
+{
+    uint8x8x4_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.val[0].lane[i] = p[(4 * i)];
+        r.val[1].lane[i] = p[(4 * i) + 1];
+        r.val[2].lane[i] = p[(4 * i) + 2];
+        r.val[3].lane[i] = p[(4 * i) + 3];
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline void
+vst3_u8(
+    uint8_t *p,
+    uint8x8x3_t v)
+{
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        p[(3 * i)] = v.val[0].lane[i];
+        p[(3 * i) + 1] = v.val[1].lane[i];
+        p[(3 * i) + 2] = v.val[2].lane[i];
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static inline void
+vst4_u8(
+    uint8_t *p,
+    uint8x8x4_t v)
+{
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        p[(4 * i)] = v.val[0].lane[i];
+        p[(4 * i) + 1] = v.val[1].lane[i];
+        p[(4 * i) + 2] = v.val[2].lane[i];
+        p[(4 * i) + 3] = v.val[3].lane[i];
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint16x8_t
+vld1q_u16(
+    const uint16_t *p)
+{
+    uint16x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = p[i];
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline void
+vst1q_u16(
+    uint16_t *p,
+    uint16x8_t v)
+{
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        p[i] = v.lane[i];
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint8x8_t
+vdup_n_u8(
+    uint8_t value)
+{
+    uint8x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = value;
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint8x8_t
+vqadd_u8(
+    uint8x8_t a,
+    uint8x8_t b)
+{
+    uint8x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        uint16_t sum = a.lane[i] + b.lane[i];
+        r.lane[i] = (sum > 255) ? 255 : sum;
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint16x8_t
+vshll_n_u8(
+    uint8x8_t a,
+    int n)
+{
+    uint16x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = (uint16_t)(a.lane[i] << n);
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint16x8_t
+vshlq_n_u16(
+    uint16x8_t a,
+    int n)
+{
+    uint16x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = (uint16_t)(a.lane[i] << n);
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint8x8_t
+vshrn_n_u16(
+    uint16x8_t a,
+    int n)
+{
+    uint8x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = (uint8_t)(a.lane[i] >> n);
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint8x8_t
+vmovn_u16(
+    uint16x8_t a)
+{
+    return vshrn_n_u16(a, 0);
+}
+
+//-------------------------------------------------------------------------
+
+// Shift each lane of 'b' right by 'n' and insert it into 'a', keeping the
+// top 'n' bits of 'a'.
+
+static inline uint8x8_t
+vsri_n_u8(
+    uint8x8_t a,
+    uint8x8_t b,
+    int n)
+{
+    uint8_t keep = ~(0xFF >> n);
+    uint8x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = (a.lane[i] & keep) | (b.lane[i] >> n);
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint16x8_t
+vsriq_n_u16(
+    uint16x8_t a,
+    uint16x8_t b,
+    int n)
+{
+    uint16_t keep = ~(0xFFFF >> n);
+    uint16x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = (a.lane[i] & keep) | (b.lane[i] >> n);
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+// Shift each lane of 'b' left by 'n' and insert it into 'a', keeping the
+// bottom 'n' bits of 'a'.
+
+static inline uint8x8_t
+vsli_n_u8(
+    uint8x8_t a,
+    uint8x8_t b,
+    int n)
+{
+    uint8_t keep = (1 << n) - 1;
+    uint8x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = (a.lane[i] & keep) | (uint8_t)(b.lane[i] << n);
+    }
+
+    return r;
+}
+
+static inline uint8x8_t
+vmvn_u8(
+    uint8x8_t a)
+{
+    uint8x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = ~(a.lane[i]);
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint16x8_t
+vmull_u8(
+    uint8x8_t a,
+    uint8x8_t b)
+{
+    uint16x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = a.lane[i] * b.lane[i];
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+// Multiply and accumulate, wrapping around at 16 bits.
+
+static inline uint16x8_t
+vmlal_u8(
+    uint16x8_t a,
+    uint8x8_t b,
+    uint8x8_t c)
+{
+    uint16x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = (uint16_t)(a.lane[i] + (b.lane[i] * c.lane[i]));
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+// Shift right by 'n', rounding. The sum is worked out in more than 16 bits
+// so it doesn't wrap around.
+
+static inline uint16x8_t
+vrshrq_n_u16(
+    uint16x8_t a,
+    int n)
+{
+    uint16x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        r.lane[i] = ((uint32_t)(a.lane[i]) + (1 << (n - 1))) >> n;
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+// Add, round and keep the top half of each lane. The sum wraps around at
+// 16 bits.
+
+static inline uint8x8_t
+vraddhn_u16(
+    uint16x8_t a,
+    uint16x8_t b)
+{
+    uint8x8_t r;
+
+    int i;
+    for (i = 0 ; i < 8 ; i++)
+    {
+        uint16_t sum = a.lane[i] + b.lane[i] + 128;
+        r.lane[i] = sum >> 8;
+    }
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint64x1_t
+vreinterpret_u64_u8(
+    uint8x8_t v)
+{
+    uint64x1_t r;
+    memcpy(&r, &v, sizeof(r));
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint64_t
+vget_lane_u64(
+    uint64x1_t v,
+    int lane)
+{
+    return v.lane[lane];
+}
+
+//-------------------------------------------------------------------------
+// AArch64 only: two doubles or two 64 bit masks.
+
+static inline float64x2_t
+vdupq_n_f64(
+    double value)
+{
+    float64x2_t r = {{ value, value }};
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint64x2_t
+vdupq_n_u64(
+    uint64_t value)
+{
+    uint64x2_t r = {{ value, value }};
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline float64x2_t
+vld1q_f64(
+    const double *p)
+{
+    float64x2_t r = {{ p[0], p[1] }};
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline void
+vst1q_f64(
+    double *p,
+    float64x2_t v)
+{
+    p[0] = v.lane[0];
+    p[1] = v.lane[1];
+}
+
+//-------------------------------------------------------------------------
+
+static inline void
+vst1q_u64(
+    uint64_t *p,
+    uint64x2_t v)
+{
+    p[0] = v.lane[0];
+    p[1] = v.lane[1];
+}
+
+//-------------------------------------------------------------------------
+
+static inline float64x2_t
+vaddq_f64(
+    float64x2_t a,
+    float64x2_t b)
+{
+    float64x2_t r = {{ a.lane[0] + b.lane[0], a.lane[1] + b.lane[1] }};
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline float64x2_t
+vsubq_f64(
+    float64x2_t a,
+    float64x2_t b)
+{
+    float64x2_t r = {{ a.lane[0] - b.lane[0], a.lane[1] - b.lane[1] }};
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline float64x2_t
+vmulq_f64(
+    float64x2_t a,
+    float64x2_t b)
+{
+    float64x2_t r = {{ a.lane[0] * b.lane[0], a.lane[1] * b.lane[1] }};
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint64x2_t
+vceqq_f64(
+    float64x2_t a,
+    float64x2_t b)
+{
+    uint64x2_t r =
+    {{
+        (a.lane[0] == b.lane[0]) ? ~UINT64_C(0) : 0,
+        (a.lane[1] == b.lane[1]) ? ~UINT64_C(0) : 0
+    }};
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint64x2_t
+vcltq_f64(
+    float64x2_t a,
+    float64x2_t b)
+{
+    uint64x2_t r =
+    {{
+        (a.lane[0] < b.lane[0]) ? ~UINT64_C(0) : 0,
+        (a.lane[1] < b.lane[1]) ? ~UINT64_C(0) : 0
+    }};
+
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint64x2_t
+vandq_u64(
+    uint64x2_t a,
+    uint64x2_t b)
+{
+    uint64x2_t r = {{ a.lane[0] & b.lane[0], a.lane[1] & b.lane[1] }};
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint64x2_t
+vorrq_u64(
+    uint64x2_t a,
+    uint64x2_t b)
+{
+    uint64x2_t r = {{ a.lane[0] | b.lane[0], a.lane[1] | b.lane[1] }};
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+// a & ~b
+
+static inline uint64x2_t
+vbicq_u64(
+    uint64x2_t a,
+    uint64x2_t b)
+{
+    uint64x2_t r = {{ a.lane[0] & ~b.lane[0], a.lane[1] & ~b.lane[1] }};
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint64_t
+vgetq_lane_u64(
+    uint64x2_t v,
+    int lane)
+{
+    return v.lane[lane];
+}
+
+//-------------------------------------------------------------------------
+
+static inline float64x2_t
+vreinterpretq_f64_u64(
+    uint64x2_t v)
+{
+    float64x2_t r;
+    memcpy(&r, &v, sizeof(r));
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+static inline uint64x2_t
+vreinterpretq_u64_f64(
+    float64x2_t v)
+{
+    uint64x2_t r;
+    memcpy(&r, &v, sizeof(r));
+    return r;
+}
+
+//-------------------------------------------------------------------------
+
+#endif
@@ -44,6 +44,7 @@
 void
 lifeInfo(
     IMAGE_LAYER_T *imageLayer,
+    FONT_CACHE_T *fontCache,
     int32_t size,
     bool paused,
     int32_t threads,
@@ -69,13 +70,14 @@ lifeInfo(
     x = INFO_LEFT_PADDING;
     y += key_dimensions.height + INFO_TOP_PADDING;
 
-    key_dimensions = drawKey(imageLayer, x, y, "Esc", "exit");
+    key_dimensions = drawKey(imageLayer, fontCache, x, y, "Esc", "exit");
 
     //---------------------------------------------------------------------
 
     y += key_dimensions.height + INFO_TOP_PADDING;
 
     key_dimensions = drawKey(imageLayer,
+                             fontCache,
                              x,
                              y,
                              "P",
@@ -85,7 +87,7 @@ lifeInfo(
 
     y += key_dimensions.height + INFO_TOP_PADDING;
 
-    key_dimensions = drawKey(imageLayer, x, y, "space", "step");
+    key_dimensions = drawKey(imageLayer, fontCache, x, y, "space", "step");
 
     //---------------------------------------------------------------------
 
@@ -94,12 +96,24 @@ lifeInfo(
     y += key_dimensions.height + INFO_TOP_PADDING;
 
     snprintf(buffer, sizeof(buffer), "size: %d", size);
-    drawStringRGB(x, y, buffer, &textColour, image);
+    drawStringCachedRGB(fontCache,
+                        x,
+                        y,
+                        buffer,
+                        &textColour,
+                        &backgroundColour,
+                        image);
 
     y += FONT_HEIGHT + INFO_TOP_PADDING;
 
     snprintf(buffer, sizeof(buffer), "threads: %d", threads);
-    drawStringRGB(x, y, buffer, &textColour, image);
+    drawStringCachedRGB(fontCache,
+                        x,
+                        y,
+                        buffer,
+                        &textColour,
+                        &backgroundColour,
+                        image);
 
     y += FONT_HEIGHT + INFO_TOP_PADDING;
 
@@ -112,7 +126,13 @@ lifeInfo(
         snprintf(buffer, sizeof(buffer), "fps: --");
     }
 
-    drawStringRGB(x, y, buffer, &textColour, image);
+    drawStringCachedRGB(fontCache,
+                        x,
+                        y,
+                        buffer,
+                        &textColour,
+                        &backgroundColour,
+                        image);
 
     //---------------------------------------------------------------------
 
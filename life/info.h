@@ -30,6 +30,7 @@
 
 #include <stdint.h>
 
+#include "font.h"
 #include "imageLayer.h"
 
 //-------------------------------------------------------------------------
@@ -37,6 +38,7 @@
 void
 lifeInfo(
     IMAGE_LAYER_T *imageLayer,
+    FONT_CACHE_T *fontCache,
     int32_t size,
     bool paused,
     int32_t threads,
@@ -31,7 +31,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <sys/time.h>
 
 #include "life.h"
 
@@ -48,66 +47,89 @@
 
 //-------------------------------------------------------------------------
 
+// Expansion of eight packed cells into eight palette indices. Built
+// once in newLife() before any worker threads are started.
+
+static uint8_t cellPattern[256][8];
+
+//-------------------------------------------------------------------------
+
+static uint64_t
+splitMix64(
+    uint64_t *state)
+{
+    uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+//-------------------------------------------------------------------------
+
 static void
-setCell(
-    LIFE_T *life,
-    int32_t col,
-    int32_t row)
+initCellPattern(void)
 {
-    life->buffer[col + (row * life->alignedWidth)] = LIVE;
-
-    int32_t width = life->width;
-    int32_t height = life->height;
-    int32_t fieldLength = life->fieldLength;
-
-    uint8_t *cell = life->fieldNext + col + (row * width);
-
-    int32_t left = (col == 0) ? width - 1 :  -1;
-    int32_t right = (col == width - 1) ?  -(width - 1) : 1;
-    int32_t above = (row == 0) ? fieldLength - width : -width;
-    int32_t below = (row == height - 1) ? -(fieldLength - width) : width;
-
-    *(cell) |= 0x01;
-    *(cell + above + left) += 2;
-    *(cell + above) += 2;
-    *(cell + above + right) += 2;
-    *(cell + left) += 2;
-    *(cell + right) += 2;
-    *(cell + below + left) += 2;
-    *(cell + below) += 2;
-    *(cell + below + right) += 2;
+    int32_t cells;
+    for (cells = 0 ; cells < 256 ; cells++)
+    {
+        int32_t bit;
+        for (bit = 0 ; bit < 8 ; bit++)
+        {
+            cellPattern[cells][bit] = (cells & (1 << bit)) ? LIVE : DEAD;
+        }
+    }
 }
 
 //-------------------------------------------------------------------------
 
 static void
-clearCell(
+drawLifeRows(
     LIFE_T *life,
-    int32_t col,
-    int32_t row)
+    const uint64_t *field,
+    int32_t startRow,
+    int32_t endRow)
+{
+    if (endRow > life->viewHeight)
+    {
+        endRow = life->viewHeight;
+    }
+
+    // pitch is a multiple of 16, so whole groups of eight cells can be
+    // written even when viewWidth is not a multiple of eight.
+
+    int32_t groups = (life->viewWidth + 7) / 8;
+
+    int32_t row;
+    for (row = startRow ; row < endRow ; row++)
+    {
+        const uint64_t *words = field + ((size_t)row * life->wordsPerRow);
+        uint8_t *line = life->buffer + (row * life->pitch);
+
+        int32_t group;
+        for (group = 0 ; group < groups ; group++)
+        {
+            uint8_t cells = words[group / 8] >> ((group % 8) * 8);
+            memcpy(line + (group * 8), cellPattern[cells], 8);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static uint64_t *
+allocateField(
+    LIFE_T *life)
 {
-    life->buffer[col + (row * life->alignedWidth)] = DEAD;
-
-    int32_t width = life->width;
-    int32_t height = life->height;
-    int32_t fieldLength = life->fieldLength;
-
-    uint8_t *cell = life->fieldNext + col + (row * width);
-
-    int32_t left = (col == 0) ? width - 1 :  -1;
-    int32_t right = (col == width - 1) ?  -(width - 1) : 1;
-    int32_t above = (row == 0) ? fieldLength - width : -width;
-    int32_t below = (row == height - 1) ? -(fieldLength - width) : width;
-
-    *(cell) &= ~0x01;
-    *(cell + above + left) -= 2;
-    *(cell + above) -= 2;
-    *(cell + above + right) -= 2;
-    *(cell + left) -= 2;
-    *(cell + right) -= 2;
-    *(cell + below + left) -= 2;
-    *(cell + below) -= 2;
-    *(cell + below + right) -= 2;
+    uint64_t *field = calloc((size_t)life->wordsPerRow * life->height,
+                             sizeof(uint64_t));
+
+    if (field == NULL)
+    {
+        fprintf(stderr, "life: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return field;
 }
 
 //-------------------------------------------------------------------------
@@ -115,61 +137,70 @@ clearCell(
 void
 newLife(
     LIFE_T *life,
-    int32_t size)
+    int32_t size,
+    int32_t viewSize,
+    uint32_t seed)
 {
+    if (viewSize > size)
+    {
+        viewSize = size;
+    }
+
     life->width = size;
     life->height = size;
-    life->alignedWidth = ALIGN_TO_16(life->width);
-    life->alignedHeight = ALIGN_TO_16(life->height);
-    life->pitch = ALIGN_TO_16(life->width);
+    life->wordsPerRow = (life->width + 63) / 64;
 
-    life->buffer = calloc(1, life->pitch * life->alignedHeight);
+    int32_t lastWordBits = life->width - ((life->wordsPerRow - 1) * 64);
 
-    if (life->buffer == NULL)
+    if (lastWordBits == 64)
     {
-        fprintf(stderr, "life: memory exhausted\n");
-        exit(EXIT_FAILURE);
+        life->lastWordMask = ~UINT64_C(0);
+    }
+    else
+    {
+        life->lastWordMask = (UINT64_C(1) << lastWordBits) - 1;
     }
 
-    life->fieldLength = life->width * life->height;
+    life->field = allocateField(life);
+    life->fieldNext = allocateField(life);
 
-    life->field = calloc(1, life->fieldLength);
+    life->viewWidth = viewSize;
+    life->viewHeight = viewSize;
+    life->alignedHeight = ALIGN_TO_16(life->viewHeight);
+    life->pitch = ALIGN_TO_16(life->viewWidth);
 
-    if (life->field == NULL)
+    life->buffer = calloc(1, life->pitch * life->alignedHeight);
+
+    if (life->buffer == NULL)
     {
         fprintf(stderr, "life: memory exhausted\n");
         exit(EXIT_FAILURE);
     }
 
-    life->fieldNext = calloc(1, life->fieldLength);
+    //---------------------------------------------------------------------
 
-    if (life->fieldNext == NULL)
-    {
-        fprintf(stderr, "life: memory exhausted\n");
-        exit(EXIT_FAILURE);
-    }
+    // Each cell is live with a probability of one half. The field only
+    // depends on the seed, so a given seed always gives the same run.
 
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    srand(tv.tv_usec);
+    uint64_t state = seed;
 
     int32_t row = 0;
     for (row = 0 ; row < life->height ; row++)
     {
-        int32_t col = 0;
-        for (col = 0 ; col < life->width ; col++)
+        uint64_t *words = life->field + ((size_t)row * life->wordsPerRow);
+
+        int32_t word = 0;
+        for (word = 0 ; word < life->wordsPerRow ; word++)
         {
-            if (rand() > (RAND_MAX / 2))
-            {
-                setCell(life, col, row);
-            }
-            else
-            {
-                life->buffer[col + (row * life->alignedWidth)] = DEAD;
-            }
+            words[word] = splitMix64(&state);
         }
+
+        words[life->wordsPerRow - 1] &= life->lastWordMask;
     }
 
+    initCellPattern();
+    drawLifeRows(life, life->field, 0, life->viewHeight);
+
     //---------------------------------------------------------------------
 
     VC_IMAGE_TYPE_T type = VC_IMAGE_8BPP;
@@ -179,22 +210,26 @@ newLife(
     life->frontResource = 
         vc_dispmanx_resource_create(
             type,
-            life->width | (life->pitch << 16),
-            life->height | (life->alignedHeight << 16),
+            life->viewWidth | (life->pitch << 16),
+            life->viewHeight | (life->alignedHeight << 16),
             &vc_image_ptr);
     assert(life->frontResource != 0);
 
     life->backResource = 
         vc_dispmanx_resource_create(
             type,
-            life->width | (life->pitch << 16),
-            life->height | (life->alignedHeight << 16),
+            life->viewWidth | (life->pitch << 16),
+            life->viewHeight | (life->alignedHeight << 16),
             &vc_image_ptr);
     assert(life->backResource != 0);
 
     //---------------------------------------------------------------------
 
-    vc_dispmanx_rect_set(&(life->bmpRect), 0, 0, life->width, life->height);
+    vc_dispmanx_rect_set(&(life->bmpRect),
+                         0,
+                         0,
+                         life->viewWidth,
+                         life->viewHeight);
 
     result = vc_dispmanx_resource_write_data(life->frontResource,
                                              type,
@@ -221,6 +256,8 @@ newLife(
         life->numberOfThreads = cores;
     }
 
+    life->stopping = false;
+
     pthread_barrier_init(&(life->startIterationBarrier),
                          NULL,
                          life->numberOfThreads + 1);
@@ -253,7 +290,6 @@ newLife(
 
     //---------------------------------------------------------------------
 
-    memcpy(life->field, life->fieldNext, life->fieldLength);
     pthread_barrier_wait(&(life->startIterationBarrier));
 }
 
@@ -285,6 +321,12 @@ workerLife(
     while (true)
     {
         pthread_barrier_wait(&(life->startIterationBarrier));
+
+        if (life->stopping)
+        {
+            break;
+        }
+
         iterateLifeKernel(life, thread);
         pthread_barrier_wait(&(life->finishedIterationBarrier));
     }
@@ -315,8 +357,8 @@ addElementLife(
     vc_dispmanx_rect_set(&(life->srcRect),
                          0,
                          0,
-                         life->width << 16,
-                         life->height << 16);
+                         life->viewWidth << 16,
+                         life->viewHeight << 16);
 
     vc_dispmanx_rect_set(&(life->dstRect),
                          xOffset,
@@ -340,42 +382,114 @@ addElementLife(
 
 //-------------------------------------------------------------------------
 
+static void
+neighbourWords(
+    const uint64_t *words,
+    int32_t word,
+    int32_t wordsPerRow,
+    int32_t lastBit,
+    uint64_t *west,
+    uint64_t *east)
+{
+    uint64_t current = words[word];
+    uint64_t westCarry;
+    uint64_t eastCarry;
+
+    // the field wraps around, so the cell to the west of column 0 is the
+    // last column and the cell to the east of the last column is column 0
+
+    if (word == 0)
+    {
+        westCarry = (words[wordsPerRow - 1] >> lastBit) & 1;
+    }
+    else
+    {
+        westCarry = words[word - 1] >> 63;
+    }
+
+    if (word == wordsPerRow - 1)
+    {
+        eastCarry = (words[0] & 1) << lastBit;
+    }
+    else
+    {
+        eastCarry = words[word + 1] << 63;
+    }
+
+    *west = (current << 1) | westCarry;
+    *east = (current >> 1) | eastCarry;
+}
+
+//-------------------------------------------------------------------------
+
 void
 iterateLifeKernel(
     LIFE_T *life,
     int32_t thread)
 {
-    uint8_t *cell = life->field +
-                    (life->heightRange[thread].startHeight * life->width);
+    // Each thread reads any row of field, but only writes the rows of
+    // fieldNext (and buffer) in its own range, so no locking is needed.
+
+    const uint64_t *field = life->field;
+    int32_t wordsPerRow = life->wordsPerRow;
+    int32_t lastBit = (life->width - 1) & 63;
+    int32_t startRow = life->heightRange[thread].startHeight;
+    int32_t endRow = life->heightRange[thread].endHeight;
 
     int32_t row;
-    for (row = life->heightRange[thread].startHeight ;
-         row < life->heightRange[thread].endHeight ;
-         row++)
+    for (row = startRow ; row < endRow ; row++)
     {
-        int32_t col;
-        for (col = 0 ; col < life->width ; col++)
+        int32_t rowAbove = (row == 0) ? life->height - 1 : row - 1;
+        int32_t rowBelow = (row == life->height - 1) ? 0 : row + 1;
+
+        const uint64_t *above = field + ((size_t)rowAbove * wordsPerRow);
+        const uint64_t *middle = field + ((size_t)row * wordsPerRow);
+        const uint64_t *below = field + ((size_t)rowBelow * wordsPerRow);
+        uint64_t *next = life->fieldNext + ((size_t)row * wordsPerRow);
+
+        int32_t word;
+        for (word = 0 ; word < wordsPerRow ; word++)
         {
-            uint8_t neighbours = *cell >> 1;
-
-            if (*cell & 0x01)
-            {
-                if ((neighbours != 2) && (neighbours != 3))
-                {
-                    clearCell(life, col, row);
-                }
-            }
-            else
-            {
-                if (neighbours == 3)
-                {
-                    setCell(life, col, row);
-                }
-            }
-
-            ++cell;
+            uint64_t aw, ae, mw, me, bw, be;
+
+            neighbourWords(above, word, wordsPerRow, lastBit, &aw, &ae);
+            neighbourWords(middle, word, wordsPerRow, lastBit, &mw, &me);
+            neighbourWords(below, word, wordsPerRow, lastBit, &bw, &be);
+
+            uint64_t a = above[word];
+            uint64_t m = middle[word];
+            uint64_t b = below[word];
+
+            // Add up the eight neighbours of all 64 cells at once. Each
+            // row gives a two bit sum (carry, sum).
+
+            uint64_t aSum = aw ^ a ^ ae;
+            uint64_t aCarry = (aw & a) | (ae & (aw ^ a));
+            uint64_t bSum = bw ^ b ^ be;
+            uint64_t bCarry = (bw & b) | (be & (bw ^ b));
+            uint64_t mSum = mw ^ me;
+            uint64_t mCarry = mw & me;
+
+            // neighbours = ones + 2 * (aCarry + bCarry + mCarry + carry)
+
+            uint64_t ones = aSum ^ bSum ^ mSum;
+            uint64_t carry = (aSum & bSum) | (mSum & (aSum ^ bSum));
+
+            // The count is 2 or 3 when exactly one of the four carries
+            // is set. A cell is live next generation with 3 neighbours,
+            // or with 2 neighbours if it is already live.
+
+            uint64_t twoOrThree = ((aCarry ^ bCarry) ^ (mCarry ^ carry))
+                                & ~(aCarry & bCarry)
+                                & ~(mCarry & carry);
+
+            next[word] = twoOrThree & (ones | m);
         }
+
+        next[wordsPerRow - 1] &= life->lastWordMask;
     }
+
+    drawLifeRows(life, life->fieldNext, startRow, endRow);
 }
 
 //-------------------------------------------------------------------------
@@ -387,7 +501,7 @@ iterateLife(
     pthread_barrier_wait(&(life->finishedIterationBarrier));
 
     int result = 0;
-    VC_IMAGE_TYPE_T type = VC_IMAGE_RGBA16;
+    VC_IMAGE_TYPE_T type = VC_IMAGE_8BPP;
 
     result = vc_dispmanx_resource_write_data(life->backResource,
                                              type,
@@ -396,7 +510,12 @@ iterateLife(
                                              &(life->bmpRect));
     assert(result == 0);
 
-    memcpy(life->field, life->fieldNext, life->fieldLength);
+    // swap field and fieldNext
+
+    uint64_t *tmp = life->field;
+    life->field = life->fieldNext;
+    life->fieldNext = tmp;
+
     pthread_barrier_wait(&(life->startIterationBarrier));
 }
 
@@ -426,6 +545,27 @@ void
 destroyLife(
     LIFE_T *life)
 {
+    // Let the workers finish the generation they are on, then start them
+    // again with stopping set so that they return, before freeing the
+    // fields they use.
+
+    pthread_barrier_wait(&(life->finishedIterationBarrier));
+    life->stopping = true;
+    pthread_barrier_wait(&(life->startIterationBarrier));
+
+    int32_t thread;
+    for (thread = 0 ; thread < life->numberOfThreads ; thread++)
+    {
+        pthread_join(life->threads[thread], NULL);
+    }
+
+    pthread_barrier_destroy(&(life->startIterationBarrier));
+    pthread_barrier_destroy(&(life->finishedIterationBarrier));
+
+    life->numberOfThreads = 0;
+
+    //---------------------------------------------------------------------
+
     if (life->buffer)
     {
         free(life->buffer);
@@ -445,11 +585,12 @@ destroyLife(
     }
 
     life->width = 0;
-    life->alignedWidth = 0;
     life->height = 0;
+    life->wordsPerRow = 0;
+    life->viewWidth = 0;
+    life->viewHeight = 0;
     life->alignedHeight = 0;
     life->pitch = 0;
-    life->fieldLength = 0;
 
     //---------------------------------------------------------------------
 
@@ -468,13 +609,5 @@ destroyLife(
     assert(result == 0);
     result = vc_dispmanx_resource_delete(life->backResource);
     assert(result == 0);
-
-    //---------------------------------------------------------------------
-
-    int32_t thread;
-    for (thread = 0 ; thread < life->numberOfThreads ; thread++)
-    {
-        pthread_cancel(life->threads[thread]);
-    }
 }
 
@@ -29,13 +29,14 @@
 #define LIFE_H
 
 #include <pthread.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "bcm_host.h"
 
 //-------------------------------------------------------------------------
 
-#define LIFE_MAX_THREADS 4
+#define LIFE_MAX_THREADS 64
 
 //-------------------------------------------------------------------------
 
@@ -47,17 +48,26 @@ typedef struct
 
 //-------------------------------------------------------------------------
 
+// The field is stored one bit per cell, packed into 64 bit words. Bit n
+// of word w in a row holds column (64 * w) + n. Only the top left
+// viewWidth x viewHeight cells are expanded into the 8 bit buffer that
+// is copied to the display, so the field can be much larger than the
+// biggest resource the display will take.
+
 typedef struct
 {
     int32_t width;
-    int32_t alignedWidth;
     int32_t height;
+    int32_t wordsPerRow;
+    uint64_t lastWordMask;
+    uint64_t *field;
+    uint64_t *fieldNext;
+
+    int32_t viewWidth;
+    int32_t viewHeight;
     int32_t alignedHeight;
     int32_t pitch;
     uint8_t *buffer;
-    int32_t fieldLength;
-    uint8_t *field;
-    uint8_t *fieldNext;
 
     VC_RECT_T bmpRect;
     VC_RECT_T srcRect;
@@ -67,6 +77,7 @@ typedef struct
     DISPMANX_ELEMENT_HANDLE_T element;
 
     int32_t numberOfThreads;
+    bool stopping;
     pthread_t threads[LIFE_MAX_THREADS];
     LIFE_HEIGHT_RANGE_T heightRange[LIFE_MAX_THREADS];
     pthread_barrier_t startIterationBarrier;
@@ -75,7 +86,12 @@ typedef struct
 
 //-------------------------------------------------------------------------
 
-void newLife(LIFE_T *life, int32_t size);
+void
+newLife(
+    LIFE_T *life,
+    int32_t size,
+    int32_t viewSize,
+    uint32_t seed);
 
 void
 addElementLife(
@@ -0,0 +1,370 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bcm_host.h"
+
+#include "life.h"
+
+//-------------------------------------------------------------------------
+
+#define NDEBUG
+
+//-------------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-------------------------------------------------------------------------
+
+// Field sizes to check: tiny fields where a cell is its own neighbour,
+// and sizes either side of the 64 cell words, so that the last word of a
+// row is partly used and the wrap around crosses words.
+
+static const int32_t sizes[] = { 1, 2, 3, 7, 63, 64, 65, 100, 127, 128,
+                                 129, 191, 257, 300 };
+
+#define LIFECHECK_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+
+//-------------------------------------------------------------------------
+
+static uint8_t *
+allocateCells(
+    int32_t size)
+{
+    uint8_t *cells = calloc((size_t)size * size, 1);
+
+    if (cells == NULL)
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    return cells;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+packedCell(
+    const LIFE_T *life,
+    int32_t col,
+    int32_t row)
+{
+    const uint64_t *words = life->field + ((size_t)row * life->wordsPerRow);
+
+    return (words[col / 64] >> (col % 64)) & 1;
+}
+
+//-------------------------------------------------------------------------
+
+// One generation the slow way, one cell at a time. The field wraps around
+// at each edge.
+
+static void
+iterateReference(
+    const uint8_t *cells,
+    uint8_t *next,
+    int32_t size)
+{
+    int32_t row;
+    for (row = 0 ; row < size ; row++)
+    {
+        int32_t col;
+        for (col = 0 ; col < size ; col++)
+        {
+            int32_t neighbours = 0;
+
+            int32_t dy;
+            for (dy = -1 ; dy <= 1 ; dy++)
+            {
+                int32_t y = (row + dy + size) % size;
+
+                int32_t dx;
+                for (dx = -1 ; dx <= 1 ; dx++)
+                {
+                    int32_t x = (col + dx + size) % size;
+
+                    if ((dx != 0) || (dy != 0))
+                    {
+                        neighbours += cells[x + (y * size)];
+                    }
+                }
+            }
+
+            bool live = cells[col + (row * size)];
+
+            next[col + (row * size)] = (neighbours == 3) ||
+                                       (live && (neighbours == 2));
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Compare the packed field with the reference, including the unused bits
+// at the end of each row, which must stay clear.
+
+static bool
+sameField(
+    const LIFE_T *life,
+    const uint8_t *cells,
+    int32_t generation)
+{
+    int32_t size = life->width;
+
+    int32_t row;
+    for (row = 0 ; row < size ; row++)
+    {
+        int32_t col;
+        for (col = 0 ; col < size ; col++)
+        {
+            if (packedCell(life, col, row) != cells[col + (row * size)])
+            {
+                fprintf(stderr,
+                        "%s: size %d generation %d differs at (%d, %d)\n",
+                        program,
+                        size,
+                        generation,
+                        col,
+                        row);
+                return false;
+            }
+        }
+
+        const uint64_t *words = life->field
+                              + ((size_t)row * life->wordsPerRow);
+
+        if (words[life->wordsPerRow - 1] & ~(life->lastWordMask))
+        {
+            fprintf(stderr,
+                    "%s: size %d generation %d has cells past the end"
+                    " of row %d\n",
+                    program,
+                    size,
+                    generation,
+                    row);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+checkSize(
+    int32_t size,
+    int32_t generations,
+    uint32_t seed,
+    DISPMANX_DISPLAY_HANDLE_T display)
+{
+    int32_t viewSize = (size < 256) ? size : 256;
+
+    LIFE_T life;
+    newLife(&life, size, viewSize, seed);
+
+    DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
+    assert(update != 0);
+
+    addElementLife(&life, 0, 0, viewSize, display, update);
+
+    int result = vc_dispmanx_update_submit_sync(update);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    uint8_t *cells = allocateCells(size);
+    uint8_t *next = allocateCells(size);
+
+    int32_t row;
+    for (row = 0 ; row < size ; row++)
+    {
+        int32_t col;
+        for (col = 0 ; col < size ; col++)
+        {
+            cells[col + (row * size)] = packedCell(&life, col, row);
+        }
+    }
+
+    // The workers start on the first generation in newLife() and
+    // iterateLife() waits for them, so after it returns field holds the
+    // next generation. The workers only ever write fieldNext, so field
+    // can be read while they work on the one after.
+
+    bool same = true;
+    int32_t live = 0;
+
+    int32_t generation;
+    for (generation = 1 ; (generation <= generations) && same ; generation++)
+    {
+        iterateLife(&life);
+
+        iterateReference(cells, next, size);
+
+        uint8_t *tmp = cells;
+        cells = next;
+        next = tmp;
+
+        same = sameField(&life, cells, generation);
+    }
+
+    int32_t i;
+    for (i = 0 ; i < size * size ; i++)
+    {
+        live += cells[i];
+    }
+
+    if (same)
+    {
+        printf("%5d x %-5d %5d generations match, %d cells live\n",
+               size,
+               size,
+               generations,
+               live);
+    }
+
+    free(cells);
+    free(next);
+
+    destroyLife(&life);
+
+    return same;
+}
+
+//-------------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s ", program);
+    fprintf(stderr, "[-d <number>] [-g <generations>] [-r <seed>] ");
+    fprintf(stderr, "[-s <size>]\n");
+    fprintf(stderr, "    -d - Raspberry Pi display number\n");
+    fprintf(stderr, "    -g - generations to compare (default 100)\n");
+    fprintf(stderr, "    -r - seed for the random start (default 1)\n");
+    fprintf(stderr, "    -s - only check a field of this size\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    uint32_t displayNumber = 0;
+    int32_t generations = 100;
+    uint32_t seed = 1;
+    int32_t size = 0;
+
+    program = basename(argv[0]);
+
+    //---------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "d:g:r:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+
+            displayNumber = atoi(optarg);
+            break;
+
+        case 'g':
+
+            generations = atoi(optarg);
+            break;
+
+        case 'r':
+
+            seed = strtoul(optarg, NULL, 10);
+            break;
+
+        case 's':
+
+            size = atoi(optarg);
+
+            if (size < 1)
+            {
+                usage();
+            }
+
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    bcm_host_init();
+
+    DISPMANX_DISPLAY_HANDLE_T display
+        = vc_dispmanx_display_open(displayNumber);
+    assert(display != 0);
+
+    //---------------------------------------------------------------------
+
+    bool result = true;
+
+    if (size > 0)
+    {
+        result = checkSize(size, generations, seed, display);
+    }
+    else
+    {
+        size_t i;
+        for (i = 0 ; i < LIFECHECK_SIZES ; i++)
+        {
+            if (checkSize(sizes[i], generations, seed, display) == false)
+            {
+                result = false;
+            }
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    int status = vc_dispmanx_display_close(display);
+    assert(status == 0);
+
+    return (result) ? 0 : EXIT_FAILURE;
+}
+
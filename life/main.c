@@ -56,10 +56,12 @@ int main(int argc, char *argv[])
     int opt = 0;
     int32_t size = 0;
     uint32_t displayNumber = 0;
+    bool seedSet = false;
+    uint32_t seed = 0;
 
     //-------------------------------------------------------------------
 
-    while ((opt = getopt(argc, argv, "d:s:")) != -1)
+    while ((opt = getopt(argc, argv, "d:r:s:")) != -1)
     {
         switch (opt)
         {
@@ -68,6 +70,12 @@ int main(int argc, char *argv[])
             displayNumber = atoi(optarg);
             break;
 
+        case 'r':
+
+            seed = strtoul(optarg, NULL, 10);
+            seedSet = true;
+            break;
+
         case 's':
 
             size = atoi(optarg);
@@ -76,11 +84,12 @@ int main(int argc, char *argv[])
         default:
 
             fprintf(stderr,
-                    "Usage: %s [-d <number>] [-s <size>]\n",
+                    "Usage: %s [-d <number>] [-r <seed>] [-s <size>]\n",
                     basename(argv[0]));
 
             fprintf(stderr, "    -d - Raspberry Pi display number\n");
-            fprintf(stderr, "    -s - size of image to create\n");
+            fprintf(stderr, "    -r - seed for the random start\n");
+            fprintf(stderr, "    -s - size of field to create\n");
             exit(EXIT_FAILURE);
             break;
         }
@@ -110,14 +119,26 @@ int main(int argc, char *argv[])
         size = info.height;
     }
 
-    if (size > info.height)
+    // The field may be larger than the display, in which case only the
+    // top left corner of it is shown.
+
+    int32_t viewSize = size;
+
+    if (viewSize > info.height)
+    {
+        viewSize = info.height;
+    }
+
+    if (viewSize > info.width)
     {
-        size = info.height;
+        viewSize = info.width;
     }
 
-    if (size > info.width)
+    if (seedSet == false)
     {
-        size = info.width;
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        seed = tv.tv_sec ^ tv.tv_usec;
     }
 
     //---------------------------------------------------------------------
@@ -132,13 +153,16 @@ int main(int argc, char *argv[])
                    VC_IMAGE_RGBA16);
     createResourceImageLayer(&infoLayer, 2);
 
+    FONT_CACHE_T fontCache;
+    initFontCache(&fontCache);
+
     //---------------------------------------------------------------------
 
     BACKGROUND_LAYER_T bg;
     initBackgroundLayer(&bg, 0x000F, 0);
 
     LIFE_T life;
-    newLife(&life, size);
+    newLife(&life, size, viewSize, seed);
 
     //---------------------------------------------------------------------
 
@@ -147,11 +171,11 @@ int main(int argc, char *argv[])
 
     //---------------------------------------------------------------------
 
-    int32_t dstSize = size;
+    int32_t dstSize = viewSize;
     
     if (dstSize < info.height)
     {
-        dstSize = info.height - (info.height % size);
+        dstSize = info.height - (info.height % viewSize);
     }
 
     //---------------------------------------------------------------------
@@ -177,7 +201,13 @@ int main(int argc, char *argv[])
                                display,
                                update);
 
-    lifeInfo(&infoLayer, size, false, life.numberOfThreads, false, 0.0);
+    lifeInfo(&infoLayer,
+             &fontCache,
+             size,
+             false,
+             life.numberOfThreads,
+             false,
+             0.0);
 
     //---------------------------------------------------------------------
 
@@ -220,6 +250,7 @@ int main(int argc, char *argv[])
                 paused = !paused;
 
                 lifeInfo(&infoLayer,
+                         &fontCache,
                          size,
                          paused,
                          life.numberOfThreads,
@@ -252,6 +283,7 @@ int main(int argc, char *argv[])
             double frames_per_second = 2.0e5 / time_taken;
 
             lifeInfo(&infoLayer,
+                     &fontCache,
                      size,
                      paused,
                      life.numberOfThreads,
@@ -292,6 +324,7 @@ int main(int argc, char *argv[])
     destroyBackgroundLayer(&bg);
     destroyLife(&life);
     destroyImageLayer(&infoLayer);
+    destroyFontCache(&fontCache);
 
     //---------------------------------------------------------------------
 
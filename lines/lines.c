@@ -0,0 +1,270 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "bcm_host.h"
+
+#include "backgroundLayer.h"
+#include "image.h"
+#include "imageGraphics.h"
+#include "imageLayer.h"
+#include "key.h"
+
+//-----------------------------------------------------------------------
+
+#define NDEBUG
+
+//-----------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-----------------------------------------------------------------------
+
+static void
+drawLines(
+    IMAGE_T *image,
+    uint32_t number,
+    bool antiAliased)
+{
+    static RGBA8_T clear = { 0, 0, 0, 0 };
+    clearImageRGB(image, &clear);
+
+    uint32_t i;
+    for (i = 0 ; i < number ; i++)
+    {
+        int32_t x1 = rand() % image->width;
+        int32_t y1 = rand() % image->height;
+        int32_t x2 = rand() % image->width;
+        int32_t y2 = rand() % image->height;
+
+        RGBA8_T colour = { rand() % 256, rand() % 256, rand() % 256, 255 };
+
+        if (antiAliased)
+        {
+            imageLineAntiAliasedRGB(image, x1, y1, x2, y2, &colour);
+        }
+        else
+        {
+            imageLineRGB(image, x1, y1, x2, y2, &colour);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    int opt = 0;
+
+    const char* imageTypeName = "RGBA32";
+    VC_IMAGE_TYPE_T imageType = VC_IMAGE_MIN;
+    uint16_t background = 0x000F;
+    uint32_t displayNumber = 0;
+    uint32_t number_of_lines = 100000;
+    bool antiAliased = false;
+
+    program = basename(argv[0]);
+
+    //-------------------------------------------------------------------
+
+    while ((opt = getopt(argc, argv, "ab:d:n:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a':
+
+            antiAliased = true;
+            break;
+
+        case 'b':
+
+            background = strtol(optarg, NULL, 16);
+            break;
+
+        case 'd':
+
+            displayNumber = strtol(optarg, NULL, 10);
+            break;
+
+        case 'n':
+
+            number_of_lines = strtol(optarg, NULL, 10);
+            break;
+
+        case 't':
+
+            imageTypeName = optarg;
+            break;
+
+        default:
+
+            fprintf(stderr, "Usage: %s \n", program);
+            fprintf(stderr, "[-a] [-b <RGBA>] [-d <number>] [-n <number>]");
+            fprintf(stderr, " [-t <type>]\n");
+            fprintf(stderr, "    -a - draw anti-aliased lines\n");
+            fprintf(stderr, "    -b - set background colour 16 bit RGBA\n");
+            fprintf(stderr, "         e.g. 0x000F is opaque black\n");
+            fprintf(stderr, "    -d - Raspberry Pi display number\n");
+            fprintf(stderr, "    -n - lines drawn each frame ");
+            fprintf(stderr, "(default 100000)\n");
+            fprintf(stderr, "    -t - type of image to create\n");
+            fprintf(stderr, "         can be one of the following:");
+            printImageTypes(stderr,
+                            " ",
+                            "",
+                            IMAGE_TYPES_WITH_ALPHA |
+                            IMAGE_TYPES_DIRECT_COLOUR);
+            fprintf(stderr, "\n");
+
+            exit(EXIT_FAILURE);
+            break;
+        }
+    }
+
+    //-------------------------------------------------------------------
+
+    IMAGE_TYPE_INFO_T typeInfo;
+
+    if (findImageType(&typeInfo,
+                      imageTypeName,
+                      IMAGE_TYPES_WITH_ALPHA | IMAGE_TYPES_DIRECT_COLOUR))
+    {
+        imageType = typeInfo.type;
+    }
+    else
+    {
+        fprintf(stderr,
+                "%s: unknown image type %s\n",
+                program,
+                imageTypeName);
+
+        exit(EXIT_FAILURE);
+    }
+
+    //---------------------------------------------------------------------
+
+    bcm_host_init();
+
+    //---------------------------------------------------------------------
+
+    DISPMANX_DISPLAY_HANDLE_T display
+        = vc_dispmanx_display_open(displayNumber);
+    assert(display != 0);
+
+    //---------------------------------------------------------------------
+
+    DISPMANX_MODEINFO_T info;
+    int result = vc_dispmanx_display_get_info(display, &info);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    BACKGROUND_LAYER_T backgroundLayer;
+    initBackgroundLayer(&backgroundLayer, background, 0);
+
+    IMAGE_LAYER_T linesLayer;
+    initImageLayer(&linesLayer, info.width, info.height, imageType);
+    createResourceImageLayer(&linesLayer, 1);
+
+    //---------------------------------------------------------------------
+
+    DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
+    assert(update != 0);
+
+    addElementBackgroundLayer(&backgroundLayer, display, update);
+    addElementImageLayerCentered(&linesLayer, &info, display, update);
+
+    result = vc_dispmanx_update_submit_sync(update);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    struct timeval start_time;
+    gettimeofday(&start_time, NULL);
+
+    //---------------------------------------------------------------------
+
+    int c = 0;
+    uint32_t frame = 0;
+
+    while (c != 27)
+    {
+        keyPressed(&c);
+
+        //-----------------------------------------------------------------
+
+        drawLines(&(linesLayer.image), number_of_lines, antiAliased);
+        changeSourceAndUpdateImageLayer(&linesLayer);
+
+        //-----------------------------------------------------------------
+
+        ++frame;
+    }
+
+    //---------------------------------------------------------------------
+
+    struct timeval end_time;
+    gettimeofday(&end_time, NULL);
+
+    struct timeval diff;
+    timersub(&end_time, &start_time, &diff);
+
+    int32_t time_taken = (diff.tv_sec * 1000000) + diff.tv_usec;
+    double frames_per_second = (frame * 1000000.0) / time_taken;
+
+    printf("%0.1f frames per second, %0.0f lines per second\n",
+           frames_per_second,
+           frames_per_second * number_of_lines);
+
+    //---------------------------------------------------------------------
+
+    keyboardReset();
+
+    //---------------------------------------------------------------------
+
+    destroyBackgroundLayer(&backgroundLayer);
+    destroyImageLayer(&linesLayer);
+
+    //---------------------------------------------------------------------
+
+    result = vc_dispmanx_display_close(display);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    return 0;
+}
+
@@ -0,0 +1,277 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <math.h>
+
+#include "fixed.h"
+
+//-------------------------------------------------------------------------
+
+static int
+compareMagnitude(
+    const FIXED_T *a,
+    const FIXED_T *b)
+{
+    int32_t i;
+    for (i = FIXED_LIMBS - 1 ; i >= 0 ; i--)
+    {
+        if (a->limbs[i] != b->limbs[i])
+        {
+            return (a->limbs[i] > b->limbs[i]) ? 1 : -1;
+        }
+    }
+
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+
+static bool
+isZero(
+    const FIXED_T *value)
+{
+    int32_t i;
+    for (i = 0 ; i < FIXED_LIMBS ; i++)
+    {
+        if (value->limbs[i] != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+static void
+addMagnitude(
+    uint32_t *result,
+    const uint32_t *a,
+    const uint32_t *b)
+{
+    uint64_t carry = 0;
+
+    int32_t i;
+    for (i = 0 ; i < FIXED_LIMBS ; i++)
+    {
+        uint64_t sum = (uint64_t)a[i] + b[i] + carry;
+        result[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// a must not be smaller than b
+
+static void
+subMagnitude(
+    uint32_t *result,
+    const uint32_t *a,
+    const uint32_t *b)
+{
+    int64_t borrow = 0;
+
+    int32_t i;
+    for (i = 0 ; i < FIXED_LIMBS ; i++)
+    {
+        int64_t difference = (int64_t)a[i] - b[i] - borrow;
+        borrow = (difference < 0) ? 1 : 0;
+        result[i] = (uint32_t)difference;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+void
+fixedFromDouble(
+    FIXED_T *result,
+    double value)
+{
+    result->negative = (value < 0.0);
+
+    double magnitude = fabs(value);
+    double integer = floor(magnitude);
+    double fraction = magnitude - integer;
+
+    result->limbs[FIXED_LIMBS - 1] = (uint32_t)integer;
+
+    // each step is exact, as it only scales by a power of two and
+    // removes the integer part
+
+    int32_t i;
+    for (i = FIXED_LIMBS - 2 ; i >= 0 ; i--)
+    {
+        fraction = ldexp(fraction, 32);
+
+        double limb = floor(fraction);
+        result->limbs[i] = (uint32_t)limb;
+        fraction -= limb;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+double
+fixedToDouble(
+    const FIXED_T *value)
+{
+    double result = 0.0;
+
+    int32_t i;
+    for (i = 0 ; i < FIXED_LIMBS ; i++)
+    {
+        result += ldexp(value->limbs[i], 32 * (i - (FIXED_LIMBS - 1)));
+    }
+
+    return (value->negative) ? -result : result;
+}
+
+//-------------------------------------------------------------------------
+
+void
+fixedAdd(
+    FIXED_T *result,
+    const FIXED_T *a,
+    const FIXED_T *b)
+{
+    FIXED_T sum;
+
+    if (a->negative == b->negative)
+    {
+        addMagnitude(sum.limbs, a->limbs, b->limbs);
+        sum.negative = a->negative;
+    }
+    else if (compareMagnitude(a, b) >= 0)
+    {
+        subMagnitude(sum.limbs, a->limbs, b->limbs);
+        sum.negative = a->negative;
+    }
+    else
+    {
+        subMagnitude(sum.limbs, b->limbs, a->limbs);
+        sum.negative = b->negative;
+    }
+
+    if (isZero(&sum))
+    {
+        sum.negative = false;
+    }
+
+    *result = sum;
+}
+
+//-------------------------------------------------------------------------
+
+void
+fixedSub(
+    FIXED_T *result,
+    const FIXED_T *a,
+    const FIXED_T *b)
+{
+    FIXED_T negated = *b;
+    negated.negative = !(b->negative);
+
+    fixedAdd(result, a, &negated);
+}
+
+//-------------------------------------------------------------------------
+
+void
+fixedMul(
+    FIXED_T *result,
+    const FIXED_T *a,
+    const FIXED_T *b)
+{
+    // Only the partial products that reach the kept limbs (or carry into
+    // the lowest of them) are formed, so the result can be a few units
+    // out in the last limb. Any overflow of the integer part is lost.
+
+    uint64_t columns[2 * FIXED_LIMBS];
+    int32_t lowest = FIXED_LIMBS - 2;
+
+    int32_t i;
+    for (i = 0 ; i < 2 * FIXED_LIMBS ; i++)
+    {
+        columns[i] = 0;
+    }
+
+    for (i = 0 ; i < FIXED_LIMBS ; i++)
+    {
+        if (a->limbs[i] == 0)
+        {
+            continue;
+        }
+
+        int32_t j = lowest - i;
+
+        if (j < 0)
+        {
+            j = 0;
+        }
+
+        for ( ; j < FIXED_LIMBS ; j++)
+        {
+            uint64_t product = (uint64_t)(a->limbs[i]) * b->limbs[j];
+            columns[i + j] += (uint32_t)product;
+            columns[i + j + 1] += product >> 32;
+        }
+    }
+
+    FIXED_T product;
+    uint64_t carry = 0;
+
+    for (i = lowest ; i < (2 * FIXED_LIMBS) - 1 ; i++)
+    {
+        uint64_t column = columns[i] + carry;
+        carry = column >> 32;
+
+        if (i >= FIXED_LIMBS - 1)
+        {
+            product.limbs[i - (FIXED_LIMBS - 1)] = (uint32_t)column;
+        }
+    }
+
+    product.negative = (a->negative != b->negative) && !isZero(&product);
+
+    *result = product;
+}
+
+//-------------------------------------------------------------------------
+
+void
+fixedAddDouble(
+    FIXED_T *result,
+    const FIXED_T *a,
+    double b)
+{
+    FIXED_T value;
+    fixedFromDouble(&value, b);
+    fixedAdd(result, a, &value);
+}
@@ -0,0 +1,90 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//-------------------------------------------------------------------------
+
+// Fixed point numbers with a 32 bit integer part and
+// 32 * (FIXED_LIMBS - 1) fraction bits, stored as a sign and a magnitude.
+// limbs[FIXED_LIMBS - 1] is the integer part and limbs[0] the least
+// significant part of the fraction. This is enough for the position of a
+// pixel anywhere down to the smallest normal double.
+
+#define FIXED_LIMBS 32
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    bool negative;
+    uint32_t limbs[FIXED_LIMBS];
+} FIXED_T;
+
+//-------------------------------------------------------------------------
+
+void
+fixedFromDouble(
+    FIXED_T *result,
+    double value);
+
+double
+fixedToDouble(
+    const FIXED_T *value);
+
+void
+fixedAdd(
+    FIXED_T *result,
+    const FIXED_T *a,
+    const FIXED_T *b);
+
+void
+fixedSub(
+    FIXED_T *result,
+    const FIXED_T *a,
+    const FIXED_T *b);
+
+void
+fixedMul(
+    FIXED_T *result,
+    const FIXED_T *a,
+    const FIXED_T *b);
+
+void
+fixedAddDouble(
+    FIXED_T *result,
+    const FIXED_T *a,
+    double b);
+
+//-------------------------------------------------------------------------
+
+#endif
@@ -25,9 +25,12 @@
 //
 //-------------------------------------------------------------------------
 
+
 #include <stdint.h>
+#include <string.h>
 
 #include "font.h"
+#include "imageBlit.h"
 #include "imageGraphics.h"
 #include "imageKey.h"
 #include "imageLayer.h"
@@ -38,11 +41,132 @@
 #define INFO_LEFT_PADDING 4
 #define INFO_TOP_PADDING 4
 
+// The bottom line of the panel is kept for the state of the save queue.
+
+#define INFO_STATUS_Y(image) \
+    ((image)->height - FONT_HEIGHT - INFO_TOP_PADDING)
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    const char *text;
+    const char *description;
+} INFO_KEY_T;
+
+static const INFO_KEY_T mandelbrotKeys[] =
+{
+    { "Esc", "exit" },
+    { "Z", "zoom in" },
+    { "S", "save PNG file" },
+    { "C", "cycle colours" }
+};
+
+#define INFO_MANDELBROT_KEYS \
+    (sizeof(mandelbrotKeys) / sizeof(mandelbrotKeys[0]))
+
+static const INFO_KEY_T zoomKeys[] =
+{
+    { "Enter", "zoom" },
+    { "Esc", "cancel zoom" },
+    { "W", "move up" },
+    { "A", "move left" },
+    { "S", "move down" },
+    { "D", "mode right" },
+    { "[", "decrease step" },
+    { "]", "increase step" }
+};
+
+#define INFO_ZOOM_KEYS (sizeof(zoomKeys) / sizeof(zoomKeys[0]))
+
+//-------------------------------------------------------------------------
+
+void
+initInfoPanel(
+    INFO_PANEL_T *panel)
+{
+    memset(panel, 0, sizeof(*panel));
+    initFontCache(&(panel->fontCache));
+}
+
+//-------------------------------------------------------------------------
+
+void
+destroyInfoPanel(
+    INFO_PANEL_T *panel)
+{
+    destroyFontCache(&(panel->fontCache));
+
+    if (panel->mandelbrotKeys.buffer != NULL)
+    {
+        destroyImage(&(panel->mandelbrotKeys));
+    }
+
+    if (panel->zoomKeys.buffer != NULL)
+    {
+        destroyImage(&(panel->zoomKeys));
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Draw a column of keys at the top of the panel and return the y
+// coordinate below them. The keys don't change, so the first time they
+// are drawn they are copied into 'keys' and after that they are blitted
+// from it.
+
+static int32_t
+keysInfo(
+    IMAGE_LAYER_T *imageLayer,
+    INFO_PANEL_T *panel,
+    IMAGE_T *keys,
+    const INFO_KEY_T *table,
+    size_t count)
+{
+    IMAGE_T *image = &(imageLayer->image);
+
+    if (keys->buffer != NULL)
+    {
+        imageBlit(image, 0, 0, keys, NULL, IMAGE_BLIT_COPY, 255);
+        return keys->height;
+    }
+
+    KEY_DIMENSIONS_T key_dimensions = { 0, 0 };
+    int32_t x = INFO_LEFT_PADDING;
+    int32_t y = 0;
+
+    size_t i;
+    for (i = 0 ; i < count ; i++)
+    {
+        y += key_dimensions.height + INFO_TOP_PADDING;
+
+        key_dimensions = drawKey(imageLayer,
+                                 &(panel->fontCache),
+                                 x,
+                                 y,
+                                 table[i].text,
+                                 table[i].description);
+    }
+
+    y += key_dimensions.height + INFO_TOP_PADDING;
+
+    if (initImage(keys, image->type, image->width, y, false))
+    {
+        VC_RECT_T rect;
+        vc_dispmanx_rect_set(&rect, 0, 0, image->width, y);
+
+        imageBlit(keys, 0, 0, image, &rect, IMAGE_BLIT_COPY, 255);
+    }
+
+    return y;
+}
+
 //-------------------------------------------------------------------------
 
 void
 calculatingInfo(
     IMAGE_LAYER_T *imageLayer,
+    INFO_PANEL_T *panel,
     int32_t threads)
 {
     static RGBA8_T textColour = { 0, 0, 0, 255 };
@@ -54,11 +178,13 @@ calculatingInfo(
 
     //---------------------------------------------------------------------
 
-    drawStringRGB(INFO_LEFT_PADDING,
-                  INFO_TOP_PADDING,
-                  "Calculating ...",
-                  &textColour,
-                  image);
+    drawStringCachedRGB(&(panel->fontCache),
+                        INFO_LEFT_PADDING,
+                        INFO_TOP_PADDING,
+                        "Calculating ...",
+                        &textColour,
+                        &backgroundColour,
+                        image);
 
     //---------------------------------------------------------------------
 
@@ -66,11 +192,13 @@ calculatingInfo(
 
     snprintf(buffer, sizeof(buffer), "threads: %d", threads);
 
-    drawStringRGB(INFO_LEFT_PADDING,
-                  (2 * INFO_TOP_PADDING) + FONT_HEIGHT,
-                  buffer,
-                  &textColour,
-                  image);
+    drawStringCachedRGB(&(panel->fontCache),
+                        INFO_LEFT_PADDING,
+                        (2 * INFO_TOP_PADDING) + FONT_HEIGHT,
+                        buffer,
+                        &textColour,
+                        &backgroundColour,
+                        image);
 
     changeSourceAndUpdateImageLayer(imageLayer);
 }
@@ -79,7 +207,9 @@ calculatingInfo(
 
 void
 mandelbrotInfo(
-    IMAGE_LAYER_T *imageLayer)
+    IMAGE_LAYER_T *imageLayer,
+    INFO_PANEL_T *panel,
+    MANDELBROT_T *mbrot)
 {
     static RGBA8_T backgroundColour = { 255, 255, 255, 255 };
 
@@ -89,27 +219,55 @@ mandelbrotInfo(
 
     //---------------------------------------------------------------------
 
-    KEY_DIMENSIONS_T key_dimensions = { 0, 0 };
     int32_t x = INFO_LEFT_PADDING;
-    int32_t y = 0;
+    int32_t y = keysInfo(imageLayer,
+                         panel,
+                         &(panel->mandelbrotKeys),
+                         mandelbrotKeys,
+                         INFO_MANDELBROT_KEYS);
 
     //---------------------------------------------------------------------
 
-    y += key_dimensions.height + INFO_TOP_PADDING;
+    static RGBA8_T textColour = { 0, 0, 0, 255 };
 
-    key_dimensions = drawKey(imageLayer, x, y, "Esc", "exit");
+    char buffer[128];
 
-    //---------------------------------------------------------------------
+    snprintf(buffer, sizeof(buffer), "time: %.1f ms", mbrot->milliseconds);
+    drawStringCachedRGB(&(panel->fontCache),
+                        x,
+                        y,
+                        buffer,
+                        &textColour,
+                        &backgroundColour,
+                        image);
 
-    y += key_dimensions.height + INFO_TOP_PADDING;
+    // time and number of tiles for each thread, as many as will fit
 
-    key_dimensions = drawKey(imageLayer, x, y, "Z", "zoom in");
-
-    //---------------------------------------------------------------------
+    int32_t thread;
+    for (thread = 0 ; thread < mbrot->numberOfThreads ; thread++)
+    {
+        y += FONT_HEIGHT + INFO_TOP_PADDING;
 
-    y += key_dimensions.height + INFO_TOP_PADDING;
+        if ((y + FONT_HEIGHT) > INFO_STATUS_Y(image))
+        {
+            break;
+        }
 
-    key_dimensions = drawKey(imageLayer, x, y, "S", "save PNG file");
+        snprintf(buffer,
+                 sizeof(buffer),
+                 "%2d:%6.1fms %4d",
+                 thread,
+                 mbrot->timing[thread].milliseconds,
+                 mbrot->timing[thread].tiles);
+
+        drawStringCachedRGB(&(panel->fontCache),
+                            x,
+                            y,
+                            buffer,
+                            &textColour,
+                            &backgroundColour,
+                            image);
+    }
 
     //---------------------------------------------------------------------
 
@@ -121,6 +279,7 @@ mandelbrotInfo(
 void
 zoomInfo(
     IMAGE_LAYER_T *imageLayer,
+    INFO_PANEL_T *panel,
     int32_t *steps,
     int32_t numberOfSteps,
     int32_t stepIndex)
@@ -134,67 +293,24 @@ zoomInfo(
     //---------------------------------------------------------------------
 
     int32_t x = INFO_LEFT_PADDING;
-    int32_t y = 0;
-
-    KEY_DIMENSIONS_T key_dimensions = { 0, 0 };
-
-    //---------------------------------------------------------------------
-
-    x = INFO_LEFT_PADDING;
-    y += key_dimensions.height + INFO_TOP_PADDING;
-
-    key_dimensions = drawKey(imageLayer, x, y, "Enter", "zoom");
-
-    //---------------------------------------------------------------------
-
-    y += key_dimensions.height + INFO_TOP_PADDING;
-
-    key_dimensions = drawKey(imageLayer, x, y, "Esc", "cancel zoom");
-
-    //---------------------------------------------------------------------
-
-    y += key_dimensions.height + INFO_TOP_PADDING;
-
-    key_dimensions = drawKey(imageLayer, x, y, "W", "move up");
-
-    //---------------------------------------------------------------------
-
-    y += key_dimensions.height + INFO_TOP_PADDING;
-
-    key_dimensions = drawKey(imageLayer, x, y, "A", "move left");
-
-    //---------------------------------------------------------------------
-
-    y += key_dimensions.height + INFO_TOP_PADDING;
-
-    key_dimensions = drawKey(imageLayer, x, y, "S", "move down");
-
-    //---------------------------------------------------------------------
-
-    y += key_dimensions.height + INFO_TOP_PADDING;
-
-    key_dimensions = drawKey(imageLayer, x, y, "D", "mode right");
-
-    //---------------------------------------------------------------------
-
-    y += key_dimensions.height + INFO_TOP_PADDING;
-
-    key_dimensions = drawKey(imageLayer, x, y, "[", "decrease step");
-
-    //---------------------------------------------------------------------
-
-    y += key_dimensions.height + INFO_TOP_PADDING;
-
-    key_dimensions = drawKey(imageLayer, x, y, "]", "increase step");
+    int32_t y = keysInfo(imageLayer,
+                         panel,
+                         &(panel->zoomKeys),
+                         zoomKeys,
+                         INFO_ZOOM_KEYS);
 
     //---------------------------------------------------------------------
 
     static RGBA8_T lowlightColour = { 191, 191, 191, 255 };
     static RGBA8_T highlightColour = { 0, 0, 0, 255 };
 
-    y += key_dimensions.height + INFO_TOP_PADDING;
-
-    drawStringRGB(x, y, "step:", &highlightColour, image);
+    drawStringCachedRGB(&(panel->fontCache),
+                        x,
+                        y,
+                        "step:",
+                        &highlightColour,
+                        &backgroundColour,
+                        image);
 
     y += FONT_HEIGHT + INFO_TOP_PADDING;
 
@@ -212,7 +328,13 @@ zoomInfo(
 
         snprintf(buffer, sizeof(buffer), "%d ", steps[i]);
 
-        drawStringRGB(x, y, buffer, colour, image);
+        drawStringCachedRGB(&(panel->fontCache),
+                            x,
+                            y,
+                            buffer,
+                            colour,
+                            &backgroundColour,
+                            image);
 
         x += strlen(buffer) * FONT_WIDTH;
     }
@@ -222,3 +344,56 @@ zoomInfo(
     changeSourceAndUpdateImageLayer(imageLayer);
 }
 
+//-------------------------------------------------------------------------
+
+void
+saveInfo(
+    IMAGE_LAYER_T *imageLayer,
+    INFO_PANEL_T *panel,
+    const SAVE_QUEUE_STATUS_T *status)
+{
+    static RGBA8_T textColour = { 0, 0, 0, 255 };
+    static RGBA8_T backgroundColour = { 255, 255, 255, 255 };
+
+    IMAGE_T *image = &(imageLayer->image);
+    int32_t y = INFO_STATUS_Y(image);
+
+    imageBoxFilledRGB(image,
+                      0,
+                      y,
+                      image->width - 1,
+                      image->height - 1,
+                      &backgroundColour);
+
+    //---------------------------------------------------------------------
+
+    char buffer[128] = "";
+
+    if (status->full)
+    {
+        snprintf(buffer, sizeof(buffer), "save queue full");
+    }
+    else if (status->queued > 0)
+    {
+        snprintf(buffer, sizeof(buffer), "saving %d ...", status->queued);
+    }
+    else if (status->lastFailed)
+    {
+        snprintf(buffer, sizeof(buffer), "save failed");
+    }
+    else if (status->saved > 0)
+    {
+        snprintf(buffer, sizeof(buffer), "saved %s", status->label);
+    }
+
+    drawStringCachedRGB(&(panel->fontCache),
+                        INFO_LEFT_PADDING,
+                        y,
+                        buffer,
+                        &textColour,
+                        &backgroundColour,
+                        image);
+
+    changeSourceAndUpdateImageLayer(imageLayer);
+}
+
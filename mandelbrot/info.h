@@ -30,26 +30,62 @@
 
 #include <stdint.h>
 
+#include "font.h"
 #include "imageLayer.h"
+#include "mandelbrot.h"
+#include "saveQueue.h"
+
+//-------------------------------------------------------------------------
+
+// The font cache for the panel's text, and the columns of keys, which are
+// drawn once and then blitted into the panel.
+
+typedef struct
+{
+    FONT_CACHE_T fontCache;
+    IMAGE_T mandelbrotKeys;
+    IMAGE_T zoomKeys;
+} INFO_PANEL_T;
 
 //-------------------------------------------------------------------------
 
+void
+initInfoPanel(
+    INFO_PANEL_T *panel);
+
+void
+destroyInfoPanel(
+    INFO_PANEL_T *panel);
+
 void
 calculatingInfo(
     IMAGE_LAYER_T *imageLayer,
+    INFO_PANEL_T *panel,
     int32_t threads);
 
 void
 mandelbrotInfo(
-    IMAGE_LAYER_T *imageLayer);
+    IMAGE_LAYER_T *imageLayer,
+    INFO_PANEL_T *panel,
+    MANDELBROT_T *mbrot);
 
 void
 zoomInfo(
     IMAGE_LAYER_T *imageLayer,
+    INFO_PANEL_T *panel,
     int32_t *steps,
     int32_t numberOfSteps,
     int32_t stepIndex);
 
+// Draws the state of the save queue on the bottom line of the panel, which
+// the other functions leave clear.
+
+void
+saveInfo(
+    IMAGE_LAYER_T *imageLayer,
+    INFO_PANEL_T *panel,
+    const SAVE_QUEUE_STATUS_T *status);
+
 //-------------------------------------------------------------------------
 
 #endif
@@ -32,8 +32,8 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <termio.h>
-#include <time.h>
 #include <unistd.h>
 #include <sys/time.h>
 
@@ -46,7 +46,7 @@
 #include "info.h"
 #include "key.h"
 #include "mandelbrot.h"
-#include "savepng.h"
+#include "saveQueue.h"
 
 //-------------------------------------------------------------------------
 
@@ -58,6 +58,7 @@ bool
 zoom(
     IMAGE_LAYER_T *zoomLayer,
     IMAGE_LAYER_T *infoLayer,
+    INFO_PANEL_T *panel,
     MANDELBROT_COORDS_T *coords)
 {
     bool changed = false;
@@ -84,7 +85,7 @@ zoom(
                       &clearColour);
     changeSourceAndUpdateImageLayer(zoomLayer);
 
-    zoomInfo(infoLayer, steps, numberOfSteps, stepIndex);
+    zoomInfo(infoLayer, panel, steps, numberOfSteps, stepIndex);
 
     int c = 0;
     while ((c != 27) && (changed == false))
@@ -96,6 +97,8 @@ zoom(
             c = tolower(c);
 
             bool update = false;
+            int32_t previousX = x;
+            int32_t previousY = y;
 
             switch (c)
             {
@@ -145,7 +148,11 @@ zoom(
                 if (stepIndex < (numberOfSteps - 1))
                 {
                     step = steps[++stepIndex];
-                    zoomInfo(infoLayer, steps, numberOfSteps, stepIndex);
+                    zoomInfo(infoLayer,
+                             panel,
+                             steps,
+                             numberOfSteps,
+                             stepIndex);
                 }
 
                 break;
@@ -155,7 +162,11 @@ zoom(
                 if (stepIndex > 0)
                 {
                     step = steps[--stepIndex];
-                    zoomInfo(infoLayer, steps, numberOfSteps, stepIndex);
+                    zoomInfo(infoLayer,
+                             panel,
+                             steps,
+                             numberOfSteps,
+                             stepIndex);
                 }
 
                 break;
@@ -163,7 +174,15 @@ zoom(
 
             if (update)
             {
-                clearImageRGB(&(zoomLayer->image), &maskColour);
+                // Only redraw the old and new boxes, so that only their
+                // rows are copied to the resource.
+
+                imageBoxFilledRGB(&(zoomLayer->image),
+                                  previousX,
+                                  previousY,
+                                  previousX + width - 1,
+                                  previousY + height - 1,
+                                  &maskColour);
                 imageBoxFilledRGB(&(zoomLayer->image),
                                   x,
                                   y,
@@ -180,9 +199,24 @@ zoom(
 
     if (changed)
     {
-        coords->x0 += (coords->side * x) / zoomLayer->image.width;
-        coords->y0 += (coords->side * y) / zoomLayer->image.height;
-        coords->side *=  (double)width / zoomLayer->image.width;
+        // Start the new view exactly on a sample of the current view and
+        // zoom by a whole number, so that every ratio'th sample of the
+        // new view has already been calculated.
+
+        double dx = coords->side / (zoomLayer->image.width - 1);
+        double dy = coords->side / (zoomLayer->image.height - 1);
+        int32_t ratio = zoomLayer->image.width / width;
+
+        if ((coords->side / ratio) < MANDELBROT_MINIMUM_SIDE)
+        {
+            changed = false;
+        }
+        else
+        {
+            fixedAddDouble(&(coords->x0), &(coords->x0), dx * x);
+            fixedAddDouble(&(coords->y0), &(coords->y0), dy * y);
+            coords->side /= ratio;
+        }
     }
 
     return changed;
@@ -193,12 +227,13 @@ zoom(
 int main(int argc, char *argv[])
 {
     uint32_t displayNumber = 0;
+    const char *saveFormat = "png";
 
     //-------------------------------------------------------------------
 
     int opt;
 
-    while ((opt = getopt(argc, argv, "d:")) != -1)
+    while ((opt = getopt(argc, argv, "d:f:")) != -1)
     {
         switch (opt)
         {
@@ -207,10 +242,24 @@ int main(int argc, char *argv[])
             displayNumber = atoi(optarg);
             break;
 
+        case 'f':
+
+            if ((strcmp(optarg, "png") == 0) || (strcmp(optarg, "qoi") == 0))
+            {
+                saveFormat = optarg;
+                break;
+            }
+
+            // fall through
+
         default:
 
-            fprintf(stderr, "Usage: %s [-d <number>]\n", basename(argv[0]));
+            fprintf(stderr,
+                    "Usage: %s [-d <number>] [-f <format>]\n",
+                    basename(argv[0]));
             fprintf(stderr, "    -d - Raspberry Pi display number\n");
+            fprintf(stderr, "    -f - format of saved images, ");
+            fprintf(stderr, "png (default) or qoi\n");
             exit(EXIT_FAILURE);
             break;
         }
@@ -254,7 +303,7 @@ int main(int argc, char *argv[])
     initImageLayer(&mandelbrotLayer,
                    mandelbrotLayerSize,
                    mandelbrotLayerSize,
-                   VC_IMAGE_RGB888);
+                   VC_IMAGE_8BPP);
     createResourceImageLayer(&mandelbrotLayer, 1);
 
     IMAGE_LAYER_T zoomLayer;
@@ -271,6 +320,9 @@ int main(int argc, char *argv[])
                    VC_IMAGE_RGBA16);
     createResourceImageLayer(&infoLayer, 2);
 
+    INFO_PANEL_T infoPanel;
+    initInfoPanel(&infoPanel);
+
     //---------------------------------------------------------------------
 
     DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
@@ -309,17 +361,39 @@ int main(int argc, char *argv[])
 
     //---------------------------------------------------------------------
 
-    MANDELBROT_COORDS_T coords = { -2.0, -1.5, 3.0 };
+    MANDELBROT_COORDS_T coords;
+    initCoordsMandelbrot(&coords, -2.0, -1.5, 3.0);
 
-    calculatingInfo(&infoLayer, mandelbrot.numberOfThreads);
+    calculatingInfo(&infoLayer, &infoPanel, mandelbrot.numberOfThreads);
     mandelbrotImage(&mandelbrot, &coords);
-    mandelbrotInfo(&infoLayer);
+    mandelbrotInfo(&infoLayer, &infoPanel, &mandelbrot);
+
+    //---------------------------------------------------------------------
+
+    SAVE_QUEUE_T saveQueue;
+    initSaveQueue(&saveQueue,
+                  mandelbrotLayer.image.width,
+                  mandelbrotLayer.image.height,
+                  saveFormat);
+
+    SAVE_QUEUE_STATUS_T saveStatus;
+    getSaveQueueStatus(&saveQueue, &saveStatus);
 
     //---------------------------------------------------------------------
 
+    bool cycling = false;
+
     int c = 0;
     while (c != 27)
     {
+        uint32_t changes = saveStatus.changes;
+        getSaveQueueStatus(&saveQueue, &saveStatus);
+
+        if (saveStatus.changes != changes)
+        {
+            saveInfo(&infoLayer, &infoPanel, &saveStatus);
+        }
+
         if (keyPressed(&c))
         {
             c = tolower(c);
@@ -327,39 +401,37 @@ int main(int argc, char *argv[])
             switch (c)
             {
             case 's':
-            {
-                time_t now;
-                time(&now);
-
-                struct tm *tm = localtime(&now);
-
-                char filename[128];
-                snprintf(filename,
-                         sizeof(filename),
-                         "mandelbrot_%4d%02d%02d_%2d%02d%02d.png",
-                         tm->tm_year + 1900,
-                         tm->tm_mon,
-                         tm->tm_mday,
-                         tm->tm_hour,
-                         tm->tm_min,
-                         tm->tm_sec);
-
-                savePng(&(mandelbrotLayer.image), filename);
+
+                queueSaveMandelbrot(&saveQueue, &mandelbrot);
                 break;
-            }
+
+            case 'c':
+
+                cycling = !cycling;
+                break;
+
             case 'z':
 
-                if (zoom(&zoomLayer, &infoLayer, &coords))
+                if (zoom(&zoomLayer, &infoLayer, &infoPanel, &coords))
                 {
-                    calculatingInfo(&infoLayer, mandelbrot.numberOfThreads);
+                    calculatingInfo(&infoLayer,
+                                    &infoPanel,
+                                    mandelbrot.numberOfThreads);
                     mandelbrotImage(&mandelbrot, &coords);
                 }
 
-                mandelbrotInfo(&infoLayer);
+                mandelbrotInfo(&infoLayer, &infoPanel, &mandelbrot);
+                saveInfo(&infoLayer, &infoPanel, &saveStatus);
 
                 break;
             }
         }
+        else if (cycling)
+        {
+            setPaletteOffsetMandelbrot(&mandelbrot,
+                                       mandelbrot.paletteOffset + 1);
+            usleep(20000);
+        }
         else
         {
             usleep(100000);
@@ -372,11 +444,13 @@ int main(int argc, char *argv[])
 
     //---------------------------------------------------------------------
 
+    destroySaveQueue(&saveQueue);
     destroyMandelbrot(&mandelbrot);
     destroyBackgroundLayer(&bg);
     destroyImageLayer(&mandelbrotLayer);
     destroyImageLayer(&zoomLayer);
     destroyImageLayer(&infoLayer);
+    destroyInfoPanel(&infoPanel);
 
     //---------------------------------------------------------------------
 
@@ -26,6 +26,20 @@
 //-------------------------------------------------------------------------
 
 #include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#if defined(RASPIDMX_NO_SIMD)
+// plain C only
+#elif defined(__ARM_NEON) && defined(__ARM_64BIT_STATE)
+#include <arm_neon.h>
+#define MANDELBROT_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define MANDELBROT_SSE2
+#endif
 
 #include "bcm_host.h"
 
@@ -35,6 +49,20 @@
 
 //-------------------------------------------------------------------------
 
+void
+initCoordsMandelbrot(
+    MANDELBROT_COORDS_T *coords,
+    double x0,
+    double y0,
+    double side)
+{
+    fixedFromDouble(&(coords->x0), x0);
+    fixedFromDouble(&(coords->y0), y0);
+    coords->side = side;
+}
+
+//-------------------------------------------------------------------------
+
 void
 newMandelbrot(
     MANDELBROT_T *mbrot,
@@ -44,19 +72,46 @@ newMandelbrot(
 
     //---------------------------------------------------------------------
 
-    size_t colours = (sizeof(mbrot->colours) / sizeof(mbrot->colours[0]));
-    size_t colour = 0;
+    // The colours for escape counts 1 to 255 are stored twice, so that
+    // any rotation of them is a contiguous part of the palette.
+
+    int32_t colours = MANDELBROT_COLOURS;
+    int32_t cycle = colours - 1;
+    int32_t colour = 0;
 
     mbrot->numberOfColours = colours;
 
-    for (colour = 0 ; colour < colours ; colour++)
+    initImagePalette32(&(mbrot->palette), 1 + (2 * cycle));
+
+    RGBA8_T rgba = { 0, 0, 0, 255 };
+
+    setPalette32EntryRgba(&(mbrot->palette), 0, &rgba);
+
+    for (colour = 1 ; colour < colours ; colour++)
     {
         hsv2rgb((colours - 1 - colour) * (2400 / colours),
                 1000,
                 1000,
-                &(mbrot->colours[colour]));
+                &rgba);
+        rgba.alpha = 255;
+
+        setPalette32EntryRgba(&(mbrot->palette), colour, &rgba);
+        setPalette32EntryRgba(&(mbrot->palette), colour + cycle, &rgba);
     }
 
+    setResourcePalette32(&(mbrot->palette),
+                         0,
+                         imageLayer->resource,
+                         0,
+                         1);
+
+    mbrot->paletteOffset = 0;
+    setResourcePalette32(&(mbrot->palette),
+                         1,
+                         imageLayer->resource,
+                         1,
+                         cycle);
+
     //---------------------------------------------------------------------
     
     long cores = sysconf(_SC_NPROCESSORS_ONLN);
@@ -75,6 +130,8 @@ newMandelbrot(
         mbrot->numberOfThreads = cores;
     }
 
+    mbrot->stopping = false;
+
     pthread_barrier_init(&(mbrot->startBarrier),
                          NULL,
                          mbrot->numberOfThreads + 1);
@@ -87,18 +144,72 @@ newMandelbrot(
 
     IMAGE_T *image = &(imageLayer->image);
 
+    assert(image->type == VC_IMAGE_8BPP);
+
+    //---------------------------------------------------------------------
+
+    size_t pixels = image->width * image->height;
+
+    mbrot->iterations = malloc(pixels * sizeof(uint16_t));
+    mbrot->previousIterations = malloc(pixels * sizeof(uint16_t));
+    mbrot->columnMap = malloc(image->width * sizeof(int32_t));
+    mbrot->rowMap = malloc(image->height * sizeof(int32_t));
+
+    if ((mbrot->iterations == NULL) ||
+        (mbrot->previousIterations == NULL) ||
+        (mbrot->columnMap == NULL) ||
+        (mbrot->rowMap == NULL))
+    {
+        fprintf(stderr, "mandelbrot: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // nothing has been calculated yet, so there is nothing to reuse
+
+    initCoordsMandelbrot(&(mbrot->coords), 0.0, 0.0, 0.0);
+    mbrot->originX = 0.0;
+    mbrot->originY = 0.0;
+    mbrot->maxIterations = mbrot->numberOfColours;
+    mbrot->deep = false;
+    mbrot->step = 1;
+
+    //---------------------------------------------------------------------
+
+    MANDELBROT_REFERENCE_T *reference = &(mbrot->reference);
+
+    reference->x = malloc((MANDELBROT_MAX_ITERATIONS + 1) * sizeof(double));
+    reference->y = malloc((MANDELBROT_MAX_ITERATIONS + 1) * sizeof(double));
+
+    if ((reference->x == NULL) || (reference->y == NULL))
+    {
+        fprintf(stderr, "mandelbrot: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    reference->length = 0;
+    reference->skip = 0;
+
     //---------------------------------------------------------------------
 
-    int32_t heightStep = image->height / mbrot->numberOfThreads;
-    int32_t heightStart = 0;
+    // The image is split into small tiles that the threads take one at a
+    // time from a shared counter, so a thread that gets cheap tiles just
+    // takes more of them rather than waiting for the others.
+
+    mbrot->tileColumns = (image->width + MANDELBROT_TILE_SIZE - 1)
+                       / MANDELBROT_TILE_SIZE;
+    mbrot->tileRows = (image->height + MANDELBROT_TILE_SIZE - 1)
+                    / MANDELBROT_TILE_SIZE;
+    mbrot->numberOfTiles = mbrot->tileColumns * mbrot->tileRows;
+
+    atomic_init(&(mbrot->nextTile), mbrot->numberOfTiles);
+
+    //---------------------------------------------------------------------
 
     int32_t thread;
     for (thread = 0 ; thread < mbrot->numberOfThreads ; thread++)
     {
-        mbrot->heightRange[thread].startHeight = heightStart;
-        mbrot->heightRange[thread].endHeight = heightStart + heightStep;
-
-        heightStart += heightStep;
+        mbrot->timing[thread].tiles = 0;
+        mbrot->timing[thread].milliseconds = 0.0;
 
         pthread_create(&(mbrot->threads[thread]),
                        NULL,
@@ -106,8 +217,7 @@ newMandelbrot(
                        mbrot);
     }
 
-    thread = mbrot->numberOfThreads - 1;
-    mbrot->heightRange[thread].endHeight = image->height;
+    mbrot->milliseconds = 0.0;
 }
 
 //-------------------------------------------------------------------------
@@ -116,11 +226,43 @@ void
 destroyMandelbrot(
     MANDELBROT_T *mbrot)
 {
+    // mandelbrotImage() waits for every pass to finish, so the workers
+    // are all waiting to start. Start them with stopping set so that they
+    // return, before freeing the fields they use.
+
+    mbrot->stopping = true;
+    pthread_barrier_wait(&(mbrot->startBarrier));
+
     int32_t thread;
     for (thread = 0 ; thread < mbrot->numberOfThreads ; thread++)
     {
-        pthread_cancel(mbrot->threads[thread]);
+        pthread_join(mbrot->threads[thread], NULL);
     }
+
+    pthread_barrier_destroy(&(mbrot->startBarrier));
+    pthread_barrier_destroy(&(mbrot->finishedBarrier));
+
+    mbrot->numberOfThreads = 0;
+
+    free(mbrot->iterations);
+    mbrot->iterations = NULL;
+
+    free(mbrot->previousIterations);
+    mbrot->previousIterations = NULL;
+
+    free(mbrot->columnMap);
+    mbrot->columnMap = NULL;
+
+    free(mbrot->rowMap);
+    mbrot->rowMap = NULL;
+
+    free(mbrot->reference.x);
+    mbrot->reference.x = NULL;
+
+    free(mbrot->reference.y);
+    mbrot->reference.y = NULL;
+
+    destroyImagePalette32(&(mbrot->palette));
 }
 
 //-------------------------------------------------------------------------
@@ -148,12 +290,41 @@ workerMandelbrot(
         return NULL;
     }
 
+    MANDELBROT_THREAD_TIMING_T *timing = &(mbrot->timing[thread]);
+
     while (true)
     {
         pthread_barrier_wait(&(mbrot->startBarrier));
-        mandelbrotImageKernel(mbrot,
-                              mbrot->heightRange[thread].startHeight,
-                              mbrot->heightRange[thread].endHeight);
+
+        if (mbrot->stopping)
+        {
+            break;
+        }
+
+        struct timeval start_time;
+        struct timeval end_time;
+        struct timeval diff;
+
+        gettimeofday(&start_time, NULL);
+
+        int32_t tiles = 0;
+        int32_t tile = atomic_fetch_add(&(mbrot->nextTile), 1);
+
+        while (tile < mbrot->numberOfTiles)
+        {
+            mandelbrotImageKernel(mbrot, tile);
+            ++tiles;
+
+            tile = atomic_fetch_add(&(mbrot->nextTile), 1);
+        }
+
+        gettimeofday(&end_time, NULL);
+        timersub(&end_time, &start_time, &diff);
+
+        timing->tiles += tiles;
+        timing->milliseconds += (diff.tv_sec * 1000.0)
+                              + (diff.tv_usec / 1000.0);
+
         pthread_barrier_wait(&(mbrot->finishedBarrier));
     }
 
@@ -162,49 +333,735 @@ workerMandelbrot(
 
 //-------------------------------------------------------------------------
 
+// Points inside the main cardioid or the period 2 bulb never escape, so
+// there is no need to iterate them.
+
+static bool
+insideCardioidOrBulb(
+    double x,
+    double y)
+{
+    double y2 = y * y;
+    double xq = x - 0.25;
+    double q = (xq * xq) + y2;
+
+    if ((q * (q + xq)) < (0.25 * y2))
+    {
+        return true;
+    }
+
+    double xb = x + 1.0;
+
+    return ((xb * xb) + y2) < 0.0625;
+}
+
+//-------------------------------------------------------------------------
+// Escape time of a single point. Every fourth iteration the orbit is
+// compared against a saved point whose position doubles each time it is
+// updated (Brent's method). Only an exact match is treated as a cycle, so
+// the result is always the same as iterating to maxIterations.
+
+static uint16_t
+escapeTime(
+    double x0,
+    double y0,
+    int32_t maxIterations)
+{
+    double x = 0.0;
+    double y = 0.0;
+
+    double x2 = x * x;
+    double y2 = y * y;
+
+    double savedX = x;
+    double savedY = y;
+    int32_t nextSave = 1;
+
+    int32_t n = 0;
+
+    while ((x2 + y2 < 4.0) && (n < maxIterations))
+    {
+        double xtemp = x2 - y2 + x0;
+        y = 2 * x * y + y0;
+        x = xtemp;
+
+        x2 = x * x;
+        y2 = y * y;
+
+        n++;
+
+        if (((n & 3) == 0) && (x == savedX) && (y == savedY))
+        {
+            return maxIterations;
+        }
+
+        if (n == nextSave)
+        {
+            savedX = x;
+            savedY = y;
+            nextSave *= 2;
+        }
+    }
+
+    return n;
+}
+
+//-------------------------------------------------------------------------
+// Escape time of MANDELBROT_LANES points on the same row. Each lane stops
+// counting once it escapes or is found to be periodic, and the loop exits
+// as soon as no lanes are still active.
+
+#define MANDELBROT_LANES 4
+
+#if defined(MANDELBROT_NEON)
+
+static void
+escapeTimeLanes(
+    const double *x0,
+    double y0,
+    int32_t maxIterations,
+    uint16_t *counts)
+{
+    float64x2_t zero = vdupq_n_f64(0.0);
+    float64x2_t one = vdupq_n_f64(1.0);
+    float64x2_t two = vdupq_n_f64(2.0);
+    float64x2_t four = vdupq_n_f64(4.0);
+
+    float64x2_t x0a = vld1q_f64(x0);
+    float64x2_t x0b = vld1q_f64(x0 + 2);
+    float64x2_t y0v = vdupq_n_f64(y0);
+
+    float64x2_t xa = zero;
+    float64x2_t xb = zero;
+    float64x2_t ya = zero;
+    float64x2_t yb = zero;
+    float64x2_t x2a = zero;
+    float64x2_t x2b = zero;
+    float64x2_t y2a = zero;
+    float64x2_t y2b = zero;
+
+    float64x2_t savedXa = zero;
+    float64x2_t savedXb = zero;
+    float64x2_t savedYa = zero;
+    float64x2_t savedYb = zero;
+    int32_t nextSave = 1;
+
+    float64x2_t na = zero;
+    float64x2_t nb = zero;
+    uint64x2_t activeA = vceqq_f64(zero, zero);
+    uint64x2_t activeB = activeA;
+    uint64x2_t periodicA = vdupq_n_u64(0);
+    uint64x2_t periodicB = periodicA;
+
+    int32_t n;
+    for (n = 0 ; n < maxIterations ; n++)
+    {
+        activeA = vandq_u64(activeA, vcltq_f64(vaddq_f64(x2a, y2a), four));
+        activeB = vandq_u64(activeB, vcltq_f64(vaddq_f64(x2b, y2b), four));
+
+        uint64x2_t active = vorrq_u64(activeA, activeB);
+
+        if ((vgetq_lane_u64(active, 0) | vgetq_lane_u64(active, 1)) == 0)
+        {
+            break;
+        }
+
+        na = vaddq_f64(na, vreinterpretq_f64_u64(
+                vandq_u64(activeA, vreinterpretq_u64_f64(one))));
+        nb = vaddq_f64(nb, vreinterpretq_f64_u64(
+                vandq_u64(activeB, vreinterpretq_u64_f64(one))));
+
+        float64x2_t xtempA = vaddq_f64(vsubq_f64(x2a, y2a), x0a);
+        float64x2_t xtempB = vaddq_f64(vsubq_f64(x2b, y2b), x0b);
+        ya = vaddq_f64(vmulq_f64(vmulq_f64(two, xa), ya), y0v);
+        yb = vaddq_f64(vmulq_f64(vmulq_f64(two, xb), yb), y0v);
+        xa = xtempA;
+        xb = xtempB;
+
+        x2a = vmulq_f64(xa, xa);
+        x2b = vmulq_f64(xb, xb);
+        y2a = vmulq_f64(ya, ya);
+        y2b = vmulq_f64(yb, yb);
+
+        if (((n + 1) & 3) == 0)
+        {
+            uint64x2_t sameA = vandq_u64(vceqq_f64(xa, savedXa),
+                                         vceqq_f64(ya, savedYa));
+            uint64x2_t sameB = vandq_u64(vceqq_f64(xb, savedXb),
+                                         vceqq_f64(yb, savedYb));
+            sameA = vandq_u64(sameA, activeA);
+            sameB = vandq_u64(sameB, activeB);
+            periodicA = vorrq_u64(periodicA, sameA);
+            periodicB = vorrq_u64(periodicB, sameB);
+            activeA = vbicq_u64(activeA, sameA);
+            activeB = vbicq_u64(activeB, sameB);
+        }
+
+        if ((n + 1) == nextSave)
+        {
+            savedXa = xa;
+            savedXb = xb;
+            savedYa = ya;
+            savedYb = yb;
+            nextSave *= 2;
+        }
+    }
+
+    double iterations[MANDELBROT_LANES];
+    uint64_t periodic[MANDELBROT_LANES];
+
+    vst1q_f64(iterations, na);
+    vst1q_f64(iterations + 2, nb);
+    vst1q_u64(periodic, periodicA);
+    vst1q_u64(periodic + 2, periodicB);
+
+    int32_t lane;
+    for (lane = 0 ; lane < MANDELBROT_LANES ; lane++)
+    {
+        counts[lane] = (periodic[lane]) ? maxIterations : iterations[lane];
+    }
+}
+
+#elif defined(MANDELBROT_SSE2)
+
+static void
+escapeTimeLanes(
+    const double *x0,
+    double y0,
+    int32_t maxIterations,
+    uint16_t *counts)
+{
+    __m128d zero = _mm_setzero_pd();
+    __m128d one = _mm_set1_pd(1.0);
+    __m128d two = _mm_set1_pd(2.0);
+    __m128d four = _mm_set1_pd(4.0);
+
+    __m128d x0a = _mm_loadu_pd(x0);
+    __m128d x0b = _mm_loadu_pd(x0 + 2);
+    __m128d y0v = _mm_set1_pd(y0);
+
+    __m128d xa = zero;
+    __m128d xb = zero;
+    __m128d ya = zero;
+    __m128d yb = zero;
+    __m128d x2a = zero;
+    __m128d x2b = zero;
+    __m128d y2a = zero;
+    __m128d y2b = zero;
+
+    __m128d savedXa = zero;
+    __m128d savedXb = zero;
+    __m128d savedYa = zero;
+    __m128d savedYb = zero;
+    int32_t nextSave = 1;
+
+    __m128d na = zero;
+    __m128d nb = zero;
+    __m128d activeA = _mm_cmpeq_pd(zero, zero);
+    __m128d activeB = activeA;
+    __m128d periodicA = zero;
+    __m128d periodicB = zero;
+
+    int32_t n;
+    for (n = 0 ; n < maxIterations ; n++)
+    {
+        activeA = _mm_and_pd(activeA,
+                             _mm_cmplt_pd(_mm_add_pd(x2a, y2a), four));
+        activeB = _mm_and_pd(activeB,
+                             _mm_cmplt_pd(_mm_add_pd(x2b, y2b), four));
+
+        if (_mm_movemask_pd(_mm_or_pd(activeA, activeB)) == 0)
+        {
+            break;
+        }
+
+        na = _mm_add_pd(na, _mm_and_pd(activeA, one));
+        nb = _mm_add_pd(nb, _mm_and_pd(activeB, one));
+
+        __m128d xtempA = _mm_add_pd(_mm_sub_pd(x2a, y2a), x0a);
+        __m128d xtempB = _mm_add_pd(_mm_sub_pd(x2b, y2b), x0b);
+        ya = _mm_add_pd(_mm_mul_pd(_mm_mul_pd(two, xa), ya), y0v);
+        yb = _mm_add_pd(_mm_mul_pd(_mm_mul_pd(two, xb), yb), y0v);
+        xa = xtempA;
+        xb = xtempB;
+
+        x2a = _mm_mul_pd(xa, xa);
+        x2b = _mm_mul_pd(xb, xb);
+        y2a = _mm_mul_pd(ya, ya);
+        y2b = _mm_mul_pd(yb, yb);
+
+        if (((n + 1) & 3) == 0)
+        {
+            __m128d sameA = _mm_and_pd(_mm_cmpeq_pd(xa, savedXa),
+                                       _mm_cmpeq_pd(ya, savedYa));
+            __m128d sameB = _mm_and_pd(_mm_cmpeq_pd(xb, savedXb),
+                                       _mm_cmpeq_pd(yb, savedYb));
+            sameA = _mm_and_pd(sameA, activeA);
+            sameB = _mm_and_pd(sameB, activeB);
+            periodicA = _mm_or_pd(periodicA, sameA);
+            periodicB = _mm_or_pd(periodicB, sameB);
+            activeA = _mm_andnot_pd(sameA, activeA);
+            activeB = _mm_andnot_pd(sameB, activeB);
+        }
+
+        if ((n + 1) == nextSave)
+        {
+            savedXa = xa;
+            savedXb = xb;
+            savedYa = ya;
+            savedYb = yb;
+            nextSave *= 2;
+        }
+    }
+
+    double iterations[MANDELBROT_LANES];
+
+    _mm_storeu_pd(iterations, na);
+    _mm_storeu_pd(iterations + 2, nb);
+
+    int periodic = _mm_movemask_pd(periodicA)
+                 | (_mm_movemask_pd(periodicB) << 2);
+
+    int32_t lane;
+    for (lane = 0 ; lane < MANDELBROT_LANES ; lane++)
+    {
+        if (periodic & (1 << lane))
+        {
+            counts[lane] = maxIterations;
+        }
+        else
+        {
+            counts[lane] = iterations[lane];
+        }
+    }
+}
+
+#else
+
+static void
+escapeTimeLanes(
+    const double *x0,
+    double y0,
+    int32_t maxIterations,
+    uint16_t *counts)
+{
+    int32_t lane;
+    for (lane = 0 ; lane < MANDELBROT_LANES ; lane++)
+    {
+        counts[lane] = escapeTime(x0[lane], y0, maxIterations);
+    }
+}
+
+#endif
+
+//-------------------------------------------------------------------------
+// Escape time for each point of a row. Points inside the cardioid or bulb
+// are filled in directly, the rest are packed together and iterated
+// MANDELBROT_LANES at a time, with any left over done one at a time.
+
+void
+escapeTimeRowMandelbrot(
+    const double *x0,
+    double y0,
+    int32_t length,
+    int32_t maxIterations,
+    uint16_t *counts)
+{
+    double packedX0[MANDELBROT_TILE_SIZE];
+    int32_t packedIndex[MANDELBROT_TILE_SIZE];
+    int32_t packed = 0;
+
+    int32_t i;
+    for (i = 0 ; i < length ; i++)
+    {
+        if (insideCardioidOrBulb(x0[i], y0))
+        {
+            counts[i] = maxIterations;
+        }
+        else
+        {
+            packedX0[packed] = x0[i];
+            packedIndex[packed] = i;
+            ++packed;
+        }
+    }
+
+    int32_t groups = packed - (packed % MANDELBROT_LANES);
+
+    for (i = 0 ; i < groups ; i += MANDELBROT_LANES)
+    {
+        uint16_t laneCounts[MANDELBROT_LANES];
+
+        escapeTimeLanes(packedX0 + i, y0, maxIterations, laneCounts);
+
+        int32_t lane;
+        for (lane = 0 ; lane < MANDELBROT_LANES ; lane++)
+        {
+            counts[packedIndex[i + lane]] = laneCounts[lane];
+        }
+    }
+
+    for (i = groups ; i < packed ; i++)
+    {
+        counts[packedIndex[i]] = escapeTime(packedX0[i], y0, maxIterations);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+const char *
+kernelPathMandelbrot(void)
+{
+#if defined(MANDELBROT_NEON)
+    return "NEON";
+#elif defined(MANDELBROT_SSE2)
+    return "SSE2";
+#else
+    return "C";
+#endif
+}
+
+//-------------------------------------------------------------------------
+
+// Escape time of a point given as an offset (dcx, dcy) from the reference
+// point. Only the difference from the reference orbit is iterated, which
+// stays accurate in double precision however deep the zoom. When z gets
+// closer to zero than the difference, or the reference orbit runs out,
+// the difference is rebased onto the start of the reference orbit, which
+// avoids the glitches of plain perturbation.
+
+static uint16_t
+perturbedEscapeTime(
+    const MANDELBROT_REFERENCE_T *reference,
+    double dcx,
+    double dcy,
+    int32_t maxIterations)
+{
+    const double *zx = reference->x;
+    const double *zy = reference->y;
+    const double *a = reference->a;
+    const double *b = reference->b;
+    const double *c = reference->c;
+
+    // start from the series approximation at iteration skip
+
+    double dcx2 = dcx * dcx - dcy * dcy;
+    double dcy2 = 2 * dcx * dcy;
+    double dcx3 = dcx2 * dcx - dcy2 * dcy;
+    double dcy3 = dcx2 * dcy + dcy2 * dcx;
+
+    double dx = (a[0] * dcx - a[1] * dcy)
+              + (b[0] * dcx2 - b[1] * dcy2)
+              + (c[0] * dcx3 - c[1] * dcy3);
+    double dy = (a[0] * dcy + a[1] * dcx)
+              + (b[0] * dcy2 + b[1] * dcx2)
+              + (c[0] * dcy3 + c[1] * dcx3);
+
+    int32_t last = reference->length - 1;
+    int32_t m = reference->skip;
+    int32_t n = reference->skip;
+
+    while (n < maxIterations)
+    {
+        double x = zx[m] + dx;
+        double y = zy[m] + dy;
+        double r2 = x * x + y * y;
+
+        if (r2 >= 4.0)
+        {
+            break;
+        }
+
+        if ((r2 < (dx * dx + dy * dy)) || (m == last))
+        {
+            dx = x;
+            dy = y;
+            m = 0;
+        }
+
+        double xtemp = 2 * (zx[m] * dx - zy[m] * dy)
+                     + (dx * dx - dy * dy) + dcx;
+        dy = 2 * (zx[m] * dy + zy[m] * dx) + (2 * dx * dy) + dcy;
+        dx = xtemp;
+
+        m++;
+        n++;
+    }
+
+    return n;
+}
+
+//-------------------------------------------------------------------------
+
+static void
+perturbedEscapeTimeRow(
+    const MANDELBROT_REFERENCE_T *reference,
+    const double *dcx,
+    double dcy,
+    int32_t length,
+    int32_t maxIterations,
+    uint16_t *counts)
+{
+    int32_t i;
+    for (i = 0 ; i < length ; i++)
+    {
+        counts[i] = perturbedEscapeTime(reference,
+                                        dcx[i],
+                                        dcy,
+                                        maxIterations);
+    }
+}
+
+//-------------------------------------------------------------------------
+
 void
 mandelbrotImageKernel(
     MANDELBROT_T *mbrot,
-    int32_t startHeight,
-    int32_t endHeight)
+    int32_t tile)
 {
     IMAGE_T *image = &(mbrot->imageLayer->image);
 
+    int32_t startWidth = (tile % mbrot->tileColumns) * MANDELBROT_TILE_SIZE;
+    int32_t startHeight = (tile / mbrot->tileColumns) * MANDELBROT_TILE_SIZE;
+    int32_t endWidth = startWidth + MANDELBROT_TILE_SIZE;
+    int32_t endHeight = startHeight + MANDELBROT_TILE_SIZE;
+
+    if (endWidth > image->width)
+    {
+        endWidth = image->width;
+    }
+
+    if (endHeight > image->height)
+    {
+        endHeight = image->height;
+    }
+
     double dx = (mbrot->coords.side / (image->width - 1));
     double dy = (mbrot->coords.side / (image->height - 1));
 
+    // in deep zoom mode the points are relative to the reference orbit
+
+    double startX = mbrot->originX;
+    double startY = mbrot->originY;
+
+    if (mbrot->deep)
+    {
+        startX = mbrot->reference.offsetX;
+        startY = mbrot->reference.offsetY;
+    }
+
+    int32_t maxIterations = mbrot->maxIterations;
+    int32_t colours = mbrot->numberOfColours - 1;
+    int32_t step = mbrot->step;
+
+    double x0[MANDELBROT_TILE_SIZE];
+    int32_t columns[MANDELBROT_TILE_SIZE];
+    uint16_t counts[MANDELBROT_TILE_SIZE];
+
+    // calculate the samples for this pass that are not already known
+
+    int32_t i;
     int32_t j;
-    for (j = startHeight ; j < endHeight ; j++)
+    for (j = startHeight ; j < endHeight ; j += step)
     {
-        int32_t i;
-        for (i = 0 ; i < image->width ; i++)
+        uint16_t *iterations = mbrot->iterations + (j * image->width);
+        int32_t length = 0;
+
+        for (i = startWidth ; i < endWidth ; i += step)
         {
-            double x0 = mbrot->coords.x0 + dx * i;
-            double y0 = mbrot->coords.y0 + dy * j;
+            if (iterations[i] == MANDELBROT_UNKNOWN)
+            {
+                x0[length] = startX + dx * i;
+                columns[length] = i;
+                ++length;
+            }
+        }
 
-            double x = 0.0;
-            double y = 0.0;
+        if (length > 0)
+        {
+            double y0 = startY + dy * j;
 
-            double x2 = x * x;
-            double y2 = y * y;
+            if (mbrot->deep)
+            {
+                perturbedEscapeTimeRow(&(mbrot->reference),
+                                       x0,
+                                       y0,
+                                       length,
+                                       maxIterations,
+                                       counts);
+            }
+            else
+            {
+                escapeTimeRowMandelbrot(x0,
+                                        y0,
+                                        length,
+                                        maxIterations,
+                                        counts);
+            }
+
+            for (i = 0 ; i < length ; i++)
+            {
+                iterations[columns[i]] = counts[i];
+            }
+        }
+    }
+
+    // Draw the tile. Pixels that have not been calculated yet take the
+    // value of the sample at the top left of their step x step block.
+
+    for (j = startHeight ; j < endHeight ; j++)
+    {
+        const uint16_t *iterations = mbrot->iterations + (j * image->width);
+        const uint16_t *samples = mbrot->iterations
+                                + ((j - (j % step)) * image->width);
+        uint8_t *line = (uint8_t *)(image->buffer) + (j * image->pitch);
+
+        for (i = startWidth ; i < endWidth ; i++)
+        {
+            uint16_t n = iterations[i];
 
-            size_t n = 0;
+            if (n == MANDELBROT_UNKNOWN)
+            {
+                n = samples[i - (i % step)];
+            }
 
-            while ((x2 + y2 < 4.0) && (n < mbrot->numberOfColours))
+            if (n < maxIterations)
+            {
+                line[i] = 1 + ((n - 1) % colours);
+            }
+            else
             {
-                double xtemp = x2 - y2 + x0;
-                y = 2 * x * y + y0;
-                x = xtemp;
+                line[i] = 0;
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// For each sample along one axis of the new view, find the sample of the
+// old view at the same position (to within a small fraction of a pixel),
+// or -1 if there is not one.
+
+static void
+reprojectAxis(
+    const FIXED_T *oldStart,
+    double oldStep,
+    const FIXED_T *newStart,
+    double newStep,
+    int32_t length,
+    int32_t *map)
+{
+    FIXED_T difference;
+    fixedSub(&difference, newStart, oldStart);
+
+    double offset = fixedToDouble(&difference);
+
+    int32_t i;
+    for (i = 0 ; i < length ; i++)
+    {
+        double position = (offset + newStep * i) / oldStep;
+        double nearest = floor(position + 0.5);
+
+        if ((fabs(position - nearest) < 1.0e-3) &&
+            (nearest >= 0.0) &&
+            (nearest < length))
+        {
+            map[i] = nearest;
+        }
+        else
+        {
+            map[i] = -1;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+reprojectIterations(
+    MANDELBROT_T *mbrot,
+    MANDELBROT_COORDS_T *coords,
+    int32_t maxIterations)
+{
+    IMAGE_T *image = &(mbrot->imageLayer->image);
+    size_t pixels = image->width * image->height;
+
+    uint16_t *tmp = mbrot->previousIterations;
+    mbrot->previousIterations = mbrot->iterations;
+    mbrot->iterations = tmp;
+
+    if (mbrot->coords.side <= 0.0)
+    {
+        size_t i;
+        for (i = 0 ; i < pixels ; i++)
+        {
+            mbrot->iterations[i] = MANDELBROT_UNKNOWN;
+        }
+
+        return;
+    }
+
+    reprojectAxis(&(mbrot->coords.x0),
+                  mbrot->coords.side / (image->width - 1),
+                  &(coords->x0),
+                  coords->side / (image->width - 1),
+                  image->width,
+                  mbrot->columnMap);
 
-                x2 = x * x;
-                y2 = y * y;
+    reprojectAxis(&(mbrot->coords.y0),
+                  mbrot->coords.side / (image->height - 1),
+                  &(coords->y0),
+                  coords->side / (image->height - 1),
+                  image->height,
+                  mbrot->rowMap);
 
-                n++;
+    // Points that did not escape before may escape with a higher limit,
+    // so they are only reused if the limit is the same.
+
+    uint16_t previousMax = mbrot->maxIterations;
+
+    int32_t j;
+    for (j = 0 ; j < image->height ; j++)
+    {
+        uint16_t *iterations = mbrot->iterations + (j * image->width);
+        int32_t oldRow = mbrot->rowMap[j];
+
+        int32_t i;
+
+        if (oldRow == -1)
+        {
+            for (i = 0 ; i < image->width ; i++)
+            {
+                iterations[i] = MANDELBROT_UNKNOWN;
             }
+        }
+        else
+        {
+            const uint16_t *previous = mbrot->previousIterations
+                                     + (oldRow * image->width);
 
-            if (n < mbrot->numberOfColours)
+            for (i = 0 ; i < image->width ; i++)
             {
-                setPixelRGB(image, i, j, &(mbrot->colours[n]));
+                int32_t oldColumn = mbrot->columnMap[i];
+
+                if (oldColumn == -1)
+                {
+                    iterations[i] = MANDELBROT_UNKNOWN;
+                }
+                else if ((previous[oldColumn] >= previousMax) &&
+                         (previousMax != maxIterations))
+                {
+                    iterations[i] = MANDELBROT_UNKNOWN;
+                }
+                else if (previous[oldColumn] > maxIterations)
+                {
+                    iterations[i] = maxIterations;
+                }
+                else
+                {
+                    iterations[i] = previous[oldColumn];
+                }
             }
         }
     }
@@ -212,25 +1069,267 @@ mandelbrotImageKernel(
 
 //-------------------------------------------------------------------------
 
+static int32_t
+maxIterationsForSide(
+    MANDELBROT_T *mbrot,
+    double side)
+{
+    // Use one colour per iteration down to a side of about 1e-10, then
+    // allow 100 more iterations for each further factor of ten.
+
+    double depth = -log10(side) - 10.0;
+    int32_t maxIterations = mbrot->numberOfColours;
+
+    if (depth > 0.0)
+    {
+        maxIterations += (int32_t)(depth * 100.0);
+    }
+
+    if (maxIterations > MANDELBROT_MAX_ITERATIONS)
+    {
+        maxIterations = MANDELBROT_MAX_ITERATIONS;
+    }
+
+    return maxIterations;
+}
+
+//-------------------------------------------------------------------------
+
+// Calculate the orbit of the centre of the view at full precision, then
+// work out how many iterations the series approximation can skip.
+
+static void
+calculateReference(
+    MANDELBROT_T *mbrot)
+{
+    MANDELBROT_REFERENCE_T *reference = &(mbrot->reference);
+    double half = mbrot->coords.side / 2.0;
+
+    FIXED_T cx;
+    FIXED_T cy;
+
+    fixedAddDouble(&cx, &(mbrot->coords.x0), half);
+    fixedAddDouble(&cy, &(mbrot->coords.y0), half);
+
+    FIXED_T x;
+    FIXED_T y;
+    FIXED_T x2;
+    FIXED_T y2;
+    FIXED_T xy;
+
+    fixedFromDouble(&x, 0.0);
+    fixedFromDouble(&y, 0.0);
+
+    reference->x[0] = 0.0;
+    reference->y[0] = 0.0;
+
+    int32_t n = 0;
+
+    while (n < mbrot->maxIterations)
+    {
+        fixedMul(&x2, &x, &x);
+        fixedMul(&y2, &y, &y);
+        fixedMul(&xy, &x, &y);
+
+        fixedSub(&x, &x2, &y2);
+        fixedAdd(&x, &x, &cx);
+        fixedAdd(&y, &xy, &xy);
+        fixedAdd(&y, &y, &cy);
+
+        n++;
+
+        reference->x[n] = fixedToDouble(&x);
+        reference->y[n] = fixedToDouble(&y);
+
+        if ((reference->x[n] * reference->x[n] +
+             reference->y[n] * reference->y[n]) >= 4.0)
+        {
+            break;
+        }
+    }
+
+    reference->length = n + 1;
+
+    // the top left pixel, relative to the reference point
+
+    reference->offsetX = -half;
+    reference->offsetY = -half;
+
+    //---------------------------------------------------------------------
+
+    // The difference from the reference orbit after n iterations is
+    // approximately a.dc + b.dc^2 + c.dc^3. Keep going while the cubic
+    // term stays negligible for the furthest pixel, and the difference
+    // stays small compared to the reference orbit itself.
+
+    double radius = half * sqrt(2.0);
+    double a[2] = { 0.0, 0.0 };
+    double b[2] = { 0.0, 0.0 };
+    double c[2] = { 0.0, 0.0 };
+
+    reference->skip = 0;
+
+    for (n = 0 ; n < reference->length - 2 ; n++)
+    {
+        double zx = reference->x[n];
+        double zy = reference->y[n];
+
+        double na[2];
+        double nb[2];
+        double nc[2];
+
+        na[0] = 2 * (zx * a[0] - zy * a[1]) + 1.0;
+        na[1] = 2 * (zx * a[1] + zy * a[0]);
+        nb[0] = 2 * (zx * b[0] - zy * b[1]) + (a[0] * a[0] - a[1] * a[1]);
+        nb[1] = 2 * (zx * b[1] + zy * b[0]) + (2 * a[0] * a[1]);
+        nc[0] = 2 * (zx * c[0] - zy * c[1]) + 2 * (a[0] * b[0] - a[1] * b[1]);
+        nc[1] = 2 * (zx * c[1] + zy * c[0]) + 2 * (a[0] * b[1] + a[1] * b[0]);
+
+        double linear = hypot(na[0], na[1]) * radius;
+        double quadratic = hypot(nb[0], nb[1]) * radius * radius;
+        double cubic = hypot(nc[0], nc[1]) * radius * radius * radius;
+        double orbit = hypot(reference->x[n + 1], reference->y[n + 1]);
+
+        if ((cubic > (1.0e-6 * quadratic)) || (linear > (1.0e-3 * orbit)))
+        {
+            break;
+        }
+
+        memcpy(a, na, sizeof(a));
+        memcpy(b, nb, sizeof(b));
+        memcpy(c, nc, sizeof(c));
+        reference->skip = n + 1;
+    }
+
+    memcpy(reference->a, a, sizeof(a));
+    memcpy(reference->b, b, sizeof(b));
+    memcpy(reference->c, c, sizeof(c));
+}
+
+//-------------------------------------------------------------------------
+
 void
 mandelbrotImage(
     MANDELBROT_T *mbrot,
     MANDELBROT_COORDS_T *coords)
 {
-    memcpy(&(mbrot->coords), coords, sizeof(MANDELBROT_COORDS_T));
+    struct timeval start_time;
+    struct timeval end_time;
+    struct timeval diff;
 
-    static RGBA8_T black = {0, 0, 0, 0};
+    gettimeofday(&start_time, NULL);
 
     IMAGE_T *image = &(mbrot->imageLayer->image);
-    clearImageRGB(image, &black);
+    int32_t maxIterations = maxIterationsForSide(mbrot, coords->side);
+
+    reprojectIterations(mbrot, coords, maxIterations);
+    memcpy(&(mbrot->coords), coords, sizeof(MANDELBROT_COORDS_T));
+
+    mbrot->originX = fixedToDouble(&(coords->x0));
+    mbrot->originY = fixedToDouble(&(coords->y0));
+    mbrot->maxIterations = maxIterations;
+    mbrot->deep = (coords->side / (image->width - 1))
+                < MANDELBROT_DEEP_ZOOM_STEP;
+
+    if (mbrot->deep)
+    {
+        calculateReference(mbrot);
+    }
+
+    int32_t thread;
+    for (thread = 0 ; thread < mbrot->numberOfThreads ; thread++)
+    {
+        mbrot->timing[thread].tiles = 0;
+        mbrot->timing[thread].milliseconds = 0.0;
+    }
 
     //---------------------------------------------------------------------
 
-    pthread_barrier_wait(&(mbrot->startBarrier));
-    pthread_barrier_wait(&(mbrot->finishedBarrier));
+    // Each pass only calculates samples that are not already known, so
+    // the coarse passes cost very little extra and are shown straight
+    // away.
+
+    int32_t step;
+    for (step = MANDELBROT_COARSEST_STEP ; step > 0 ; step /= 2)
+    {
+        mbrot->step = step;
+        atomic_store(&(mbrot->nextTile), 0);
+
+        pthread_barrier_wait(&(mbrot->startBarrier));
+        pthread_barrier_wait(&(mbrot->finishedBarrier));
+
+        // the threads write to the image buffer directly
+
+        markImageAllDirty(image);
+        changeSourceAndUpdateImageLayer(mbrot->imageLayer);
+    }
 
     //---------------------------------------------------------------------
 
-    changeSourceAndUpdateImageLayer(mbrot->imageLayer);
+    gettimeofday(&end_time, NULL);
+    timersub(&end_time, &start_time, &diff);
+
+    mbrot->milliseconds = (diff.tv_sec * 1000.0) + (diff.tv_usec / 1000.0);
+}
+
+//-------------------------------------------------------------------------
+
+void
+setPaletteOffsetMandelbrot(
+    MANDELBROT_T *mbrot,
+    int32_t offset)
+{
+    int32_t cycle = mbrot->numberOfColours - 1;
+
+    offset %= cycle;
+
+    if (offset < 0)
+    {
+        offset += cycle;
+    }
+
+    mbrot->paletteOffset = offset;
+
+    //---------------------------------------------------------------------
+
+    IMAGE_LAYER_T *il = mbrot->imageLayer;
+
+    setResourcePalette32(&(mbrot->palette),
+                         1 + offset,
+                         il->resource,
+                         1,
+                         cycle);
+
+    DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
+    assert(update != 0);
+
+    int result = vc_dispmanx_element_change_source(update,
+                                                   il->element,
+                                                   il->resource);
+    assert(result == 0);
+
+    result = vc_dispmanx_update_submit_sync(update);
+    assert(result == 0);
+}
+
+//-------------------------------------------------------------------------
+
+void
+mandelbrotColours(
+    MANDELBROT_T *mbrot,
+    RGBA8_T *colours)
+{
+    int32_t colour;
+    for (colour = 0 ; colour < mbrot->numberOfColours ; colour++)
+    {
+        int32_t index = colour;
+
+        if (colour > 0)
+        {
+            index += mbrot->paletteOffset;
+        }
+
+        getPalette32EntryRgba(&(mbrot->palette), index, &(colours[colour]));
+    }
 }
 
@@ -29,54 +29,136 @@
 #define MANDELBROT_H
 
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 
+#include "fixed.h"
 #include "imageLayer.h"
+#include "imagePalette.h"
 
 //-------------------------------------------------------------------------
 
-#define MANDELBROT_MAX_THREADS 4
+#define MANDELBROT_MAX_THREADS 64
+#define MANDELBROT_TILE_SIZE 32
+
+// The image is drawn in passes, first sampling every eighth pixel in each
+// direction, then every fourth and so on. MANDELBROT_TILE_SIZE must be a
+// multiple of MANDELBROT_COARSEST_STEP.
+
+#define MANDELBROT_COARSEST_STEP 8
+
+// Marks an entry in the iteration buffer that has not been calculated.
+
+#define MANDELBROT_UNKNOWN 0xFFFF
+
+// The image is 8BPP. Index 0 is used for points inside the set and the
+// escape count (1 to MANDELBROT_COLOURS - 1) for the rest.
+
+#define MANDELBROT_COLOURS 256
+
+// Escape counts go up to MANDELBROT_COLOURS until the view gets small,
+// after which the limit grows with the depth of the zoom.
+
+#define MANDELBROT_MAX_ITERATIONS 16384
+
+// Below this distance between pixels double precision runs out, so each
+// pixel is calculated as a perturbation of a full precision reference
+// orbit instead.
+
+#define MANDELBROT_DEEP_ZOOM_STEP 1.0e-12
+
+// The perturbations are doubles, so the zoom stops just short of the
+// smallest normal double.
+
+#define MANDELBROT_MINIMUM_SIDE 1.0e-290
 
 //-------------------------------------------------------------------------
 
 typedef struct
 {
-    double x0;
-    double y0;
+    FIXED_T x0;
+    FIXED_T y0;
     double side;
 } MANDELBROT_COORDS_T;
 
 //-------------------------------------------------------------------------
 
+// The orbit of the centre of the view, rounded to doubles, along with the
+// series approximation coefficients (a, b, c) that let every pixel start
+// at iteration skip.
+
+typedef struct
+{
+    double *x;
+    double *y;
+    int32_t length;
+    int32_t skip;
+    double a[2];
+    double b[2];
+    double c[2];
+    double offsetX;
+    double offsetY;
+} MANDELBROT_REFERENCE_T;
+
+//-------------------------------------------------------------------------
+
 typedef struct
 {
-    int32_t startHeight;
-    int32_t endHeight;
-} MANDELBROT_HEIGHT_RANGE_T;
+    int32_t tiles;
+    double milliseconds;
+} MANDELBROT_THREAD_TIMING_T;
 
 //-------------------------------------------------------------------------
 
 typedef struct
 {
     MANDELBROT_COORDS_T coords;
+    double originX;
+    double originY;
+    int32_t maxIterations;
+    bool deep;
+    MANDELBROT_REFERENCE_T reference;
     IMAGE_LAYER_T *imageLayer;
 
-    RGBA8_T colours[256];
-    size_t numberOfColours;
+    IMAGE_PALETTE32_T palette;
+    int32_t paletteOffset;
+    int32_t numberOfColours;
+
+    uint16_t *iterations;
+    uint16_t *previousIterations;
+    int32_t *columnMap;
+    int32_t *rowMap;
+    int32_t step;
+
+    int32_t tileColumns;
+    int32_t tileRows;
+    int32_t numberOfTiles;
+    atomic_int nextTile;
 
     int32_t numberOfThreads;
+    bool stopping;
     pthread_t threads[MANDELBROT_MAX_THREADS];
-    MANDELBROT_HEIGHT_RANGE_T heightRange[MANDELBROT_MAX_THREADS];
+    MANDELBROT_THREAD_TIMING_T timing[MANDELBROT_MAX_THREADS];
+    double milliseconds;
     pthread_barrier_t startBarrier;
     pthread_barrier_t finishedBarrier;
 } MANDELBROT_T;
 
 //-------------------------------------------------------------------------
 
+void
+initCoordsMandelbrot(
+    MANDELBROT_COORDS_T *coords,
+    double x0,
+    double y0,
+    double side);
+
 void
 newMandelbrot(
     MANDELBROT_T *mbrot,
     IMAGE_LAYER_T *imageLayer);
+
 void
 destroyMandelbrot(
     MANDELBROT_T *mbrot);
@@ -88,14 +170,42 @@ workerMandelbrot(
 void
 mandelbrotImageKernel(
     MANDELBROT_T *mbrot,
-    int32_t startHeight,
-    int32_t endHeight);
+    int32_t tile);
 
 void
 mandelbrotImage(
     MANDELBROT_T *mbrot,
     MANDELBROT_COORDS_T *coords);
 
+void
+setPaletteOffsetMandelbrot(
+    MANDELBROT_T *mbrot,
+    int32_t offset);
+
+// Escape counts of up to MANDELBROT_TILE_SIZE points on a row, the
+// kernel used by mandelbrotImageKernel() for views that are not deep.
+// Points that never escape are given maxIterations.
+
+void
+escapeTimeRowMandelbrot(
+    const double *x0,
+    double y0,
+    int32_t length,
+    int32_t maxIterations,
+    uint16_t *counts);
+
+// The code path the kernel was built with: "NEON", "SSE2" or "C".
+
+const char *
+kernelPathMandelbrot(void);
+
+// The colour of each index in the image, with the current palette offset.
+
+void
+mandelbrotColours(
+    MANDELBROT_T *mbrot,
+    RGBA8_T *colours);
+
 //-------------------------------------------------------------------------
 
 #endif
@@ -0,0 +1,317 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mandelbrot.h"
+
+//-------------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-------------------------------------------------------------------------
+
+// The default view and some zooms into it, all shallow enough for double
+// precision (deeper zooms use perturbation rather than this kernel).
+
+typedef struct
+{
+    const char *name;
+    double x;
+    double y;
+    double side;
+    int32_t maxIterations;
+} MANDELBROT_CHECK_VIEW_T;
+
+static const MANDELBROT_CHECK_VIEW_T views[] =
+{
+    { "default", -0.5, 0.0, 3.0, 256 },
+    { "seahorse valley", -0.7436438870, 0.1318259043, 1.0e-2, 256 },
+    { "elephant valley", 0.2850, 0.0110, 1.0e-2, 256 },
+    { "spiral 1e-4", -0.743643887037, 0.131825904205, 1.0e-4, 512 },
+    { "spiral 1e-6", -0.743643887037, 0.131825904205, 1.0e-6, 1024 },
+    { "spiral 1e-8", -0.743643887037151, 0.131825904205330, 1.0e-8, 2048 },
+    { "minibrot 1e-7", -1.7497591451, 0.0, 1.0e-7, 2048 }
+};
+
+#define MANDELBROT_CHECK_VIEWS (sizeof(views) / sizeof(views[0]))
+
+//-------------------------------------------------------------------------
+
+static double
+secondsNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + (now.tv_nsec / 1.0e9);
+}
+
+//-------------------------------------------------------------------------
+
+// The escape time loop as it was before the lane kernel, one point at a
+// time with no cardioid, bulb or cycle checks.
+
+static uint16_t
+escapeTimeScalar(
+    double x0,
+    double y0,
+    int32_t maxIterations)
+{
+    double x = 0.0;
+    double y = 0.0;
+
+    double x2 = x * x;
+    double y2 = y * y;
+
+    int32_t n = 0;
+
+    while ((x2 + y2 < 4.0) && (n < maxIterations))
+    {
+        double xtemp = x2 - y2 + x0;
+        y = 2 * x * y + y0;
+        x = xtemp;
+
+        x2 = x * x;
+        y2 = y * y;
+
+        n++;
+    }
+
+    return n;
+}
+
+//-------------------------------------------------------------------------
+
+// Calculate a size x size view both ways, timing each, and compare the
+// escape counts pixel by pixel.
+
+static bool
+checkView(
+    const MANDELBROT_CHECK_VIEW_T *view,
+    int32_t size)
+{
+    size_t pixels = (size_t)size * size;
+    uint16_t *scalar = malloc(pixels * sizeof(uint16_t));
+    uint16_t *lanes = malloc(pixels * sizeof(uint16_t));
+
+    if ((scalar == NULL) || (lanes == NULL))
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    double step = view->side / (size - 1);
+    double left = view->x - (view->side / 2.0);
+    double top = view->y - (view->side / 2.0);
+
+    //---------------------------------------------------------------------
+
+    double start = secondsNow();
+
+    int32_t i;
+    int32_t j;
+    for (j = 0 ; j < size ; j++)
+    {
+        double y0 = top + step * j;
+
+        for (i = 0 ; i < size ; i++)
+        {
+            scalar[i + (j * size)] = escapeTimeScalar(left + step * i,
+                                                      y0,
+                                                      view->maxIterations);
+        }
+    }
+
+    double scalarSeconds = secondsNow() - start;
+
+    //---------------------------------------------------------------------
+
+    // Rows are handed to the kernel a tile width at a time, as
+    // mandelbrotImageKernel() does.
+
+    start = secondsNow();
+
+    for (j = 0 ; j < size ; j++)
+    {
+        double y0 = top + step * j;
+
+        for (i = 0 ; i < size ; i += MANDELBROT_TILE_SIZE)
+        {
+            double x0[MANDELBROT_TILE_SIZE];
+            int32_t length = size - i;
+
+            if (length > MANDELBROT_TILE_SIZE)
+            {
+                length = MANDELBROT_TILE_SIZE;
+            }
+
+            int32_t k;
+            for (k = 0 ; k < length ; k++)
+            {
+                x0[k] = left + step * (i + k);
+            }
+
+            escapeTimeRowMandelbrot(x0,
+                                    y0,
+                                    length,
+                                    view->maxIterations,
+                                    lanes + i + (j * size));
+        }
+    }
+
+    double lanesSeconds = secondsNow() - start;
+
+    //---------------------------------------------------------------------
+
+    size_t differences = 0;
+    size_t inside = 0;
+    size_t p;
+
+    for (p = 0 ; p < pixels ; p++)
+    {
+        if (scalar[p] != lanes[p])
+        {
+            if (differences == 0)
+            {
+                fprintf(stderr,
+                        "%s: %s differs at (%zu, %zu): %d and %d\n",
+                        program,
+                        view->name,
+                        p % size,
+                        p / size,
+                        scalar[p],
+                        lanes[p]);
+            }
+
+            ++differences;
+        }
+
+        if (scalar[p] == view->maxIterations)
+        {
+            ++inside;
+        }
+    }
+
+    printf("%-16s %9.2e %6d %5.1f%% %10.1f %10.1f %7.1fx %s\n",
+           view->name,
+           view->side,
+           view->maxIterations,
+           (100.0 * inside) / pixels,
+           scalarSeconds * 1000.0,
+           lanesSeconds * 1000.0,
+           scalarSeconds / lanesSeconds,
+           (differences == 0) ? "match" : "DIFFER");
+
+    free(scalar);
+    free(lanes);
+
+    return differences == 0;
+}
+
+//-------------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s [-s <size>]\n", program);
+    fprintf(stderr, "    -s - width and height of each view (default 540)\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    int32_t size = 540;
+
+    program = basename(argv[0]);
+
+    //---------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+
+            size = atoi(optarg);
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    if (size < 2)
+    {
+        usage();
+    }
+
+    //---------------------------------------------------------------------
+
+    printf("%s: kernel built for %s, %dx%d views, one thread\n\n",
+           program,
+           kernelPathMandelbrot(),
+           size,
+           size);
+
+    printf("%-16s %9s %6s %6s %10s %10s %8s\n",
+           "view",
+           "side",
+           "limit",
+           "inside",
+           "scalar ms",
+           "kernel ms",
+           "speedup");
+
+    bool result = true;
+
+    size_t v;
+    for (v = 0 ; v < MANDELBROT_CHECK_VIEWS ; v++)
+    {
+        if (checkView(&(views[v]), size) == false)
+        {
+            result = false;
+        }
+    }
+
+    return (result) ? 0 : EXIT_FAILURE;
+}
+
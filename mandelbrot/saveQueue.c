@@ -0,0 +1,309 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "imageFile.h"
+#include "saveQueue.h"
+
+//-------------------------------------------------------------------------
+
+static bool
+saveJob(
+    SAVE_QUEUE_T *queue,
+    const SAVE_JOB_T *job)
+{
+    IMAGE_T *image = &(queue->image);
+    RGBA8_T *row = malloc(queue->width * sizeof(RGBA8_T));
+
+    if (row == NULL)
+    {
+        fprintf(stderr, "mandelbrot: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int32_t j;
+    for (j = 0 ; j < queue->height ; j++)
+    {
+        const uint8_t *line = job->indices + (j * queue->width);
+
+        int32_t i;
+        for (i = 0 ; i < queue->width ; i++)
+        {
+            row[i] = job->colours[line[i]];
+        }
+
+        setSpanRGB(image, 0, j, queue->width, row);
+    }
+
+    free(row);
+
+    return saveImage(image, job->filename);
+}
+
+//-------------------------------------------------------------------------
+
+static void *
+saveQueueWorker(
+    void *arg)
+{
+    SAVE_QUEUE_T *queue = arg;
+
+    pthread_mutex_lock(&(queue->mutex));
+
+    while (true)
+    {
+        while ((queue->status.queued == 0) && (queue->stop == false))
+        {
+            pthread_cond_wait(&(queue->queued), &(queue->mutex));
+        }
+
+        if (queue->status.queued == 0)
+        {
+            break;
+        }
+
+        // The job at the head stays queued, so that its slot isn't
+        // reused, until it has been saved.
+
+        SAVE_JOB_T *job = &(queue->jobs[queue->head]);
+
+        pthread_mutex_unlock(&(queue->mutex));
+
+        bool saved = saveJob(queue, job);
+
+        pthread_mutex_lock(&(queue->mutex));
+
+        SAVE_QUEUE_STATUS_T *status = &(queue->status);
+
+        queue->head = (queue->head + 1) % SAVE_QUEUE_LENGTH;
+        status->queued--;
+        status->full = false;
+        status->lastFailed = (saved == false);
+
+        if (saved)
+        {
+            status->saved++;
+            snprintf(status->label, sizeof(status->label), "%s", job->label);
+        }
+        else
+        {
+            status->failed++;
+        }
+
+        status->changes++;
+    }
+
+    pthread_mutex_unlock(&(queue->mutex));
+
+    return NULL;
+}
+
+//-------------------------------------------------------------------------
+
+void
+initSaveQueue(
+    SAVE_QUEUE_T *queue,
+    int32_t width,
+    int32_t height,
+    const char *extension)
+{
+    memset(queue, 0, sizeof(*queue));
+
+    queue->width = width;
+    queue->height = height;
+    queue->extension = extension;
+
+    initImage(&(queue->image), VC_IMAGE_RGB888, width, height, false);
+
+    pthread_mutex_init(&(queue->mutex), NULL);
+    pthread_cond_init(&(queue->queued), NULL);
+
+    if (pthread_create(&(queue->thread), NULL, saveQueueWorker, queue) != 0)
+    {
+        perror("mandelbrot: creating save thread");
+        exit(EXIT_FAILURE);
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Snapshot the image and its colours into the next free slot, which only
+// this thread writes to until it is queued.
+
+bool
+queueSaveMandelbrot(
+    SAVE_QUEUE_T *queue,
+    MANDELBROT_T *mbrot)
+{
+    pthread_mutex_lock(&(queue->mutex));
+
+    bool full = (queue->status.queued == SAVE_QUEUE_LENGTH);
+    int32_t slot = (queue->head + queue->status.queued) % SAVE_QUEUE_LENGTH;
+
+    if (full)
+    {
+        queue->status.full = true;
+        queue->status.changes++;
+    }
+
+    pthread_mutex_unlock(&(queue->mutex));
+
+    if (full)
+    {
+        return false;
+    }
+
+    //---------------------------------------------------------------------
+
+    SAVE_JOB_T *job = &(queue->jobs[slot]);
+
+    if (job->indices == NULL)
+    {
+        job->indices = malloc(queue->width * queue->height);
+
+        if (job->indices == NULL)
+        {
+            fprintf(stderr, "mandelbrot: memory exhausted\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    const IMAGE_T *indexed = &(mbrot->imageLayer->image);
+
+    int32_t j;
+    for (j = 0 ; j < queue->height ; j++)
+    {
+        memcpy(job->indices + (j * queue->width),
+               (uint8_t *)(indexed->buffer) + (j * indexed->pitch),
+               queue->width);
+    }
+
+    mandelbrotColours(mbrot, job->colours);
+
+    //---------------------------------------------------------------------
+
+    // Saves in the same second get a sequence number so that they don't
+    // overwrite each other.
+
+    time_t now;
+    time(&now);
+
+    if (now == queue->lastRequest)
+    {
+        queue->sameSecond++;
+    }
+    else
+    {
+        queue->lastRequest = now;
+        queue->sameSecond = 0;
+    }
+
+    struct tm *tm = localtime(&now);
+
+    char suffix[16] = "";
+
+    if (queue->sameSecond > 0)
+    {
+        snprintf(suffix, sizeof(suffix), "_%d", queue->sameSecond);
+    }
+
+    snprintf(job->filename,
+             sizeof(job->filename),
+             "mandelbrot_%04d%02d%02d_%02d%02d%02d%s.%s",
+             tm->tm_year + 1900,
+             tm->tm_mon + 1,
+             tm->tm_mday,
+             tm->tm_hour,
+             tm->tm_min,
+             tm->tm_sec,
+             suffix,
+             queue->extension);
+
+    snprintf(job->label,
+             sizeof(job->label),
+             "%02d:%02d:%02d%s",
+             tm->tm_hour,
+             tm->tm_min,
+             tm->tm_sec,
+             suffix);
+
+    //---------------------------------------------------------------------
+
+    pthread_mutex_lock(&(queue->mutex));
+
+    queue->status.queued++;
+    queue->status.full = false;
+    queue->status.changes++;
+
+    pthread_cond_signal(&(queue->queued));
+    pthread_mutex_unlock(&(queue->mutex));
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+
+void
+getSaveQueueStatus(
+    SAVE_QUEUE_T *queue,
+    SAVE_QUEUE_STATUS_T *status)
+{
+    pthread_mutex_lock(&(queue->mutex));
+    *status = queue->status;
+    pthread_mutex_unlock(&(queue->mutex));
+}
+
+//-------------------------------------------------------------------------
+
+void
+destroySaveQueue(
+    SAVE_QUEUE_T *queue)
+{
+    pthread_mutex_lock(&(queue->mutex));
+    queue->stop = true;
+    pthread_cond_signal(&(queue->queued));
+    pthread_mutex_unlock(&(queue->mutex));
+
+    pthread_join(queue->thread, NULL);
+
+    pthread_cond_destroy(&(queue->queued));
+    pthread_mutex_destroy(&(queue->mutex));
+
+    int32_t i;
+    for (i = 0 ; i < SAVE_QUEUE_LENGTH ; i++)
+    {
+        free(queue->jobs[i].indices);
+        queue->jobs[i].indices = NULL;
+    }
+
+    destroyImage(&(queue->image));
+}
+
@@ -0,0 +1,120 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#ifndef SAVE_QUEUE_H
+#define SAVE_QUEUE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "image.h"
+#include "mandelbrot.h"
+
+//-------------------------------------------------------------------------
+
+// Images are saved on a worker thread, as PNG or QOI depending on the
+// file extension given to initSaveQueue. Each save takes a snapshot of
+// the 8BPP image and its colours, so at most SAVE_QUEUE_LENGTH images are
+// held, at a byte per pixel, while waiting to be saved. Saves requested
+// while the queue is full are refused rather than waited for.
+
+#define SAVE_QUEUE_LENGTH 4
+#define SAVE_QUEUE_FILENAME_LENGTH 128
+#define SAVE_QUEUE_LABEL_LENGTH 16
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    uint8_t *indices;
+    RGBA8_T colours[MANDELBROT_COLOURS];
+    char filename[SAVE_QUEUE_FILENAME_LENGTH];
+    char label[SAVE_QUEUE_LABEL_LENGTH];
+} SAVE_JOB_T;
+
+// 'changes' is incremented every time the status changes. 'label' is the
+// time the last finished save was requested.
+
+typedef struct
+{
+    uint32_t changes;
+    int32_t queued;
+    int32_t saved;
+    int32_t failed;
+    bool full;
+    bool lastFailed;
+    char label[SAVE_QUEUE_LABEL_LENGTH];
+} SAVE_QUEUE_STATUS_T;
+
+typedef struct
+{
+    int32_t width;
+    int32_t height;
+    const char *extension;
+    SAVE_JOB_T jobs[SAVE_QUEUE_LENGTH];
+    int32_t head;
+    IMAGE_T image;
+    SAVE_QUEUE_STATUS_T status;
+    time_t lastRequest;
+    int32_t sameSecond;
+    bool stop;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t queued;
+} SAVE_QUEUE_T;
+
+//-------------------------------------------------------------------------
+
+void
+initSaveQueue(
+    SAVE_QUEUE_T *queue,
+    int32_t width,
+    int32_t height,
+    const char *extension);
+
+bool
+queueSaveMandelbrot(
+    SAVE_QUEUE_T *queue,
+    MANDELBROT_T *mbrot);
+
+void
+getSaveQueueStatus(
+    SAVE_QUEUE_T *queue,
+    SAVE_QUEUE_STATUS_T *status);
+
+// Saves that are still queued are finished before this returns.
+
+void
+destroySaveQueue(
+    SAVE_QUEUE_T *queue);
+
+//-------------------------------------------------------------------------
+
+#endif
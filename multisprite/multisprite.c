@@ -0,0 +1,339 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "backgroundLayer.h"
+#include "key.h"
+#include "multiSpriteLayer.h"
+#include "spriteAtlas.h"
+
+#include "bcm_host.h"
+
+//-------------------------------------------------------------------------
+
+#define NDEBUG
+
+//-------------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+    int32_t dx;
+    int32_t dy;
+    int32_t frame;
+} BOUNCER_T;
+
+//-------------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s ", program);
+    fprintf(stderr, "[-a] [-b <RGBA>] [-d <number>] [-l <layer>] ");
+    fprintf(stderr, "[-n <number>] <atlas.txt>\n");
+    fprintf(stderr, "    -a - animate, step each sprite through the frames\n");
+    fprintf(stderr, "    -b - set background colour 16 bit RGBA\n");
+    fprintf(stderr, "         e.g. 0x000F is opaque black\n");
+    fprintf(stderr, "    -d - Raspberry Pi display number\n");
+    fprintf(stderr, "    -l - DispmanX layer number\n");
+    fprintf(stderr, "    -n - number of sprites (default 200)\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+moveBouncer(
+    BOUNCER_T *b,
+    const SPRITE_ATLAS_FRAME_T *frame,
+    const DISPMANX_MODEINFO_T *info)
+{
+    b->x += b->dx;
+    b->y += b->dy;
+
+    if ((b->x < 0) || (b->x + frame->width > info->width))
+    {
+        b->dx = -(b->dx);
+        b->x += 2 * b->dx;
+    }
+
+    if ((b->y < 0) || (b->y + frame->height > info->height))
+    {
+        b->dy = -(b->dy);
+        b->y += 2 * b->dy;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    uint16_t background = 0x000F;
+    int32_t layer = 1;
+    uint32_t displayNumber = 0;
+    int32_t number = 200;
+    bool animate = false;
+
+    program = basename(argv[0]);
+
+    //---------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "ab:d:l:n:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'a':
+
+            animate = true;
+            break;
+
+        case 'b':
+
+            background = strtol(optarg, NULL, 16);
+            break;
+
+        case 'd':
+
+            displayNumber = atoi(optarg);
+            break;
+
+        case 'l':
+
+            layer = atoi(optarg);
+            break;
+
+        case 'n':
+
+            number = atoi(optarg);
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    if ((optind >= argc) || (number < 1))
+    {
+        usage();
+    }
+
+    //---------------------------------------------------------------------
+
+    bcm_host_init();
+
+    //---------------------------------------------------------------------
+
+    SPRITE_ATLAS_T atlas;
+
+    if (loadSpriteAtlas(&atlas, argv[optind]) == false)
+    {
+        fprintf(stderr, "%s: unable to load %s\n", program, argv[optind]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (atlas.frameCount == 0)
+    {
+        fprintf(stderr, "%s: %s has no frames\n", program, argv[optind]);
+        exit(EXIT_FAILURE);
+    }
+
+    BACKGROUND_LAYER_T bg;
+    initBackgroundLayer(&bg, background, 0);
+
+    MULTI_SPRITE_LAYER_T sprites;
+    initMultiSpriteLayer(&sprites, &atlas, number, layer);
+
+    BOUNCER_T *bouncers = calloc(number, sizeof(BOUNCER_T));
+
+    if (bouncers == NULL)
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    //---------------------------------------------------------------------
+
+    DISPMANX_DISPLAY_HANDLE_T display
+        = vc_dispmanx_display_open(displayNumber);
+    assert(display != 0);
+
+    //---------------------------------------------------------------------
+
+    DISPMANX_MODEINFO_T info;
+    int result = vc_dispmanx_display_get_info(display, &info);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
+    assert(update != 0);
+
+    if (background > 0)
+    {
+        addElementBackgroundLayer(&bg, display, update);
+    }
+
+    srand(1);
+
+    int32_t i;
+    for (i = 0 ; i < number ; i++)
+    {
+        BOUNCER_T *b = &(bouncers[i]);
+        b->frame = i % atlas.frameCount;
+
+        const SPRITE_ATLAS_FRAME_T *frame = &(atlas.frames[b->frame]);
+
+        int32_t xRange = info.width - frame->width;
+        int32_t yRange = info.height - frame->height;
+
+        b->x = (xRange > 0) ? rand() % xRange : 0;
+        b->y = (yRange > 0) ? rand() % yRange : 0;
+        b->dx = (rand() % 2) ? 1 + rand() % 4 : -1 - rand() % 4;
+        b->dy = (rand() % 2) ? 1 + rand() % 4 : -1 - rand() % 4;
+
+        addInstanceMultiSpriteLayer(&sprites,
+                                    b->frame,
+                                    b->x,
+                                    b->y,
+                                    display,
+                                    update);
+    }
+
+    result = vc_dispmanx_update_submit_sync(update);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    struct timeval start_time;
+    gettimeofday(&start_time, NULL);
+
+    int c = 0;
+    uint32_t frames = 0;
+    bool paused = false;
+
+    while (c != 27)
+    {
+        if (keyPressed(&c))
+        {
+            c = tolower(c);
+
+            if (c == 'p')
+            {
+                paused = !paused;
+            }
+        }
+
+        if (paused)
+        {
+            usleep(10000);
+            continue;
+        }
+
+        //-----------------------------------------------------------------
+
+        for (i = 0 ; i < number ; i++)
+        {
+            BOUNCER_T *b = &(bouncers[i]);
+
+            if (animate && ((frames % 8) == 0))
+            {
+                b->frame = (b->frame + 1) % atlas.frameCount;
+            }
+
+            moveBouncer(b, &(atlas.frames[b->frame]), &info);
+
+            setInstanceMultiSpriteLayer(&sprites,
+                                        i,
+                                        b->frame,
+                                        b->x,
+                                        b->y);
+        }
+
+        update = vc_dispmanx_update_start(0);
+        assert(update != 0);
+
+        updateMultiSpriteLayer(&sprites, update);
+
+        result = vc_dispmanx_update_submit_sync(update);
+        assert(result == 0);
+
+        ++frames;
+    }
+
+    //---------------------------------------------------------------------
+
+    struct timeval end_time;
+    gettimeofday(&end_time, NULL);
+
+    struct timeval diff;
+    timersub(&end_time, &start_time, &diff);
+
+    int32_t time_taken = (diff.tv_sec * 1000000) + diff.tv_usec;
+    double frames_per_second = (frames * 1000000.0) / time_taken;
+
+    printf("%0.1f frames per second\n", frames_per_second);
+
+    //---------------------------------------------------------------------
+
+    keyboardReset();
+
+    //---------------------------------------------------------------------
+
+    destroyBackgroundLayer(&bg);
+    destroyMultiSpriteLayer(&sprites);
+    destroySpriteAtlas(&atlas);
+    free(bouncers);
+
+    //---------------------------------------------------------------------
+
+    result = vc_dispmanx_display_close(display);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    return 0;
+}
+
@@ -0,0 +1,206 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bcm_host.h"
+
+#include "image.h"
+#include "imagePalette.h"
+#include "loadpng.h"
+#include "mappedImage.h"
+
+//-----------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-----------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s ", program);
+    fprintf(stderr, "[-d] [-t <type>] <file.png> [<file.dmx>]\n");
+    fprintf(stderr, "    -d - dither when converting to fewer bits\n");
+    fprintf(stderr, "    -t - type of image to save\n");
+    fprintf(stderr, "         can be one of the following:");
+    printImageTypes(stderr, " ", "", IMAGE_TYPES_ALL_DIRECT_COLOUR);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "         (default palette PNGs as 8BPP, ");
+    fprintf(stderr, "RGBA32 with alpha, otherwise RGB888)\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-----------------------------------------------------------------------
+
+// Replace a .png suffix with .dmx, or add .dmx if there isn't one.
+
+static char *
+mappedImageName(
+    const char *pngName)
+{
+    size_t length = strlen(pngName);
+
+    if ((length > 4) && (strcasecmp(pngName + length - 4, ".png") == 0))
+    {
+        length -= 4;
+    }
+
+    char *name = malloc(length + 5);
+
+    if (name == NULL)
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    memcpy(name, pngName, length);
+    strcpy(name + length, ".dmx");
+
+    return name;
+}
+
+//-----------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    const char *imageTypeName = NULL;
+    bool dither = false;
+
+    program = basename(argv[0]);
+
+    //-------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "dt:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+
+            dither = true;
+            break;
+
+        case 't':
+
+            imageTypeName = optarg;
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    if ((optind >= argc) || (optind + 2 < argc))
+    {
+        usage();
+    }
+
+    const char *pngName = argv[optind];
+    char *dmxName = mappedImageName(pngName);
+
+    if (optind + 1 < argc)
+    {
+        free(dmxName);
+        dmxName = strdup(argv[optind + 1]);
+    }
+
+    //-------------------------------------------------------------------
+
+    IMAGE_T image;
+    IMAGE_PALETTE32_T palette = { NULL, 0 };
+    bool loaded = false;
+
+    if (imageTypeName == NULL)
+    {
+        loaded = loadPngPalette(&image, &palette, pngName);
+    }
+    else
+    {
+        IMAGE_TYPE_INFO_T typeInfo;
+
+        if (findImageType(&typeInfo,
+                          imageTypeName,
+                          IMAGE_TYPES_ALL_DIRECT_COLOUR) == false)
+        {
+            fprintf(stderr,
+                    "%s: unsupported image type %s\n",
+                    program,
+                    imageTypeName);
+
+            exit(EXIT_FAILURE);
+        }
+
+        loaded = loadPngAs(&image, pngName, typeInfo.type, dither);
+    }
+
+    if (loaded == false)
+    {
+        fprintf(stderr, "%s: unable to load %s\n", program, pngName);
+        exit(EXIT_FAILURE);
+    }
+
+    //-------------------------------------------------------------------
+
+    if (saveMappedImage(&image, &palette, dmxName) == false)
+    {
+        fprintf(stderr, "%s: unable to save %s\n", program, dmxName);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%s: %dx%d %d bits per pixel",
+           dmxName,
+           image.width,
+           image.height,
+           image.bitsPerPixel);
+
+    if (palette.length > 0)
+    {
+        printf(" with %d colour palette", palette.length);
+    }
+
+    printf(", %u bytes of pixels\n", image.size);
+
+    //-------------------------------------------------------------------
+
+    destroyImagePalette32(&palette);
+    destroyImage(&image);
+    free(dmxName);
+
+    return 0;
+}
+
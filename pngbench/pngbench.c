@@ -0,0 +1,614 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "bcm_host.h"
+
+#include "font.h"
+#include "hsv2rgb.h"
+#include "image.h"
+#include "imageFile.h"
+#include "imageGraphics.h"
+#include "loadpng.h"
+#include "qoi.h"
+#include "savepng.h"
+
+//-----------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-----------------------------------------------------------------------
+
+typedef struct
+{
+    int32_t width;
+    int32_t height;
+} PNGBENCH_SIZE_T;
+
+static const PNGBENCH_SIZE_T sizes[] =
+{
+    { 320, 240 },
+    { 640, 480 },
+    { 1280, 720 },
+    { 1920, 1080 }
+};
+
+static const char *presetNames[] =
+{
+    "uncompressed",
+    "fast",
+    "default",
+    "small"
+};
+
+typedef struct
+{
+    const char *name;
+    bool (*save)(const IMAGE_T *image, const char *file);
+    bool (*load)(IMAGE_T *image, const char *file);
+} PNGBENCH_CODEC_T;
+
+static const PNGBENCH_CODEC_T codecs[] =
+{
+    { "png", savePng, loadPng },
+    { "qoi", saveQoi, loadQoi }
+};
+
+#define PNGBENCH_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+#define PNGBENCH_PRESETS (sizeof(presetNames) / sizeof(presetNames[0]))
+#define PNGBENCH_CODECS (sizeof(codecs) / sizeof(codecs[0]))
+
+//-----------------------------------------------------------------------
+
+// Something like a screenshot: a smooth background with flat boxes, lines
+// and text over it.
+
+static void
+drawTestImage(
+    IMAGE_T *image)
+{
+    RGBA8_T rgba;
+
+    int32_t j;
+    for (j = 0 ; j < image->height ; j++)
+    {
+        int32_t i;
+        for (i = 0 ; i < image->width ; i++)
+        {
+            hsv2rgb((i * 3600) / image->width,
+                    500 + (j * 500) / image->height,
+                    1000,
+                    &rgba);
+            rgba.alpha = 255 - ((i + j) % 256);
+            setPixelRGB(image, i, j, &rgba);
+        }
+    }
+
+    srand(1);
+
+    for (j = 0 ; j < 100 ; j++)
+    {
+        RGBA8_T colour = { rand() % 256, rand() % 256, rand() % 256, 255 };
+        int32_t x = rand() % image->width;
+        int32_t y = rand() % image->height;
+
+        imageBoxFilledRGB(image,
+                          x,
+                          y,
+                          x + rand() % (image->width / 4),
+                          y + rand() % (image->height / 4),
+                          &colour);
+
+        imageLineRGB(image,
+                     rand() % image->width,
+                     rand() % image->height,
+                     rand() % image->width,
+                     rand() % image->height,
+                     &colour);
+    }
+
+    RGBA8_T black = { 0, 0, 0, 255 };
+
+    for (j = 0 ; j < image->height ; j += 32)
+    {
+        drawStringRGB(8,
+                      j,
+                      "The quick brown fox jumps over the lazy dog",
+                      &black,
+                      image);
+    }
+}
+
+//-----------------------------------------------------------------------
+
+static bool
+samePixels(
+    IMAGE_T *a,
+    IMAGE_T *b)
+{
+    if ((a->width != b->width) || (a->height != b->height))
+    {
+        return false;
+    }
+
+    RGBA8_T *rowA = malloc(2 * a->width * sizeof(RGBA8_T));
+
+    if (rowA == NULL)
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    RGBA8_T *rowB = rowA + a->width;
+    bool same = true;
+
+    int32_t j;
+    for (j = 0 ; (j < a->height) && same ; j++)
+    {
+        getSpanRGB(a, 0, j, a->width, rowA);
+        getSpanRGB(b, 0, j, b->width, rowB);
+
+        same = (memcmp(rowA, rowB, a->width * sizeof(RGBA8_T)) == 0);
+    }
+
+    free(rowA);
+
+    return same;
+}
+
+//-----------------------------------------------------------------------
+
+static double
+secondsNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + (now.tv_nsec / 1.0e9);
+}
+
+//-----------------------------------------------------------------------
+
+// Thread counts go up in powers of two, ending with the largest. Zero
+// means there are no more.
+
+static int32_t
+nextThreads(
+    int32_t threads,
+    int32_t maxThreads)
+{
+    if (threads >= maxThreads)
+    {
+        return 0;
+    }
+
+    return (threads * 2 < maxThreads) ? threads * 2 : maxThreads;
+}
+
+//-----------------------------------------------------------------------
+
+// Time saving the image with a codec and loading it back, taking the best
+// of 'repeats' runs of each, and check that it loads back the same.
+
+static void
+timeCodec(
+    const PNGBENCH_CODEC_T *codec,
+    IMAGE_T *image,
+    const char *name,
+    const char *file,
+    int32_t repeats)
+{
+    bool hasAlpha = (image->type == VC_IMAGE_RGBA16) ||
+                    (image->type == VC_IMAGE_RGBA32);
+
+    double rawBytes = (double)(image->width)
+                    * image->height
+                    * ((hasAlpha) ? 4 : 3);
+
+    double bestSave = 0.0;
+    double bestLoad = 0.0;
+
+    int32_t r;
+    for (r = 0 ; r < repeats ; r++)
+    {
+        double start = secondsNow();
+
+        if (codec->save(image, file) == false)
+        {
+            fprintf(stderr, "%s: unable to save %s\n", program, file);
+            exit(EXIT_FAILURE);
+        }
+
+        double seconds = secondsNow() - start;
+
+        if ((r == 0) || (seconds < bestSave))
+        {
+            bestSave = seconds;
+        }
+    }
+
+    IMAGE_T loaded;
+
+    for (r = 0 ; r < repeats ; r++)
+    {
+        double start = secondsNow();
+
+        if (codec->load(&loaded, file) == false)
+        {
+            fprintf(stderr, "%s: unable to load %s\n", program, file);
+            exit(EXIT_FAILURE);
+        }
+
+        double seconds = secondsNow() - start;
+
+        if ((r == 0) || (seconds < bestLoad))
+        {
+            bestLoad = seconds;
+        }
+
+        if (r < repeats - 1)
+        {
+            destroyImage(&loaded);
+        }
+    }
+
+    if (samePixels(image, &loaded) == false)
+    {
+        fprintf(stderr,
+                "%s: %s doesn't load back as the image saved\n",
+                program,
+                file);
+        exit(EXIT_FAILURE);
+    }
+
+    destroyImage(&loaded);
+
+    struct stat st;
+    stat(file, &st);
+
+    printf("%-16s %-6s %9.2f %9.1f %9.2f %9.1f %10lld %5.1f%%\n",
+           name,
+           codec->name,
+           bestSave * 1000.0,
+           rawBytes / bestSave / 1.0e6,
+           bestLoad * 1000.0,
+           rawBytes / bestLoad / 1.0e6,
+           (long long)(st.st_size),
+           (100.0 * st.st_size) / rawBytes);
+}
+
+//-----------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s ", program);
+    fprintf(stderr, "[-j <threads>] [-o <file>] [-p <preset>] ");
+    fprintf(stderr, "[-q <file>] [-r <number>] [-t <type>] [<image> ...]\n");
+    fprintf(stderr, "    -j - most threads to try (default one per core)\n");
+    fprintf(stderr, "    -o - file to write (default pngbench.png)\n");
+    fprintf(stderr, "    -p - only time one preset, one of:");
+
+    size_t i;
+    for (i = 0 ; i < PNGBENCH_PRESETS ; i++)
+    {
+        fprintf(stderr, " %s", presetNames[i]);
+    }
+
+    fprintf(stderr, "\n");
+    fprintf(stderr, "    -q - QOI file to write (default pngbench.qoi)\n");
+    fprintf(stderr, "    -r - times to save each image (default 3)\n");
+    fprintf(stderr, "    -t - type of image to save, one of: ");
+    fprintf(stderr, "RGB565 RGB888 RGBA16 RGBA32 (default RGB888)\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-----------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    const char *file = "pngbench.png";
+    const char *qoiFile = "pngbench.qoi";
+    const char *imageTypeName = "RGB888";
+    int32_t maxThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    int32_t firstPreset = 0;
+    int32_t lastPreset = PNGBENCH_PRESETS - 1;
+    int32_t repeats = 3;
+
+    program = basename(argv[0]);
+
+    //-------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "j:o:p:q:r:t:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'j':
+
+            maxThreads = strtol(optarg, NULL, 10);
+            break;
+
+        case 'o':
+
+            file = optarg;
+            break;
+
+        case 'p':
+        {
+            firstPreset = -1;
+
+            size_t i;
+            for (i = 0 ; i < PNGBENCH_PRESETS ; i++)
+            {
+                if (strcasecmp(optarg, presetNames[i]) == 0)
+                {
+                    firstPreset = i;
+                    lastPreset = i;
+                }
+            }
+
+            if (firstPreset == -1)
+            {
+                usage();
+            }
+
+            break;
+        }
+        case 'q':
+
+            qoiFile = optarg;
+            break;
+
+        case 'r':
+
+            repeats = strtol(optarg, NULL, 10);
+            break;
+
+        case 't':
+
+            imageTypeName = optarg;
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    if ((maxThreads < 1) || (repeats < 1))
+    {
+        usage();
+    }
+
+    //-------------------------------------------------------------------
+
+    IMAGE_TYPE_INFO_T typeInfo;
+
+    if ((findImageType(&typeInfo,
+                       imageTypeName,
+                       IMAGE_TYPES_ALL_DIRECT_COLOUR) == false) ||
+        ((typeInfo.type != VC_IMAGE_RGB565) &&
+         (typeInfo.type != VC_IMAGE_RGB888) &&
+         (typeInfo.type != VC_IMAGE_RGBA16) &&
+         (typeInfo.type != VC_IMAGE_RGBA32)))
+    {
+        fprintf(stderr,
+                "%s: unsupported image type %s\n",
+                program,
+                imageTypeName);
+
+        exit(EXIT_FAILURE);
+    }
+
+    //-------------------------------------------------------------------
+
+    printf("%-10s %-12s %7s %9s %9s %10s %6s\n",
+           "size",
+           "preset",
+           "threads",
+           "ms",
+           "MB/s",
+           "bytes",
+           "ratio");
+
+    size_t s;
+    for (s = 0 ; s < PNGBENCH_SIZES ; s++)
+    {
+        IMAGE_T image;
+        initImage(&image,
+                  typeInfo.type,
+                  sizes[s].width,
+                  sizes[s].height,
+                  false);
+
+        drawTestImage(&image);
+
+        double rawBytes = (double)(image.width)
+                        * image.height
+                        * ((typeInfo.hasAlpha) ? 4 : 3);
+
+        char sizeName[32];
+        snprintf(sizeName,
+                 sizeof(sizeName),
+                 "%dx%d",
+                 image.width,
+                 image.height);
+
+        int32_t preset;
+        for (preset = firstPreset ; preset <= lastPreset ; preset++)
+        {
+            SAVEPNG_OPTIONS_T options;
+            setSavePngPreset(&options, preset);
+
+            int32_t threads;
+            for (threads = 1 ;
+                 threads > 0 ;
+                 threads = nextThreads(threads, maxThreads))
+            {
+                options.threads = threads;
+
+                double best = 0.0;
+
+                int32_t r;
+                for (r = 0 ; r < repeats ; r++)
+                {
+                    double start = secondsNow();
+
+                    if (savePngWithOptions(&image, file, &options) == false)
+                    {
+                        fprintf(stderr, "%s: unable to save %s\n",
+                                program,
+                                file);
+                        exit(EXIT_FAILURE);
+                    }
+
+                    double seconds = secondsNow() - start;
+
+                    if ((r == 0) || (seconds < best))
+                    {
+                        best = seconds;
+                    }
+                }
+
+                struct stat st;
+                stat(file, &st);
+
+                printf("%-10s %-12s %7d %9.2f %9.1f %10lld %5.1f%%\n",
+                       sizeName,
+                       presetNames[preset],
+                       threads,
+                       best * 1000.0,
+                       rawBytes / best / 1.0e6,
+                       (long long)(st.st_size),
+                       (100.0 * st.st_size) / rawBytes);
+            }
+
+            IMAGE_T loaded;
+
+            if ((loadPng(&loaded, file) == false) ||
+                (samePixels(&image, &loaded) == false))
+            {
+                fprintf(stderr,
+                        "%s: %s doesn't load back as the image saved\n",
+                        program,
+                        file);
+                exit(EXIT_FAILURE);
+            }
+
+            destroyImage(&loaded);
+        }
+
+        destroyImage(&image);
+    }
+
+    //-------------------------------------------------------------------
+
+    // Compare the PNG and QOI codecs on the same test images, and on any
+    // image files given.
+
+    printf("\n");
+
+    printf("%-16s %-6s %9s %9s %9s %9s %10s %6s\n",
+           "image",
+           "codec",
+           "save ms",
+           "MB/s",
+           "load ms",
+           "MB/s",
+           "bytes",
+           "ratio");
+
+    for (s = 0 ; s < PNGBENCH_SIZES ; s++)
+    {
+        IMAGE_T image;
+        initImage(&image,
+                  typeInfo.type,
+                  sizes[s].width,
+                  sizes[s].height,
+                  false);
+
+        drawTestImage(&image);
+
+        char sizeName[32];
+        snprintf(sizeName,
+                 sizeof(sizeName),
+                 "%dx%d",
+                 image.width,
+                 image.height);
+
+        size_t c;
+        for (c = 0 ; c < PNGBENCH_CODECS ; c++)
+        {
+            const char *codecFile = (c == 0) ? file : qoiFile;
+            timeCodec(&(codecs[c]), &image, sizeName, codecFile, repeats);
+        }
+
+        destroyImage(&image);
+    }
+
+    int i;
+    for (i = optind ; i < argc ; i++)
+    {
+        IMAGE_T image;
+
+        if (loadImage(&image, NULL, argv[i]) == false)
+        {
+            fprintf(stderr, "%s: unable to load %s\n", program, argv[i]);
+            exit(EXIT_FAILURE);
+        }
+
+        size_t c;
+        for (c = 0 ; c < PNGBENCH_CODECS ; c++)
+        {
+            const char *codecFile = (c == 0) ? file : qoiFile;
+
+            timeCodec(&(codecs[c]),
+                      &image,
+                      basename(argv[i]),
+                      codecFile,
+                      repeats);
+        }
+
+        destroyImage(&image);
+    }
+
+    return 0;
+}
+
@@ -36,9 +36,9 @@
 #include <unistd.h>
 
 #include "backgroundLayer.h"
+#include "imageFile.h"
 #include "imageLayer.h"
 #include "key.h"
-#include "loadpng.h"
 
 #include "bcm_host.h"
 
@@ -192,7 +192,9 @@ int main(int argc, char *argv[])
     if(strcmp(imagePath, "-") == 0)
     {
         // Use stdin
-        if (loadPngFile(&(imageLayer.image), stdin) == false)
+        if (loadImageFile(&(imageLayer.image),
+                          &(imageLayer.palette),
+                          stdin) == false)
         {
             fprintf(stderr, "unable to load %s\n", imagePath);
             exit(EXIT_FAILURE);
@@ -201,7 +203,9 @@ int main(int argc, char *argv[])
     else
     {
         // Load image from path
-        if (loadPng(&(imageLayer.image), imagePath) == false)
+        if (loadImage(&(imageLayer.image),
+                      &(imageLayer.palette),
+                      imagePath) == false)
         {
             fprintf(stderr, "unable to load %s\n", imagePath);
             exit(EXIT_FAILURE);
@@ -213,6 +217,7 @@ int main(int argc, char *argv[])
     if (alphaRelativeSet == true)
     {
       setImageAlphaRelative(&(imageLayer.image), alphaRelative);
+      setPalette32AlphaRelative(&(imageLayer.palette), alphaRelative);
     }
 
     //---------------------------------------------------------------------
@@ -223,6 +228,7 @@ int main(int argc, char *argv[])
       uint8_t green = (rgb>>8) & 0xff;
       uint8_t blue = rgb & 0xff;
       setImageRGB(&(imageLayer.image), red , green, blue);
+      setPalette32Rgb(&(imageLayer.palette), red , green, blue);
     }
 
     //---------------------------------------------------------------------
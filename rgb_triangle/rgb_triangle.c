@@ -215,31 +215,33 @@ int main(int argc, char *argv[])
     int32_t x_offset = (modeInfo.width - width) / 2;
     int32_t y_offset = (modeInfo.height - height) / 2;
 
+    RGBA8_T row[256];
+
     int32_t y;
     for (y = 0 ; y < 256 ; y++)
     {
         int32_t x;
         for (x = 0 ; x < 256 ; x++)
         {
-            RGBA8_T rgba;
+            RGBA8_T *rgba = &(row[x]);
 
             if (((255 - x - (y/2)) >= 0)&& ((x - (y/2)) >= 0))
             {
-                rgba.red = 255 - x - (y/2);
-                rgba.green = x - (y/2);
-                rgba.blue = 255 - rgba.red - rgba.green;
-                rgba.alpha = 255;
+                rgba->red = 255 - x - (y/2);
+                rgba->green = x - (y/2);
+                rgba->blue = 255 - rgba->red - rgba->green;
+                rgba->alpha = 255;
             }
             else
             {
-                rgba.red = 0;
-                rgba.green = 0;
-                rgba.blue = 0;
-                rgba.alpha = 255;
+                rgba->red = 0;
+                rgba->green = 0;
+                rgba->blue = 0;
+                rgba->alpha = 255;
             }
-
-            setPixelRGB(&image, x, y, &rgba);
         }
+
+        setSpanRGB(&image, 0, y, 256, row);
     }
 
     //---------------------------------------------------------------------
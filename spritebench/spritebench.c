@@ -0,0 +1,753 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "element_change.h"
+#include "hsv2rgb.h"
+#include "image.h"
+#include "multiSpriteLayer.h"
+#include "spriteAtlas.h"
+
+#include "bcm_host.h"
+
+// Built against the software DispmanX, the calls made each frame are
+// counted too.
+
+#if defined(__has_include)
+#if __has_include("headless.h")
+#include "headless.h"
+#define SPRITEBENCH_COUNT_CALLS
+#endif
+#endif
+
+//-------------------------------------------------------------------------
+
+#define NDEBUG
+
+//-------------------------------------------------------------------------
+
+#define SPRITEBENCH_FRAMES 8
+
+//-------------------------------------------------------------------------
+
+const char *program = NULL;
+
+//-------------------------------------------------------------------------
+
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+    int32_t dx;
+    int32_t dy;
+    int32_t frame;
+} SPRITEBENCH_SPRITE_T;
+
+typedef struct
+{
+    int32_t number;
+    int32_t frames;
+    int32_t movePercent;
+    int32_t animatePercent;
+} SPRITEBENCH_OPTIONS_T;
+
+typedef struct
+{
+    const char *name;
+    double buildSeconds;
+    double submitSeconds;
+    double attributeCalls;
+    double sourceCalls;
+} SPRITEBENCH_RESULT_T;
+
+//-------------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s ", program);
+    fprintf(stderr, "[-a <percent>] [-d <number>] [-f <frames>] ");
+    fprintf(stderr, "[-l <layer>] [-m <percent>] [-n <number>] ");
+    fprintf(stderr, "[-s <size>]\n");
+    fprintf(stderr, "    -a - sprites changing frame each frame ");
+    fprintf(stderr, "(default 10%%)\n");
+    fprintf(stderr, "    -d - Raspberry Pi display number\n");
+    fprintf(stderr, "    -f - number of frames timed (default 300)\n");
+    fprintf(stderr, "    -l - DispmanX layer number\n");
+    fprintf(stderr, "    -m - sprites moving each frame (default 10%%)\n");
+    fprintf(stderr, "    -n - number of sprites (default 1000)\n");
+    fprintf(stderr, "    -s - sprite size in pixels (default 16)\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-------------------------------------------------------------------------
+
+static double
+secondsNow(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + (now.tv_nsec / 1.0e9);
+}
+
+//-------------------------------------------------------------------------
+
+// An atlas of one page holding a row of differently coloured discs. The
+// arrays are allocated as loadSpriteAtlas() would, so that
+// destroySpriteAtlas() can free them.
+
+static void
+createAtlas(
+    SPRITE_ATLAS_T *atlas,
+    int32_t size)
+{
+    IMAGE_T image;
+
+    if (initImage(&image,
+                  VC_IMAGE_RGBA32,
+                  size * SPRITEBENCH_FRAMES,
+                  size,
+                  false) == false)
+    {
+        fprintf(stderr, "%s: unable to initialize image\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    RGBA8_T clear = { 0, 0, 0, 0 };
+    clearImageRGB(&image, &clear);
+
+    int32_t f;
+    for (f = 0 ; f < SPRITEBENCH_FRAMES ; f++)
+    {
+        RGBA8_T colour;
+        hsv2rgb((f * 3600) / SPRITEBENCH_FRAMES, 1000, 1000, &colour);
+        colour.alpha = 255;
+
+        int32_t y;
+        for (y = 0 ; y < size ; y++)
+        {
+            int32_t x;
+            for (x = 0 ; x < size ; x++)
+            {
+                // twice the distance from the centre
+
+                int32_t dx = (2 * x) + 1 - size;
+                int32_t dy = (2 * y) + 1 - size;
+
+                if ((dx * dx) + (dy * dy) <= size * size)
+                {
+                    setPixelRGB(&image, (f * size) + x, y, &colour);
+                }
+            }
+        }
+    }
+
+    //---------------------------------------------------------------------
+
+    memset(atlas, 0, sizeof(*atlas));
+
+    atlas->pages = calloc(1, sizeof(SPRITE_ATLAS_PAGE_T));
+    atlas->frames = calloc(SPRITEBENCH_FRAMES, sizeof(SPRITE_ATLAS_FRAME_T));
+
+    if ((atlas->pages == NULL) || (atlas->frames == NULL))
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    SPRITE_ATLAS_PAGE_T *page = &(atlas->pages[0]);
+    page->type = image.type;
+    page->width = image.width;
+    page->height = image.height;
+
+    uint32_t vc_image_ptr;
+
+    page->resource =
+        vc_dispmanx_resource_create(
+            image.type,
+            image.width | (image.pitch << 16),
+            image.height | (image.alignedHeight << 16),
+            &vc_image_ptr);
+    assert(page->resource != 0);
+
+    VC_RECT_T bmpRect;
+    vc_dispmanx_rect_set(&bmpRect, 0, 0, image.width, image.height);
+
+    int result = vc_dispmanx_resource_write_data(page->resource,
+                                                 image.type,
+                                                 image.pitch,
+                                                 image.buffer,
+                                                 &bmpRect);
+    assert(result == 0);
+
+    atlas->pageCount = 1;
+
+    for (f = 0 ; f < SPRITEBENCH_FRAMES ; f++)
+    {
+        SPRITE_ATLAS_FRAME_T *frame = &(atlas->frames[f]);
+
+        snprintf(frame->name, sizeof(frame->name), "disc%d", f);
+        frame->page = 0;
+        frame->x = f * size;
+        frame->y = 0;
+        frame->width = size;
+        frame->height = size;
+    }
+
+    atlas->frameCount = SPRITEBENCH_FRAMES;
+
+    destroyImage(&image);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+initSprites(
+    SPRITEBENCH_SPRITE_T *sprites,
+    int32_t number,
+    int32_t size,
+    const DISPMANX_MODEINFO_T *info)
+{
+    int32_t xRange = info->width - size;
+    int32_t yRange = info->height - size;
+
+    srand(1);
+
+    int32_t i;
+    for (i = 0 ; i < number ; i++)
+    {
+        SPRITEBENCH_SPRITE_T *s = &(sprites[i]);
+
+        s->x = (xRange > 0) ? rand() % xRange : 0;
+        s->y = (yRange > 0) ? rand() % yRange : 0;
+        s->dx = (rand() % 2) ? 1 + rand() % 4 : -1 - rand() % 4;
+        s->dy = (rand() % 2) ? 1 + rand() % 4 : -1 - rand() % 4;
+        s->frame = i % SPRITEBENCH_FRAMES;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// Move and animate a spread of the sprites. Which sprites change depends
+// only on the frame number, so every method makes the same changes.
+
+static void
+stepSprites(
+    SPRITEBENCH_SPRITE_T *sprites,
+    const SPRITEBENCH_OPTIONS_T *options,
+    int32_t frameNumber,
+    int32_t size,
+    const DISPMANX_MODEINFO_T *info)
+{
+    int32_t i;
+    for (i = 0 ; i < options->number ; i++)
+    {
+        SPRITEBENCH_SPRITE_T *s = &(sprites[i]);
+
+        if ((((i * 37) + (frameNumber * 11)) % 100) < options->movePercent)
+        {
+            s->x += s->dx;
+            s->y += s->dy;
+
+            if ((s->x < 0) || (s->x + size > info->width))
+            {
+                s->dx = -(s->dx);
+                s->x += 2 * s->dx;
+            }
+
+            if ((s->y < 0) || (s->y + size > info->height))
+            {
+                s->dy = -(s->dy);
+                s->y += 2 * s->dy;
+            }
+        }
+
+        if ((((i * 59) + (frameNumber * 13)) % 100) <
+            options->animatePercent)
+        {
+            s->frame = (s->frame + 1) % SPRITEBENCH_FRAMES;
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+static void
+startResult(
+    SPRITEBENCH_RESULT_T *result,
+    const char *name)
+{
+    memset(result, 0, sizeof(*result));
+    result->name = name;
+
+#ifdef SPRITEBENCH_COUNT_CALLS
+    HEADLESS_CALLS_T calls;
+    headlessCalls(&calls);
+
+    result->attributeCalls = -(double)(calls.elementChanges);
+    result->sourceCalls = -(double)(calls.sourceChanges);
+#endif
+}
+
+//-------------------------------------------------------------------------
+
+static void
+finishResult(
+    SPRITEBENCH_RESULT_T *result,
+    int32_t frames)
+{
+#ifdef SPRITEBENCH_COUNT_CALLS
+    HEADLESS_CALLS_T calls;
+    headlessCalls(&calls);
+
+    result->attributeCalls += calls.elementChanges;
+    result->sourceCalls += calls.sourceChanges;
+#endif
+
+    result->buildSeconds /= frames;
+    result->submitSeconds /= frames;
+    result->attributeCalls /= frames;
+    result->sourceCalls /= frames;
+}
+
+//-------------------------------------------------------------------------
+
+// The way a program with a SPRITE_LAYER_T per sprite works: each sprite
+// is positioned with its own attribute change, setting both rectangles
+// every frame whether it has changed or not.
+
+static void
+timeEachSprite(
+    SPRITEBENCH_RESULT_T *result,
+    const SPRITEBENCH_OPTIONS_T *options,
+    const SPRITE_ATLAS_T *atlas,
+    SPRITEBENCH_SPRITE_T *sprites,
+    int32_t layer,
+    DISPMANX_DISPLAY_HANDLE_T display,
+    const DISPMANX_MODEINFO_T *info)
+{
+    int32_t size = atlas->frames[0].width;
+    DISPMANX_RESOURCE_HANDLE_T resource = atlas->pages[0].resource;
+
+    DISPMANX_ELEMENT_HANDLE_T *elements =
+        calloc(options->number, sizeof(DISPMANX_ELEMENT_HANDLE_T));
+
+    if (elements == NULL)
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    initSprites(sprites, options->number, size, info);
+
+    VC_DISPMANX_ALPHA_T alpha =
+    {
+        DISPMANX_FLAGS_ALPHA_FROM_SOURCE,
+        255, /*alpha 0->255*/
+        0
+    };
+
+    VC_RECT_T srcRect;
+    VC_RECT_T dstRect;
+
+    DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
+    assert(update != 0);
+
+    int32_t i;
+    for (i = 0 ; i < options->number ; i++)
+    {
+        const SPRITE_ATLAS_FRAME_T *f = &(atlas->frames[sprites[i].frame]);
+
+        vc_dispmanx_rect_set(&srcRect,
+                             f->x << 16,
+                             f->y << 16,
+                             f->width << 16,
+                             f->height << 16);
+
+        vc_dispmanx_rect_set(&dstRect,
+                             sprites[i].x,
+                             sprites[i].y,
+                             f->width,
+                             f->height);
+
+        elements[i] = vc_dispmanx_element_add(update,
+                                              display,
+                                              layer,
+                                              &dstRect,
+                                              resource,
+                                              &srcRect,
+                                              DISPMANX_PROTECTION_NONE,
+                                              &alpha,
+                                              NULL, // clamp
+                                              DISPMANX_NO_ROTATE);
+        assert(elements[i] != 0);
+    }
+
+    int status = vc_dispmanx_update_submit_sync(update);
+    assert(status == 0);
+
+    //---------------------------------------------------------------------
+
+    startResult(result, "each sprite");
+
+    int32_t frame;
+    for (frame = 0 ; frame < options->frames ; frame++)
+    {
+        double start = secondsNow();
+
+        stepSprites(sprites, options, frame, size, info);
+
+        update = vc_dispmanx_update_start(0);
+        assert(update != 0);
+
+        for (i = 0 ; i < options->number ; i++)
+        {
+            const SPRITE_ATLAS_FRAME_T *f =
+                &(atlas->frames[sprites[i].frame]);
+
+            vc_dispmanx_rect_set(&srcRect,
+                                 f->x << 16,
+                                 f->y << 16,
+                                 f->width << 16,
+                                 f->height << 16);
+
+            vc_dispmanx_rect_set(&dstRect,
+                                 sprites[i].x,
+                                 sprites[i].y,
+                                 f->width,
+                                 f->height);
+
+            status =
+            vc_dispmanx_element_change_attributes(update,
+                                                  elements[i],
+                                                  ELEMENT_CHANGE_SRC_RECT |
+                                                  ELEMENT_CHANGE_DEST_RECT,
+                                                  0,
+                                                  255,
+                                                  &dstRect,
+                                                  &srcRect,
+                                                  0,
+                                                  DISPMANX_NO_ROTATE);
+            assert(status == 0);
+        }
+
+        double built = secondsNow();
+
+        status = vc_dispmanx_update_submit_sync(update);
+        assert(status == 0);
+
+        double submitted = secondsNow();
+
+        result->buildSeconds += built - start;
+        result->submitSeconds += submitted - built;
+    }
+
+    finishResult(result, options->frames);
+
+    //---------------------------------------------------------------------
+
+    update = vc_dispmanx_update_start(0);
+    assert(update != 0);
+
+    for (i = 0 ; i < options->number ; i++)
+    {
+        status = vc_dispmanx_element_remove(update, elements[i]);
+        assert(status == 0);
+    }
+
+    status = vc_dispmanx_update_submit_sync(update);
+    assert(status == 0);
+
+    free(elements);
+}
+
+//-------------------------------------------------------------------------
+
+// The same sprites in a MULTI_SPRITE_LAYER_T, which only changes the
+// attributes of the sprites that have changed.
+
+static void
+timeMultiSprite(
+    SPRITEBENCH_RESULT_T *result,
+    const SPRITEBENCH_OPTIONS_T *options,
+    const SPRITE_ATLAS_T *atlas,
+    SPRITEBENCH_SPRITE_T *sprites,
+    int32_t layer,
+    DISPMANX_DISPLAY_HANDLE_T display,
+    const DISPMANX_MODEINFO_T *info)
+{
+    int32_t size = atlas->frames[0].width;
+
+    initSprites(sprites, options->number, size, info);
+
+    MULTI_SPRITE_LAYER_T ms;
+    initMultiSpriteLayer(&ms, atlas, options->number, layer);
+
+    DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
+    assert(update != 0);
+
+    int32_t i;
+    for (i = 0 ; i < options->number ; i++)
+    {
+        addInstanceMultiSpriteLayer(&ms,
+                                    sprites[i].frame,
+                                    sprites[i].x,
+                                    sprites[i].y,
+                                    display,
+                                    update);
+    }
+
+    int status = vc_dispmanx_update_submit_sync(update);
+    assert(status == 0);
+
+    //---------------------------------------------------------------------
+
+    startResult(result, "multi sprite");
+
+    int32_t frame;
+    for (frame = 0 ; frame < options->frames ; frame++)
+    {
+        double start = secondsNow();
+
+        stepSprites(sprites, options, frame, size, info);
+
+        for (i = 0 ; i < options->number ; i++)
+        {
+            setInstanceMultiSpriteLayer(&ms,
+                                        i,
+                                        sprites[i].frame,
+                                        sprites[i].x,
+                                        sprites[i].y);
+        }
+
+        update = vc_dispmanx_update_start(0);
+        assert(update != 0);
+
+        updateMultiSpriteLayer(&ms, update);
+
+        double built = secondsNow();
+
+        status = vc_dispmanx_update_submit_sync(update);
+        assert(status == 0);
+
+        double submitted = secondsNow();
+
+        result->buildSeconds += built - start;
+        result->submitSeconds += submitted - built;
+    }
+
+    finishResult(result, options->frames);
+
+    //---------------------------------------------------------------------
+
+    destroyMultiSpriteLayer(&ms);
+}
+
+//-------------------------------------------------------------------------
+
+static void
+printResult(
+    const SPRITEBENCH_RESULT_T *result)
+{
+#ifdef SPRITEBENCH_COUNT_CALLS
+    printf("%-14s %10.1f %10.1f",
+           result->name,
+           result->attributeCalls,
+           result->sourceCalls);
+#else
+    printf("%-14s %10s %10s", result->name, "-", "-");
+#endif
+
+    printf(" %10.1f %10.1f %10.1f\n",
+           result->buildSeconds * 1.0e6,
+           result->submitSeconds * 1.0e6,
+           (result->buildSeconds + result->submitSeconds) * 1.0e6);
+}
+
+//-------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    SPRITEBENCH_OPTIONS_T options = { 1000, 300, 10, 10 };
+    int32_t layer = 1;
+    int32_t size = 16;
+    uint32_t displayNumber = 0;
+
+    program = basename(argv[0]);
+
+    //---------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "a:d:f:l:m:n:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'a':
+
+            options.animatePercent = atoi(optarg);
+            break;
+
+        case 'd':
+
+            displayNumber = atoi(optarg);
+            break;
+
+        case 'f':
+
+            options.frames = atoi(optarg);
+            break;
+
+        case 'l':
+
+            layer = atoi(optarg);
+            break;
+
+        case 'm':
+
+            options.movePercent = atoi(optarg);
+            break;
+
+        case 'n':
+
+            options.number = atoi(optarg);
+            break;
+
+        case 's':
+
+            size = atoi(optarg);
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    if ((options.number < 1) ||
+        (options.frames < 1) ||
+        (options.movePercent < 0) ||
+        (options.movePercent > 100) ||
+        (options.animatePercent < 0) ||
+        (options.animatePercent > 100) ||
+        (size < 1))
+    {
+        usage();
+    }
+
+    //---------------------------------------------------------------------
+
+    bcm_host_init();
+
+    DISPMANX_DISPLAY_HANDLE_T display
+        = vc_dispmanx_display_open(displayNumber);
+    assert(display != 0);
+
+    DISPMANX_MODEINFO_T info;
+    int result = vc_dispmanx_display_get_info(display, &info);
+    assert(result == 0);
+
+    SPRITE_ATLAS_T atlas;
+    createAtlas(&atlas, size);
+
+    SPRITEBENCH_SPRITE_T *sprites =
+        calloc(options.number, sizeof(SPRITEBENCH_SPRITE_T));
+
+    if (sprites == NULL)
+    {
+        fprintf(stderr, "%s: memory exhausted\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    //---------------------------------------------------------------------
+
+    SPRITEBENCH_RESULT_T eachSprite;
+    SPRITEBENCH_RESULT_T multiSprite;
+
+    timeEachSprite(&eachSprite,
+                   &options,
+                   &atlas,
+                   sprites,
+                   layer,
+                   display,
+                   &info);
+
+    timeMultiSprite(&multiSprite,
+                    &options,
+                    &atlas,
+                    sprites,
+                    layer,
+                    display,
+                    &info);
+
+    printf("%d sprites of %dx%d on %dx%d, %d%% moving and %d%% "
+           "changing frame each frame, %d frames\n\n",
+           options.number,
+           size,
+           size,
+           info.width,
+           info.height,
+           options.movePercent,
+           options.animatePercent,
+           options.frames);
+
+    printf("%-14s %10s %10s %10s %10s %10s\n",
+           "",
+           "changes",
+           "sources",
+           "build us",
+           "submit us",
+           "total us");
+
+    printResult(&eachSprite);
+    printResult(&multiSprite);
+
+    //---------------------------------------------------------------------
+
+    destroySpriteAtlas(&atlas);
+    free(sprites);
+
+    result = vc_dispmanx_display_close(display);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    return 0;
+}
+
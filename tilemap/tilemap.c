@@ -0,0 +1,509 @@
+//-------------------------------------------------------------------------
+//
+// The MIT License (MIT)
+//
+// Copyright (c) 2015 Andrew Duncan
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+// TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+// SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//-------------------------------------------------------------------------
+
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "backgroundLayer.h"
+#include "image.h"
+#include "imageFile.h"
+#include "imagePalette.h"
+#include "key.h"
+#include "tiledLayer.h"
+
+#include "bcm_host.h"
+
+//-------------------------------------------------------------------------
+
+#define NDEBUG
+
+//-------------------------------------------------------------------------
+
+// The generated tile set has two variations of each kind of terrain,
+// from deep water up to snow.
+
+#define TILEMAP_TERRAINS 7
+#define TILEMAP_VARIANTS 2
+
+//-------------------------------------------------------------------------
+
+const char *program = NULL;
+
+static const RGBA8_T terrainColours[TILEMAP_TERRAINS] =
+{
+    {  20,  50, 130, 255 },
+    {  40,  90, 180, 255 },
+    { 210, 195, 140, 255 },
+    {  90, 160,  70, 255 },
+    {  40, 100,  45, 255 },
+    { 120, 115, 110, 255 },
+    { 240, 240, 245, 255 }
+};
+
+static const int32_t xDirections[8] = { 0, 3, 4, 3, 0, -3, -4, -3 };
+static const int32_t yDirections[8] = { 4, 3, 0, -3, -4, -3, 0, 3 };
+
+//-------------------------------------------------------------------------
+
+void usage(void)
+{
+    fprintf(stderr, "Usage: %s ", program);
+    fprintf(stderr, "[-b <RGBA>] [-d <number>] [-l <layer>] ");
+    fprintf(stderr, "[-m <width>x<height>] [-s <size>] [-t <tiles>]\n");
+    fprintf(stderr, "    -b - set background colour 16 bit RGBA\n");
+    fprintf(stderr, "         e.g. 0x000F is opaque black\n");
+    fprintf(stderr, "    -d - Raspberry Pi display number\n");
+    fprintf(stderr, "    -l - DispmanX layer number\n");
+    fprintf(stderr, "    -m - map size in tiles (default 1024x1024)\n");
+    fprintf(stderr, "    -s - tile size in pixels (default 128)\n");
+    fprintf(stderr, "    -t - tile set image, instead of generated tiles\n");
+
+    exit(EXIT_FAILURE);
+}
+
+//-------------------------------------------------------------------------
+
+static uint32_t
+hash(
+    uint32_t x,
+    uint32_t y,
+    uint32_t seed)
+{
+    uint32_t h = (x * 0x8DA6B343) ^ (y * 0xD8163841) ^ (seed * 0xCB1AB31F);
+
+    h ^= h >> 15;
+    h *= 0x2C1B3C6D;
+    h ^= h >> 12;
+
+    return h;
+}
+
+//-------------------------------------------------------------------------
+
+// Value noise from 0 to 255 that repeats every 'period' lattice points, so
+// that a map filled from it wraps around without a seam.
+
+static int32_t
+valueNoise(
+    int32_t x,
+    int32_t y,
+    int32_t cell,
+    int32_t periodX,
+    int32_t periodY,
+    uint32_t seed)
+{
+    int32_t x0 = (x / cell) % periodX;
+    int32_t y0 = (y / cell) % periodY;
+    int32_t x1 = (x0 + 1) % periodX;
+    int32_t y1 = (y0 + 1) % periodY;
+
+    int32_t fx = ((x % cell) * 256) / cell;
+    int32_t fy = ((y % cell) * 256) / cell;
+
+    // smooth step
+
+    fx = (fx * fx * (768 - (2 * fx))) >> 16;
+    fy = (fy * fy * (768 - (2 * fy))) >> 16;
+
+    int32_t a = hash(x0, y0, seed) & 0xFF;
+    int32_t b = hash(x1, y0, seed) & 0xFF;
+    int32_t c = hash(x0, y1, seed) & 0xFF;
+    int32_t d = hash(x1, y1, seed) & 0xFF;
+
+    int32_t top = a + (((b - a) * fx) >> 8);
+    int32_t bottom = c + (((d - c) * fx) >> 8);
+
+    return top + (((bottom - top) * fy) >> 8);
+}
+
+//-------------------------------------------------------------------------
+
+// Heights from a few octaves of noise, made into tiles by splitting the
+// range of heights evenly between the kinds of terrain.
+
+static void
+generateMap(
+    TILED_LAYER_T *tl,
+    int32_t terrains,
+    int32_t variants)
+{
+    int32_t row;
+    for (row = 0 ; row < tl->mapHeight ; row++)
+    {
+        int32_t column;
+        for (column = 0 ; column < tl->mapWidth ; column++)
+        {
+            int32_t height = 0;
+            int32_t weight = 0;
+            int32_t amplitude = 8;
+
+            int32_t cell;
+            for (cell = 64 ; cell >= 4 ; cell /= 2)
+            {
+                int32_t periodX = (tl->mapWidth + cell - 1) / cell;
+                int32_t periodY = (tl->mapHeight + cell - 1) / cell;
+
+                height += amplitude * valueNoise(column,
+                                                 row,
+                                                 cell,
+                                                 periodX,
+                                                 periodY,
+                                                 cell);
+                weight += amplitude;
+                amplitude /= 2;
+            }
+
+            // Averaged noise is rarely near either end of its range, so
+            // the middle half of the range is stretched over all of it.
+
+            int32_t level = ((height / weight) - 64) * 2;
+
+            if (level < 0)
+            {
+                level = 0;
+            }
+            else if (level > 255)
+            {
+                level = 255;
+            }
+
+            int32_t terrain = (level * terrains) / 256;
+            int32_t variant = hash(column, row, 0) % variants;
+
+            setTileTiledLayer(tl, column, row, (variant * terrains) + terrain);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// A row of tiles for each variant, each tile one colour with a little
+// noise.
+
+static void
+generateTileSet(
+    IMAGE_T *image,
+    int32_t size)
+{
+    if (initImage(image,
+                  VC_IMAGE_RGB565,
+                  size * TILEMAP_TERRAINS,
+                  size * TILEMAP_VARIANTS,
+                  false) == false)
+    {
+        fprintf(stderr, "%s: unable to initialize image\n", program);
+        exit(EXIT_FAILURE);
+    }
+
+    int32_t y;
+    for (y = 0 ; y < image->height ; y++)
+    {
+        int32_t x;
+        for (x = 0 ; x < image->width ; x++)
+        {
+            const RGBA8_T *base = &(terrainColours[x / size]);
+            int32_t shade = (int32_t)(hash(x, y, y / size) % 41) - 20;
+
+            RGBA8_T colour = *base;
+            colour.red = (base->red * (100 + shade)) / 120;
+            colour.green = (base->green * (100 + shade)) / 120;
+            colour.blue = (base->blue * (100 + shade)) / 120;
+
+            setPixelRGB(image, x, y, &colour);
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    uint16_t background = 0x000F;
+    int32_t layer = 1;
+    uint32_t displayNumber = 0;
+    int32_t mapWidth = 1024;
+    int32_t mapHeight = 1024;
+    int32_t size = 128;
+    const char *tileFile = NULL;
+
+    program = basename(argv[0]);
+
+    //---------------------------------------------------------------------
+
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "b:d:l:m:s:t:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'b':
+
+            background = strtol(optarg, NULL, 16);
+            break;
+
+        case 'd':
+
+            displayNumber = atoi(optarg);
+            break;
+
+        case 'l':
+
+            layer = atoi(optarg);
+            break;
+
+        case 'm':
+
+            if (sscanf(optarg, "%dx%d", &mapWidth, &mapHeight) != 2)
+            {
+                usage();
+            }
+            break;
+
+        case 's':
+
+            size = atoi(optarg);
+            break;
+
+        case 't':
+
+            tileFile = optarg;
+            break;
+
+        default:
+
+            usage();
+            break;
+        }
+    }
+
+    if ((mapWidth < 1) || (mapHeight < 1) || (size < 1))
+    {
+        usage();
+    }
+
+    //---------------------------------------------------------------------
+
+    bcm_host_init();
+
+    //---------------------------------------------------------------------
+
+    IMAGE_T tileSet;
+    IMAGE_PALETTE32_T palette = { NULL, 0 };
+
+    if (tileFile != NULL)
+    {
+        if (loadImage(&tileSet, &palette, tileFile) == false)
+        {
+            fprintf(stderr, "%s: unable to load %s\n", program, tileFile);
+            exit(EXIT_FAILURE);
+        }
+
+        if ((tileSet.width < size) || (tileSet.height < size))
+        {
+            fprintf(stderr,
+                    "%s: %s is smaller than one tile\n",
+                    program,
+                    tileFile);
+            exit(EXIT_FAILURE);
+        }
+    }
+    else
+    {
+        generateTileSet(&tileSet, size);
+    }
+
+    TILED_LAYER_T tiles;
+    initTiledLayer(&tiles,
+                   &tileSet,
+                   &palette,
+                   size,
+                   size,
+                   mapWidth,
+                   mapHeight,
+                   layer);
+
+    if (tileFile != NULL)
+    {
+        generateMap(&tiles, tiles.tileCount, 1);
+    }
+    else
+    {
+        generateMap(&tiles, TILEMAP_TERRAINS, TILEMAP_VARIANTS);
+    }
+
+    BACKGROUND_LAYER_T bg;
+    initBackgroundLayer(&bg, background, 0);
+
+    //---------------------------------------------------------------------
+
+    DISPMANX_DISPLAY_HANDLE_T display
+        = vc_dispmanx_display_open(displayNumber);
+    assert(display != 0);
+
+    //---------------------------------------------------------------------
+
+    DISPMANX_MODEINFO_T info;
+    int result = vc_dispmanx_display_get_info(display, &info);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    DISPMANX_UPDATE_HANDLE_T update = vc_dispmanx_update_start(0);
+    assert(update != 0);
+
+    if (background > 0)
+    {
+        addElementBackgroundLayer(&bg, display, update);
+    }
+
+    VC_RECT_T viewRect;
+    vc_dispmanx_rect_set(&viewRect, 0, 0, info.width, info.height);
+
+    addElementTiledLayer(&tiles, &viewRect, display, update);
+
+    result = vc_dispmanx_update_submit_sync(update);
+    assert(result == 0);
+
+    printf("map of %dx%d tiles (%dx%d pixels), tile set of %dx%d pixels "
+           "in one resource, %d elements\n",
+           mapWidth,
+           mapHeight,
+           mapWidth * size,
+           mapHeight * size,
+           tileSet.width,
+           tileSet.height,
+           tiles.columns * tiles.rows);
+
+    destroyImage(&tileSet);
+    destroyImagePalette32(&palette);
+
+    //---------------------------------------------------------------------
+
+    struct timeval start_time;
+    gettimeofday(&start_time, NULL);
+
+    int c = 0;
+    int32_t direction = 1;
+    int32_t x = 0;
+    int32_t y = 0;
+    uint32_t frames = 0;
+    uint64_t changed = 0;
+    bool paused = false;
+
+    while (c != 27)
+    {
+        if (keyPressed(&c))
+        {
+            c = tolower(c);
+
+            switch (c)
+            {
+            case ',':
+            case '<':
+
+                direction = (direction + 7) % 8;
+                break;
+
+            case '.':
+            case '>':
+
+                direction = (direction + 1) % 8;
+                break;
+
+            case 'p':
+
+                paused = !paused;
+                break;
+            }
+        }
+
+        if (paused)
+        {
+            usleep(10000);
+            continue;
+        }
+
+        //-----------------------------------------------------------------
+
+        x += xDirections[direction];
+        y -= yDirections[direction];
+
+        setPositionTiledLayer(&tiles, x, y);
+
+        update = vc_dispmanx_update_start(0);
+        assert(update != 0);
+
+        changed += updateTiledLayer(&tiles, update);
+
+        result = vc_dispmanx_update_submit_sync(update);
+        assert(result == 0);
+
+        ++frames;
+    }
+
+    //---------------------------------------------------------------------
+
+    struct timeval end_time;
+    gettimeofday(&end_time, NULL);
+
+    struct timeval diff;
+    timersub(&end_time, &start_time, &diff);
+
+    int32_t time_taken = (diff.tv_sec * 1000000) + diff.tv_usec;
+    double frames_per_second = (frames * 1000000.0) / time_taken;
+
+    printf("%0.1f frames per second, %0.1f elements changed per frame\n",
+           frames_per_second,
+           (frames > 0) ? (double)changed / frames : 0.0);
+
+    //---------------------------------------------------------------------
+
+    keyboardReset();
+
+    //---------------------------------------------------------------------
+
+    destroyBackgroundLayer(&bg);
+    destroyTiledLayer(&tiles);
+
+    //---------------------------------------------------------------------
+
+    result = vc_dispmanx_display_close(display);
+    assert(result == 0);
+
+    //---------------------------------------------------------------------
+
+    return 0;
+}
+
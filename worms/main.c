@@ -59,12 +59,14 @@ int main(int argc, char *argv[])
     VC_IMAGE_TYPE_T imageType = VC_IMAGE_MIN;
     uint16_t  background = 0x0000;
     uint32_t displayNumber = 0;
+    uint16_t number_of_worms = 36;
+    uint16_t worm_length = 25;
 
     program = basename(argv[0]);
 
     //-------------------------------------------------------------------
 
-    while ((opt = getopt(argc, argv, "b:d:t:")) != -1)
+    while ((opt = getopt(argc, argv, "b:d:l:n:t:")) != -1)
     {
         switch (opt)
         {
@@ -78,6 +80,16 @@ int main(int argc, char *argv[])
             displayNumber = strtol(optarg, NULL, 10);
             break;
 
+        case 'l':
+
+            worm_length = strtol(optarg, NULL, 10);
+            break;
+
+        case 'n':
+
+            number_of_worms = strtol(optarg, NULL, 10);
+            break;
+
         case 't':
 
             imageTypeName = optarg;
@@ -86,10 +98,13 @@ int main(int argc, char *argv[])
         default:
 
             fprintf(stderr, "Usage: %s \n", program);
-            fprintf(stderr, "[-b <RGBA>] [-d <number>] [-t <type>]\n");
+            fprintf(stderr, "[-b <RGBA>] [-d <number>] [-l <length>]");
+            fprintf(stderr, " [-n <number>] [-t <type>]\n");
             fprintf(stderr, "    -b - set background colour 16 bit RGBA\n");
             fprintf(stderr, "         e.g. 0x000F is opaque black\n");
             fprintf(stderr, "    -d - Raspberry Pi display number\n");
+            fprintf(stderr, "    -l - length of each worm (default 25)\n");
+            fprintf(stderr, "    -n - number of worms (default 36)\n");
             fprintf(stderr, "    -t - type of image to create\n");
             fprintf(stderr, "         can be one of the following:");
             printImageTypes(stderr,
@@ -106,6 +121,17 @@ int main(int argc, char *argv[])
 
     //-------------------------------------------------------------------
 
+    if ((number_of_worms == 0) || (worm_length == 0))
+    {
+        fprintf(stderr,
+                "%s: number and length of worms must be at least 1\n",
+                program);
+
+        exit(EXIT_FAILURE);
+    }
+
+    //-------------------------------------------------------------------
+
     IMAGE_TYPE_INFO_T typeInfo;
 
     if (findImageType(&typeInfo,
@@ -147,8 +173,6 @@ int main(int argc, char *argv[])
 
     //---------------------------------------------------------------------
 
-    uint16_t number_of_worms = 36;
-    uint16_t worm_length = 25;
     WORMS_T worms;
 
     initWorms(number_of_worms, worm_length, &worms, imageType, &info);
@@ -180,9 +204,7 @@ int main(int argc, char *argv[])
 
         //-----------------------------------------------------------------
 
-        undrawWorms(&worms);
         updateWorms(&worms);
-        drawWorms(&worms);
         writeDataWorms(&worms);
 
         //-----------------------------------------------------------------
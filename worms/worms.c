@@ -27,8 +27,10 @@
 
 #include <assert.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "hsv2rgb.h"
@@ -39,14 +41,90 @@
 
 //-------------------------------------------------------------------------
 
+// A row that changes has to be copied to the back resource this frame,
+// and to the other resource next frame.
+
+#define WORMS_ROW_THIS_FRAME 1
+#define WORMS_ROW_LAST_FRAME 2
+
+// Runs of changed rows closer than this are copied with one write.
+
+#define WORMS_ROW_GAP 8
+
+//-------------------------------------------------------------------------
+
+static bool
+segmentPixel(
+    const COORD_T *segment,
+    const IMAGE_T *image,
+    int32_t *x,
+    int32_t *y)
+{
+    *x = (int32_t)floor(segment->x);
+    *y = (int32_t)floor(segment->y);
+
+    return (*x >= 0) && (*x < image->width) &&
+           (*y >= 0) && (*y < image->height);
+}
+
+//-------------------------------------------------------------------------
+
+// The pixels are range checked by segmentPixel() and the changed rows are
+// kept in rowChanged, so they are set directly rather than through
+// setPixelRGB(), which would clip them again and mark the image dirty.
+
+static void
+plotSegment(
+    const WORM_T *worm,
+    const COORD_T *segment,
+    WORMS_T *worms)
+{
+    int32_t x;
+    int32_t y;
+
+    if (segmentPixel(segment, &(worms->image), &x, &y))
+    {
+        ++(worms->coverage[x + (y * worms->image.width)]);
+
+        worms->image.setPixelDirect(&(worms->image), x, y, &(worm->colour));
+        worms->rowChanged[y] |= WORMS_ROW_THIS_FRAME;
+    }
+}
+
+//-------------------------------------------------------------------------
+
+// The pixel is only cleared once no segment of any worm covers it.
+
+static void
+unplotSegment(
+    const COORD_T *segment,
+    WORMS_T *worms)
+{
+    static RGBA8_T colour = { 0, 0, 0, 0 };
+
+    int32_t x;
+    int32_t y;
+
+    if (segmentPixel(segment, &(worms->image), &x, &y) &&
+        (--(worms->coverage[x + (y * worms->image.width)]) == 0))
+    {
+        worms->image.setPixelDirect(&(worms->image), x, y, &colour);
+        worms->rowChanged[y] |= WORMS_ROW_THIS_FRAME;
+    }
+}
+
+//-------------------------------------------------------------------------
+
 void
 initWorm(
     uint16_t worm_number,
     uint16_t number_of_worms,
     uint16_t worm_length,
     WORM_T *worm,
-    IMAGE_T *image)
+    WORMS_T *worms)
 {
+    IMAGE_T *image = &(worms->image);
+
     hsv2rgb((3600 * worm_number) / number_of_worms,
             1000,
             1000,
@@ -72,16 +150,22 @@ initWorm(
     {
         worm->body[i].x = x;
         worm->body[i].y = y;
+
+        plotSegment(worm, &(worm->body[i]), worms);
     }
 }
 
 //-------------------------------------------------------------------------
 
+// Only the tail that the worm leaves behind and its new head are drawn.
+
 void
 updateWorm(
     WORM_T *worm,
-    IMAGE_T *image)
+    WORMS_T *worms)
 {
+    IMAGE_T *image = &(worms->image);
+
     uint16_t wasHead = worm->head;
     worm->head = (worm->head + 1) % worm->size;
 
@@ -129,44 +213,12 @@ updateWorm(
 
     //---------------------------------------------------------------------
 
+    unplotSegment(&(worm->body[worm->head]), worms);
+
     worm->body[worm->head].x = x;
     worm->body[worm->head].y = y;
-}
-
-//-------------------------------------------------------------------------
-
-void
-drawWorm(
-    WORM_T *worm,
-    IMAGE_T *image)
-{
-    uint16_t i = 0;
-    for (i = 0 ; i < worm->size ; i++)
-    {
-        setPixelRGB(image,
-                    (int32_t)floor(worm->body[i].x),
-                    (int32_t)floor(worm->body[i].y),
-                    &(worm->colour));
-    }
-}
-
-//-------------------------------------------------------------------------
 
-void
-undrawWorm(
-    WORM_T *worm,
-    IMAGE_T *image)
-{
-    RGBA8_T colour = { 0, 0, 0, 0 };
-
-    uint32_t i = 0;
-    for (i = 0 ; i < worm->size ; i++)
-    {
-        setPixelRGB(image,
-                    (int32_t)floor(worm->body[i].x),
-                    (int32_t)floor(worm->body[i].y),
-                    &colour);
-    }
+    plotSegment(worm, &(worm->body[worm->head]), worms);
 }
 
 //-------------------------------------------------------------------------
@@ -195,6 +247,16 @@ initWorms(
     initImage(&(worms->image), imageType, info->width, info->height, false);
     srand(time(NULL));
 
+    size_t pixels = worms->image.width * worms->image.height;
+    worms->coverage = calloc(pixels, sizeof(uint32_t));
+    worms->rowChanged = calloc(worms->image.height, sizeof(uint8_t));
+
+    if ((worms->coverage == NULL) || (worms->rowChanged == NULL))
+    {
+        fprintf(stderr, "worms: memory exhausted\n");
+        exit(EXIT_FAILURE);
+    }
+
     worms->size = number;
     worms->worms = malloc(worms->size * sizeof(WORM_T));
 
@@ -208,7 +270,7 @@ initWorms(
     for (i = 0 ; i < worms->size ; i++)
     {
         WORM_T *worm = &(worms->worms[i]);
-        initWorm(i, number, length, worm, &(worms->image));
+        initWorm(i, number, length, worm, worms);
     }
 
     //---------------------------------------------------------------------
@@ -247,6 +309,18 @@ initWorms(
                                              worms->image.buffer,
                                              &dst_rect);
     assert(result == 0);
+
+    // From now on only changed rows are written, so both resources need
+    // to start with the whole image.
+
+    result = vc_dispmanx_resource_write_data(worms->backResource,
+                                             worms->image.type,
+                                             worms->image.pitch,
+                                             worms->image.buffer,
+                                             &dst_rect);
+    assert(result == 0);
+
+    memset(worms->rowChanged, 0, worms->image.height);
 }
 
 //-------------------------------------------------------------------------
@@ -289,23 +363,58 @@ addElementWorms(
 
 //-------------------------------------------------------------------------
 
+// Copy the rows that have changed in this frame or the last one to the
+// back resource, which was last written two frames ago.
+
 void
 writeDataWorms(
     WORMS_T *worms)
 {
-    VC_RECT_T dst_rect;
-    vc_dispmanx_rect_set(&dst_rect,
-                         0,
-                         0,
-                         worms->image.width,
-                         worms->image.height);
+    IMAGE_T *image = &(worms->image);
+    int32_t start = -1;
+    int32_t end = -1;
 
-    int result = vc_dispmanx_resource_write_data(worms->backResource,
-                                                 worms->image.type,
-                                                 worms->image.pitch,
-                                                 worms->image.buffer,
-                                                 &dst_rect);
-    assert(result == 0);
+    int32_t row;
+    for (row = 0 ; row <= image->height ; row++)
+    {
+        bool changed = (row < image->height) && (worms->rowChanged[row] != 0);
+
+        if (changed && (start != -1) && (row - end < WORMS_ROW_GAP))
+        {
+            end = row + 1;
+        }
+        else if (changed || (row == image->height))
+        {
+            if (start != -1)
+            {
+                VC_RECT_T dst_rect;
+                vc_dispmanx_rect_set(&dst_rect,
+                                     0,
+                                     start,
+                                     image->width,
+                                     end - start);
+
+                int result =
+                    vc_dispmanx_resource_write_data(worms->backResource,
+                                                    image->type,
+                                                    image->pitch,
+                                                    image->buffer,
+                                                    &dst_rect);
+                assert(result == 0);
+            }
+
+            start = row;
+            end = row + 1;
+        }
+
+        if (row < image->height)
+        {
+            worms->rowChanged[row] =
+                (worms->rowChanged[row] & WORMS_ROW_THIS_FRAME)
+                ? WORMS_ROW_LAST_FRAME
+                : 0;
+        }
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -336,35 +445,7 @@ updateWorms(
     for (i = 0 ; i < worms->size ; i++)
     {
         WORM_T *worm = &(worms->worms[i]);
-        updateWorm(worm, &(worms->image));
-    }
-}
-
-//-------------------------------------------------------------------------
-
-void
-drawWorms(
-    WORMS_T *worms)
-{
-    uint16_t i = 0;
-    for (i = 0 ; i < worms->size ; i++)
-    {
-        WORM_T *worm = &(worms->worms[i]);
-        drawWorm(worm, &(worms->image));
-    }
-}
-
-//-------------------------------------------------------------------------
-
-void
-undrawWorms(
-    WORMS_T *worms)
-{
-    uint16_t i = 0;
-    for (i = 0 ; i < worms->size ; i++)
-    {
-        WORM_T *worm = &(worms->worms[i]);
-        undrawWorm(worm, &(worms->image));
+        updateWorm(worm, worms);
     }
 }
 
@@ -382,9 +463,13 @@ destroyWorms(
     }
 
     free(worms->worms);
+    free(worms->coverage);
+    free(worms->rowChanged);
 
     worms->size = 0;
     worms->worms = NULL;
+    worms->coverage = NULL;
+    worms->rowChanged = NULL;
 
     destroyImage(&(worms->image));
 
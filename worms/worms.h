@@ -56,6 +56,8 @@ typedef struct
     uint16_t size;
     WORM_T *worms;
     IMAGE_T image;
+    uint32_t *coverage;
+    uint8_t *rowChanged;
     DISPMANX_RESOURCE_HANDLE_T frontResource;
     DISPMANX_RESOURCE_HANDLE_T backResource;
     DISPMANX_ELEMENT_HANDLE_T element;
@@ -72,8 +74,6 @@ initWorms(
     DISPMANX_MODEINFO_T *info);
 
 void updateWorms(WORMS_T *worms);
-void drawWorms(WORMS_T *worms);
-void undrawWorms(WORMS_T *worms);
 
 void
 addElementWorms(